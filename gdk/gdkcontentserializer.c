@@ -692,7 +692,20 @@ serialize_texture_in_thread (GTask        *task,
   texture = g_value_get_object (value);
 
   if (strcmp (gdk_content_serializer_get_mime_type (serializer), "image/png") == 0)
-    bytes = gdk_save_png (texture);
+    {
+      /* No need to go through an intermediate buffer here.
+       * The other side is waiting for the data, so favor speed over size.
+       */
+      if (gdk_save_png_to_stream (texture,
+                                  gdk_content_serializer_get_output_stream (serializer),
+                                  &gdk_png_save_options_fast,
+                                  gdk_content_serializer_get_cancellable (serializer),
+                                  &error))
+        g_task_return_boolean (task, TRUE);
+      else
+        g_task_return_error (task, error);
+      return;
+    }
   else if (strcmp (gdk_content_serializer_get_mime_type (serializer), "image/tiff") == 0)
     bytes = gdk_save_tiff (texture);
   else if (strcmp (gdk_content_serializer_get_mime_type (serializer), "image/jpeg") == 0)
@@ -24,6 +24,7 @@
 
 #include "gdkdebugprivate.h"
 #include <glib/gi18n-lib.h>
+#include "gdkframeclockprivate.h"
 #include "gdkprofilerprivate.h"
 #include "gdksurfaceprivate.h"
 
@@ -50,6 +51,7 @@ struct _GdkDrawContextPrivate {
   cairo_region_t *frame_region;
   GdkColorState *color_state;
   GdkMemoryDepth depth;
+  gint64 frame_start_time;
 };
 
 enum {
@@ -393,6 +395,7 @@ gdk_draw_context_begin_frame_full (GdkDrawContext        *context,
 
   priv->frame_region = cairo_region_copy (region);
   priv->surface->paint_context = g_object_ref (context);
+  priv->frame_start_time = g_get_monotonic_time ();
 
   g_assert (priv->color_state == NULL);
 
@@ -436,11 +439,16 @@ void
 gdk_draw_context_end_frame_full (GdkDrawContext *context)
 {
   GdkDrawContextPrivate *priv = gdk_draw_context_get_instance_private (context);
+  GdkFrameClock *frame_clock;
 
   GDK_DRAW_CONTEXT_GET_CLASS (context)->end_frame (context, priv->frame_region);
 
   gdk_profiler_set_int_counter (pixels_counter, region_get_pixels (priv->frame_region));
 
+  frame_clock = gdk_surface_get_frame_clock (priv->surface);
+  if (frame_clock)
+    gdk_frame_clock_add_render_time (frame_clock, g_get_monotonic_time () - priv->frame_start_time);
+
   priv->color_state = NULL;
   g_clear_pointer (&priv->frame_region, cairo_region_destroy);
   g_clear_object (&priv->surface->paint_context);
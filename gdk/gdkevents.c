@@ -603,6 +603,12 @@ _gdk_event_unqueue (GdkDisplay *display)
  *
  * We give the remaining event a history with N items, and deltas
  * that are the sum over the history entries.
+ *
+ * Since this is done every time an event is queued, there are
+ * usually only 2 events to combine, and the first one has already
+ * been combined before. Its history is reused and its deltas are
+ * the sum over that history, so the cost per event does not grow
+ * with the length of the history.
  */
 void
 gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
@@ -615,6 +621,7 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
   GdkScrollUnit scroll_unit = GDK_SCROLL_UNIT_WHEEL;
   gboolean scroll_unit_defined = FALSE;
   GdkTimeCoord hist;
+  double total_dx = 0, total_dy = 0;
 
   l = g_queue_peek_tail_link (&display->queued_events);
 
@@ -668,10 +675,12 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
       if (!history)
         history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
 
+      gdk_scroll_event_get_deltas (event, &dx, &dy);
+      total_dx += dx;
+      total_dy += dy;
+
       if (!inherited)
         {
-          gdk_scroll_event_get_deltas (event, &dx, &dy);
-
           memset (&hist, 0, sizeof (GdkTimeCoord));
           hist.time = gdk_event_get_time (event);
           hist.flags = GDK_AXIS_FLAG_DELTA_X | GDK_AXIS_FLAG_DELTA_Y;
@@ -702,21 +711,16 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
       hist.axes[GDK_AXIS_DELTA_Y] = dy;
       g_array_append_val (history, hist);
 
-      dx = dy = 0;
-      for (int i = 0; i < history->len; i++)
-        {
-          GdkTimeCoord *val = &g_array_index (history, GdkTimeCoord, i);
-          dx += val->axes[GDK_AXIS_DELTA_X];
-          dy += val->axes[GDK_AXIS_DELTA_Y];
-        }
+      total_dx += dx;
+      total_dy += dy;
 
       event = gdk_scroll_event_new (surface,
                                     device,
                                     gdk_event_get_device_tool (old_event),
                                     gdk_event_get_time (old_event),
                                     gdk_event_get_modifier_state (old_event),
-                                    dx,
-                                    dy,
+                                    total_dx,
+                                    total_dy,
                                     gdk_scroll_event_is_stop (old_event),
                                     scroll_unit);
 
@@ -741,15 +745,26 @@ gdk_motion_event_push_history (GdkEvent *event,
   g_assert (GDK_IS_EVENT_TYPE (event, GDK_MOTION_NOTIFY));
   g_assert (GDK_IS_EVENT_TYPE (history_event, GDK_MOTION_NOTIFY));
 
-  if (G_UNLIKELY (!self->history))
-    self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
-
   if (((GdkMotionEvent *)history_event)->history)
     {
       GArray *history = ((GdkMotionEvent *)history_event)->history;
-      g_array_append_vals (self->history, history->data, history->len);
+
+      /* history_event is about to be dropped, so take over its history
+       * instead of copying it. Otherwise, compressing every new motion
+       * would copy the whole history accumulated so far.
+       */
+      if (self->history == NULL)
+        {
+          self->history = history;
+          ((GdkMotionEvent *)history_event)->history = NULL;
+        }
+      else
+        g_array_append_vals (self->history, history->data, history->len);
     }
 
+  if (G_UNLIKELY (!self->history))
+    self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+
   tool = gdk_event_get_device_tool (history_event);
 
   memset (&hist, 0, sizeof (GdkTimeCoord));
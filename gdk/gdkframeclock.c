@@ -26,6 +26,15 @@
 
 #include "gdkframeclockprivate.h"
 
+#include <stdio.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+
+#ifdef G_OS_UNIX
+#include <signal.h>
+#include <glib-unix.h>
+#endif
+
 /**
  * GdkFrameClock:
  *
@@ -62,6 +71,12 @@
  * time between an initial value from [method@Gdk.FrameClock.get_frame_time]
  * and the value inside the [signal@Gdk.FrameClock::update] signal of the clock,
  * they will stay exactly synchronized.
+ *
+ * The durations of the phases of the last frames, and the number of
+ * frames that missed their refresh cycle, are recorded for each frame
+ * clock. If the `GDK_FRAME_STATS` environment variable is set to a
+ * filename, these statistics are appended to that file when a frame
+ * clock is destroyed and, on Unix, whenever the process receives SIGUSR1.
  */
 
 enum {
@@ -91,23 +106,148 @@ static guint fps_counter;
 #define GDK_ARRAY_FREE_FUNC frame_timings_unref
 #include "gdk/gdkarrayimpl.c"
 
+/* how long to wait for a frame to be presented before recording it */
+#define MAX_STATS_DELAY (G_USEC_PER_SEC / 2)
+
 struct _GdkFrameClockPrivate
 {
   gint64 frame_counter;
   int current;
   Timings timings;
   int n_freeze_inhibitors;
+
+  /* time spent flushing events since the last frame */
+  gint64 events_duration;
+
+  GdkFrameStats *stats;
+  /* the next frame to add to stats */
+  gint64 stats_counter;
+  char *label;
 };
 
+static GList *frame_clocks;
+static const char *stats_filename;
+
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GdkFrameClock, gdk_frame_clock, G_TYPE_OBJECT)
 
 static void
 _gdk_frame_clock_freeze (GdkFrameClock *clock);
 
+static void gdk_frame_clock_update_stats (GdkFrameClock *frame_clock,
+                                          gint64         monotonic_time);
+
+static gboolean
+write_stats (const char  *filename,
+             GString     *string,
+             GError     **error)
+{
+  FILE *file;
+  gboolean result;
+
+  file = g_fopen (filename, "a");
+  if (file == NULL)
+    {
+      int saved_errno = errno;
+      char *display_name = g_filename_display_name (filename);
+
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                   "Failed to open file “%s”: %s",
+                   display_name, g_strerror (saved_errno));
+      g_free (display_name);
+      return FALSE;
+    }
+
+  result = fwrite (string->str, 1, string->len, file) == string->len;
+  result &= fclose (file) == 0;
+
+  if (!result)
+    {
+      char *display_name = g_filename_display_name (filename);
+
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   "Failed to write file “%s”",
+                   display_name);
+      g_free (display_name);
+    }
+
+  return result;
+}
+
+/*< private >
+ * gdk_frame_clock_dump_stats:
+ * @filename: the file to append to
+ * @error: return location for an error
+ *
+ * Appends the frame statistics of all frame clocks to @filename.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+gdk_frame_clock_dump_stats (const char  *filename,
+                            GError     **error)
+{
+  GString *string;
+  gboolean result;
+  GList *l;
+
+  string = g_string_new (NULL);
+
+  for (l = frame_clocks; l; l = l->next)
+    {
+      GdkFrameClock *frame_clock = l->data;
+
+      gdk_frame_clock_update_stats (frame_clock, g_get_monotonic_time ());
+      gdk_frame_stats_print (frame_clock->priv->stats, frame_clock->priv->label, string);
+    }
+
+  result = write_stats (filename, string, error);
+
+  g_string_free (string, TRUE);
+
+  return result;
+}
+
+#ifdef G_OS_UNIX
+static gboolean
+dump_stats_on_signal (gpointer data)
+{
+  GError *error = NULL;
+
+  if (!gdk_frame_clock_dump_stats (stats_filename, &error))
+    {
+      g_warning ("Could not write frame statistics: %s", error->message);
+      g_error_free (error);
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+#endif
+
 static void
 gdk_frame_clock_finalize (GObject *object)
 {
-  GdkFrameClockPrivate *priv = GDK_FRAME_CLOCK (object)->priv;
+  GdkFrameClock *frame_clock = GDK_FRAME_CLOCK (object);
+  GdkFrameClockPrivate *priv = frame_clock->priv;
+
+  if (stats_filename)
+    {
+      GString *string = g_string_new (NULL);
+      GError *error = NULL;
+
+      gdk_frame_clock_update_stats (frame_clock, G_MAXINT64);
+      gdk_frame_stats_print (priv->stats, priv->label, string);
+      if (!write_stats (stats_filename, string, &error))
+        {
+          g_warning ("Could not write frame statistics: %s", error->message);
+          g_error_free (error);
+        }
+
+      g_string_free (string, TRUE);
+    }
+
+  frame_clocks = g_list_remove (frame_clocks, frame_clock);
+  g_clear_pointer (&priv->stats, gdk_frame_stats_free);
+  g_free (priv->label);
 
   timings_clear (&priv->timings);
 
@@ -253,6 +393,12 @@ gdk_frame_clock_class_init (GdkFrameClockClass *klass)
                   0,
                   NULL, NULL, NULL,
                   G_TYPE_NONE, 0);
+
+  stats_filename = g_getenv ("GDK_FRAME_STATS");
+#ifdef G_OS_UNIX
+  if (stats_filename)
+    g_unix_signal_add (SIGUSR1, dump_stats_on_signal, NULL);
+#endif
 }
 
 static void
@@ -266,6 +412,10 @@ gdk_frame_clock_init (GdkFrameClock *clock)
   priv->current = 0;
   timings_init (&priv->timings);
 
+  priv->stats = gdk_frame_stats_new ();
+  priv->label = g_strdup_printf ("%s %p", G_OBJECT_TYPE_NAME (clock), clock);
+  frame_clocks = g_list_prepend (frame_clocks, clock);
+
   if (fps_counter == 0)
     fps_counter = gdk_profiler_define_counter ("fps", "Frames per Second");
 }
@@ -460,6 +610,9 @@ _gdk_frame_clock_begin_frame (GdkFrameClock *frame_clock,
 
   priv = frame_clock->priv;
 
+  /* Do this first, the timings of old frames are about to be reused */
+  gdk_frame_clock_update_stats (frame_clock, monotonic_time);
+
   priv->frame_counter++;
 
   if (G_UNLIKELY (timings_get_size (&priv->timings) == 0))
@@ -490,6 +643,9 @@ _gdk_frame_clock_begin_frame (GdkFrameClock *frame_clock,
           timings_splice (&priv->timings, priv->current, 1, FALSE, &timings, 1);
         }
     }
+
+  timings_get (&priv->timings, priv->current)->events_duration = priv->events_duration;
+  priv->events_duration = 0;
 }
 
 static inline GdkFrameTimings *
@@ -693,7 +849,13 @@ gdk_frame_clock_get_refresh_info (GdkFrameClock *frame_clock,
 void
 _gdk_frame_clock_emit_flush_events (GdkFrameClock *frame_clock)
 {
+  gint64 before;
+
+  before = g_get_monotonic_time ();
+
   g_signal_emit (frame_clock, signals[FLUSH_EVENTS], 0);
+
+  frame_clock->priv->events_duration += g_get_monotonic_time () - before;
 }
 
 void
@@ -832,6 +994,194 @@ gdk_frame_clock_get_fps (GdkFrameClock *frame_clock)
   return ((double) end_counter - start_counter) * G_USEC_PER_SEC / (end_timestamp - start_timestamp);
 }
 
+/* Adds all frames up to the current one to the stats, waiting
+ * for frames to be presented for a while
+ */
+static void
+gdk_frame_clock_update_stats (GdkFrameClock *frame_clock,
+                              gint64         monotonic_time)
+{
+  GdkFrameClockPrivate *priv = frame_clock->priv;
+
+  priv->stats_counter = MAX (priv->stats_counter, _gdk_frame_clock_get_history_start (frame_clock));
+
+  while (priv->stats_counter < priv->frame_counter)
+    {
+      GdkFrameTimings *timings = _gdk_frame_clock_get_timings (frame_clock, priv->stats_counter);
+
+      if (timings != NULL)
+        {
+          if (!timings->complete &&
+              timings->frame_time + MAX_STATS_DELAY > monotonic_time)
+            break;
+
+          if (timings->frame_time != 0)
+            gdk_frame_stats_add (priv->stats, timings);
+        }
+
+      priv->stats_counter++;
+    }
+}
+
+/*< private >
+ * gdk_frame_clock_get_stats:
+ * @frame_clock: a `GdkFrameClock`
+ *
+ * Gets the statistics about the frames of @frame_clock.
+ *
+ * Frames are only included once they have been presented,
+ * or once they are old enough to assume they never will be.
+ *
+ * Returns: (transfer none): the statistics
+ */
+const GdkFrameStats *
+gdk_frame_clock_get_stats (GdkFrameClock *frame_clock)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), NULL);
+
+  gdk_frame_clock_update_stats (frame_clock, g_get_monotonic_time ());
+
+  return frame_clock->priv->stats;
+}
+
+/**
+ * gdk_frame_clock_get_n_frames:
+ * @frame_clock: a `GdkFrameClock`
+ *
+ * Gets the number of frames that @frame_clock has drawn
+ * so far.
+ *
+ * Frames are only counted once they have been presented,
+ * or once they are old enough to assume they never will be.
+ *
+ * Returns: the number of frames
+ *
+ * Since: 4.18
+ */
+guint64
+gdk_frame_clock_get_n_frames (GdkFrameClock *frame_clock)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+
+  return gdk_frame_clock_get_stats (frame_clock)->n_frames;
+}
+
+/**
+ * gdk_frame_clock_get_n_dropped_frames:
+ * @frame_clock: a `GdkFrameClock`
+ *
+ * Gets the number of refresh cycles that @frame_clock missed
+ * because frames were not presented in time.
+ *
+ * Returns: the number of dropped frames
+ *
+ * Since: 4.18
+ */
+guint64
+gdk_frame_clock_get_n_dropped_frames (GdkFrameClock *frame_clock)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+
+  return gdk_frame_clock_get_stats (frame_clock)->n_dropped;
+}
+
+/**
+ * gdk_frame_clock_get_phase_time:
+ * @frame_clock: a `GdkFrameClock`
+ * @phase: the phase
+ *
+ * Gets the average time that @frame_clock spent in @phase.
+ *
+ * The average is taken over all frames since @frame_clock was
+ * created that @phase happened in. For example, frames that were
+ * never presented don't count for %GDK_FRAME_STATS_PHASE_PRESENT.
+ * Frames are only included once they have been presented, or once
+ * they are old enough to assume they never will be.
+ *
+ * Returns: the average duration of @phase, in microseconds,
+ *   or 0 if it never happened
+ *
+ * Since: 4.18
+ */
+double
+gdk_frame_clock_get_phase_time (GdkFrameClock      *frame_clock,
+                                GdkFrameStatsPhase  phase)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+  g_return_val_if_fail (phase < GDK_FRAME_STATS_N_PHASES, 0);
+
+  return gdk_frame_stats_get_average (gdk_frame_clock_get_stats (frame_clock), phase);
+}
+
+/**
+ * gdk_frame_clock_print_stats:
+ * @frame_clock: a `GdkFrameClock`
+ *
+ * Creates a report of the frame statistics of @frame_clock.
+ *
+ * The report starts with a summary, followed by the phase
+ * durations of the last frames as comma-separated values.
+ * It uses the same format as the file that is written when
+ * the `GDK_FRAME_STATS` environment variable is set.
+ *
+ * The format is meant for humans and tools reading CSV, and
+ * may change between versions.
+ *
+ * Returns: (transfer full): the report
+ *
+ * Since: 4.18
+ */
+char *
+gdk_frame_clock_print_stats (GdkFrameClock *frame_clock)
+{
+  GString *string;
+
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), NULL);
+
+  string = g_string_new (NULL);
+  gdk_frame_stats_print (gdk_frame_clock_get_stats (frame_clock),
+                         frame_clock->priv->label,
+                         string);
+
+  return g_string_free (string, FALSE);
+}
+
+/*< private >
+ * gdk_frame_clock_set_label:
+ * @frame_clock: a `GdkFrameClock`
+ * @label: the name to use for @frame_clock in statistics
+ *
+ * Sets the name under which the statistics of @frame_clock
+ * are reported.
+ */
+void
+gdk_frame_clock_set_label (GdkFrameClock *frame_clock,
+                           const char    *label)
+{
+  g_return_if_fail (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  g_free (frame_clock->priv->label);
+  frame_clock->priv->label = g_strdup (label);
+}
+
+/*< private >
+ * gdk_frame_clock_add_render_time:
+ * @frame_clock: a `GdkFrameClock`
+ * @duration: the time spent rendering, in µs
+ *
+ * Records time spent rendering the current frame.
+ */
+void
+gdk_frame_clock_add_render_time (GdkFrameClock *frame_clock,
+                                 gint64         duration)
+{
+  GdkFrameTimings *timings;
+
+  timings = gdk_frame_clock_get_current_timings (frame_clock);
+  if (timings)
+    timings->render_duration += duration;
+}
+
 void
 _gdk_frame_clock_add_timings_to_profiler (GdkFrameClock   *clock,
                                           GdkFrameTimings *timings)
@@ -69,6 +69,33 @@ typedef enum {
   GDK_FRAME_CLOCK_PHASE_AFTER_PAINT   = 1 << 6
 } GdkFrameClockPhase;
 
+/**
+ * GdkFrameStatsPhase:
+ * @GDK_FRAME_STATS_PHASE_EVENTS: dispatching the events that were
+ *   queued for the frame, during [signal@Gdk.FrameClock::flush-events]
+ * @GDK_FRAME_STATS_PHASE_UPDATE: from the start of the frame to the start
+ *   of the layout phase, mostly [signal@Gdk.FrameClock::update]
+ * @GDK_FRAME_STATS_PHASE_LAYOUT: [signal@Gdk.FrameClock::layout]
+ * @GDK_FRAME_STATS_PHASE_PAINT: [signal@Gdk.FrameClock::paint], until the
+ *   end of the frame
+ * @GDK_FRAME_STATS_PHASE_RENDER: rendering the frame, between beginning
+ *   and ending the frame of the draw context
+ * @GDK_FRAME_STATS_PHASE_PRESENT: from the end of the frame until it was
+ *   presented
+ *
+ * The phases of a frame that frame clock statistics measure.
+ *
+ * Since: 4.18
+ */
+typedef enum {
+  GDK_FRAME_STATS_PHASE_EVENTS,
+  GDK_FRAME_STATS_PHASE_UPDATE,
+  GDK_FRAME_STATS_PHASE_LAYOUT,
+  GDK_FRAME_STATS_PHASE_PAINT,
+  GDK_FRAME_STATS_PHASE_RENDER,
+  GDK_FRAME_STATS_PHASE_PRESENT
+} GdkFrameStatsPhase;
+
 GDK_AVAILABLE_IN_ALL
 GType    gdk_frame_clock_get_type             (void) G_GNUC_CONST;
 
@@ -105,6 +132,17 @@ void gdk_frame_clock_get_refresh_info (GdkFrameClock *frame_clock,
 GDK_AVAILABLE_IN_ALL
 double gdk_frame_clock_get_fps (GdkFrameClock *frame_clock);
 
+/* Frame statistics */
+GDK_AVAILABLE_IN_4_18
+guint64 gdk_frame_clock_get_n_frames         (GdkFrameClock      *frame_clock);
+GDK_AVAILABLE_IN_4_18
+guint64 gdk_frame_clock_get_n_dropped_frames (GdkFrameClock      *frame_clock);
+GDK_AVAILABLE_IN_4_18
+double  gdk_frame_clock_get_phase_time       (GdkFrameClock      *frame_clock,
+                                              GdkFrameStatsPhase  phase);
+GDK_AVAILABLE_IN_4_18
+char *  gdk_frame_clock_print_stats          (GdkFrameClock      *frame_clock);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GdkFrameClock, g_object_unref)
 
 G_END_DECLS
@@ -28,6 +28,7 @@
 
 #include <gdk/gdkframeclock.h>
 #include <gdk/gdkprofilerprivate.h>
+#include <gdk/gdkframestatsprivate.h>
 
 G_BEGIN_DECLS
 
@@ -99,6 +100,10 @@ struct _GdkFrameTimings
   gint64 paint_start_time;
   gint64 frame_end_time;
 
+  /* time spent in these phases, in µs */
+  gint64 events_duration;
+  gint64 render_duration;
+
   guint complete : 1;
   guint slept_before : 1;
 };
@@ -113,6 +118,14 @@ void _gdk_frame_clock_debug_print_timings (GdkFrameClock   *clock,
 void _gdk_frame_clock_add_timings_to_profiler (GdkFrameClock *frame_clock,
                                                GdkFrameTimings *timings);
 
+void                 gdk_frame_clock_set_label       (GdkFrameClock *frame_clock,
+                                                      const char    *label);
+const GdkFrameStats *gdk_frame_clock_get_stats       (GdkFrameClock *frame_clock);
+void                 gdk_frame_clock_add_render_time (GdkFrameClock *frame_clock,
+                                                      gint64         duration);
+gboolean             gdk_frame_clock_dump_stats      (const char    *filename,
+                                                      GError       **error);
+
 GdkFrameTimings *_gdk_frame_timings_new   (gint64           frame_counter);
 gboolean         _gdk_frame_timings_steal (GdkFrameTimings *timings,
                                            gint64           frame_counter);
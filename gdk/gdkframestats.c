@@ -0,0 +1,268 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkframestatsprivate.h"
+
+#include "gdkframeclockprivate.h"
+
+/* GdkFrameStats keeps the durations of the phases of the last frames
+ * of a frame clock in a fixed size ring buffer, plus totals over the
+ * lifetime of the clock.
+ *
+ * Unlike the profiler marks, this is always enabled, so that numbers
+ * can be collected from production systems. It is cheap enough for
+ * that: recording a frame is a handful of subtractions.
+ */
+
+static const char *phase_names[GDK_FRAME_STATS_N_PHASES] = {
+  [GDK_FRAME_STATS_PHASE_EVENTS] = "events",
+  [GDK_FRAME_STATS_PHASE_UPDATE] = "update",
+  [GDK_FRAME_STATS_PHASE_LAYOUT] = "layout",
+  [GDK_FRAME_STATS_PHASE_PAINT] = "paint",
+  [GDK_FRAME_STATS_PHASE_RENDER] = "render",
+  [GDK_FRAME_STATS_PHASE_PRESENT] = "present",
+};
+
+GdkFrameStats *
+gdk_frame_stats_new (void)
+{
+  GdkFrameStats *stats;
+
+  stats = g_new0 (GdkFrameStats, 1);
+  stats->last_frame_counter = -1;
+
+  return stats;
+}
+
+void
+gdk_frame_stats_free (GdkFrameStats *stats)
+{
+  g_free (stats);
+}
+
+/* Returns the first of the given times that is set */
+static gint64
+first_time (gint64 a,
+            gint64 b,
+            gint64 c)
+{
+  if (a != 0)
+    return a;
+  if (b != 0)
+    return b;
+  return c;
+}
+
+static gint32
+duration (gint64 start,
+          gint64 end)
+{
+  if (start == 0 || end == 0 || end < start)
+    return -1;
+
+  return MIN (end - start, G_MAXINT32);
+}
+
+/* Computes the refresh cycles that were missed between the previous
+ * frame and @timings. Only consecutive frames count, if the clock was
+ * idle in between, the gap is not a dropped frame.
+ */
+static guint
+count_dropped (GdkFrameStats   *stats,
+               GdkFrameTimings *timings)
+{
+  gint64 interval, cycles;
+
+  if (timings->presentation_time == 0 ||
+      timings->refresh_interval == 0 ||
+      timings->slept_before ||
+      stats->last_presentation_time == 0 ||
+      stats->last_frame_counter != timings->frame_counter - 1 ||
+      timings->presentation_time <= stats->last_presentation_time)
+    return 0;
+
+  interval = timings->presentation_time - stats->last_presentation_time;
+  cycles = (interval + timings->refresh_interval / 2) / timings->refresh_interval;
+
+  return cycles > 1 ? cycles - 1 : 0;
+}
+
+/*
+ * gdk_frame_stats_add:
+ * @stats: a `GdkFrameStats`
+ * @timings: the timings of a finished frame
+ *
+ * Records the frame described by @timings.
+ *
+ * Frames must be added in order.
+ */
+void
+gdk_frame_stats_add (GdkFrameStats   *stats,
+                     GdkFrameTimings *timings)
+{
+  GdkFrameRecord *record;
+  gint64 frame_end;
+  guint i;
+
+  if (stats->n_records < GDK_FRAME_STATS_HISTORY)
+    {
+      record = &stats->records[(stats->first + stats->n_records) % GDK_FRAME_STATS_HISTORY];
+      stats->n_records++;
+    }
+  else
+    {
+      record = &stats->records[stats->first];
+      stats->first = (stats->first + 1) % GDK_FRAME_STATS_HISTORY;
+    }
+
+  frame_end = timings->frame_end_time;
+
+  record->frame_counter = timings->frame_counter;
+  record->frame_time = timings->frame_time;
+
+  record->durations[GDK_FRAME_STATS_PHASE_EVENTS] = MIN (timings->events_duration, G_MAXINT32);
+  record->durations[GDK_FRAME_STATS_PHASE_UPDATE] = duration (timings->frame_time,
+                                                              first_time (timings->layout_start_time,
+                                                                          timings->paint_start_time,
+                                                                          frame_end));
+  if (timings->layout_start_time != 0)
+    record->durations[GDK_FRAME_STATS_PHASE_LAYOUT] = duration (timings->layout_start_time,
+                                                                first_time (timings->paint_start_time, frame_end, 0));
+  else
+    record->durations[GDK_FRAME_STATS_PHASE_LAYOUT] = -1;
+  record->durations[GDK_FRAME_STATS_PHASE_PAINT] = duration (timings->paint_start_time, frame_end);
+  if (timings->paint_start_time != 0)
+    record->durations[GDK_FRAME_STATS_PHASE_RENDER] = MIN (timings->render_duration, G_MAXINT32);
+  else
+    record->durations[GDK_FRAME_STATS_PHASE_RENDER] = -1;
+  record->durations[GDK_FRAME_STATS_PHASE_PRESENT] = duration (frame_end,
+                                                               first_time (timings->presentation_time,
+                                                                           timings->drawn_time,
+                                                                           0));
+
+  record->dropped = count_dropped (stats, timings);
+
+  stats->n_frames++;
+  stats->n_dropped += record->dropped;
+
+  for (i = 0; i < GDK_FRAME_STATS_N_PHASES; i++)
+    {
+      if (record->durations[i] < 0)
+        continue;
+
+      stats->total[i] += record->durations[i];
+      stats->count[i]++;
+      stats->max[i] = MAX (stats->max[i], record->durations[i]);
+    }
+
+  stats->last_frame_counter = timings->frame_counter;
+  stats->last_presentation_time = timings->presentation_time;
+}
+
+guint
+gdk_frame_stats_get_n_records (const GdkFrameStats *stats)
+{
+  return stats->n_records;
+}
+
+/*
+ * gdk_frame_stats_get_record:
+ * @stats: a `GdkFrameStats`
+ * @i: the index of the record, 0 being the oldest
+ *
+ * Returns: the record
+ */
+const GdkFrameRecord *
+gdk_frame_stats_get_record (const GdkFrameStats *stats,
+                            guint                i)
+{
+  g_return_val_if_fail (i < stats->n_records, NULL);
+
+  return &stats->records[(stats->first + i) % GDK_FRAME_STATS_HISTORY];
+}
+
+/*
+ * gdk_frame_stats_get_average:
+ * @stats: a `GdkFrameStats`
+ * @phase: the phase
+ *
+ * Returns: the average duration of @phase over all frames
+ *   it happened in, in µs
+ */
+double
+gdk_frame_stats_get_average (const GdkFrameStats *stats,
+                             GdkFrameStatsPhase   phase)
+{
+  if (stats->count[phase] == 0)
+    return 0;
+
+  return (double) stats->total[phase] / stats->count[phase];
+}
+
+/*
+ * gdk_frame_stats_print:
+ * @stats: a `GdkFrameStats`
+ * @label: a name for the frame clock
+ * @string: the string to append to
+ *
+ * Prints a summary of @stats, followed by the durations of the
+ * recorded frames as comma-separated values, in µs.
+ */
+void
+gdk_frame_stats_print (const GdkFrameStats *stats,
+                       const char          *label,
+                       GString             *string)
+{
+  guint i, j;
+
+  g_string_append_printf (string, "# %s\n", label);
+  g_string_append_printf (string, "# frames: %" G_GUINT64_FORMAT ", dropped: %" G_GUINT64_FORMAT "\n",
+                          stats->n_frames, stats->n_dropped);
+
+  for (i = 0; i < GDK_FRAME_STATS_N_PHASES; i++)
+    {
+      g_string_append_printf (string, "# %-8s avg %7.2f ms  max %7.2f ms\n",
+                              phase_names[i],
+                              gdk_frame_stats_get_average (stats, i) / 1000.,
+                              stats->max[i] / 1000.);
+    }
+
+  g_string_append (string, "frame,time");
+  for (i = 0; i < GDK_FRAME_STATS_N_PHASES; i++)
+    g_string_append_printf (string, ",%s", phase_names[i]);
+  g_string_append (string, ",dropped\n");
+
+  for (i = 0; i < stats->n_records; i++)
+    {
+      const GdkFrameRecord *record = gdk_frame_stats_get_record (stats, i);
+
+      g_string_append_printf (string, "%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT,
+                              record->frame_counter, record->frame_time);
+      for (j = 0; j < GDK_FRAME_STATS_N_PHASES; j++)
+        {
+          if (record->durations[j] < 0)
+            g_string_append_c (string, ',');
+          else
+            g_string_append_printf (string, ",%d", record->durations[j]);
+        }
+      g_string_append_printf (string, ",%u\n", record->dropped);
+    }
+
+  g_string_append_c (string, '\n');
+}
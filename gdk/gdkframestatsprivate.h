@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gdk/gdkframeclock.h>
+
+G_BEGIN_DECLS
+
+#define GDK_FRAME_STATS_N_PHASES (GDK_FRAME_STATS_PHASE_PRESENT + 1)
+
+/* enough for 4s at 60Hz */
+#define GDK_FRAME_STATS_HISTORY 256
+
+typedef struct _GdkFrameRecord GdkFrameRecord;
+typedef struct _GdkFrameStats GdkFrameStats;
+
+struct _GdkFrameRecord
+{
+  gint64 frame_counter;
+  gint64 frame_time;
+  /* in µs, or -1 if the phase did not happen */
+  gint32 durations[GDK_FRAME_STATS_N_PHASES];
+  /* refresh cycles missed before this frame was presented */
+  guint dropped;
+};
+
+struct _GdkFrameStats
+{
+  /* ring buffer of the last frames */
+  GdkFrameRecord records[GDK_FRAME_STATS_HISTORY];
+  guint first;
+  guint n_records;
+
+  guint64 n_frames;
+  guint64 n_dropped;
+
+  gint64 total[GDK_FRAME_STATS_N_PHASES];
+  guint64 count[GDK_FRAME_STATS_N_PHASES];
+  gint32 max[GDK_FRAME_STATS_N_PHASES];
+
+  gint64 last_frame_counter;
+  gint64 last_presentation_time;
+};
+
+GdkFrameStats *         gdk_frame_stats_new                     (void);
+void                    gdk_frame_stats_free                    (GdkFrameStats          *stats);
+
+void                    gdk_frame_stats_add                     (GdkFrameStats          *stats,
+                                                                 GdkFrameTimings        *timings);
+
+guint                   gdk_frame_stats_get_n_records           (const GdkFrameStats    *stats);
+const GdkFrameRecord *  gdk_frame_stats_get_record              (const GdkFrameStats    *stats,
+                                                                 guint                   i);
+double                  gdk_frame_stats_get_average             (const GdkFrameStats    *stats,
+                                                                 GdkFrameStatsPhase      phase);
+
+void                    gdk_frame_stats_print                   (const GdkFrameStats    *stats,
+                                                                 const char             *label,
+                                                                 GString                *string);
+
+G_END_DECLS
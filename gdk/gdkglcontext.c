@@ -107,6 +107,8 @@ static const GdkDebugKey gdk_gl_feature_keys[] = {
   { "debug", GDK_GL_FEATURE_DEBUG, "GL_KHR_debug" },
   { "base-instance", GDK_GL_FEATURE_BASE_INSTANCE, "GL_ARB_base_instance" },
   { "buffer-storage", GDK_GL_FEATURE_BUFFER_STORAGE, "GL_EXT_buffer_storage" },
+  { "program-binary", GDK_GL_FEATURE_PROGRAM_BINARY, "GL_ARB_get_program_binary" },
+  { "parallel-shader-compile", GDK_GL_FEATURE_PARALLEL_SHADER_COMPILE, "GL_KHR_parallel_shader_compile" },
 };
 
 typedef struct _GdkGLContextPrivate GdkGLContextPrivate;
@@ -1696,6 +1698,13 @@ gdk_gl_context_check_features (GdkGLContext *context)
       epoxy_has_gl_extension ("GL_ARB_buffer_storage"))
     features |= GDK_GL_FEATURE_BUFFER_STORAGE;
 
+  if (gdk_gl_context_check_version (context, "4.1", "3.0") ||
+      epoxy_has_gl_extension ("GL_ARB_get_program_binary"))
+    features |= GDK_GL_FEATURE_PROGRAM_BINARY;
+
+  if (epoxy_has_gl_extension ("GL_KHR_parallel_shader_compile"))
+    features |= GDK_GL_FEATURE_PARALLEL_SHADER_COMPILE;
+
   return features;
 }
 
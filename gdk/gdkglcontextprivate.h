@@ -31,6 +31,8 @@ typedef enum {
   GDK_GL_FEATURE_DEBUG                      = 1 << 0,
   GDK_GL_FEATURE_BASE_INSTANCE              = 1 << 1,
   GDK_GL_FEATURE_BUFFER_STORAGE             = 1 << 2,
+  GDK_GL_FEATURE_PROGRAM_BINARY             = 1 << 3,
+  GDK_GL_FEATURE_PARALLEL_SHADER_COMPILE    = 1 << 4,
 } GdkGLFeatures;
 
 typedef enum {
@@ -2560,6 +2560,14 @@ gdk_surface_set_frame_clock (GdkSurface     *surface,
 
       if (surface->update_freeze_count == 0)
         _gdk_frame_clock_inhibit_freeze (clock);
+
+      /* popups share the frame clock of their parent */
+      if (surface->parent == NULL)
+        {
+          char *label = g_strdup_printf ("%s %p", G_OBJECT_TYPE_NAME (surface), surface);
+          gdk_frame_clock_set_label (clock, label);
+          g_free (label);
+        }
     }
 
   if (surface->frame_clock)
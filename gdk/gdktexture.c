@@ -780,6 +780,103 @@ gdk_texture_new_from_filename (const char  *path,
   return texture;
 }
 
+/**
+ * gdk_texture_new_from_bytes_at_size:
+ * @bytes: a `GBytes` containing the data to load
+ * @width: the width that is needed, or -1
+ * @height: the height that is needed, or -1
+ * @error: Return location for an error
+ *
+ * Creates a new texture by loading an image from memory, decoding
+ * it at a reduced size if the image is larger than needed.
+ *
+ * The returned texture keeps the aspect ratio of the image and is at
+ * least @width x @height pixels, unless the image itself is smaller.
+ * It is usually somewhat larger than requested, because decoders can
+ * only scale down by certain factors. Formats that don't support
+ * decoding at reduced size are loaded at their full size.
+ *
+ * Decoding at reduced size is much faster and uses a lot less memory
+ * than loading a full-size image and scaling it down when rendering,
+ * which makes this the right choice for thumbnails and photo grids.
+ *
+ * Use [func@Gdk.Texture.get_size_from_bytes] to find the full size
+ * of the image.
+ *
+ * This function is threadsafe, so that you can e.g. use GTask
+ * and [method@Gio.Task.run_in_thread] to avoid blocking the main thread
+ * while loading a big image.
+ *
+ * Return value: A newly-created `GdkTexture`
+ *
+ * Since: 4.18
+ */
+GdkTexture *
+gdk_texture_new_from_bytes_at_size (GBytes  *bytes,
+                                    int      width,
+                                    int      height,
+                                    GError **error)
+{
+  GdkTexture *texture;
+  GError *internal_error = NULL;
+
+  g_return_val_if_fail (bytes != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (gdk_is_png (bytes))
+    texture = gdk_load_png_at_size (bytes, NULL, width, height, &internal_error);
+  else if (gdk_is_jpeg (bytes))
+    texture = gdk_load_jpeg_at_size (bytes, width, height, &internal_error);
+  else
+    return gdk_texture_new_from_bytes (bytes, error);
+
+  if (texture)
+    return texture;
+
+  if (!g_error_matches (internal_error, GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_UNSUPPORTED_CONTENT))
+    {
+      g_propagate_error (error, internal_error);
+      return NULL;
+    }
+
+  g_clear_error (&internal_error);
+
+  return gdk_texture_new_from_bytes_pixbuf (bytes, error);
+}
+
+/**
+ * gdk_texture_get_size_from_bytes:
+ * @bytes: a `GBytes` containing image data
+ * @width: (out): return location for the width
+ * @height: (out): return location for the height
+ *
+ * Determines the size of the image in @bytes without decoding it.
+ *
+ * This only looks at the image header and is cheap. It works for
+ * the formats that [ctor@Gdk.Texture.new_from_bytes_at_size] can
+ * decode at reduced size.
+ *
+ * Returns: %TRUE if the size could be determined
+ *
+ * Since: 4.18
+ */
+gboolean
+gdk_texture_get_size_from_bytes (GBytes *bytes,
+                                 int    *width,
+                                 int    *height)
+{
+  g_return_val_if_fail (bytes != NULL, FALSE);
+  g_return_val_if_fail (width != NULL, FALSE);
+  g_return_val_if_fail (height != NULL, FALSE);
+
+  if (gdk_is_png (bytes))
+    return gdk_png_get_size (bytes, width, height);
+  else if (gdk_is_jpeg (bytes))
+    return gdk_jpeg_get_size (bytes, width, height);
+
+  return FALSE;
+}
+
 /**
  * gdk_texture_get_width:
  * @texture: a `GdkTexture`
@@ -75,6 +75,15 @@ GdkTexture *            gdk_texture_new_from_filename          (const char
 GDK_AVAILABLE_IN_4_6
 GdkTexture *            gdk_texture_new_from_bytes             (GBytes          *bytes,
                                                                 GError         **error);
+GDK_AVAILABLE_IN_4_18
+GdkTexture *            gdk_texture_new_from_bytes_at_size     (GBytes          *bytes,
+                                                                int              width,
+                                                                int              height,
+                                                                GError         **error);
+GDK_AVAILABLE_IN_4_18
+gboolean                gdk_texture_get_size_from_bytes        (GBytes          *bytes,
+                                                                int             *width,
+                                                                int             *height);
 
 GDK_AVAILABLE_IN_ALL
 int                     gdk_texture_get_width                  (GdkTexture      *texture) G_GNUC_PURE;
@@ -108,12 +108,78 @@ convert_cmyk_to_rgba (guchar *data,
     }
 }
 
+/* libjpeg can scale by n/8 while decoding, which is a lot cheaper
+ * than decoding the full image. Pick the smallest n that still gives
+ * us at least the requested size.
+ */
+static int
+find_scale_num (guint image_width,
+                guint image_height,
+                int   width,
+                int   height)
+{
+  int n;
+
+  for (n = 1; n < 8; n++)
+    {
+      if ((width <= 0 || (int) ((image_width * n + 7) / 8) >= width) &&
+          (height <= 0 || (int) ((image_height * n + 7) / 8) >= height))
+        break;
+    }
+
+  return n;
+}
+
 /* }}} */
 /* {{{ Public API */
 
 GdkTexture *
 gdk_load_jpeg (GBytes  *input_bytes,
                GError **error)
+{
+  return gdk_load_jpeg_at_size (input_bytes, -1, -1, error);
+}
+
+gboolean
+gdk_jpeg_get_size (GBytes *input_bytes,
+                   int    *width,
+                   int    *height)
+{
+  struct jpeg_decompress_struct info;
+  struct error_handler_data jerr;
+
+  info.err = jpeg_std_error (&jerr.pub);
+  jerr.pub.error_exit = fatal_error_handler;
+  jerr.pub.output_message = output_message_handler;
+  jerr.error = NULL;
+
+  if (sigsetjmp (jerr.setjmp_buffer, 1))
+    {
+      jpeg_destroy_decompress (&info);
+      return FALSE;
+    }
+
+  jpeg_create_decompress (&info);
+
+  jpeg_mem_src (&info,
+                g_bytes_get_data (input_bytes, NULL),
+                g_bytes_get_size (input_bytes));
+
+  jpeg_read_header (&info, TRUE);
+
+  *width = info.image_width;
+  *height = info.image_height;
+
+  jpeg_destroy_decompress (&info);
+
+  return TRUE;
+}
+
+GdkTexture *
+gdk_load_jpeg_at_size (GBytes  *input_bytes,
+                       int      requested_width,
+                       int      requested_height,
+                       GError **error)
 {
   struct jpeg_decompress_struct info;
   struct error_handler_data jerr;
@@ -149,6 +215,14 @@ gdk_load_jpeg (GBytes  *input_bytes,
                 g_bytes_get_size (input_bytes));
 
   jpeg_read_header (&info, TRUE);
+
+  if (requested_width > 0 || requested_height > 0)
+    {
+      info.scale_num = find_scale_num (info.image_width, info.image_height,
+                                       requested_width, requested_height);
+      info.scale_denom = 8;
+    }
+
   jpeg_start_decompress (&info);
 
   width = info.output_width;
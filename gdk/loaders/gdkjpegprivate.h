@@ -24,6 +24,13 @@
 
 GdkTexture *gdk_load_jpeg         (GBytes           *bytes,
                                    GError          **error);
+GdkTexture *gdk_load_jpeg_at_size (GBytes           *bytes,
+                                   int               width,
+                                   int               height,
+                                   GError          **error);
+gboolean    gdk_jpeg_get_size     (GBytes           *bytes,
+                                   int              *width,
+                                   int              *height);
 
 GBytes     *gdk_save_jpeg         (GdkTexture     *texture);
 
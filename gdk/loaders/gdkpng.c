@@ -23,12 +23,15 @@
 #include "gdkcolorstateprivate.h"
 #include "gdkmemoryformatprivate.h"
 #include "gdkmemorytexturebuilder.h"
+#include "gdkparalleltaskprivate.h"
 #include "gdkprofilerprivate.h"
 #include "gdktexturedownloaderprivate.h"
 #include "gsk/gl/fp16private.h"
 
 #include <png.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <zlib.h>
 
 /* The main difference between the png load/save code here and
  * gdk-pixbuf is that we can support loading 16-bit data in the
@@ -263,6 +266,675 @@ gdk_png_set_color_state (png_struct    *png,
     png_set_sRGB (png, info, PNG_sRGB_INTENT_PERCEPTUAL);
 }
 
+/* }}} */
+/* {{{ Downscaling */
+
+/* When a smaller size is requested, we read the image row by row
+ * and box-filter it by an integer factor, so the full size image
+ * never needs to be in memory. That doesn't work for interlaced
+ * images, which libpng can only deliver as a whole.
+ */
+
+static int
+find_downscale_factor (guint width,
+                       guint height,
+                       int   requested_width,
+                       int   requested_height)
+{
+  guint factor = G_MAXUINT;
+
+  if (requested_width > 0)
+    factor = MIN (factor, width / requested_width);
+  if (requested_height > 0)
+    factor = MIN (factor, height / requested_height);
+
+  if (factor == G_MAXUINT || factor < 1)
+    return 1;
+
+  return MIN (factor, G_MAXINT);
+}
+
+static inline guint
+read_channel (const guchar *row,
+              gsize         index,
+              int           depth)
+{
+  if (depth == 8)
+    return row[index];
+  else
+    return ((const guint16 *) row)[index];
+}
+
+static inline void
+write_channel (guchar  *row,
+               gsize    index,
+               int      depth,
+               guint64  value)
+{
+  if (depth == 8)
+    row[index] = value;
+  else
+    ((guint16 *) row)[index] = value;
+}
+
+static void
+downscale_accumulate (guint64      *acc,
+                      const guchar *row,
+                      gsize         width,
+                      int           n_channels,
+                      int           depth,
+                      gboolean      has_alpha,
+                      int           factor)
+{
+  gsize x;
+  int c;
+
+  for (x = 0; x < width; x++)
+    {
+      guint64 *dest = acc + (x / factor) * n_channels;
+
+      /* Weigh colors by alpha, so transparent pixels don't bleed */
+      if (has_alpha)
+        {
+          guint alpha = read_channel (row, x * n_channels + n_channels - 1, depth);
+
+          for (c = 0; c < n_channels - 1; c++)
+            dest[c] += (guint64) read_channel (row, x * n_channels + c, depth) * alpha;
+          dest[n_channels - 1] += alpha;
+        }
+      else
+        {
+          for (c = 0; c < n_channels; c++)
+            dest[c] += read_channel (row, x * n_channels + c, depth);
+        }
+    }
+}
+
+static void
+downscale_emit (guchar        *out,
+                const guint64 *acc,
+                gsize          width,
+                gsize          out_width,
+                int            n_channels,
+                int            depth,
+                gboolean       has_alpha,
+                int            factor,
+                int            n_rows)
+{
+  gsize x;
+  int c;
+
+  for (x = 0; x < out_width; x++)
+    {
+      const guint64 *src = acc + x * n_channels;
+      guint64 count = MIN ((gsize) factor, width - x * factor) * n_rows;
+
+      if (has_alpha)
+        {
+          guint64 alpha = src[n_channels - 1];
+
+          for (c = 0; c < n_channels - 1; c++)
+            write_channel (out, x * n_channels + c, depth,
+                           alpha ? (src[c] + alpha / 2) / alpha : 0);
+          write_channel (out, x * n_channels + n_channels - 1, depth,
+                         (alpha + count / 2) / count);
+        }
+      else
+        {
+          for (c = 0; c < n_channels; c++)
+            write_channel (out, x * n_channels + c, depth,
+                           (src[c] + count / 2) / count);
+        }
+    }
+}
+
+/* }}} */
+/* {{{ Saving */
+
+static GdkMemoryFormat
+gdk_png_get_save_format (GdkMemoryFormat  format,
+                         int             *png_format,
+                         int             *depth)
+{
+  switch (format)
+    {
+    case GDK_MEMORY_B8G8R8A8_PREMULTIPLIED:
+    case GDK_MEMORY_A8R8G8B8_PREMULTIPLIED:
+    case GDK_MEMORY_R8G8B8A8_PREMULTIPLIED:
+    case GDK_MEMORY_A8B8G8R8_PREMULTIPLIED:
+    case GDK_MEMORY_B8G8R8A8:
+    case GDK_MEMORY_A8R8G8B8:
+    case GDK_MEMORY_R8G8B8A8:
+    case GDK_MEMORY_A8B8G8R8:
+      format = GDK_MEMORY_R8G8B8A8;
+      *png_format = PNG_COLOR_TYPE_RGB_ALPHA;
+      *depth = 8;
+      break;
+
+    case GDK_MEMORY_R8G8B8:
+    case GDK_MEMORY_B8G8R8:
+    case GDK_MEMORY_R8G8B8X8:
+    case GDK_MEMORY_X8R8G8B8:
+    case GDK_MEMORY_B8G8R8X8:
+    case GDK_MEMORY_X8B8G8R8:
+      format = GDK_MEMORY_R8G8B8;
+      *png_format = PNG_COLOR_TYPE_RGB;
+      *depth = 8;
+      break;
+
+    case GDK_MEMORY_R16G16B16A16:
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+    case GDK_MEMORY_R16G16B16A16_FLOAT:
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+    case GDK_MEMORY_R32G32B32A32_FLOAT:
+    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
+      format = GDK_MEMORY_R16G16B16A16;
+      *png_format = PNG_COLOR_TYPE_RGB_ALPHA;
+      *depth = 16;
+      break;
+
+    case GDK_MEMORY_R16G16B16:
+    case GDK_MEMORY_R16G16B16_FLOAT:
+    case GDK_MEMORY_R32G32B32_FLOAT:
+      format = GDK_MEMORY_R16G16B16;
+      *png_format = PNG_COLOR_TYPE_RGB;
+      *depth = 16;
+      break;
+
+    case GDK_MEMORY_G8:
+      format = GDK_MEMORY_G8;
+      *png_format = PNG_COLOR_TYPE_GRAY;
+      *depth = 8;
+      break;
+
+    case GDK_MEMORY_G8A8_PREMULTIPLIED:
+    case GDK_MEMORY_G8A8:
+    case GDK_MEMORY_A8:
+      format = GDK_MEMORY_G8A8;
+      *png_format = PNG_COLOR_TYPE_GRAY_ALPHA;
+      *depth = 8;
+      break;
+
+    case GDK_MEMORY_G16:
+      format = GDK_MEMORY_G16;
+      *png_format = PNG_COLOR_TYPE_GRAY;
+      *depth = 16;
+      break;
+
+    case GDK_MEMORY_G16A16_PREMULTIPLIED:
+    case GDK_MEMORY_G16A16:
+    case GDK_MEMORY_A16:
+    case GDK_MEMORY_A16_FLOAT:
+    case GDK_MEMORY_A32_FLOAT:
+      format = GDK_MEMORY_G16A16;
+      *png_format = PNG_COLOR_TYPE_GRAY_ALPHA;
+      *depth = 16;
+      break;
+
+    case GDK_MEMORY_N_FORMATS:
+    default:
+      g_assert_not_reached ();
+    }
+
+  return format;
+}
+
+/* Instead of going through libpng row by row, we filter and compress
+ * the image ourselves, so that the work can be spread over threads.
+ *
+ * First all rows are filtered, in parallel. The filtered data is then
+ * cut into blocks that are deflated independently, each one primed
+ * with the 32kB of data preceding it. Every block but the last ends
+ * with a sync flush, so the raw deflate streams simply concatenate to
+ * a single zlib stream, and a block can be written out as an IDAT chunk
+ * as soon as it and all blocks before it are done.
+ */
+
+#define PNG_BLOCK_SIZE (256 * 1024)
+#define PNG_WINDOW_SIZE 32768
+#define PNG_FILTER_ROWS 16
+
+typedef struct
+{
+  gsize start;
+  gsize size;
+  uLong adler;
+
+  guchar *data;
+  gsize data_size;
+  gboolean done;
+} PngBlock;
+
+typedef struct
+{
+  const guchar *pixels;
+  gsize stride;
+  gsize row_size;
+  gsize bpp;
+  gsize height;
+  gboolean swap;
+  GdkPngFilter filter;
+  int level;
+  int strategy;
+
+  guchar *zero_row;
+  guchar *filtered;
+  /* atomic */ int rows_done;
+
+  PngBlock *blocks;
+  gsize n_blocks;
+  /* atomic */ int blocks_started;
+
+  GOutputStream *stream;
+  GCancellable *cancellable;
+
+  GMutex lock;
+  gsize next_block;
+  gboolean writing;
+  uLong adler;
+  GError *error;
+  /* atomic */ int failed;
+} PngEncoder;
+
+static void
+png_encoder_take_error (PngEncoder *enc,
+                        GError     *error)
+{
+  g_mutex_lock (&enc->lock);
+
+  if (enc->error == NULL)
+    enc->error = error;
+  else
+    g_error_free (error);
+
+  g_atomic_int_set (&enc->failed, TRUE);
+
+  g_mutex_unlock (&enc->lock);
+}
+
+static gboolean
+png_encoder_write (PngEncoder *enc,
+                   const void *data,
+                   gsize       size)
+{
+  GError *error = NULL;
+
+  if (!g_output_stream_write_all (enc->stream, data, size, NULL, enc->cancellable, &error))
+    {
+      png_encoder_take_error (enc, error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+png_encoder_write_chunk (PngEncoder   *enc,
+                         const char   *type,
+                         const guchar *data,
+                         gsize         size)
+{
+  guchar header[8];
+  guchar footer[4];
+  uLong crc;
+
+  png_save_uint_32 (header, size);
+  memcpy (header + 4, type, 4);
+
+  crc = crc32 (0, header + 4, 4);
+  if (size > 0)
+    crc = crc32 (crc, data, size);
+  png_save_uint_32 (footer, crc);
+
+  return png_encoder_write (enc, header, sizeof (header)) &&
+         (size == 0 || png_encoder_write (enc, data, size)) &&
+         png_encoder_write (enc, footer, sizeof (footer));
+}
+
+static inline guchar
+paeth_predictor (guchar a,
+                 guchar b,
+                 guchar c)
+{
+  int p = a + b - c;
+  int pa = abs (p - a);
+  int pb = abs (p - b);
+  int pc = abs (p - c);
+
+  if (pa <= pb && pa <= pc)
+    return a;
+  else if (pb <= pc)
+    return b;
+  else
+    return c;
+}
+
+static void
+png_filter_row (GdkPngFilter  filter,
+                guchar       *dest,
+                const guchar *row,
+                const guchar *prev,
+                gsize         row_size,
+                gsize         bpp)
+{
+  gsize i;
+
+  switch (filter)
+    {
+    case GDK_PNG_FILTER_NONE:
+      memcpy (dest, row, row_size);
+      break;
+
+    case GDK_PNG_FILTER_SUB:
+      for (i = 0; i < bpp; i++)
+        dest[i] = row[i];
+      for (; i < row_size; i++)
+        dest[i] = row[i] - row[i - bpp];
+      break;
+
+    case GDK_PNG_FILTER_UP:
+      for (i = 0; i < row_size; i++)
+        dest[i] = row[i] - prev[i];
+      break;
+
+    case GDK_PNG_FILTER_AVERAGE:
+      for (i = 0; i < bpp; i++)
+        dest[i] = row[i] - (prev[i] >> 1);
+      for (; i < row_size; i++)
+        dest[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+      break;
+
+    case GDK_PNG_FILTER_PAETH:
+      for (i = 0; i < bpp; i++)
+        dest[i] = row[i] - prev[i];
+      for (; i < row_size; i++)
+        dest[i] = row[i] - paeth_predictor (row[i - bpp], prev[i], prev[i - bpp]);
+      break;
+
+    case GDK_PNG_FILTER_ADAPTIVE:
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+/* The usual heuristic: values close to 0 compress well */
+static gsize
+png_filter_cost (const guchar *data,
+                 gsize         size)
+{
+  gsize i, cost;
+
+  cost = 0;
+  for (i = 0; i < size; i++)
+    cost += abs ((signed char) data[i]);
+
+  return cost;
+}
+
+static const guchar *
+png_encoder_get_row (PngEncoder *enc,
+                     gsize       y,
+                     guchar     *scratch)
+{
+  const guchar *row = enc->pixels + y * enc->stride;
+  gsize i;
+
+  if (!enc->swap)
+    return row;
+
+  /* png wants 16bit values in big endian */
+  for (i = 0; i + 1 < enc->row_size; i += 2)
+    {
+      scratch[i] = row[i + 1];
+      scratch[i + 1] = row[i];
+    }
+
+  return scratch;
+}
+
+static void
+png_encoder_filter_rows (gpointer data)
+{
+  PngEncoder *enc = data;
+  guchar *row_buffer, *prev_buffer, *best, *trial, *tmp;
+  const guchar *row, *prev;
+  gsize y, end;
+
+  row_buffer = g_malloc (enc->row_size);
+  prev_buffer = g_malloc (enc->row_size);
+  best = g_malloc (enc->row_size);
+  trial = g_malloc (enc->row_size);
+
+  for (y = g_atomic_int_add (&enc->rows_done, PNG_FILTER_ROWS);
+       y < enc->height;
+       y = g_atomic_int_add (&enc->rows_done, PNG_FILTER_ROWS))
+    {
+      end = MIN (y + PNG_FILTER_ROWS, enc->height);
+
+      if (y > 0)
+        prev = png_encoder_get_row (enc, y - 1, prev_buffer);
+      else
+        prev = enc->zero_row;
+
+      for (; y < end; y++)
+        {
+          guchar *dest = enc->filtered + y * (enc->row_size + 1);
+
+          row = png_encoder_get_row (enc, y, row_buffer);
+
+          if (enc->filter == GDK_PNG_FILTER_ADAPTIVE)
+            {
+              GdkPngFilter filter, best_filter;
+              gsize cost, best_cost;
+
+              best_filter = GDK_PNG_FILTER_NONE;
+              best_cost = G_MAXSIZE;
+
+              for (filter = GDK_PNG_FILTER_NONE; filter < GDK_PNG_FILTER_ADAPTIVE; filter++)
+                {
+                  png_filter_row (filter, trial, row, prev, enc->row_size, enc->bpp);
+                  cost = png_filter_cost (trial, enc->row_size);
+                  if (cost < best_cost)
+                    {
+                      best_filter = filter;
+                      best_cost = cost;
+                      tmp = best;
+                      best = trial;
+                      trial = tmp;
+                    }
+                }
+
+              dest[0] = best_filter;
+              memcpy (dest + 1, best, enc->row_size);
+            }
+          else
+            {
+              dest[0] = enc->filter;
+              png_filter_row (enc->filter, dest + 1, row, prev, enc->row_size, enc->bpp);
+            }
+
+          /* keep the current row around as the previous one */
+          tmp = prev_buffer;
+          prev_buffer = row_buffer;
+          row_buffer = tmp;
+          prev = row;
+        }
+    }
+
+  g_free (row_buffer);
+  g_free (prev_buffer);
+  g_free (best);
+  g_free (trial);
+}
+
+static void
+png_zlib_header (guchar *header,
+                 int     level)
+{
+  int flevel;
+
+  if (level == Z_DEFAULT_COMPRESSION || level == 6)
+    flevel = 2;
+  else if (level < 2)
+    flevel = 0;
+  else if (level < 6)
+    flevel = 1;
+  else
+    flevel = 3;
+
+  /* deflate with a 32kB window, no preset dictionary */
+  header[0] = 0x78;
+  header[1] = flevel << 6;
+  header[1] += 31 - (header[0] * 256 + header[1]) % 31;
+}
+
+static gboolean
+png_encoder_deflate_block (PngEncoder *enc,
+                           gsize       i)
+{
+  PngBlock *block = &enc->blocks[i];
+  z_stream z = { 0, };
+  gsize offset, dict_size, alloc, used;
+  guchar *data;
+  int ret = Z_STREAM_ERROR;
+
+  if (deflateInit2 (&z, enc->level, Z_DEFLATED, -15, 8, enc->strategy) != Z_OK)
+    return FALSE;
+
+  dict_size = MIN (block->start, PNG_WINDOW_SIZE);
+  if (dict_size > 0)
+    deflateSetDictionary (&z, enc->filtered + block->start - dict_size, dict_size);
+
+  /* Leave room for the zlib header in front of the first block
+   * and for the checksum behind the last one.
+   */
+  offset = i == 0 ? 2 : 0;
+  alloc = offset + deflateBound (&z, block->size) + 16 + 4;
+  block->data = g_try_malloc (alloc);
+  if (block->data == NULL)
+    {
+      deflateEnd (&z);
+      return FALSE;
+    }
+
+  if (i == 0)
+    png_zlib_header (block->data, enc->level);
+
+  z.next_in = enc->filtered + block->start;
+  z.avail_in = block->size;
+  z.next_out = block->data + offset;
+  z.avail_out = alloc - offset - 4;
+
+  do
+    {
+      if (z.avail_out == 0)
+        {
+          used = z.next_out - block->data;
+          alloc *= 2;
+          data = g_try_realloc (block->data, alloc);
+          if (data == NULL)
+            {
+              ret = Z_MEM_ERROR;
+              break;
+            }
+
+          block->data = data;
+          z.next_out = data + used;
+          z.avail_out = alloc - used - 4;
+        }
+
+      ret = deflate (&z, i + 1 == enc->n_blocks ? Z_FINISH : Z_SYNC_FLUSH);
+    }
+  while (ret == Z_OK && (z.avail_in > 0 || z.avail_out == 0));
+
+  block->data_size = z.next_out - block->data;
+  block->adler = adler32 (adler32 (0, NULL, 0), enc->filtered + block->start, block->size);
+
+  deflateEnd (&z);
+
+  if (i + 1 == enc->n_blocks)
+    return ret == Z_STREAM_END;
+  else
+    return ret == Z_OK && z.avail_in == 0;
+}
+
+static void
+png_encoder_write_block (PngEncoder *enc,
+                         gsize       i)
+{
+  PngBlock *block = &enc->blocks[i];
+
+  enc->adler = adler32_combine (enc->adler, block->adler, block->size);
+
+  if (i + 1 == enc->n_blocks)
+    {
+      png_save_uint_32 (block->data + block->data_size, enc->adler);
+      block->data_size += 4;
+    }
+
+  png_encoder_write_chunk (enc, "IDAT", block->data, block->data_size);
+}
+
+static void
+png_encoder_block_done (PngEncoder *enc,
+                        gsize       i)
+{
+  g_mutex_lock (&enc->lock);
+
+  enc->blocks[i].done = TRUE;
+
+  /* Somebody else is writing, they'll pick up this block */
+  if (enc->writing)
+    {
+      g_mutex_unlock (&enc->lock);
+      return;
+    }
+
+  enc->writing = TRUE;
+
+  while (enc->next_block < enc->n_blocks && enc->blocks[enc->next_block].done)
+    {
+      i = enc->next_block;
+
+      g_mutex_unlock (&enc->lock);
+
+      if (!g_atomic_int_get (&enc->failed))
+        png_encoder_write_block (enc, i);
+      g_clear_pointer (&enc->blocks[i].data, g_free);
+
+      g_mutex_lock (&enc->lock);
+
+      enc->next_block++;
+    }
+
+  enc->writing = FALSE;
+
+  g_mutex_unlock (&enc->lock);
+}
+
+static void
+png_encoder_deflate_blocks (gpointer data)
+{
+  PngEncoder *enc = data;
+  gsize i;
+
+  for (i = g_atomic_int_add (&enc->blocks_started, 1);
+       i < enc->n_blocks;
+       i = g_atomic_int_add (&enc->blocks_started, 1))
+    {
+      GError *error = NULL;
+
+      if (g_cancellable_set_error_if_cancelled (enc->cancellable, &error))
+        png_encoder_take_error (enc, error);
+      else if (!g_atomic_int_get (&enc->failed) &&
+               !png_encoder_deflate_block (enc, i))
+        png_encoder_take_error (enc, g_error_new_literal (G_IO_ERROR, G_IO_ERROR_FAILED,
+                                                          _("Failed to compress image data")));
+
+      png_encoder_block_done (enc, i);
+    }
+}
+
 /* }}} */
 /* {{{ Public API */
 
@@ -270,6 +942,43 @@ GdkTexture *
 gdk_load_png (GBytes      *bytes,
               GHashTable  *options,
               GError     **error)
+{
+  return gdk_load_png_at_size (bytes, options, -1, -1, error);
+}
+
+gboolean
+gdk_png_get_size (GBytes *bytes,
+                  int    *width,
+                  int    *height)
+{
+  const guchar *data;
+  gsize size;
+  guint32 w, h;
+
+  data = g_bytes_get_data (bytes, &size);
+
+  /* The IHDR chunk must come first, right after the signature */
+  if (size < 24 || memcmp (data + 12, "IHDR", 4) != 0)
+    return FALSE;
+
+  w = ((guint32) data[16] << 24) | (data[17] << 16) | (data[18] << 8) | data[19];
+  h = ((guint32) data[20] << 24) | (data[21] << 16) | (data[22] << 8) | data[23];
+
+  if (w == 0 || h == 0 || w > G_MAXINT || h > G_MAXINT)
+    return FALSE;
+
+  *width = w;
+  *height = h;
+
+  return TRUE;
+}
+
+GdkTexture *
+gdk_load_png_at_size (GBytes      *bytes,
+                      GHashTable  *options,
+                      int          requested_width,
+                      int          requested_height,
+                      GError     **error)
 {
   png_io io;
   png_struct *png = NULL;
@@ -277,13 +986,17 @@ gdk_load_png (GBytes      *bytes,
   png_textp text;
   int num_texts;
   guint width, height;
+  guint out_width, out_height;
   gsize i, stride;
   int depth, color_type;
   int interlace;
+  int factor, n_channels;
   GdkMemoryTextureBuilder *builder;
   GdkMemoryFormat format;
   guchar *buffer = NULL;
   guchar **row_pointers = NULL;
+  guchar *row = NULL;
+  guint64 *acc = NULL;
   GBytes *out_bytes;
   GdkColorState *color_state;
   GdkTexture *texture;
@@ -316,6 +1029,8 @@ gdk_load_png (GBytes      *bytes,
     {
       g_free (buffer);
       g_free (row_pointers);
+      g_free (row);
+      g_free (acc);
       png_destroy_read_struct (&png, &info, NULL);
       return NULL;
     }
@@ -412,8 +1127,17 @@ gdk_load_png (GBytes      *bytes,
   if (color_state == NULL)
     return NULL;
 
+  if (interlace == PNG_INTERLACE_NONE)
+    factor = find_downscale_factor (width, height, requested_width, requested_height);
+  else
+    factor = 1;
+
+  out_width = (width + factor - 1) / factor;
+  out_height = (height + factor - 1) / factor;
+
   bpp = gdk_memory_format_bytes_per_pixel (format);
-  if (!g_size_checked_mul (&stride, width, bpp) ||
+  n_channels = bpp / (depth / 8);
+  if (!g_size_checked_mul (&stride, out_width, bpp) ||
       !g_size_checked_add (&stride, stride, (8 - stride % 8) % 8))
     {
       g_set_error (error,
@@ -422,14 +1146,24 @@ gdk_load_png (GBytes      *bytes,
       return NULL;
     }
 
-  buffer = g_try_malloc_n (height, stride);
-  row_pointers = g_try_malloc_n (height, sizeof (char *));
+  buffer = g_try_malloc_n (out_height, stride);
+  if (factor == 1)
+    {
+      row_pointers = g_try_malloc_n (height, sizeof (char *));
+    }
+  else
+    {
+      row = g_try_malloc_n (width, bpp);
+      acc = g_try_new0 (guint64, (gsize) out_width * n_channels);
+    }
 
-  if (!buffer || !row_pointers)
+  if (!buffer || (factor == 1 ? !row_pointers : (!row || !acc)))
     {
       gdk_color_state_unref (color_state);
       g_free (buffer);
       g_free (row_pointers);
+      g_free (row);
+      g_free (acc);
       png_destroy_read_struct (&png, &info, NULL);
       g_set_error (error,
                    GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_TOO_LARGE,
@@ -437,18 +1171,43 @@ gdk_load_png (GBytes      *bytes,
       return NULL;
     }
 
-  for (i = 0; i < height; i++)
-    row_pointers[i] = &buffer[i * stride];
+  if (factor == 1)
+    {
+      for (i = 0; i < height; i++)
+        row_pointers[i] = &buffer[i * stride];
+
+      png_read_image (png, row_pointers);
+    }
+  else
+    {
+      gboolean has_alpha = (color_type & PNG_COLOR_MASK_ALPHA) != 0;
+
+      for (i = 0; i < height; i++)
+        {
+          png_read_row (png, row, NULL);
+          downscale_accumulate (acc, row, width, n_channels, depth, has_alpha, factor);
+
+          if ((i + 1) % factor == 0 || i + 1 == height)
+            {
+              downscale_emit (&buffer[(i / factor) * stride], acc,
+                              width, out_width, n_channels, depth, has_alpha,
+                              factor, i % factor + 1);
+              memset (acc, 0, sizeof (guint64) * out_width * n_channels);
+            }
+        }
+
+      g_clear_pointer (&row, g_free);
+      g_clear_pointer (&acc, g_free);
+    }
 
-  png_read_image (png, row_pointers);
   png_read_end (png, info);
 
-  out_bytes = g_bytes_new_take (buffer, height * stride);
+  out_bytes = g_bytes_new_take (buffer, out_height * stride);
   builder = gdk_memory_texture_builder_new ();
   gdk_memory_texture_builder_set_format (builder, format);
   gdk_memory_texture_builder_set_color_state (builder, color_state);
-  gdk_memory_texture_builder_set_width (builder, width);
-  gdk_memory_texture_builder_set_height (builder, height);
+  gdk_memory_texture_builder_set_width (builder, out_width);
+  gdk_memory_texture_builder_set_height (builder, out_height);
   gdk_memory_texture_builder_set_bytes (builder, out_bytes);
   gdk_memory_texture_builder_set_stride (builder, stride);
   texture = gdk_memory_texture_builder_build (builder);
@@ -480,8 +1239,193 @@ gdk_load_png (GBytes      *bytes,
   return texture;
 }
 
+/* Much faster than the defaults, and the files are only a bit bigger */
+const GdkPngSaveOptions gdk_png_save_options_fast = {
+  .compression_level = 1,
+  .filter = GDK_PNG_FILTER_SUB,
+  .parallel = TRUE,
+};
+
+gboolean
+gdk_save_png_to_stream (GdkTexture               *texture,
+                        GOutputStream            *stream,
+                        const GdkPngSaveOptions  *options,
+                        GCancellable             *cancellable,
+                        GError                  **error)
+{
+  static const GdkPngSaveOptions default_options = {
+    .compression_level = -1,
+    .filter = GDK_PNG_FILTER_ADAPTIVE,
+    .parallel = TRUE,
+  };
+  PngEncoder enc = { 0, };
+  GdkTextureDownloader downloader;
+  GdkColorState *color_state;
+  const GdkCicp *cicp;
+  GdkMemoryFormat format;
+  GBytes *bytes;
+  int width, height;
+  int png_format;
+  int depth;
+  guchar ihdr[13];
+  gsize rows_per_block, i;
+  gboolean parallel;
+  gint64 before = GDK_PROFILER_CURRENT_TIME;
+
+  if (options == NULL)
+    options = &default_options;
+
+  width = gdk_texture_get_width (texture);
+  height = gdk_texture_get_height (texture);
+  format = gdk_png_get_save_format (gdk_texture_get_format (texture),
+                                    &png_format, &depth);
+
+  /* Unsupported color states are converted to sRGB */
+  color_state = gdk_texture_get_color_state (texture);
+  cicp = gdk_color_state_get_cicp (color_state);
+  if (cicp == NULL)
+    color_state = GDK_COLOR_STATE_SRGB;
+
+  g_mutex_init (&enc.lock);
+  enc.stream = stream;
+  enc.cancellable = cancellable;
+  enc.adler = adler32 (0, NULL, 0);
+  enc.filter = options->filter;
+  enc.level = CLAMP (options->compression_level, -1, 9);
+  enc.strategy = enc.filter == GDK_PNG_FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+  enc.height = height;
+  enc.bpp = gdk_memory_format_bytes_per_pixel (format);
+  enc.row_size = width * enc.bpp;
+  enc.swap = depth == 16 && G_BYTE_ORDER == G_LITTLE_ENDIAN;
+
+  enc.filtered = g_try_malloc_n (height, enc.row_size + 1);
+  if (enc.filtered == NULL)
+    {
+      g_mutex_clear (&enc.lock);
+      g_set_error (error,
+                   GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_TOO_LARGE,
+                   _("Not enough memory for image size %ux%u"), width, height);
+      return FALSE;
+    }
+
+  parallel = options->parallel && height * (enc.row_size + 1) > PNG_BLOCK_SIZE;
+
+  gdk_texture_downloader_init (&downloader, texture);
+  gdk_texture_downloader_set_format (&downloader, format);
+  gdk_texture_downloader_set_color_state (&downloader, color_state);
+  bytes = gdk_texture_downloader_download_bytes (&downloader, &enc.stride);
+  gdk_texture_downloader_finish (&downloader);
+
+  enc.pixels = g_bytes_get_data (bytes, NULL);
+  enc.zero_row = g_malloc0 (enc.row_size);
+
+  if (parallel)
+    gdk_parallel_task_run (png_encoder_filter_rows, &enc);
+  else
+    png_encoder_filter_rows (&enc);
+
+  g_clear_pointer (&enc.zero_row, g_free);
+  g_bytes_unref (bytes);
+
+  png_save_uint_32 (ihdr, width);
+  png_save_uint_32 (ihdr + 4, height);
+  ihdr[8] = depth;
+  ihdr[9] = png_format;
+  ihdr[10] = PNG_COMPRESSION_TYPE_DEFAULT;
+  ihdr[11] = PNG_FILTER_TYPE_DEFAULT;
+  ihdr[12] = PNG_INTERLACE_NONE;
+
+  if (!png_encoder_write (&enc, "\x89PNG\r\n\x1a\n", 8) ||
+      !png_encoder_write_chunk (&enc, "IHDR", ihdr, sizeof (ihdr)))
+    goto out;
+
+  if (cicp)
+    {
+      guchar chunk_data[4];
+
+      chunk_data[0] = (guchar) cicp->color_primaries;
+      chunk_data[1] = (guchar) cicp->transfer_function;
+      chunk_data[2] = (guchar) 0; /* png only supports this */
+      chunk_data[3] = (guchar) cicp->range;
+
+      if (!png_encoder_write_chunk (&enc, "cICP", chunk_data, sizeof (chunk_data)))
+        goto out;
+    }
+
+  /* For good measure, we add an sRGB chunk too */
+  if (gdk_color_state_equal (color_state, GDK_COLOR_STATE_SRGB))
+    {
+      guchar intent = PNG_sRGB_INTENT_PERCEPTUAL;
+
+      if (!png_encoder_write_chunk (&enc, "sRGB", &intent, 1))
+        goto out;
+    }
+
+  rows_per_block = MAX (1, PNG_BLOCK_SIZE / (enc.row_size + 1));
+  enc.n_blocks = (height + rows_per_block - 1) / rows_per_block;
+  enc.blocks = g_new0 (PngBlock, enc.n_blocks);
+  for (i = 0; i < enc.n_blocks; i++)
+    {
+      enc.blocks[i].start = i * rows_per_block * (enc.row_size + 1);
+      enc.blocks[i].size = MIN (rows_per_block, height - i * rows_per_block) * (enc.row_size + 1);
+    }
+
+  if (parallel && enc.n_blocks > 1)
+    gdk_parallel_task_run (png_encoder_deflate_blocks, &enc);
+  else
+    png_encoder_deflate_blocks (&enc);
+
+  g_free (enc.blocks);
+
+  if (enc.error == NULL)
+    png_encoder_write_chunk (&enc, "IEND", NULL, 0);
+
+out:
+  g_free (enc.filtered);
+  g_mutex_clear (&enc.lock);
+
+  if (enc.error)
+    {
+      g_propagate_error (error, enc.error);
+      return FALSE;
+    }
+
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      gint64 end = GDK_PROFILER_CURRENT_TIME;
+      if (end - before > 500000)
+        gdk_profiler_add_mark (before, end - before, "Save png", NULL);
+    }
+
+  return TRUE;
+}
+
 GBytes *
 gdk_save_png (GdkTexture *texture)
+{
+  GOutputStream *stream;
+  GBytes *bytes;
+
+  stream = g_memory_output_stream_new_resizable ();
+
+  if (!gdk_save_png_to_stream (texture, stream, NULL, NULL, NULL))
+    {
+      g_object_unref (stream);
+      return NULL;
+    }
+
+  g_output_stream_close (stream, NULL, NULL);
+  bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (stream));
+  g_object_unref (stream);
+
+  return bytes;
+}
+
+/* The libpng based encoder. We keep it around as a reference to
+ * test and benchmark the encoder above against.
+ */
+GBytes *
+gdk_save_png_libpng (GdkTexture *texture)
 {
   png_struct *png = NULL;
   png_info *info;
@@ -501,87 +1445,8 @@ gdk_save_png (GdkTexture *texture)
   width = gdk_texture_get_width (texture);
   height = gdk_texture_get_height (texture);
   color_state = gdk_texture_get_color_state (texture);
-  format = gdk_texture_get_format (texture);
-
-  switch (format)
-    {
-    case GDK_MEMORY_B8G8R8A8_PREMULTIPLIED:
-    case GDK_MEMORY_A8R8G8B8_PREMULTIPLIED:
-    case GDK_MEMORY_R8G8B8A8_PREMULTIPLIED:
-    case GDK_MEMORY_A8B8G8R8_PREMULTIPLIED:
-    case GDK_MEMORY_B8G8R8A8:
-    case GDK_MEMORY_A8R8G8B8:
-    case GDK_MEMORY_R8G8B8A8:
-    case GDK_MEMORY_A8B8G8R8:
-      format = GDK_MEMORY_R8G8B8A8;
-      png_format = PNG_COLOR_TYPE_RGB_ALPHA;
-      depth = 8;
-      break;
-
-    case GDK_MEMORY_R8G8B8:
-    case GDK_MEMORY_B8G8R8:
-    case GDK_MEMORY_R8G8B8X8:
-    case GDK_MEMORY_X8R8G8B8:
-    case GDK_MEMORY_B8G8R8X8:
-    case GDK_MEMORY_X8B8G8R8:
-      format = GDK_MEMORY_R8G8B8;
-      png_format = PNG_COLOR_TYPE_RGB;
-      depth = 8;
-      break;
-
-    case GDK_MEMORY_R16G16B16A16:
-    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
-    case GDK_MEMORY_R16G16B16A16_FLOAT:
-    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
-    case GDK_MEMORY_R32G32B32A32_FLOAT:
-    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
-      format = GDK_MEMORY_R16G16B16A16;
-      png_format = PNG_COLOR_TYPE_RGB_ALPHA;
-      depth = 16;
-      break;
-
-    case GDK_MEMORY_R16G16B16:
-    case GDK_MEMORY_R16G16B16_FLOAT:
-    case GDK_MEMORY_R32G32B32_FLOAT:
-      format = GDK_MEMORY_R16G16B16;
-      png_format = PNG_COLOR_TYPE_RGB;
-      depth = 16;
-      break;
-
-    case GDK_MEMORY_G8:
-      format = GDK_MEMORY_G8;
-      png_format = PNG_COLOR_TYPE_GRAY;
-      depth = 8;
-      break;
-
-    case GDK_MEMORY_G8A8_PREMULTIPLIED:
-    case GDK_MEMORY_G8A8:
-    case GDK_MEMORY_A8:
-      format = GDK_MEMORY_G8A8;
-      png_format = PNG_COLOR_TYPE_GRAY_ALPHA;
-      depth = 8;
-      break;
-
-    case GDK_MEMORY_G16:
-      format = GDK_MEMORY_G16;
-      png_format = PNG_COLOR_TYPE_GRAY;
-      depth = 16;
-      break;
-
-    case GDK_MEMORY_G16A16_PREMULTIPLIED:
-    case GDK_MEMORY_G16A16:
-    case GDK_MEMORY_A16:
-    case GDK_MEMORY_A16_FLOAT:
-    case GDK_MEMORY_A32_FLOAT:
-      format = GDK_MEMORY_G16A16;
-      png_format = PNG_COLOR_TYPE_GRAY_ALPHA;
-      depth = 16;
-      break;
-
-    case GDK_MEMORY_N_FORMATS:
-    default:
-      g_assert_not_reached ();
-    }
+  format = gdk_png_get_save_format (gdk_texture_get_format (texture),
+                                    &png_format, &depth);
 
   png = png_create_write_struct_2 (PNG_LIBPNG_VER_STRING, NULL,
                                    png_simple_error_callback,
@@ -22,11 +22,49 @@
 
 #define PNG_SIGNATURE "\x89PNG"
 
-GdkTexture *gdk_load_png        (GBytes         *bytes,
-                                 GHashTable     *options,
-                                 GError        **error);
+/* The values match the png filter types */
+typedef enum
+{
+  GDK_PNG_FILTER_NONE,
+  GDK_PNG_FILTER_SUB,
+  GDK_PNG_FILTER_UP,
+  GDK_PNG_FILTER_AVERAGE,
+  GDK_PNG_FILTER_PAETH,
+  GDK_PNG_FILTER_ADAPTIVE,
+} GdkPngFilter;
+
+typedef struct
+{
+  int compression_level;        /* 0-9, or -1 for the zlib default */
+  GdkPngFilter filter;
+  gboolean parallel;
+} GdkPngSaveOptions;
+
+/* For data that is read right away instead of being stored,
+ * like clipboard and DND contents
+ */
+extern const GdkPngSaveOptions gdk_png_save_options_fast;
+
+GdkTexture *gdk_load_png          (GBytes         *bytes,
+                                   GHashTable     *options,
+                                   GError        **error);
+GdkTexture *gdk_load_png_at_size  (GBytes         *bytes,
+                                   GHashTable     *options,
+                                   int             width,
+                                   int             height,
+                                   GError        **error);
+gboolean    gdk_png_get_size      (GBytes         *bytes,
+                                   int            *width,
+                                   int            *height);
 
-GBytes     *gdk_save_png        (GdkTexture     *texture);
+GBytes     *gdk_save_png          (GdkTexture     *texture);
+GBytes     *gdk_save_png_libpng   (GdkTexture     *texture);
+gboolean    gdk_save_png_to_stream
+                                  (GdkTexture              *texture,
+                                   GOutputStream           *stream,
+                                   const GdkPngSaveOptions *options,
+                                   GCancellable            *cancellable,
+                                   GError                 **error);
 
 static inline gboolean
 gdk_is_png (GBytes *bytes)
@@ -413,6 +413,48 @@ snapshots_equal (GskGLCommandQueue *self,
   return TRUE;
 }
 
+/* Upload buffers bigger than this are not worth keeping around,
+ * textures that big are uploaded from client memory.
+ */
+#define MAX_UPLOAD_BUFFER_SIZE (64 * 1024 * 1024)
+#define MIN_UPLOAD_BUFFER_SIZE (4 * 1024 * 1024)
+
+/* Regions start at multiples of this, which is more than
+ * any memory format needs
+ */
+#define UPLOAD_REGION_ALIGNMENT 64
+
+/* Release the upload buffer after this many frames without uploads */
+#define UPLOAD_BUFFER_TIMEOUT 60
+
+static void
+gsk_gl_upload_region_free (gpointer data)
+{
+  GskGLUploadRegion *region = data;
+
+  glDeleteSync (region->sync);
+  g_free (region);
+}
+
+static void
+gsk_gl_command_queue_release_upload_buffers (GskGLCommandQueue *self)
+{
+  GskGLUploadBuffer *buffer = &self->upload_buffer;
+
+  g_queue_clear_full (&buffer->regions, gsk_gl_upload_region_free);
+
+  if (buffer->id)
+    {
+      /* This unmaps the buffer, too */
+      glDeleteBuffers (1, &buffer->id);
+      buffer->id = 0;
+    }
+
+  buffer->data = NULL;
+  buffer->size = 0;
+  buffer->offset = 0;
+}
+
 static void
 gsk_gl_command_queue_dispose (GObject *object)
 {
@@ -420,6 +462,8 @@ gsk_gl_command_queue_dispose (GObject *object)
 
   g_assert (GSK_IS_GL_COMMAND_QUEUE (self));
 
+  gsk_gl_command_queue_release_upload_buffers (self);
+
   g_clear_object (&self->profiler);
   g_clear_object (&self->gl_profiler);
   g_clear_object (&self->context);
@@ -502,6 +546,7 @@ gsk_gl_command_queue_new (GdkGLContext      *context,
 
   self->has_samplers = gdk_gl_context_check_version (context, "3.3", "3.0");
   self->can_swizzle = gdk_gl_context_check_version (context, "3.0", "3.0");
+  self->has_buffer_storage = gdk_gl_context_has_feature (context, GDK_GL_FEATURE_BUFFER_STORAGE);
 
   /* create the samplers */
   if (self->has_samplers)
@@ -1359,6 +1404,11 @@ gsk_gl_command_queue_end_frame (GskGLCommandQueue *self)
         }
     }
 
+  if (self->n_uploads > 0)
+    self->n_frames_without_uploads = 0;
+  else if (++self->n_frames_without_uploads == UPLOAD_BUFFER_TIMEOUT)
+    gsk_gl_command_queue_release_upload_buffers (self);
+
   self->batches.len = 0;
   self->batch_binds.len = 0;
   self->batch_uniforms.len = 0;
@@ -1571,6 +1621,157 @@ memory_format_gl_format (GskGLCommandQueue *self,
   return GDK_MEMORY_R8G8B8A8_PREMULTIPLIED;
 }
 
+static gboolean
+gsk_gl_upload_buffer_create (GskGLUploadBuffer *buffer,
+                             gsize              size)
+{
+  buffer->size = MAX (MIN_UPLOAD_BUFFER_SIZE, 1 << g_bit_storage (size - 1));
+  buffer->size = MIN (buffer->size, MAX_UPLOAD_BUFFER_SIZE);
+  buffer->offset = 0;
+
+  glGenBuffers (1, &buffer->id);
+  glBindBuffer (GL_PIXEL_UNPACK_BUFFER, buffer->id);
+  glBufferStorage (GL_PIXEL_UNPACK_BUFFER,
+                   buffer->size,
+                   NULL,
+                   GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+  buffer->data = glMapBufferRange (GL_PIXEL_UNPACK_BUFFER,
+                                   0,
+                                   buffer->size,
+                                   GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+  if (buffer->data == NULL)
+    {
+      glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+      glDeleteBuffers (1, &buffer->id);
+      buffer->id = 0;
+      buffer->size = 0;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Forgets the regions that the GPU is done reading, without waiting */
+static void
+gsk_gl_upload_buffer_retire_regions (GskGLUploadBuffer *buffer)
+{
+  GskGLUploadRegion *region;
+
+  while ((region = g_queue_peek_head (&buffer->regions)))
+    {
+      GLenum status = glClientWaitSync (region->sync, 0, 0);
+
+      if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        break;
+
+      gsk_gl_upload_region_free (g_queue_pop_head (&buffer->regions));
+    }
+
+  if (g_queue_is_empty (&buffer->regions))
+    buffer->offset = 0;
+}
+
+/* Finds room for @size bytes after the regions in use. This only
+ * does the bookkeeping, so it doesn't need a GL context.
+ */
+gboolean
+gsk_gl_upload_buffer_alloc (GskGLUploadBuffer *buffer,
+                            gsize              size,
+                            gsize             *out_start)
+{
+  GskGLUploadRegion *oldest;
+  gsize start, aligned_size;
+
+  if (size == 0 || size > buffer->size)
+    return FALSE;
+
+  aligned_size = (size + UPLOAD_REGION_ALIGNMENT - 1) & ~(gsize) (UPLOAD_REGION_ALIGNMENT - 1);
+
+  oldest = g_queue_peek_head (&buffer->regions);
+  if (oldest == NULL)
+    {
+      start = 0;
+    }
+  else if (buffer->offset > oldest->start)
+    {
+      /* The free space is after the regions in use, and before them
+       * after wrapping around. Regions never end right at the oldest
+       * one, so that a full buffer can't look empty.
+       */
+      if (buffer->offset + size <= buffer->size)
+        start = buffer->offset;
+      else if (aligned_size < oldest->start)
+        start = 0;
+      else
+        return FALSE;
+    }
+  else
+    {
+      /* We wrapped around, the free space is up to the oldest region */
+      if (buffer->offset + aligned_size < oldest->start)
+        start = buffer->offset;
+      else
+        return FALSE;
+    }
+
+  buffer->offset = MIN (buffer->size, start + aligned_size);
+
+  *out_start = start;
+  return TRUE;
+}
+
+/* Finds room for @size bytes in the upload buffer, binds it as
+ * GL_PIXEL_UNPACK_BUFFER and returns the offset of the region.
+ * Returns %FALSE if the data should be uploaded from client memory,
+ * because the buffer is not big enough or the GPU is still reading
+ * from the space we'd need. We never wait for it.
+ *
+ * Call gsk_gl_command_queue_end_upload_region() after the upload.
+ */
+static gboolean
+gsk_gl_command_queue_begin_upload_region (GskGLCommandQueue *self,
+                                          gsize              size,
+                                          gsize             *out_offset)
+{
+  GskGLUploadBuffer *buffer = &self->upload_buffer;
+
+  if (!self->has_buffer_storage || size == 0 || size > MAX_UPLOAD_BUFFER_SIZE)
+    return FALSE;
+
+  gsk_gl_upload_buffer_retire_regions (buffer);
+
+  if (g_queue_is_empty (&buffer->regions) && buffer->size < size)
+    {
+      if (buffer->id)
+        glDeleteBuffers (1, &buffer->id);
+
+      if (!gsk_gl_upload_buffer_create (buffer, size))
+        return FALSE;
+    }
+
+  if (!gsk_gl_upload_buffer_alloc (buffer, size, out_offset))
+    return FALSE;
+
+  glBindBuffer (GL_PIXEL_UNPACK_BUFFER, buffer->id);
+
+  return TRUE;
+}
+
+static void
+gsk_gl_command_queue_end_upload_region (GskGLCommandQueue *self,
+                                        gsize              offset)
+{
+  GskGLUploadRegion *region;
+
+  glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+
+  region = g_new (GskGLUploadRegion, 1);
+  region->start = offset;
+  region->sync = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  g_queue_push_tail (&self->upload_buffer.regions, region);
+}
+
 static void
 gsk_gl_command_queue_do_upload_texture_chunk (GskGLCommandQueue *self,
                                               GdkTexture        *texture,
@@ -1587,6 +1788,8 @@ gsk_gl_command_queue_do_upload_texture_chunk (GskGLCommandQueue *self,
   gsize stride;
   GBytes *bytes;
   GdkTextureDownloader downloader;
+  gboolean use_upload_buffer;
+  gsize upload_offset;
   int width, height;
   gsize bpp;
 
@@ -1605,12 +1808,29 @@ gsk_gl_command_queue_do_upload_texture_chunk (GskGLCommandQueue *self,
       g_type_class_unref (enum_class);
     }
 
+  bpp = gdk_memory_format_bytes_per_pixel (data_format);
+
   gdk_texture_downloader_init (&downloader, texture);
   gdk_texture_downloader_set_format (&downloader, data_format);
-  bytes = gdk_texture_downloader_download_bytes (&downloader, &stride);
+
+  use_upload_buffer = gsk_gl_command_queue_begin_upload_region (self, width * bpp * height, &upload_offset);
+  if (use_upload_buffer)
+    {
+      /* Convert right into the pixel buffer, glTexSubImage2D() then
+       * reads from the region's offset in it without stalling.
+       */
+      stride = width * bpp;
+      gdk_texture_downloader_download_into (&downloader, self->upload_buffer.data + upload_offset, stride);
+      bytes = NULL;
+      data = GSIZE_TO_POINTER (upload_offset);
+    }
+  else
+    {
+      bytes = gdk_texture_downloader_download_bytes (&downloader, &stride);
+      data = g_bytes_get_data (bytes, NULL);
+    }
+
   gdk_texture_downloader_finish (&downloader);
-  data = g_bytes_get_data (bytes, NULL);
-  bpp = gdk_memory_format_bytes_per_pixel (data_format);
 
   if (gdk_profiler_is_running ())
     {
@@ -1645,6 +1865,9 @@ gsk_gl_command_queue_do_upload_texture_chunk (GskGLCommandQueue *self,
 
   glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
 
+  if (use_upload_buffer)
+    gsk_gl_command_queue_end_upload_region (self, upload_offset);
+
   /* Only apply swizzle if really needed, might not even be
    * supported if default values are set
    */
@@ -1657,7 +1880,7 @@ gsk_gl_command_queue_do_upload_texture_chunk (GskGLCommandQueue *self,
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, gl_swizzle[3]);
     }
 
-  g_bytes_unref (bytes);
+  g_clear_pointer (&bytes, g_bytes_unref);
 
   if (gdk_profiler_is_running ())
     gdk_profiler_end_markf (start_time,
@@ -176,6 +176,27 @@ typedef struct _GskGLSync {
   gpointer sync;
 } GskGLSync;
 
+/* The part of an upload buffer that one upload reads from, and
+ * the sync for when the GPU is done reading it
+ */
+typedef struct _GskGLUploadRegion {
+  gsize start;
+  gpointer sync;
+} GskGLUploadRegion;
+
+/* A pixel buffer that texture data is converted into before it is
+ * uploaded. It is mapped persistently and used as a ring: every upload
+ * takes the next free region, and @regions holds a sync per region the
+ * GPU may still be reading from.
+ */
+typedef struct _GskGLUploadBuffer {
+  GLuint id;
+  guchar *data;
+  gsize size;
+  gsize offset;   /* where the next region starts */
+  GQueue regions; /* GskGLUploadRegion, oldest first */
+} GskGLUploadBuffer;
+
 DEFINE_INLINE_ARRAY (GskGLCommandBatches, gsk_gl_command_batches, GskGLCommandBatch)
 DEFINE_INLINE_ARRAY (GskGLCommandBinds, gsk_gl_command_binds, GskGLCommandBind)
 DEFINE_INLINE_ARRAY (GskGLCommandUniforms, gsk_gl_command_uniforms, GskGLCommandUniform)
@@ -251,6 +272,15 @@ struct _GskGLCommandQueue
    */
   GskGLSyncs syncs;
 
+  /* Pixel buffer that texture uploads go through, so that the driver
+   * can copy the data asynchronously. Only used if the GL context
+   * supports buffer storage.
+   */
+  GskGLUploadBuffer upload_buffer;
+
+  /* Frames without uploads, so we can release the upload buffer */
+  guint n_frames_without_uploads;
+
   /* Discovered max texture size when loading the command queue so that we
    * can either scale down or slice textures to fit within this size. Assumed
    * to be both height and width.
@@ -289,6 +319,9 @@ struct _GskGLCommandQueue
   /* If the GL context is new enough to support swizzling (ie is not GLES2) */
   guint can_swizzle : 1;
 
+  /* If the GL context supports persistently mapped buffers */
+  guint has_buffer_storage : 1;
+
   /* If we're inside a begin/end_frame pair */
   guint in_frame : 1;
 
@@ -353,6 +386,10 @@ gboolean            gsk_gl_command_queue_begin_draw           (GskGLCommandQueue
 void                gsk_gl_command_queue_end_draw             (GskGLCommandQueue    *self);
 void                gsk_gl_command_queue_split_draw           (GskGLCommandQueue    *self);
 
+gboolean            gsk_gl_upload_buffer_alloc                (GskGLUploadBuffer    *buffer,
+                                                               gsize                 size,
+                                                               gsize                *out_start);
+
 static inline GskGLCommandBatch *
 gsk_gl_command_queue_get_batch (GskGLCommandQueue *self)
 {
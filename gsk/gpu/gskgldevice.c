@@ -10,6 +10,7 @@
 
 #include "gdk/gdkdisplayprivate.h"
 #include "gdk/gdkglcontextprivate.h"
+#include "gdk/gdkprivate.h"
 #include "gdk/gdkprofilerprivate.h"
 
 #include <glib/gi18n-lib.h>
@@ -23,6 +24,22 @@ struct _GskGLDevice
   GdkGLAPI api;
 
   guint sampler_ids[GSK_GPU_SAMPLER_N_SAMPLERS];
+
+  /* NULL if program binaries are not supported */
+  GHashTable *program_cache; /* char * => GVariant (suay) */
+  char *program_cache_file;
+  char *program_cache_etag;
+  guint save_program_cache_source;
+
+  /* the variants used by this application, see gsk_gl_device_start_warmup() */
+  GHashTable *variants; /* char * */
+  char *variants_file;
+  guint save_variants_source;
+  GQueue warmup_queue; /* GLProgramKey */
+  guint warmup_source;
+  guint variants_loaded : 1;
+  guint warmup_queued : 1;
+  guint parallel_compile : 1;
 };
 
 struct _GskGLDeviceClass
@@ -40,8 +57,32 @@ struct _GLProgramKey
   guint32 variation;
 };
 
+typedef struct _GLProgram GLProgram;
+
+struct _GLProgram
+{
+  GLuint program_id;
+  /* Until the program is ready, it may still be compiling */
+  GLuint vertex_shader_id;
+  GLuint fragment_shader_id;
+  char *checksum;
+  guint ready : 1;
+};
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+/* Bump this when the format of the cache file changes */
+#define PROGRAM_CACHE_VERSION 1
+#define PROGRAM_CACHE_TYPE "(ua{s(suay)})"
+
 G_DEFINE_TYPE (GskGLDevice, gsk_gl_device, GSK_TYPE_GPU_DEVICE)
 
+static gboolean gsk_gl_device_save_program_cache (GskGLDevice *self);
+static void     gsk_gl_device_save_variants      (GskGLDevice *self);
+static void     gsk_gl_device_start_warmup       (GskGLDevice *self);
+
 static guint
 gl_program_key_hash (gconstpointer data)
 {
@@ -66,6 +107,51 @@ gl_program_key_equal (gconstpointer a,
          keya->variation == keyb->variation;
 }
 
+/* The name of the program in the program cache and the variants file */
+static char *
+gl_program_key_to_string (const GLProgramKey *key)
+{
+  return g_strdup_printf ("%s-%x-%x-%x",
+                          key->op_class->shader_name,
+                          key->flags,
+                          key->color_states,
+                          key->variation);
+}
+
+static gboolean
+gl_program_key_parse (GLProgramKey *key,
+                      const char   *string)
+{
+  char **parts;
+  gboolean result = FALSE;
+  guint64 values[3];
+  gsize i;
+
+  parts = g_strsplit (string, "-", -1);
+  if (g_strv_length (parts) != 4)
+    goto out;
+
+  key->op_class = gsk_gpu_shader_op_class_lookup (parts[0]);
+  if (key->op_class == NULL)
+    goto out;
+
+  for (i = 0; i < 3; i++)
+    {
+      if (!g_ascii_string_to_unsigned (parts[i + 1], 16, 0, G_MAXUINT32, &values[i], NULL))
+        goto out;
+    }
+
+  key->flags = values[0];
+  key->color_states = values[1];
+  key->variation = values[2];
+  result = TRUE;
+
+out:
+  g_strfreev (parts);
+
+  return result;
+}
+
 static GskGpuImage *
 gsk_gl_device_create_offscreen_image (GskGpuDevice   *device,
                                       gboolean        with_mipmap,
@@ -148,6 +234,25 @@ gsk_gl_device_finalize (GObject *object)
 
   gdk_gl_context_make_current (gdk_display_get_gl_context (gsk_gpu_device_get_display (device)));
 
+  g_clear_handle_id (&self->warmup_source, g_source_remove);
+  g_queue_clear_full (&self->warmup_queue, g_free);
+  if (self->save_variants_source)
+    {
+      g_clear_handle_id (&self->save_variants_source, g_source_remove);
+      gsk_gl_device_save_variants (self);
+    }
+  g_clear_pointer (&self->variants, g_hash_table_unref);
+  g_free (self->variants_file);
+
+  if (self->save_program_cache_source)
+    {
+      g_clear_handle_id (&self->save_program_cache_source, g_source_remove);
+      gsk_gl_device_save_program_cache (self);
+    }
+  g_clear_pointer (&self->program_cache, g_hash_table_unref);
+  g_free (self->program_cache_file);
+  g_free (self->program_cache_etag);
+
   g_hash_table_unref (self->gl_programs);
   glDeleteSamplers (G_N_ELEMENTS (self->sampler_ids), self->sampler_ids);
 
@@ -170,9 +275,17 @@ gsk_gl_device_class_init (GskGLDeviceClass *klass)
 }
 
 static void
-free_gl_program (gpointer program)
+free_gl_program (gpointer data)
 {
-  glDeleteProgram (GPOINTER_TO_UINT (program));
+  GLProgram *program = data;
+
+  if (program->vertex_shader_id)
+    glDeleteShader (program->vertex_shader_id);
+  if (program->fragment_shader_id)
+    glDeleteShader (program->fragment_shader_id);
+  glDeleteProgram (program->program_id);
+  g_free (program->checksum);
+  g_free (program);
 }
 
 static void
@@ -228,6 +341,224 @@ gsk_gl_device_setup_samplers (GskGLDevice *self)
     }
 }
 
+static char *
+gsk_gl_device_get_program_cache_dirname (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "gl-program-cache", NULL);
+}
+
+/* Program binaries are only valid for the driver that produced them,
+ * so every driver gets its own cache file. The version string usually
+ * contains the driver version.
+ */
+static char *
+gsk_gl_device_get_program_cache_file (GskGLDevice *self)
+{
+  GChecksum *checksum;
+  char *dirname, *path;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_VENDOR), -1);
+  g_checksum_update (checksum, (const guchar *) "\n", 1);
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_RENDERER), -1);
+  g_checksum_update (checksum, (const guchar *) "\n", 1);
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_VERSION), -1);
+
+  dirname = gsk_gl_device_get_program_cache_dirname ();
+  path = g_build_filename (dirname, g_checksum_get_string (checksum), NULL);
+
+  g_free (dirname);
+  g_checksum_free (checksum);
+
+  return path;
+}
+
+/* Loads the cache file and merges it into the programs we have.
+ * Programs we already have win.
+ */
+static void
+gsk_gl_device_load_program_cache (GskGLDevice *self)
+{
+  GError *error = NULL;
+  GVariant *variant, *programs, *value;
+  GVariantIter iter;
+  GFile *file;
+  char *data, *etag, *key;
+  gsize size;
+  guint32 version;
+
+  file = g_file_new_for_path (self->program_cache_file);
+  if (!g_file_load_contents (file, NULL, &data, &size, &etag, &error))
+    {
+      GSK_DEBUG (SHADERS, "Failed to load GL program cache file '%s': %s",
+                 self->program_cache_file, error->message);
+      g_object_unref (file);
+      g_clear_error (&error);
+      return;
+    }
+  g_object_unref (file);
+
+  variant = g_variant_new_from_data (G_VARIANT_TYPE (PROGRAM_CACHE_TYPE),
+                                     data, size,
+                                     FALSE,
+                                     g_free, data);
+  g_variant_ref_sink (variant);
+
+  g_variant_get (variant, "(u@a{s(suay)})", &version, &programs);
+  if (version == PROGRAM_CACHE_VERSION)
+    {
+      g_variant_iter_init (&iter, programs);
+      while (g_variant_iter_next (&iter, "{s@(suay)}", &key, &value))
+        {
+          if (g_hash_table_contains (self->program_cache, key))
+            {
+              g_free (key);
+              g_variant_unref (value);
+            }
+          else
+            {
+              g_hash_table_insert (self->program_cache, key, value);
+            }
+        }
+    }
+  else
+    {
+      GSK_DEBUG (SHADERS, "Ignoring GL program cache file '%s' with version %u",
+                 self->program_cache_file, version);
+    }
+
+  g_variant_unref (programs);
+  g_variant_unref (variant);
+
+  g_free (self->program_cache_etag);
+  self->program_cache_etag = etag;
+
+  GSK_DEBUG (SHADERS, "Loaded %u programs from GL program cache (%" G_GSIZE_FORMAT " bytes)",
+             g_hash_table_size (self->program_cache), size);
+}
+
+static gboolean
+gsk_gl_device_save_program_cache (GskGLDevice *self)
+{
+  G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
+  GError *error = NULL;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer key, value;
+  GVariant *variant;
+  GFile *file;
+  char *path, *etag;
+  gsize size;
+
+  path = gsk_gl_device_get_program_cache_dirname ();
+  if (g_mkdir_with_parents (path, 0755) != 0)
+    {
+      g_warning_once ("Failed to create GL program cache directory");
+      g_free (path);
+      return FALSE;
+    }
+  g_free (path);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(suay)}"));
+  g_hash_table_iter_init (&iter, self->program_cache);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_variant_builder_add (&builder, "{s@(suay)}", key, value);
+
+  variant = g_variant_new ("(u@a{s(suay)})", PROGRAM_CACHE_VERSION, g_variant_builder_end (&builder));
+  g_variant_ref_sink (variant);
+  size = g_variant_get_size (variant);
+
+  file = g_file_new_for_path (self->program_cache_file);
+
+  GSK_DEBUG (SHADERS, "Saving GL program cache of size %" G_GSIZE_FORMAT " to %s", size, self->program_cache_file);
+
+  if (!g_file_replace_contents (file,
+                                g_variant_get_data (variant),
+                                size,
+                                self->program_cache_etag,
+                                FALSE,
+                                0,
+                                &etag,
+                                NULL,
+                                &error))
+    {
+      g_object_unref (file);
+      g_variant_unref (variant);
+
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WRONG_ETAG))
+        {
+          GSK_DEBUG (SHADERS, "GL program cache file modified, merging into current");
+          g_clear_error (&error);
+          /* If loading fails, the etag stays unset and the next attempt
+           * overwrites the file */
+          g_clear_pointer (&self->program_cache_etag, g_free);
+          gsk_gl_device_load_program_cache (self);
+
+          /* try again */
+          return gsk_gl_device_save_program_cache (self);
+        }
+
+      g_warning ("Failed to save GL program cache: %s", error->message);
+      g_clear_error (&error);
+      return FALSE;
+    }
+
+  gdk_profiler_end_markf (begin_time,
+                          "Save GL program cache", "%s size %" G_GSIZE_FORMAT,
+                          self->program_cache_file, size);
+
+  g_object_unref (file);
+  g_variant_unref (variant);
+  g_free (self->program_cache_etag);
+  self->program_cache_etag = etag;
+
+  return TRUE;
+}
+
+static gboolean
+gsk_gl_device_save_program_cache_cb (gpointer data)
+{
+  GskGLDevice *self = data;
+
+  gsk_gl_device_save_program_cache (self);
+
+  self->save_program_cache_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gsk_gl_device_program_cache_updated (GskGLDevice *self)
+{
+  g_clear_handle_id (&self->save_program_cache_source, g_source_remove);
+  self->save_program_cache_source = g_timeout_add_seconds_full (G_PRIORITY_DEFAULT_IDLE - 10,
+                                                                10, /* don't save while starting up */
+                                                                gsk_gl_device_save_program_cache_cb,
+                                                                self,
+                                                                NULL);
+}
+
+static void
+gsk_gl_device_setup_program_cache (GskGLDevice  *self,
+                                   GdkGLContext *context)
+{
+  GLint n_formats = 0;
+
+  if (!gdk_gl_context_has_feature (context, GDK_GL_FEATURE_PROGRAM_BINARY))
+    return;
+
+  /* Some drivers support the API, but no formats */
+  glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+  if (n_formats == 0)
+    {
+      GSK_DEBUG (SHADERS, "GL driver has no program binary formats, not caching programs");
+      return;
+    }
+
+  self->program_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+  self->program_cache_file = gsk_gl_device_get_program_cache_file (self);
+  gsk_gl_device_load_program_cache (self);
+}
+
 GskGpuDevice *
 gsk_gl_device_get_for_display (GdkDisplay  *display,
                                GError     **error)
@@ -266,6 +597,9 @@ gsk_gl_device_get_for_display (GdkDisplay  *display,
   self->version_string = gdk_gl_context_get_glsl_version_string (context);
   self->api = gdk_gl_context_get_api (context);
   gsk_gl_device_setup_samplers (self);
+  gsk_gl_device_setup_program_cache (self, context);
+  self->parallel_compile = gdk_gl_context_has_feature (context, GDK_GL_FEATURE_PARALLEL_SHADER_COMPILE);
+  gsk_gl_device_start_warmup (self);
 
   g_object_set_data (G_OBJECT (display), "-gsk-gl-device", self);
 
@@ -376,19 +710,14 @@ print_shader_info (const char *prefix,
     }
 }
 
-static GLuint
-gsk_gl_device_load_shader (GskGLDevice       *self,
-                           const char        *program_name,
-                           GLenum             shader_type,
-                           GskGpuShaderFlags  flags,
-                           GskGpuColorStates  color_states,
-                           guint32            variation,
-                           GError           **error)
+static GString *
+gsk_gl_device_create_preamble (GskGLDevice       *self,
+                               GLenum             shader_type,
+                               GskGpuShaderFlags  flags,
+                               GskGpuColorStates  color_states,
+                               guint32            variation)
 {
   GString *preamble;
-  char *resource_name;
-  GBytes *bytes;
-  GLuint shader_id;
 
   preamble = g_string_new (NULL);
 
@@ -426,18 +755,25 @@ gsk_gl_device_load_shader (GskGLDevice       *self,
 
       default:
         g_assert_not_reached ();
-        return 0;
+        break;
     }
 
   g_string_append_printf (preamble, "#define GSK_FLAGS %uu\n", flags);
   g_string_append_printf (preamble, "#define GSK_COLOR_STATES %uu\n", color_states);
   g_string_append_printf (preamble, "#define GSK_VARIATION %uu\n", variation);
 
-  resource_name = g_strconcat ("/org/gtk/libgsk/shaders/gl/", program_name, ".glsl", NULL);
-  bytes = g_resources_lookup_data (resource_name, 0, error);
-  g_free (resource_name);
-  if (bytes == NULL)
-    return 0;
+  return preamble;
+}
+
+/* Starts compiling a shader, errors are checked when linking */
+static GLuint
+gsk_gl_device_load_shader (GskGLDevice *self,
+                           const char  *program_name,
+                           GLenum       shader_type,
+                           GString     *preamble,
+                           GBytes      *source)
+{
+  GLuint shader_id;
 
   shader_id = glCreateShader (shader_type);
 
@@ -445,95 +781,650 @@ gsk_gl_device_load_shader (GskGLDevice       *self,
                   2,
                   (const char *[]) {
                     preamble->str,
-                    g_bytes_get_data (bytes, NULL),
+                    g_bytes_get_data (source, NULL),
                   },
                   NULL);
 
-  g_bytes_unref (bytes);
-  g_string_free (preamble, TRUE);
-
   glCompileShader (shader_id);
 
   print_shader_info (shader_type == GL_FRAGMENT_SHADER ? "fragment" : "vertex", shader_id, program_name);
 
-  if (!gsk_gl_device_check_shader_error (program_name, shader_id, error))
-    {
-      glDeleteShader (shader_id);
-      return 0;
-    }
-
   return shader_id;
 }
 
+static char *
+compute_program_checksum (GString *vertex_preamble,
+                          GString *fragment_preamble,
+                          GBytes  *source)
+{
+  GChecksum *checksum;
+  char *result;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) vertex_preamble->str, vertex_preamble->len);
+  g_checksum_update (checksum, (const guchar *) fragment_preamble->str, fragment_preamble->len);
+  g_checksum_update (checksum, g_bytes_get_data (source, NULL), g_bytes_get_size (source));
+  result = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  return result;
+}
+
+/* Returns 0 if there is no usable binary for the program */
 static GLuint
-gsk_gl_device_load_program (GskGLDevice               *self,
-                            const GskGpuShaderOpClass *op_class,
-                            GskGpuShaderFlags          flags,
-                            GskGpuColorStates          color_states,
-                            guint32                    variation,
-                            GError                   **error)
+gsk_gl_device_load_program_binary (GskGLDevice *self,
+                                   const char  *key,
+                                   const char  *checksum)
 {
   G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
-  GLuint vertex_shader_id, fragment_shader_id, program_id;
+  GVariant *value, *binary;
+  const char *cached_checksum;
+  const guchar *data;
+  gsize size;
+  guint32 format;
+  GLuint program_id;
   GLint link_status;
 
-  vertex_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_VERTEX_SHADER, flags, color_states, variation, error);
-  if (vertex_shader_id == 0)
+  value = g_hash_table_lookup (self->program_cache, key);
+  if (value == NULL)
     return 0;
 
-  fragment_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_FRAGMENT_SHADER, flags, color_states, variation, error);
-  if (fragment_shader_id == 0)
-    return 0;
+  g_variant_get (value, "(&su@ay)", &cached_checksum, &format, &binary);
+  if (!g_str_equal (cached_checksum, checksum))
+    {
+      g_variant_unref (binary);
+      return 0;
+    }
+
+  data = g_variant_get_fixed_array (binary, &size, 1);
 
   program_id = glCreateProgram ();
+  glProgramBinary (program_id, format, data, size);
+  g_variant_unref (binary);
 
-  glAttachShader (program_id, vertex_shader_id);
-  glAttachShader (program_id, fragment_shader_id);
+  glGetProgramiv (program_id, GL_LINK_STATUS, &link_status);
+  if (link_status == GL_FALSE)
+    {
+      /* The driver changed in a way we did not notice */
+      GSK_DEBUG (SHADERS, "Failed to load program binary for %s, compiling it", key);
+      glDeleteProgram (program_id);
+      g_hash_table_remove (self->program_cache, key);
+      return 0;
+    }
 
-  op_class->setup_attrib_locations (program_id);
+  gdk_profiler_end_markf (begin_time,
+                          "Load Program Binary",
+                          "name=%s id=%u size=%" G_GSIZE_FORMAT,
+                          key, program_id, size);
 
-  glLinkProgram (program_id);
+  return program_id;
+}
 
-  glGetProgramiv (program_id, GL_LINK_STATUS, &link_status);
+static void
+gsk_gl_device_save_program_binary (GskGLDevice *self,
+                                   char        *key,
+                                   char        *checksum,
+                                   GLuint       program_id)
+{
+  GLint size = 0;
+  GLenum format;
+  guchar *data;
+
+  glGetProgramiv (program_id, GL_PROGRAM_BINARY_LENGTH, &size);
+  if (size <= 0)
+    {
+      g_free (key);
+      g_free (checksum);
+      return;
+    }
 
-  glDetachShader (program_id, vertex_shader_id);
-  glDeleteShader (vertex_shader_id);
-  glDetachShader (program_id, fragment_shader_id);
-  glDeleteShader (fragment_shader_id);
+  data = g_malloc (size);
+  glGetProgramBinary (program_id, size, &size, &format, data);
+
+  g_hash_table_replace (self->program_cache,
+                        key,
+                        g_variant_ref_sink (g_variant_new ("(su@ay)",
+                                                           checksum,
+                                                           (guint32) format,
+                                                           g_variant_new_from_data (G_VARIANT_TYPE_BYTESTRING,
+                                                                                    data, size,
+                                                                                    TRUE,
+                                                                                    g_free, data))));
+  g_free (checksum);
+
+  gsk_gl_device_program_cache_updated (self);
+}
 
-  if (link_status == GL_FALSE)
+/* Creates the program for @key, either from the program cache, or
+ * by compiling the shaders.
+ *
+ * When compiling, this only starts the process, so that drivers that
+ * can compile in parallel are free to do so, and the program is not
+ * ready until gsk_gl_device_finish_program() has been called.
+ */
+static GLProgram *
+gsk_gl_device_start_program (GskGLDevice        *self,
+                             const GLProgramKey *key,
+                             GError            **error)
+{
+  const GskGpuShaderOpClass *op_class = key->op_class;
+  GString *vertex_preamble, *fragment_preamble;
+  GLProgram *program;
+  char *resource_name;
+  GBytes *source;
+
+  resource_name = g_strconcat ("/org/gtk/libgsk/shaders/gl/", op_class->shader_name, ".glsl", NULL);
+  source = g_resources_lookup_data (resource_name, 0, error);
+  g_free (resource_name);
+  if (source == NULL)
+    return NULL;
+
+  vertex_preamble = gsk_gl_device_create_preamble (self, GL_VERTEX_SHADER, key->flags, key->color_states, key->variation);
+  fragment_preamble = gsk_gl_device_create_preamble (self, GL_FRAGMENT_SHADER, key->flags, key->color_states, key->variation);
+
+  program = g_new0 (GLProgram, 1);
+
+  if (self->program_cache)
+    {
+      char *cache_key = gl_program_key_to_string (key);
+
+      program->checksum = compute_program_checksum (vertex_preamble, fragment_preamble, source);
+      program->program_id = gsk_gl_device_load_program_binary (self, cache_key, program->checksum);
+      g_free (cache_key);
+    }
+
+  if (program->program_id == 0)
+    {
+      program->vertex_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_VERTEX_SHADER, vertex_preamble, source);
+      program->fragment_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_FRAGMENT_SHADER, fragment_preamble, source);
+
+      program->program_id = glCreateProgram ();
+
+      glAttachShader (program->program_id, program->vertex_shader_id);
+      glAttachShader (program->program_id, program->fragment_shader_id);
+
+      op_class->setup_attrib_locations (program->program_id);
+
+      if (self->program_cache)
+        glProgramParameteri (program->program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+      glLinkProgram (program->program_id);
+    }
+
+  g_string_free (vertex_preamble, TRUE);
+  g_string_free (fragment_preamble, TRUE);
+  g_bytes_unref (source);
+
+  return program;
+}
+
+static gboolean
+gsk_gl_device_check_link_status (GskGLDevice  *self,
+                                 const char   *name,
+                                 GLProgram    *program,
+                                 GError      **error)
+{
+  char *buffer = NULL;
+  GLint link_status;
+  int log_len = 0;
+
+  glGetProgramiv (program->program_id, GL_LINK_STATUS, &link_status);
+  if G_LIKELY (link_status == GL_TRUE)
+    return TRUE;
+
+  /* Report compilation failures with the source code */
+  if (!gsk_gl_device_check_shader_error (name, program->vertex_shader_id, error) ||
+      !gsk_gl_device_check_shader_error (name, program->fragment_shader_id, error))
+    return FALSE;
+
+  glGetProgramiv (program->program_id, GL_INFO_LOG_LENGTH, &log_len);
+
+  if (log_len > 0)
     {
-      char *buffer = NULL;
-      int log_len = 0;
+      /* log_len includes NULL */
+      buffer = g_malloc0 (log_len);
+      glGetProgramInfoLog (program->program_id, log_len, NULL, buffer);
+    }
+
+  g_set_error (error,
+               GDK_GL_ERROR,
+               GDK_GL_ERROR_LINK_FAILED,
+               "Linking failure in shader: %s",
+               buffer ? buffer : "");
 
-      glGetProgramiv (program_id, GL_INFO_LOG_LENGTH, &log_len);
+  g_free (buffer);
 
-      if (log_len > 0)
+  return FALSE;
+}
+
+/* Waits for the compilation to finish if necessary */
+static gboolean
+gsk_gl_device_finish_program (GskGLDevice        *self,
+                              const GLProgramKey *key,
+                              GLProgram          *program,
+                              GError            **error)
+{
+  G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
+
+  g_assert (!program->ready);
+
+  if (program->vertex_shader_id)
+    {
+      gboolean linked;
+
+      linked = gsk_gl_device_check_link_status (self, key->op_class->shader_name, program, error);
+
+      glDetachShader (program->program_id, program->vertex_shader_id);
+      glDeleteShader (program->vertex_shader_id);
+      glDetachShader (program->program_id, program->fragment_shader_id);
+      glDeleteShader (program->fragment_shader_id);
+
+      gdk_profiler_end_markf (begin_time,
+                              "Compile Program",
+                              "name=%s id=%u frag=%u vert=%u",
+                              key->op_class->shader_name, program->program_id,
+                              program->fragment_shader_id, program->vertex_shader_id);
+
+      program->vertex_shader_id = 0;
+      program->fragment_shader_id = 0;
+
+      if (!linked)
+        return FALSE;
+
+      if (self->program_cache)
         {
-          /* log_len includes NULL */
-          buffer = g_malloc0 (log_len);
-          glGetProgramInfoLog (program_id, log_len, NULL, buffer);
+          gsk_gl_device_save_program_binary (self,
+                                             gl_program_key_to_string (key),
+                                             g_steal_pointer (&program->checksum),
+                                             program->program_id);
         }
+    }
 
-      g_set_error (error,
-                   GDK_GL_ERROR,
-                   GDK_GL_ERROR_LINK_FAILED,
-                   "Linking failure in shader: %s",
-                   buffer ? buffer : "");
+  g_clear_pointer (&program->checksum, g_free);
+  program->ready = TRUE;
 
-      g_free (buffer);
+  glUseProgram (program->program_id);
 
-      glDeleteProgram (program_id);
+  /* space by 3 because external textures may need 3 texture units */
+  glUniform1i (glGetUniformLocation (program->program_id, "GSK_TEXTURE0"), 0);
+  glUniform1i (glGetUniformLocation (program->program_id, "GSK_TEXTURE1"), 3);
 
-      return 0;
+  return TRUE;
+}
+
+static char *
+gsk_gl_device_get_variants_file (void)
+{
+  const char *prgname = g_get_prgname ();
+
+  if (prgname == NULL)
+    return NULL;
+
+  return g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "gl-shader-variants", prgname, NULL);
+}
+
+static void
+gsk_gl_device_load_variants (GskGLDevice *self)
+{
+  GError *error = NULL;
+  char *contents;
+  char **lines;
+  gsize i;
+
+  self->variants_loaded = TRUE;
+
+  if (!g_file_get_contents (self->variants_file, &contents, NULL, &error))
+    {
+      GSK_DEBUG (SHADERS, "Failed to load shader variants from '%s': %s",
+                 self->variants_file, error->message);
+      g_clear_error (&error);
+      return;
     }
 
-  gdk_profiler_end_markf (begin_time,
-                          "Compile Program",
-                          "name=%s id=%u frag=%u vert=%u",
-                          op_class->shader_name, program_id, fragment_shader_id, vertex_shader_id);
+  lines = g_strsplit (contents, "\n", -1);
+  for (i = 0; lines[i]; i++)
+    {
+      if (lines[i][0] != '\0')
+        g_hash_table_add (self->variants, g_steal_pointer (&lines[i]));
+    }
 
-  return program_id;
+  g_strfreev (lines);
+  g_free (contents);
+}
+
+static void
+gsk_gl_device_save_variants (GskGLDevice *self)
+{
+  GError *error = NULL;
+  GHashTableIter iter;
+  gpointer variant;
+  GString *string;
+  char *dirname;
+
+  /* don't lose the variants of last time if the warmup didn't get to them */
+  if (!self->variants_loaded)
+    gsk_gl_device_load_variants (self);
+
+  dirname = g_path_get_dirname (self->variants_file);
+  if (g_mkdir_with_parents (dirname, 0755) != 0)
+    {
+      g_warning_once ("Failed to create shader variants directory");
+      g_free (dirname);
+      return;
+    }
+  g_free (dirname);
+
+  string = g_string_new (NULL);
+  g_hash_table_iter_init (&iter, self->variants);
+  while (g_hash_table_iter_next (&iter, &variant, NULL))
+    {
+      g_string_append (string, variant);
+      g_string_append_c (string, '\n');
+    }
+
+  GSK_DEBUG (SHADERS, "Saving %u shader variants to %s",
+             g_hash_table_size (self->variants), self->variants_file);
+
+  if (!g_file_set_contents (self->variants_file, string->str, string->len, &error))
+    {
+      g_warning ("Failed to save shader variants: %s", error->message);
+      g_clear_error (&error);
+    }
+
+  g_string_free (string, TRUE);
+}
+
+static gboolean
+gsk_gl_device_save_variants_cb (gpointer data)
+{
+  GskGLDevice *self = data;
+
+  gsk_gl_device_save_variants (self);
+
+  self->save_variants_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+/* Remembers the variants the application uses, so they can be
+ * compiled ahead of time the next time it starts
+ */
+static void
+gsk_gl_device_record_variant (GskGLDevice        *self,
+                              const GLProgramKey *key)
+{
+  if (self->variants_file == NULL)
+    return;
+
+  if (!g_hash_table_add (self->variants, gl_program_key_to_string (key)))
+    return;
+
+  g_clear_handle_id (&self->save_variants_source, g_source_remove);
+  self->save_variants_source = g_timeout_add_seconds_full (G_PRIORITY_DEFAULT_IDLE - 10,
+                                                           10, /* don't save while starting up */
+                                                           gsk_gl_device_save_variants_cb,
+                                                           self,
+                                                           NULL);
+}
+
+/* The number of programs started per main loop iteration
+ * with parallel compilation
+ */
+#define WARMUP_BATCH_SIZE 8
+/* How long to compile per main loop iteration without it */
+#define WARMUP_BATCH_TIME (2 * G_TIME_SPAN_MILLISECOND)
+
+/* Forgets a variant that failed to compile, so it isn't
+ * warmed up again next time
+ */
+static void
+gsk_gl_device_warmup_failed (GskGLDevice        *self,
+                             const GLProgramKey *key,
+                             GError             *error)
+{
+  char *variant;
+
+  GSK_DEBUG (SHADERS, "Failed to warm up shader: %s", error->message);
+
+  variant = gl_program_key_to_string (key);
+  g_hash_table_remove (self->variants, variant);
+  g_free (variant);
+}
+
+static void
+gsk_gl_device_queue_variants (GskGLDevice *self)
+{
+  GHashTableIter iter;
+  gpointer variant;
+
+  if (!self->variants_loaded)
+    gsk_gl_device_load_variants (self);
+
+  g_hash_table_iter_init (&iter, self->variants);
+  while (g_hash_table_iter_next (&iter, &variant, NULL))
+    {
+      GLProgramKey key;
+
+      if (!gl_program_key_parse (&key, variant))
+        {
+          GSK_DEBUG (SHADERS, "Ignoring unknown shader variant %s", (const char *) variant);
+          continue;
+        }
+
+      if (g_hash_table_contains (self->gl_programs, &key))
+        continue;
+
+      /* Without parallel compilation, compiling blocks the main loop.
+       * Only do it ahead of time for programs in the binary cache,
+       * they are cheap to load. The others are compiled when used.
+       */
+      if (!self->parallel_compile &&
+          (self->program_cache == NULL || !g_hash_table_contains (self->program_cache, variant)))
+        continue;
+
+      g_queue_push_tail (&self->warmup_queue, g_memdup2 (&key, sizeof (GLProgramKey)));
+    }
+
+  GSK_DEBUG (SHADERS, "Warming up %u of %u shader variants%s",
+             g_queue_get_length (&self->warmup_queue),
+             g_hash_table_size (self->variants),
+             self->parallel_compile ? " in parallel" : "");
+}
+
+/* Collects the programs that are done compiling, and starts
+ * the next batch. Returns TRUE if there is more to do.
+ */
+static gboolean
+gsk_gl_device_warmup_parallel (GskGLDevice *self)
+{
+  GError *error = NULL;
+  GHashTableIter iter;
+  gpointer key, value;
+  gboolean pending = FALSE;
+  guint i;
+
+  g_hash_table_iter_init (&iter, self->gl_programs);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GLProgram *program = value;
+      GLint done;
+
+      if (program->ready)
+        continue;
+
+      glGetProgramiv (program->program_id, GL_COMPLETION_STATUS_KHR, &done);
+      if (!done)
+        {
+          pending = TRUE;
+          continue;
+        }
+
+      if (!gsk_gl_device_finish_program (self, key, program, &error))
+        {
+          gsk_gl_device_warmup_failed (self, key, error);
+          g_clear_error (&error);
+          g_hash_table_iter_remove (&iter);
+        }
+    }
+
+  for (i = 0; i < WARMUP_BATCH_SIZE; i++)
+    {
+      GLProgramKey *next = g_queue_pop_head (&self->warmup_queue);
+      GLProgram *program;
+
+      if (next == NULL)
+        break;
+
+      if (g_hash_table_contains (self->gl_programs, next))
+        {
+          g_free (next);
+          continue;
+        }
+
+      program = gsk_gl_device_start_program (self, next, &error);
+      if (program == NULL)
+        {
+          gsk_gl_device_warmup_failed (self, next, error);
+          g_clear_error (&error);
+          g_free (next);
+          continue;
+        }
+
+      g_hash_table_insert (self->gl_programs, next, program);
+      pending = TRUE;
+    }
+
+  return pending || !g_queue_is_empty (&self->warmup_queue);
+}
+
+/* Compiles programs until the time for this main loop iteration
+ * is used up. Returns TRUE if there is more to do.
+ */
+static gboolean
+gsk_gl_device_warmup_serial (GskGLDevice *self)
+{
+  GError *error = NULL;
+  gint64 start_time;
+
+  start_time = g_get_monotonic_time ();
+
+  do
+    {
+      GLProgramKey *next = g_queue_pop_head (&self->warmup_queue);
+      GLProgram *program;
+
+      if (next == NULL)
+        break;
+
+      if (g_hash_table_contains (self->gl_programs, next))
+        {
+          g_free (next);
+          continue;
+        }
+
+      program = gsk_gl_device_start_program (self, next, &error);
+      if (program && gsk_gl_device_finish_program (self, next, program, &error))
+        {
+          g_hash_table_insert (self->gl_programs, next, program);
+        }
+      else
+        {
+          gsk_gl_device_warmup_failed (self, next, error);
+          g_clear_error (&error);
+          g_clear_pointer (&program, free_gl_program);
+          g_free (next);
+        }
+    }
+  while (g_get_monotonic_time () - start_time < WARMUP_BATCH_TIME);
+
+  return !g_queue_is_empty (&self->warmup_queue);
+}
+
+static gboolean
+gsk_gl_device_warmup_cb (gpointer data)
+{
+  GskGLDevice *self = data;
+  GdkGLContext *previous;
+  gboolean pending;
+
+  if (!self->warmup_queued)
+    {
+      gsk_gl_device_queue_variants (self);
+      self->warmup_queued = TRUE;
+
+      if (g_queue_is_empty (&self->warmup_queue))
+        {
+          self->warmup_source = 0;
+          return G_SOURCE_REMOVE;
+        }
+
+      if (self->parallel_compile)
+        {
+          /* poll the driver instead of spinning in an idle */
+          self->warmup_source = g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 5, gsk_gl_device_warmup_cb, self, NULL);
+          gdk_source_set_static_name_by_id (self->warmup_source, "[gsk] shader warmup");
+          return G_SOURCE_REMOVE;
+        }
+
+      return G_SOURCE_CONTINUE;
+    }
+
+  /* Don't disturb whoever is using GL in between frames */
+  previous = gdk_gl_context_get_current ();
+  if (previous)
+    g_object_ref (previous);
+
+  gdk_gl_context_make_current (gdk_display_get_gl_context (gsk_gpu_device_get_display (GSK_GPU_DEVICE (self))));
+
+  if (self->parallel_compile)
+    pending = gsk_gl_device_warmup_parallel (self);
+  else
+    pending = gsk_gl_device_warmup_serial (self);
+
+  if (previous)
+    {
+      gdk_gl_context_make_current (previous);
+      g_object_unref (previous);
+    }
+  else
+    {
+      gdk_gl_context_clear_current ();
+    }
+
+  if (pending)
+    return G_SOURCE_CONTINUE;
+
+  GSK_DEBUG (SHADERS, "Shader warmup done");
+  self->warmup_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+/* Compiles the variants the application used last time, before
+ * the first frames need them. Nothing happens right away: the
+ * variants are loaded and compiled from the main loop, a batch
+ * at a time, when it has nothing better to do.
+ */
+static void
+gsk_gl_device_start_warmup (GskGLDevice *self)
+{
+  self->variants = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->variants_file = gsk_gl_device_get_variants_file ();
+  if (self->variants_file == NULL)
+    return;
+
+  self->warmup_source = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, gsk_gl_device_warmup_cb, self, NULL);
+  gdk_source_set_static_name_by_id (self->warmup_source, "[gsk] shader warmup");
+}
+
+/*< private >
+ * gsk_gl_device_is_warming_up:
+ * @self: a `GskGLDevice`
+ *
+ * Returns: %TRUE while shader variants are compiled ahead of time
+ */
+gboolean
+gsk_gl_device_is_warming_up (GskGLDevice *self)
+{
+  return self->warmup_source != 0;
 }
 
 void
@@ -544,7 +1435,7 @@ gsk_gl_device_use_program (GskGLDevice               *self,
                            guint32                    variation)
 {
   GError *error = NULL;
-  GLuint program_id;
+  GLProgram *program;
   GLProgramKey key = {
     .op_class = op_class,
     .flags = flags,
@@ -552,28 +1443,37 @@ gsk_gl_device_use_program (GskGLDevice               *self,
     .variation = variation,
   };
 
-  program_id = GPOINTER_TO_UINT (g_hash_table_lookup (self->gl_programs, &key));
-  if (program_id)
+  program = g_hash_table_lookup (self->gl_programs, &key);
+  if (program && program->ready)
     {
-      glUseProgram (program_id);
+      glUseProgram (program->program_id);
       return;
     }
 
-  program_id = gsk_gl_device_load_program (self, op_class, flags, color_states, variation, &error);
-  if (program_id == 0)
+  if (program == NULL)
+    {
+      program = gsk_gl_device_start_program (self, &key, &error);
+      if (program == NULL)
+        {
+          g_critical ("Failed to load shader program: %s", error->message);
+          g_clear_error (&error);
+          return;
+        }
+
+      g_hash_table_insert (self->gl_programs, g_memdup2 (&key, sizeof (GLProgramKey)), program);
+    }
+
+  if (!gsk_gl_device_finish_program (self, &key, program, &error))
     {
       g_critical ("Failed to load shader program: %s", error->message);
       g_clear_error (&error);
+      g_hash_table_remove (self->gl_programs, &key);
       return;
     }
-  
-  g_hash_table_insert (self->gl_programs, g_memdup2 (&key, sizeof (GLProgramKey)), GUINT_TO_POINTER (program_id));
 
-  glUseProgram (program_id);
+  gsk_gl_device_record_variant (self, &key);
 
-  /* space by 3 because external textures may need 3 texture units */
-  glUniform1i (glGetUniformLocation (program_id, "GSK_TEXTURE0"), 0);
-  glUniform1i (glGetUniformLocation (program_id, "GSK_TEXTURE1"), 3);
+  glUseProgram (program->program_id);
 }
 
 GLuint
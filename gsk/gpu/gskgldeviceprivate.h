@@ -17,6 +17,8 @@ void                    gsk_gl_device_use_program                       (GskGLDe
                                                                          GskGpuColorStates       color_states,
                                                                          guint32                 variation);
 
+gboolean                gsk_gl_device_is_warming_up                     (GskGLDevice            *self);
+
 GLuint                  gsk_gl_device_get_sampler_id                    (GskGLDevice            *self,
                                                                          GskGpuSampler           sampler);
 
@@ -33,7 +33,7 @@ gsk_gpu_blur_op_print_instance (GskGpuShaderOp *shader,
     gsk_gpu_print_rgba (string, instance->blur_color);
 }
 
-static const GskGpuShaderOpClass GSK_GPU_BLUR_OP_CLASS = {
+const GskGpuShaderOpClass GSK_GPU_BLUR_OP_CLASS = {
   {
     GSK_GPU_OP_SIZE (GskGpuBlurOp),
     GSK_GPU_STAGE_SHADER,
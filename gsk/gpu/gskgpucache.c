@@ -8,11 +8,15 @@
 #include "gskgpuuploadopprivate.h"
 
 #include "gdk/gdkcolorstateprivate.h"
+#include "gdk/gdkmemoryformatprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
 #include "gdk/gdkprofilerprivate.h"
 #include "gdk/gdktextureprivate.h"
 
 #include "gsk/gskdebugprivate.h"
 #include "gsk/gskprivate.h"
+#include "gsk/gskrectprivate.h"
+#include "gsk/gskrendernodeprivate.h"
 
 #define MAX_SLICES_PER_ATLAS 64
 
@@ -20,16 +24,33 @@
 
 #define MAX_ATLAS_ITEM_SIZE 256
 
+/* Textures up to this size go into the atlas, so that lots of
+ * icons can be drawn from the same image
+ */
+#define MAX_ATLAS_TEXTURE_SIZE 64
+
 #define MIN_ALIVE_PIXELS (ATLAS_SIZE * ATLAS_SIZE / 2)
 
 #define ATLAS_TIMEOUT_SCALE 4
 
+/* Pixels of all cached offscreens together, that's 64MB at 8bpc */
+#define MAX_OFFSCREEN_PIXELS (4096 * 4096)
+
+#define MAX_OFFSCREEN_ITEM_PIXELS (MAX_OFFSCREEN_PIXELS / 4)
+
+/* Nodes that were seen once. They keep their node alive, so don't
+ * keep too many of them.
+ */
+#define MAX_OFFSCREEN_CANDIDATES 64
+
 G_STATIC_ASSERT (MAX_ATLAS_ITEM_SIZE < ATLAS_SIZE);
+G_STATIC_ASSERT (MAX_ATLAS_TEXTURE_SIZE + 2 <= MAX_ATLAS_ITEM_SIZE);
 G_STATIC_ASSERT (MIN_ALIVE_PIXELS < ATLAS_SIZE * ATLAS_SIZE);
 
 typedef struct _GskGpuCachedGlyph GskGpuCachedGlyph;
 typedef struct _GskGpuCachedTexture GskGpuCachedTexture;
 typedef struct _GskGpuCachedTile GskGpuCachedTile;
+typedef struct _GskGpuCachedOffscreen GskGpuCachedOffscreen;
 
 struct _GskGpuCache
 {
@@ -43,11 +64,22 @@ struct _GskGpuCache
 
   GHashTable *texture_cache;
   GHashTable *ccs_texture_caches[GDK_COLOR_STATE_N_IDS];
+  GHashTable *atlas_texture_cache;
   GHashTable *tile_cache;
   GHashTable *glyph_cache;
+  GHashTable *offscreen_cache;
 
   GskGpuCachedAtlas *current_atlas;
 
+  gsize memory;  /* sum of the memory of all items */
+  gsize unevictable_memory;  /* memory when eviction last freed nothing, or 0 */
+
+  GQueue offscreen_candidates;
+  GQueue offscreens;  /* the ones with images, least recently used first */
+  gsize offscreen_pixels;
+  guint offscreen_hits;
+  guint offscreen_misses;
+
   /* atomic */ gsize dead_textures;
   /* atomic */ gsize dead_texture_pixels;
 };
@@ -89,6 +121,8 @@ gsk_gpu_cached_free (GskGpuCache  *self,
 
   mark_as_stale (cached, TRUE);
 
+  self->memory -= cached->memory;
+
   cached->class->free (self, cached);
 }
 
@@ -136,6 +170,25 @@ gsk_gpu_cached_use (GskGpuCache  *self,
 {
   cached->timestamp = self->timestamp;
   mark_as_stale (cached, FALSE);
+
+  /* The atlas is in use as long as its items are */
+  if (cached->atlas)
+    ((GskGpuCached *) cached->atlas)->timestamp = self->timestamp;
+}
+
+/* Accounts the memory of @image to @cached, for the cache budget */
+static void
+gsk_gpu_cached_add_image_memory (GskGpuCache  *self,
+                                 GskGpuCached *cached,
+                                 GskGpuImage  *image)
+{
+  gsize memory;
+
+  memory = gsk_gpu_image_get_width (image) * gsk_gpu_image_get_height (image) *
+           gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (image));
+
+  cached->memory += memory;
+  self->memory += memory;
 }
 
 static inline gboolean
@@ -211,7 +264,8 @@ static const GskGpuCachedClass GSK_GPU_CACHED_ATLAS_CLASS =
   sizeof (GskGpuCachedAtlas),
   "Atlas",
   gsk_gpu_cached_atlas_free,
-  gsk_gpu_cached_atlas_should_collect
+  gsk_gpu_cached_atlas_should_collect,
+  4.0f
 };
 
 static GskGpuCachedAtlas *
@@ -222,6 +276,7 @@ gsk_gpu_cached_atlas_new (GskGpuCache *cache)
   self = gsk_gpu_cached_new (cache, &GSK_GPU_CACHED_ATLAS_CLASS);
   self->image = gsk_gpu_device_create_atlas_image (cache->device, ATLAS_SIZE, ATLAS_SIZE);
   self->remaining_pixels = gsk_gpu_image_get_width (self->image) * gsk_gpu_image_get_height (self->image);
+  gsk_gpu_cached_add_image_memory (cache, (GskGpuCached *) self, self->image);
 
   return self;
 }
@@ -379,6 +434,7 @@ struct _GskGpuCachedTexture
   GdkTexture *texture;
   GskGpuImage *image;
   GdkColorState *color_state;  /* no ref because global. May be NULL */
+  graphene_rect_t area;        /* of the texture in the image, excluding padding */
 };
 
 static GHashTable *
@@ -404,6 +460,16 @@ gsk_gpu_cache_get_texture_hash_table (GskGpuCache   *cache,
     }
 }
 
+static GHashTable *
+gsk_gpu_cached_texture_get_hash_table (GskGpuCache         *cache,
+                                       GskGpuCachedTexture *self)
+{
+  if (((GskGpuCached *) self)->atlas)
+    return cache->atlas_texture_cache;
+
+  return gsk_gpu_cache_get_texture_hash_table (cache, self->color_state);
+}
+
 static void
 gsk_gpu_cached_texture_free (GskGpuCache  *cache,
                              GskGpuCached *cached)
@@ -414,7 +480,7 @@ gsk_gpu_cached_texture_free (GskGpuCache  *cache,
 
   g_clear_object (&self->image);
 
-  texture_cache = gsk_gpu_cache_get_texture_hash_table (cache, self->color_state);
+  texture_cache = gsk_gpu_cached_texture_get_hash_table (cache, self);
 
   if (g_hash_table_steal_extended (texture_cache, self->texture, &key, &value))
     {
@@ -460,7 +526,8 @@ static const GskGpuCachedClass GSK_GPU_CACHED_TEXTURE_CLASS =
   sizeof (GskGpuCachedTexture),
   "Texture",
   gsk_gpu_cached_texture_free,
-  gsk_gpu_cached_texture_should_collect
+  gsk_gpu_cached_texture_should_collect,
+  1.0f
 };
 
 /* Note: this function can run in an arbitrary thread, so it can
@@ -481,11 +548,16 @@ gsk_gpu_cached_texture_destroy_cb (gpointer data)
     g_free (self);
 }
 
+/* If @atlas is given, @area is the area of @image allocated for the
+ * texture, including 1 pixel of padding on each side
+ */
 static GskGpuCachedTexture *
-gsk_gpu_cached_texture_new (GskGpuCache   *cache,
-                            GdkTexture    *texture,
-                            GskGpuImage   *image,
-                            GdkColorState *color_state)
+gsk_gpu_cached_texture_new (GskGpuCache                 *cache,
+                            GdkTexture                  *texture,
+                            GskGpuImage                 *image,
+                            GdkColorState               *color_state,
+                            GskGpuCachedAtlas           *atlas,
+                            const cairo_rectangle_int_t *area)
 {
   GskGpuCachedTexture *self;
   GHashTable *texture_cache;
@@ -502,17 +574,27 @@ gsk_gpu_cached_texture_new (GskGpuCache   *cache,
         {
           gdk_texture_steal_render_data (texture);
           g_object_weak_ref (G_OBJECT (texture), (GWeakNotify) gsk_gpu_cached_texture_destroy_cb, self);
-          texture_cache = gsk_gpu_cache_get_texture_hash_table (cache, self->color_state);
+          texture_cache = gsk_gpu_cached_texture_get_hash_table (cache, self);
           g_assert (texture_cache != NULL);
           g_hash_table_insert (texture_cache, texture, self);
         }
     }
 
-  self = gsk_gpu_cached_new (cache, &GSK_GPU_CACHED_TEXTURE_CLASS);
+  self = gsk_gpu_cached_new_from_atlas (cache, &GSK_GPU_CACHED_TEXTURE_CLASS, atlas);
   self->texture = texture;
   self->image = g_object_ref (image);
   self->color_state = color_state;
-  ((GskGpuCached *)self)->pixels = gsk_gpu_image_get_width (image) * gsk_gpu_image_get_height (image);
+  if (atlas)
+    {
+      self->area = GRAPHENE_RECT_INIT (area->x + 1, area->y + 1, area->width - 2, area->height - 2);
+      ((GskGpuCached *)self)->pixels = area->width * area->height;
+    }
+  else
+    {
+      self->area = GRAPHENE_RECT_INIT (0, 0, gsk_gpu_image_get_width (image), gsk_gpu_image_get_height (image));
+      ((GskGpuCached *)self)->pixels = gsk_gpu_image_get_width (image) * gsk_gpu_image_get_height (image);
+      gsk_gpu_cached_add_image_memory (cache, (GskGpuCached *) self, image);
+    }
   self->dead_textures_counter = &cache->dead_textures;
   self->dead_pixels_counter = &cache->dead_texture_pixels;
   self->use_count = 2;
@@ -521,7 +603,7 @@ gsk_gpu_cached_texture_new (GskGpuCache   *cache,
     {
       g_object_weak_ref (G_OBJECT (texture), (GWeakNotify) gsk_gpu_cached_texture_destroy_cb, self);
 
-      texture_cache = gsk_gpu_cache_get_texture_hash_table (cache, self->color_state);
+      texture_cache = gsk_gpu_cached_texture_get_hash_table (cache, self);
       g_assert (texture_cache != NULL);
       g_hash_table_insert (texture_cache, texture, self);
     }
@@ -606,7 +688,8 @@ static const GskGpuCachedClass GSK_GPU_CACHED_TILE_CLASS =
   sizeof (GskGpuCachedTile),
   "Tile",
   gsk_gpu_cached_tile_free,
-  gsk_gpu_cached_tile_should_collect
+  gsk_gpu_cached_tile_should_collect,
+  1.0f
 };
 
 /* Note: this function can run in an arbitrary thread, so it can
@@ -670,6 +753,7 @@ gsk_gpu_cached_tile_new (GskGpuCache   *cache,
   self->image = g_object_ref (image);
   self->color_state = gdk_color_state_ref (color_state);
   ((GskGpuCached *)self)->pixels = gsk_gpu_image_get_width (image) * gsk_gpu_image_get_height (image);
+  gsk_gpu_cached_add_image_memory (cache, (GskGpuCached *) self, image);
   self->dead_textures_counter = &cache->dead_textures;
   self->dead_pixels_counter = &cache->dead_texture_pixels;
   self->use_count = 2;
@@ -813,9 +897,140 @@ static const GskGpuCachedClass GSK_GPU_CACHED_GLYPH_CLASS =
   sizeof (GskGpuCachedGlyph),
   "Glyph",
   gsk_gpu_cached_glyph_free,
-  gsk_gpu_cached_glyph_should_collect
+  gsk_gpu_cached_glyph_should_collect,
+  0.0f
+};
+
+/* }}} */
+/* {{{ CachedOffscreen */
+
+/* An offscreen that a node was rendered to, so it can be reused
+ * in the next frame if the node is still around. Nodes that were
+ * recreated with the same contents are found, too.
+ *
+ * The image is only created when a node is seen a second time, so
+ * nodes that change every frame don't waste memory and bandwidth.
+ * Until then, the node is a candidate.
+ */
+struct _GskGpuCachedOffscreen
+{
+  GskGpuCached parent;
+
+  GskRenderNode *node;
+  GdkColorState *color_state;  /* no ref because global */
+  graphene_vec2_t scale;
+
+  GskGpuImage *image;  /* NULL until the node was seen twice */
+  graphene_rect_t rect;
+
+  GList link;  /* in offscreens if it has an image, offscreen_candidates otherwise */
 };
 
+static void
+gsk_gpu_cached_offscreen_free (GskGpuCache  *cache,
+                               GskGpuCached *cached)
+{
+  GskGpuCachedOffscreen *self = (GskGpuCachedOffscreen *) cached;
+  gpointer key, value;
+
+  if (g_hash_table_steal_extended (cache->offscreen_cache, self, &key, &value))
+    {
+      /* If the entry has been replaced already, we put the new one back */
+      if ((GskGpuCached *) value != cached)
+        g_hash_table_add (cache->offscreen_cache, value);
+    }
+
+  if (self->image)
+    {
+      cache->offscreen_pixels -= cached->pixels;
+      g_object_unref (self->image);
+      g_queue_unlink (&cache->offscreens, &self->link);
+    }
+  else
+    g_queue_unlink (&cache->offscreen_candidates, &self->link);
+  gsk_render_node_unref (self->node);
+
+  g_free (self);
+}
+
+static gboolean
+gsk_gpu_cached_offscreen_should_collect (GskGpuCache  *cache,
+                                         GskGpuCached *cached,
+                                         gint64        cache_timeout,
+                                         gint64        timestamp)
+{
+  return gsk_gpu_cached_is_old (cache, cached, cache_timeout, timestamp);
+}
+
+static const GskGpuCachedClass GSK_GPU_CACHED_OFFSCREEN_CLASS =
+{
+  sizeof (GskGpuCachedOffscreen),
+  "Offscreen",
+  gsk_gpu_cached_offscreen_free,
+  gsk_gpu_cached_offscreen_should_collect,
+  8.0f
+};
+
+static inline guint
+hash_float (float f)
+{
+  return (guint) (int) floorf (f);
+}
+
+static guint
+gsk_gpu_cached_offscreen_hash (gconstpointer data)
+{
+  const GskGpuCachedOffscreen *self = data;
+  const graphene_rect_t *bounds = &self->node->bounds;
+
+  return gsk_render_node_get_node_type (self->node) ^
+         (hash_float (bounds->origin.x) << 5) ^
+         (hash_float (bounds->origin.y) << 13) ^
+         (hash_float (bounds->size.width) << 19) ^
+         (hash_float (bounds->size.height) << 25) ^
+         hash_float (graphene_vec2_get_x (&self->scale) * 64);
+}
+
+static gboolean
+gsk_gpu_cached_offscreen_equal (gconstpointer data_a,
+                                gconstpointer data_b)
+{
+  const GskGpuCachedOffscreen *a = data_a;
+  const GskGpuCachedOffscreen *b = data_b;
+  cairo_region_t *region;
+  gboolean result;
+
+  if (a->color_state != b->color_state ||
+      !graphene_vec2_equal (&a->scale, &b->scale))
+    return FALSE;
+
+  if (a->node == b->node)
+    return TRUE;
+
+  if (gsk_render_node_get_node_type (a->node) != gsk_render_node_get_node_type (b->node) ||
+      !gsk_rect_equal (&a->node->bounds, &b->node->bounds))
+    return FALSE;
+
+  /* The node was recreated, check if it still looks the same */
+  region = cairo_region_create ();
+  gsk_render_node_diff (a->node, b->node, &(GskDiffData) { region, NULL });
+  result = cairo_region_is_empty (region);
+  cairo_region_destroy (region);
+
+  return result;
+}
+
+static void
+gsk_gpu_cache_shrink_offscreens (GskGpuCache *self,
+                                 gsize        pixels)
+{
+  while (self->offscreen_pixels + pixels > MAX_OFFSCREEN_PIXELS &&
+         !g_queue_is_empty (&self->offscreens))
+    {
+      gsk_gpu_cached_free (self, g_queue_peek_head (&self->offscreens));
+    }
+}
+
 /* }}} */
 /* {{{ GskGpuCache */
 
@@ -844,17 +1059,15 @@ typedef struct
 {
   guint n_items;
   guint n_stale;
+  gsize memory;
 } CacheData;
 
-static void
-print_cache_stats (GskGpuCache *self)
+/* Returns a hash table mapping classes to their CacheData */
+static GHashTable *
+gsk_gpu_cache_collect_stats (GskGpuCache *self)
 {
-  GskGpuCached *cached;
-  GString *message;
-  GString *ratios = g_string_new ("");
   GHashTable *classes = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
-  GHashTableIter iter;
-  gpointer key, value;
+  GskGpuCached *cached;
 
   for (cached = self->first_cached; cached != NULL; cached = cached->next)
     {
@@ -867,7 +1080,25 @@ print_cache_stats (GskGpuCache *self)
       cache_data->n_items++;
       if (cached->stale)
         cache_data->n_stale++;
+      cache_data->memory += cached->memory;
+    }
+
+  return classes;
+}
+
+static void
+print_cache_stats (GskGpuCache *self,
+                   GHashTable  *classes,
+                   gsize        max_memory)
+{
+  GskGpuCached *cached;
+  GString *message;
+  GString *ratios = g_string_new ("");
+  GHashTableIter iter;
+  gpointer key, value;
 
+  for (cached = self->first_cached; cached != NULL; cached = cached->next)
+    {
       if (cached->class == &GSK_GPU_CACHED_ATLAS_CLASS)
         {
           double ratio;
@@ -894,22 +1125,158 @@ print_cache_stats (GskGpuCache *self)
 
       g_string_append_printf (message, "\n  %s:%*s%5u (%u stale)", class->name, 12 - MIN (12, (int) strlen (class->name)), "", cache_data->n_items, cache_data->n_stale);
 
+      if (cache_data->memory > 0)
+        g_string_append_printf (message, " %.1f MB", cache_data->memory / (1024. * 1024.));
+
       if (class == &GSK_GPU_CACHED_ATLAS_CLASS)
         g_string_append_printf (message, "%s", ratios->str);
       else if (class == &GSK_GPU_CACHED_TEXTURE_CLASS)
-        g_string_append_printf (message, " (%u in hash)", g_hash_table_size (self->texture_cache));
+        g_string_append_printf (message, " (%u in hash, %u in atlas)",
+                                g_hash_table_size (self->texture_cache),
+                                g_hash_table_size (self->atlas_texture_cache));
     }
 
+  if (max_memory < G_MAXSIZE)
+    g_string_append_printf (message, "\n  Memory: %.1f of %.1f MB",
+                            self->memory / (1024. * 1024.),
+                            max_memory / (1024. * 1024.));
+  else
+    g_string_append_printf (message, "\n  Memory: %.1f MB",
+                            self->memory / (1024. * 1024.));
+
+  if (self->offscreen_hits + self->offscreen_misses > 0)
+    g_string_append_printf (message, "\n  Offscreen hits: %u of %u (%.0f%%), %" G_GSIZE_FORMAT " pixels",
+                            self->offscreen_hits,
+                            self->offscreen_hits + self->offscreen_misses,
+                            100.0 * self->offscreen_hits / (self->offscreen_hits + self->offscreen_misses),
+                            self->offscreen_pixels);
+
   gdk_debug_message ("%s", message->str);
   g_string_free (message, TRUE);
-  g_hash_table_unref (classes);
   g_string_free (ratios, TRUE);
 }
 
+/* Sets a profiler counter with the memory of every class */
+static void
+update_profiler_counters (GHashTable *classes)
+{
+  static GHashTable *counters = NULL; /* class => counter id */
+  GHashTableIter iter;
+  gpointer key, value;
+
+  if (counters == NULL)
+    counters = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  g_hash_table_iter_init (&iter, classes);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      const GskGpuCachedClass *class = key;
+
+      if (!g_hash_table_contains (counters, class))
+        {
+          char *name = g_strdup_printf ("GPU cache: %s", class->name);
+          g_hash_table_insert (counters,
+                               (gpointer) class,
+                               GUINT_TO_POINTER (gdk_profiler_define_int_counter (name, "Bytes of GPU memory")));
+          g_free (name);
+        }
+
+      gdk_profiler_set_int_counter (GPOINTER_TO_UINT (g_hash_table_lookup (counters, class)),
+                                    ((CacheData *) value)->memory);
+    }
+
+  /* Classes without items need to be reset, too */
+  g_hash_table_iter_init (&iter, counters);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      if (!g_hash_table_contains (classes, key))
+        gdk_profiler_set_int_counter (GPOINTER_TO_UINT (value), 0);
+    }
+}
+
+typedef struct
+{
+  GskGpuCached *cached;
+  double score;
+} EvictionCandidate;
+
+static int
+compare_eviction_candidates (gconstpointer a,
+                             gconstpointer b)
+{
+  const EvictionCandidate *ca = a;
+  const EvictionCandidate *cb = b;
+
+  if (ca->score > cb->score)
+    return -1;
+  else if (ca->score < cb->score)
+    return 1;
+  else
+    return 0;
+}
+
+/* Evicting to a bit below the limit leaves room for the next frames,
+ * so we don't have to evict again right away
+ */
+#define EVICTION_TARGET(max_memory) ((max_memory) - (max_memory) / 4)
+
+/* Frees items until the cache fits into @max_memory.
+ *
+ * Items are evicted by age, weighted with the cost of recreating
+ * them, so an offscreen survives a bit longer than a texture that
+ * is just a memcpy away. Items that were used in the last frame
+ * are never evicted, the frame would just recreate them.
+ *
+ * Items on an atlas don't own memory, they go away with the atlas.
+ */
+static void
+gsk_gpu_cache_evict (GskGpuCache *self,
+                     gsize        max_memory,
+                     gint64       timestamp)
+{
+  GArray *candidates;
+  GskGpuCached *cached;
+  gsize i, before;
+
+  candidates = g_array_new (FALSE, FALSE, sizeof (EvictionCandidate));
+
+  for (cached = self->first_cached; cached != NULL; cached = cached->next)
+    {
+      if (cached->memory == 0 || cached->timestamp >= self->timestamp)
+        continue;
+
+      g_array_append_vals (candidates,
+                           &(EvictionCandidate) {
+                               cached,
+                               MAX (timestamp - cached->timestamp, 0) / MAX (cached->class->upload_cost, 0.01f)
+                           },
+                           1);
+    }
+
+  g_array_sort (candidates, compare_eviction_candidates);
+
+  before = self->memory;
+  for (i = 0; i < candidates->len && self->memory > max_memory; i++)
+    gsk_gpu_cached_free (self, g_array_index (candidates, EvictionCandidate, i).cached);
+
+  GSK_DEBUG (CACHE, "Evicted %" G_GSIZE_FORMAT " items with %" G_GSIZE_FORMAT " bytes to fit into %" G_GSIZE_FORMAT " bytes",
+             i, before - self->memory, max_memory);
+
+  /* Everything left is in use, trying again before the cache
+   * grows is pointless */
+  if (self->memory == before)
+    self->unevictable_memory = self->memory;
+  else
+    self->unevictable_memory = 0;
+
+  g_array_unref (candidates);
+}
+
 /* Returns TRUE if everything was GC'ed */
 gboolean
 gsk_gpu_cache_gc (GskGpuCache *self,
                   gint64       cache_timeout,
+                  gsize        max_memory,
                   gint64       timestamp)
 {
   GskGpuCached *cached, *prev;
@@ -928,17 +1295,59 @@ gsk_gpu_cache_gc (GskGpuCache *self,
         is_empty &= cached->stale;
     }
 
+  if (self->memory > max_memory)
+    gsk_gpu_cache_evict (self, EVICTION_TARGET (max_memory), timestamp);
+  else
+    self->unevictable_memory = 0;
+
   g_atomic_pointer_set (&self->dead_textures, 0);
   g_atomic_pointer_set (&self->dead_texture_pixels, 0);
 
-  if (GSK_DEBUG_CHECK (CACHE))
-    print_cache_stats (self);
+  if (GSK_DEBUG_CHECK (CACHE) || GDK_PROFILER_IS_RUNNING)
+    {
+      GHashTable *classes = gsk_gpu_cache_collect_stats (self);
+
+      if (GSK_DEBUG_CHECK (CACHE))
+        print_cache_stats (self, classes, max_memory);
+      if (GDK_PROFILER_IS_RUNNING)
+        update_profiler_counters (classes);
+
+      g_hash_table_unref (classes);
+    }
+
+  self->offscreen_hits = 0;
+  self->offscreen_misses = 0;
 
   gdk_profiler_end_mark (before, "Glyph cache GC", NULL);
 
   return is_empty;
 }
 
+/*
+ * gsk_gpu_cache_get_memory:
+ * @self: a `GskGpuCache`
+ *
+ * Returns: the GPU memory used by all cached items, in bytes
+ **/
+gsize
+gsk_gpu_cache_get_memory (GskGpuCache *self)
+{
+  return self->memory;
+}
+
+/*
+ * gsk_gpu_cache_get_unevictable_memory:
+ * @self: a `GskGpuCache`
+ *
+ * Returns: the memory the cache used when the last eviction
+ *   couldn't free anything, or 0
+ **/
+gsize
+gsk_gpu_cache_get_unevictable_memory (GskGpuCache *self)
+{
+  return self->unevictable_memory;
+}
+
 gsize
 gsk_gpu_cache_get_dead_textures (GskGpuCache *self)
 {
@@ -982,6 +1391,8 @@ gsk_gpu_cache_dispose (GObject *object)
   g_hash_table_unref (self->glyph_cache);
   g_clear_pointer (&self->tile_cache, g_hash_table_unref);
   g_hash_table_unref (self->texture_cache);
+  g_hash_table_unref (self->atlas_texture_cache);
+  g_hash_table_unref (self->offscreen_cache);
 
   G_OBJECT_CLASS (gsk_gpu_cache_parent_class)->dispose (object);
 }
@@ -1012,6 +1423,10 @@ gsk_gpu_cache_init (GskGpuCache *self)
                                         gsk_gpu_cached_glyph_equal);
   self->texture_cache = g_hash_table_new (g_direct_hash,
                                           g_direct_equal);
+  self->atlas_texture_cache = g_hash_table_new (g_direct_hash,
+                                                g_direct_equal);
+  self->offscreen_cache = g_hash_table_new (gsk_gpu_cached_offscreen_hash,
+                                            gsk_gpu_cached_offscreen_equal);
 }
 
 GskGpuImage *
@@ -1029,7 +1444,7 @@ gsk_gpu_cache_lookup_texture_image (GskGpuCache   *self,
   cache = gdk_texture_get_render_data (texture, self);
   /* color_state_equal() isn't necessary and if we'd use it,
    * we'd need to check for NULLs before */
-  if (cache == NULL || color_state != cache->color_state)
+  if (cache == NULL || color_state != cache->color_state || ((GskGpuCached *) cache)->atlas)
     cache = g_hash_table_lookup (texture_cache, texture);
 
   if (!cache || !cache->image || gsk_gpu_cached_texture_is_invalid (cache))
@@ -1048,12 +1463,212 @@ gsk_gpu_cache_cache_texture_image (GskGpuCache   *self,
 {
   GskGpuCachedTexture *cache;
 
-  cache = gsk_gpu_cached_texture_new (self, texture, image, color_state);
+  cache = gsk_gpu_cached_texture_new (self, texture, image, color_state, NULL, NULL);
   g_return_if_fail (cache != NULL);
 
   gsk_gpu_cached_use (self, (GskGpuCached *) cache);
 }
 
+/* Checks if the texture has an image of its own, in any color state */
+static gboolean
+gsk_gpu_cache_has_texture_image (GskGpuCache *self,
+                                 GdkTexture  *texture)
+{
+  GskGpuCachedTexture *cache;
+
+  cache = gdk_texture_get_render_data (texture, self);
+  if (cache == NULL || ((GskGpuCached *) cache)->atlas)
+    cache = g_hash_table_lookup (self->texture_cache, texture);
+
+  return cache && cache->image && !gsk_gpu_cached_texture_is_invalid (cache);
+}
+
+/*
+ * gsk_gpu_cache_lookup_atlas_texture:
+ * @self: a `GskGpuCache`
+ * @frame: the frame to upload the texture with
+ * @texture: the texture to look up
+ * @out_area: (out): the area of the returned image that contains
+ *   the texture
+ *
+ * Looks up a small texture in the atlas, and uploads it there if
+ * it isn't yet. Drawing many small textures from the same image
+ * allows merging the draws.
+ *
+ * Only memory textures are put into the atlas, and only if they
+ * don't have an image of their own already.
+ *
+ * The texture is surrounded by a copy of its edge pixels, so it can
+ * be drawn with linear filtering. It is always in the sRGB color
+ * state and can't be mipmapped.
+ *
+ * Returns: (nullable) (transfer full): the atlas image or %NULL
+ *   if the texture isn't suitable for the atlas
+ **/
+GskGpuImage *
+gsk_gpu_cache_lookup_atlas_texture (GskGpuCache     *self,
+                                    GskGpuFrame     *frame,
+                                    GdkTexture      *texture,
+                                    graphene_rect_t *out_area)
+{
+  GskGpuCachedTexture *cache;
+  GskGpuImage *image;
+  gsize width, height, x, y;
+  cairo_rectangle_int_t area;
+
+  cache = gdk_texture_get_render_data (texture, self);
+  if (cache == NULL || ((GskGpuCached *) cache)->atlas == NULL)
+    cache = g_hash_table_lookup (self->atlas_texture_cache, texture);
+
+  if (cache && !gsk_gpu_cached_texture_is_invalid (cache))
+    {
+      gsk_gpu_cached_use (self, (GskGpuCached *) cache);
+
+      *out_area = cache->area;
+      return g_object_ref (cache->image);
+    }
+
+  /* Other textures can be imported without a download, and
+   * textures that have an image already should use that one
+   */
+  if (!GDK_IS_MEMORY_TEXTURE (texture) ||
+      gsk_gpu_cache_has_texture_image (self, texture))
+    return NULL;
+
+  width = gdk_texture_get_width (texture);
+  height = gdk_texture_get_height (texture);
+  if (width > MAX_ATLAS_TEXTURE_SIZE || height > MAX_ATLAS_TEXTURE_SIZE ||
+      gdk_texture_get_depth (texture) != GDK_MEMORY_U8 ||
+      !gdk_color_state_equal (gdk_texture_get_color_state (texture), GDK_COLOR_STATE_SRGB))
+    return NULL;
+
+  image = gsk_gpu_cache_add_atlas_image (self, width + 2, height + 2, &x, &y);
+  if (image == NULL)
+    return NULL;
+
+  area = (cairo_rectangle_int_t) { x, y, width + 2, height + 2 };
+  gsk_gpu_upload_atlas_texture_op (frame, image, &area, texture);
+
+  cache = gsk_gpu_cached_texture_new (self, texture, image, NULL, self->current_atlas, &area);
+  gsk_gpu_cached_use (self, (GskGpuCached *) cache);
+
+  *out_area = cache->area;
+  return g_object_ref (image);
+}
+
+/*
+ * gsk_gpu_cache_lookup_offscreen:
+ * @self: a `GskGpuCache`
+ * @node: the node to look up
+ * @color_state: the color state the node is rendered in
+ * @scale: the scale the node is rendered at
+ * @out_rect: (out): the area of @node covered by the image
+ * @out_should_cache: (out): set to %TRUE if no image was found,
+ *   but the node should be rendered to an offscreen and cached
+ *   with gsk_gpu_cache_cache_offscreen()
+ *
+ * Looks up an offscreen that @node was rendered to previously.
+ *
+ * Returns: (nullable) (transfer full): the image
+ **/
+GskGpuImage *
+gsk_gpu_cache_lookup_offscreen (GskGpuCache           *self,
+                                GskRenderNode         *node,
+                                GdkColorState         *color_state,
+                                const graphene_vec2_t *scale,
+                                graphene_rect_t       *out_rect,
+                                gboolean              *out_should_cache)
+{
+  GskGpuCachedOffscreen lookup = {
+    .node = node,
+    .color_state = color_state,
+    .scale = *scale,
+  };
+  GskGpuCachedOffscreen *cache;
+
+  cache = g_hash_table_lookup (self->offscreen_cache, &lookup);
+  if (cache == NULL)
+    {
+      if (self->offscreen_candidates.length >= MAX_OFFSCREEN_CANDIDATES)
+        gsk_gpu_cached_free (self, g_queue_peek_head (&self->offscreen_candidates));
+
+      cache = gsk_gpu_cached_new (self, &GSK_GPU_CACHED_OFFSCREEN_CLASS);
+      cache->node = gsk_render_node_ref (node);
+      cache->color_state = color_state;
+      cache->scale = *scale;
+      g_hash_table_add (self->offscreen_cache, cache);
+      cache->link.data = cache;
+      g_queue_push_tail_link (&self->offscreen_candidates, &cache->link);
+      gsk_gpu_cached_use (self, (GskGpuCached *) cache);
+
+      self->offscreen_misses++;
+      *out_should_cache = FALSE;
+      return NULL;
+    }
+
+  gsk_gpu_cached_use (self, (GskGpuCached *) cache);
+
+  if (cache->image == NULL)
+    {
+      self->offscreen_misses++;
+      *out_should_cache = node->bounds.size.width * graphene_vec2_get_x (scale) *
+                          node->bounds.size.height * graphene_vec2_get_y (scale) <= MAX_OFFSCREEN_ITEM_PIXELS;
+      return NULL;
+    }
+
+  g_queue_unlink (&self->offscreens, &cache->link);
+  g_queue_push_tail_link (&self->offscreens, &cache->link);
+
+  self->offscreen_hits++;
+  *out_rect = cache->rect;
+  *out_should_cache = FALSE;
+
+  return g_object_ref (cache->image);
+}
+
+void
+gsk_gpu_cache_cache_offscreen (GskGpuCache           *self,
+                               GskRenderNode         *node,
+                               GdkColorState         *color_state,
+                               const graphene_vec2_t *scale,
+                               const graphene_rect_t *rect,
+                               GskGpuImage           *image)
+{
+  GskGpuCachedOffscreen lookup = {
+    .node = node,
+    .color_state = color_state,
+    .scale = *scale,
+  };
+  GskGpuCachedOffscreen *cache;
+  gsize pixels;
+
+  pixels = gsk_gpu_image_get_width (image) * gsk_gpu_image_get_height (image);
+  if (pixels > MAX_OFFSCREEN_ITEM_PIXELS)
+    return;
+
+  /* Free the entry we replace right away, it keeps its node alive */
+  cache = g_hash_table_lookup (self->offscreen_cache, &lookup);
+  if (cache)
+    gsk_gpu_cached_free (self, (GskGpuCached *) cache);
+
+  gsk_gpu_cache_shrink_offscreens (self, pixels);
+
+  cache = gsk_gpu_cached_new (self, &GSK_GPU_CACHED_OFFSCREEN_CLASS);
+  cache->node = gsk_render_node_ref (node);
+  cache->color_state = color_state;
+  cache->scale = *scale;
+  cache->image = g_object_ref (image);
+  cache->rect = *rect;
+  ((GskGpuCached *) cache)->pixels = pixels;
+  gsk_gpu_cached_add_image_memory (self, (GskGpuCached *) cache, image);
+  self->offscreen_pixels += pixels;
+  cache->link.data = cache;
+  g_queue_push_tail_link (&self->offscreens, &cache->link);
+
+  g_hash_table_add (self->offscreen_cache, cache);
+  gsk_gpu_cached_use (self, (GskGpuCached *) cache);
+}
+
 GskGpuImage *
 gsk_gpu_cache_lookup_glyph_image (GskGpuCache            *self,
                                   GskGpuFrame            *frame,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gskgputypesprivate.h"
+#include "gsktypes.h"
 
 #include <graphene.h>
 
@@ -21,6 +22,12 @@ struct _GskGpuCachedClass
                                                          GskGpuCached           *cached,
                                                          gint64                  cache_timeout,
                                                          gint64                  timestamp);
+
+  /* How expensive it is to recreate the item per byte of memory
+   * it holds. Items that are cheap to recreate get evicted first
+   * when the cache is over budget.
+   */
+  float upload_cost;
 };
 
 struct _GskGpuCached
@@ -34,6 +41,7 @@ struct _GskGpuCached
   gint64 timestamp;
   gboolean stale;
   guint pixels;   /* For glyphs and textures, pixels. For atlases, alive pixels */
+  gsize memory;   /* Bytes of GPU memory owned by the item, 0 if it is on an atlas */
 };
 
 #define GSK_TYPE_GPU_CACHE         (gsk_gpu_cache_get_type ())
@@ -63,7 +71,10 @@ void                    gsk_gpu_cache_set_time                          (GskGpuC
 
 gboolean                gsk_gpu_cache_gc                                (GskGpuCache            *self,
                                                                          gint64                  cache_timeout,
+                                                                         gsize                   max_memory,
                                                                          gint64                  timestamp);
+gsize                   gsk_gpu_cache_get_memory                        (GskGpuCache            *self);
+gsize                   gsk_gpu_cache_get_unevictable_memory            (GskGpuCache            *self);
 gsize                   gsk_gpu_cache_get_dead_textures                 (GskGpuCache            *self);
 gsize                   gsk_gpu_cache_get_dead_texture_pixels           (GskGpuCache            *self);
 GskGpuImage *           gsk_gpu_cache_get_atlas_image                   (GskGpuCache            *self);
@@ -75,6 +86,10 @@ void                    gsk_gpu_cache_cache_texture_image               (GskGpuC
                                                                          GdkTexture             *texture,
                                                                          GskGpuImage            *image,
                                                                          GdkColorState          *color_state);
+GskGpuImage *           gsk_gpu_cache_lookup_atlas_texture              (GskGpuCache            *self,
+                                                                         GskGpuFrame            *frame,
+                                                                         GdkTexture             *texture,
+                                                                         graphene_rect_t        *out_area);
 GskGpuImage *           gsk_gpu_cache_lookup_tile                       (GskGpuCache            *self,
                                                                          GdkTexture             *texture,
                                                                          guint                   lod_level,
@@ -88,6 +103,18 @@ void                    gsk_gpu_cache_cache_tile                        (GskGpuC
                                                                          gsize                   tile_id,
                                                                          GskGpuImage            *image,
                                                                          GdkColorState          *color_state);
+GskGpuImage *           gsk_gpu_cache_lookup_offscreen                  (GskGpuCache            *self,
+                                                                         GskRenderNode          *node,
+                                                                         GdkColorState          *color_state,
+                                                                         const graphene_vec2_t  *scale,
+                                                                         graphene_rect_t        *out_rect,
+                                                                         gboolean               *out_should_cache);
+void                    gsk_gpu_cache_cache_offscreen                   (GskGpuCache            *self,
+                                                                         GskRenderNode          *node,
+                                                                         GdkColorState          *color_state,
+                                                                         const graphene_vec2_t  *scale,
+                                                                         const graphene_rect_t  *rect,
+                                                                         GskGpuImage            *image);
 
 typedef enum
 {
@@ -28,7 +28,7 @@ gsk_gpu_colorize_op_print_instance (GskGpuShaderOp *shader,
   gsk_gpu_print_rgba (string, instance->color);
 }
 
-static const GskGpuShaderOpClass GSK_GPU_COLORIZE_OP_CLASS = {
+const GskGpuShaderOpClass GSK_GPU_COLORIZE_OP_CLASS = {
   {
     GSK_GPU_OP_SIZE (GskGpuColorizeOp),
     GSK_GPU_STAGE_SHADER,
@@ -32,7 +32,7 @@ gsk_gpu_convert_op_print_instance (GskGpuShaderOp *shader,
     gsk_gpu_print_string (string, "straight");
 }
 
-static const GskGpuShaderOpClass GSK_GPU_CONVERT_OP_CLASS = {
+const GskGpuShaderOpClass GSK_GPU_CONVERT_OP_CLASS = {
   {
     GSK_GPU_OP_SIZE (GskGpuConvertOp),
     GSK_GPU_STAGE_SHADER,
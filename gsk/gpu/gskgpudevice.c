@@ -9,6 +9,7 @@
 #include "gsk/gskdebugprivate.h"
 
 #define CACHE_TIMEOUT 15  /* seconds */
+#define CACHE_BUDGET 256  /* megabytes */
 
 typedef struct _GskGpuDevicePrivate GskGpuDevicePrivate;
 
@@ -21,6 +22,10 @@ struct _GskGpuDevicePrivate
   GskGpuCache *cache; /* we don't own a ref, but manage the cache */
   guint cache_gc_source;
   int cache_timeout;  /* in seconds, or -1 to disable gc */
+  gsize cache_budget; /* in bytes, or G_MAXSIZE for no limit */
+
+  GMemoryMonitor *memory_monitor;
+  gulong low_memory_handler;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GskGpuDevice, gsk_gpu_device, G_TYPE_OBJECT)
@@ -28,6 +33,7 @@ G_DEFINE_TYPE_WITH_PRIVATE (GskGpuDevice, gsk_gpu_device, G_TYPE_OBJECT)
 /* Returns TRUE if everything was GC'ed */
 static gboolean
 gsk_gpu_device_gc (GskGpuDevice *self,
+                   gsize         max_memory,
                    gint64        timestamp)
 {
   GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
@@ -41,6 +47,7 @@ gsk_gpu_device_gc (GskGpuDevice *self,
 
   result = gsk_gpu_cache_gc (priv->cache,
                              priv->cache_timeout >= 0 ? priv->cache_timeout * G_TIME_SPAN_SECOND : -1,
+                             max_memory,
                              timestamp);
   if (result)
     g_clear_object (&priv->cache);
@@ -65,7 +72,7 @@ cache_gc_cb (gpointer data)
    * the cache is keeping it alive */
   g_object_ref (self);
 
-  if (gsk_gpu_device_gc (self, timestamp))
+  if (gsk_gpu_device_gc (self, priv->cache_budget, timestamp))
     {
       priv->cache_gc_source = 0;
       result = G_SOURCE_REMOVE;
@@ -80,7 +87,7 @@ void
 gsk_gpu_device_maybe_gc (GskGpuDevice *self)
 {
   GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
-  gsize dead_texture_pixels, dead_textures;
+  gsize dead_texture_pixels, dead_textures, memory;
 
   if (priv->cache_timeout < 0)
     return;
@@ -90,15 +97,52 @@ gsk_gpu_device_maybe_gc (GskGpuDevice *self)
 
   dead_textures = gsk_gpu_cache_get_dead_textures (priv->cache);
   dead_texture_pixels = gsk_gpu_cache_get_dead_texture_pixels (priv->cache);
-
-  if (priv->cache_timeout == 0 || dead_textures > 50 || dead_texture_pixels > 1000 * 1000)
+  memory = gsk_gpu_cache_get_memory (priv->cache);
+
+  /* When the last eviction couldn't free anything, everything was
+   * in use. Wait for the cache to grow or the periodic GC instead
+   * of trying again every frame.
+   */
+  if (priv->cache_timeout == 0 || dead_textures > 50 || dead_texture_pixels > 1000 * 1000 ||
+      (memory > priv->cache_budget && memory > gsk_gpu_cache_get_unevictable_memory (priv->cache)))
     {
-      GSK_DEBUG (CACHE, "Pre-frame GC (%" G_GSIZE_FORMAT " dead textures, %" G_GSIZE_FORMAT " dead pixels)",
-                 dead_textures, dead_texture_pixels);
-      gsk_gpu_device_gc (self, g_get_monotonic_time ());
+      GSK_DEBUG (CACHE, "Pre-frame GC (%" G_GSIZE_FORMAT " dead textures, %" G_GSIZE_FORMAT " dead pixels, %" G_GSIZE_FORMAT " bytes)",
+                 dead_textures, dead_texture_pixels, memory);
+      gsk_gpu_device_gc (self, priv->cache_budget, g_get_monotonic_time ());
     }
 }
 
+static void
+low_memory_warning_cb (GMemoryMonitor             *monitor,
+                       GMemoryMonitorWarningLevel  level,
+                       gpointer                    data)
+{
+  GskGpuDevice *self = data;
+  GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
+  gsize max_memory;
+
+  if (priv->cache == NULL)
+    return;
+
+  /* Give back memory in proportion to the pressure */
+  max_memory = MIN (priv->cache_budget, gsk_gpu_cache_get_memory (priv->cache));
+  if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+    max_memory = 0;
+  else if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+    max_memory /= 4;
+  else
+    max_memory /= 2;
+
+  GSK_DEBUG (CACHE, "Low memory GC (level %d, shrinking to %" G_GSIZE_FORMAT " bytes)", level, max_memory);
+
+  /* gc can collect the device, see cache_gc_cb() */
+  g_object_ref (self);
+
+  gsk_gpu_device_gc (self, max_memory, g_get_monotonic_time ());
+
+  g_object_unref (self);
+}
+
 void
 gsk_gpu_device_queue_gc (GskGpuDevice *self)
 {
@@ -115,6 +159,8 @@ gsk_gpu_device_dispose (GObject *object)
   GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
 
   g_clear_handle_id (&priv->cache_gc_source, g_source_remove);
+  g_clear_signal_handler (&priv->low_memory_handler, priv->memory_monitor);
+  g_clear_object (&priv->memory_monitor);
 
   G_OBJECT_CLASS (gsk_gpu_device_parent_class)->dispose (object);
 }
@@ -174,6 +220,36 @@ gsk_gpu_device_setup (GskGpuDevice *self,
         }
     }
 
+  priv->cache_budget = (gsize) CACHE_BUDGET * 1024 * 1024;
+
+  str = g_getenv ("GSK_CACHE_BUDGET");
+  if (str != NULL)
+    {
+      gint64 value;
+      GError *error = NULL;
+
+      if (!g_ascii_string_to_signed (str, 10, -1, G_MAXINT, &value, &error))
+        {
+          g_warning ("Failed to parse GSK_CACHE_BUDGET: %s", error->message);
+          g_error_free (error);
+        }
+      else if (value < 0)
+        {
+          priv->cache_budget = G_MAXSIZE;
+        }
+      else
+        {
+          priv->cache_budget = (gsize) value * 1024 * 1024;
+        }
+    }
+
+  if (priv->cache_timeout >= 0)
+    {
+      priv->memory_monitor = g_memory_monitor_dup_default ();
+      priv->low_memory_handler = g_signal_connect (priv->memory_monitor, "low-memory-warning",
+                                                   G_CALLBACK (low_memory_warning_cb), self);
+    }
+
   if (GSK_DEBUG_CHECK (CACHE))
     {
       if (priv->cache_timeout < 0)
@@ -182,6 +258,11 @@ gsk_gpu_device_setup (GskGpuDevice *self,
         gdk_debug_message ("Cache GC before every frame");
       else
         gdk_debug_message ("Cache GC timeout: %d seconds", priv->cache_timeout);
+
+      if (priv->cache_budget == G_MAXSIZE)
+        gdk_debug_message ("Cache budget: unlimited");
+      else
+        gdk_debug_message ("Cache budget: %" G_GSIZE_FORMAT " MB", priv->cache_budget / (1024 * 1024));
     }
 }
 
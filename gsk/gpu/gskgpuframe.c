@@ -10,6 +10,7 @@
 #include "gskgpunodeprocessorprivate.h"
 #include "gskgpuopprivate.h"
 #include "gskgpurendererprivate.h"
+#include "gskgpushaderopprivate.h"
 #include "gskgpuuploadopprivate.h"
 
 #include "gskdebugprivate.h"
@@ -52,6 +53,22 @@ struct _GskGpuFramePrivate
   gsize storage_buffer_used;
 };
 
+/* A recording collects the ops and vertex data emitted by a thread
+ * other than the one owning the frame. It is appended to the frame
+ * once the thread is done, see gsk_gpu_frame_start_recording().
+ */
+struct _GskGpuFrameRecording
+{
+  GskGpuOps ops;
+  GskGpuOp *last_op;
+
+  guchar *vertex_data;
+  gsize vertex_data_size;
+  gsize vertex_data_used;
+};
+
+static GPrivate current_recording;
+
 G_DEFINE_TYPE_WITH_PRIVATE (GskGpuFrame, gsk_gpu_frame, G_TYPE_OBJECT)
 
 static void
@@ -451,8 +468,19 @@ gsk_gpu_frame_alloc_op (GskGpuFrame *self,
                         gsize        size)
 {
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  GskGpuFrameRecording *recording;
   gsize pos;
 
+  recording = g_private_get (&current_recording);
+  if (G_UNLIKELY (recording))
+    {
+      pos = gsk_gpu_ops_get_size (&recording->ops);
+      gsk_gpu_ops_splice (&recording->ops, pos, 0, FALSE, NULL, size);
+      recording->last_op = (GskGpuOp *) gsk_gpu_ops_index (&recording->ops, pos);
+
+      return recording->last_op;
+    }
+
   pos = gsk_gpu_ops_get_size (&priv->ops);
 
   gsk_gpu_ops_splice (&priv->ops,
@@ -470,6 +498,11 @@ GskGpuOp *
 gsk_gpu_frame_get_last_op (GskGpuFrame *self)
 {
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  GskGpuFrameRecording *recording;
+
+  recording = g_private_get (&current_recording);
+  if (G_UNLIKELY (recording))
+    return recording->last_op;
 
   return priv->last_op;
 }
@@ -519,9 +552,10 @@ gsk_gpu_frame_get_texture_vertex_size (GskGpuFrame *self,
   return priv->texture_vertex_size * n_textures;
 }
 
-gsize
-gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
-                                   gsize        size)
+static gsize
+gsk_gpu_frame_reserve_vertex_data_aligned (GskGpuFrame *self,
+                                           gsize        size,
+                                           gsize        alignment)
 {
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
   gsize size_needed;
@@ -529,12 +563,12 @@ gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
   if (priv->vertex_buffer == NULL)
     priv->vertex_buffer = gsk_gpu_frame_create_vertex_buffer (self, DEFAULT_VERTEX_BUFFER_SIZE);
 
-  size_needed = round_up (priv->vertex_buffer_used, size) + size;
+  size_needed = round_up (priv->vertex_buffer_used, alignment) + size;
 
   if (gsk_gpu_buffer_get_size (priv->vertex_buffer) < size_needed)
     {
       gsize old_size = gsk_gpu_buffer_get_size (priv->vertex_buffer);
-      GskGpuBuffer *new_buffer = gsk_gpu_frame_create_vertex_buffer (self, old_size * 2);
+      GskGpuBuffer *new_buffer = gsk_gpu_frame_create_vertex_buffer (self, MAX (old_size * 2, size_needed));
       guchar *new_data = gsk_gpu_buffer_map (new_buffer);
 
       if (priv->vertex_buffer_data)
@@ -552,11 +586,41 @@ gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
   return size_needed - size;
 }
 
+gsize
+gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
+                                   gsize        size)
+{
+  GskGpuFrameRecording *recording;
+
+  recording = g_private_get (&current_recording);
+  if (G_UNLIKELY (recording))
+    {
+      gsize size_needed;
+
+      size_needed = round_up (recording->vertex_data_used, size) + size;
+      if (recording->vertex_data_size < size_needed)
+        {
+          recording->vertex_data_size = MAX (recording->vertex_data_size * 2, size_needed);
+          recording->vertex_data = g_realloc (recording->vertex_data, recording->vertex_data_size);
+        }
+      recording->vertex_data_used = size_needed;
+
+      return size_needed - size;
+    }
+
+  return gsk_gpu_frame_reserve_vertex_data_aligned (self, size, size);
+}
+
 guchar *
 gsk_gpu_frame_get_vertex_data (GskGpuFrame *self,
                                gsize        offset)
 {
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  GskGpuFrameRecording *recording;
+
+  recording = g_private_get (&current_recording);
+  if (G_UNLIKELY (recording))
+    return recording->vertex_data + offset;
 
   if (priv->vertex_buffer_data == NULL)
     priv->vertex_buffer_data = gsk_gpu_buffer_map (priv->vertex_buffer);
@@ -564,6 +628,107 @@ gsk_gpu_frame_get_vertex_data (GskGpuFrame *self,
   return priv->vertex_buffer_data + offset;
 }
 
+/*
+ * gsk_gpu_frame_start_recording:
+ * @self: the frame
+ *
+ * Redirects all ops and vertex data that the current thread adds
+ * to @self into a new recording, until gsk_gpu_frame_stop_recording()
+ * is called.
+ *
+ * This allows recording ops from multiple threads at once. It is only
+ * safe for ops that do not need the device, like shader ops without
+ * images.
+ *
+ * Returns: the new recording
+ **/
+GskGpuFrameRecording *
+gsk_gpu_frame_start_recording (GskGpuFrame *self)
+{
+  GskGpuFrameRecording *recording;
+
+  g_return_val_if_fail (g_private_get (&current_recording) == NULL, NULL);
+
+  recording = g_new0 (GskGpuFrameRecording, 1);
+  gsk_gpu_ops_init (&recording->ops);
+
+  g_private_set (&current_recording, recording);
+
+  return recording;
+}
+
+void
+gsk_gpu_frame_stop_recording (GskGpuFrame          *self,
+                              GskGpuFrameRecording *recording)
+{
+  g_return_if_fail (g_private_get (&current_recording) == recording);
+
+  g_private_set (&current_recording, NULL);
+}
+
+gboolean
+gsk_gpu_frame_is_recording (GskGpuFrame *self)
+{
+  return g_private_get (&current_recording) != NULL;
+}
+
+/*
+ * gsk_gpu_frame_append_recording:
+ * @self: the frame
+ * @recording: (transfer full): a stopped recording
+ *
+ * Adds the ops of @recording to @self, as if they had been added
+ * to @self directly, and frees @recording.
+ *
+ * The vertex data of the recording is moved into the vertex buffer
+ * of the frame, so appending recordings in the same order always
+ * results in the same ops.
+ **/
+void
+gsk_gpu_frame_append_recording (GskGpuFrame          *self,
+                                GskGpuFrameRecording *recording)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  GskGpuOp *op;
+  gsize i, pos;
+
+  for (i = 0; i < gsk_gpu_ops_get_size (&recording->ops); i += op->op_class->size)
+    {
+      op = (GskGpuOp *) gsk_gpu_ops_index (&recording->ops, i);
+
+      if (op->op_class->stage == GSK_GPU_STAGE_SHADER)
+        {
+          GskGpuShaderOp *shader = (GskGpuShaderOp *) op;
+          const GskGpuShaderOpClass *shader_class = (const GskGpuShaderOpClass *) op->op_class;
+          gsize vertex_size, vertex_offset;
+
+          vertex_size = gsk_gpu_frame_get_texture_vertex_size (self, shader_class->n_textures) + shader_class->vertex_size;
+          vertex_offset = gsk_gpu_frame_reserve_vertex_data_aligned (self, shader->n_ops * vertex_size, vertex_size);
+          memcpy (gsk_gpu_frame_get_vertex_data (self, vertex_offset),
+                  recording->vertex_data + shader->vertex_offset,
+                  shader->n_ops * vertex_size);
+          shader->vertex_offset = vertex_offset;
+        }
+    }
+
+  if (gsk_gpu_ops_get_size (&recording->ops) > 0)
+    {
+      pos = gsk_gpu_ops_get_size (&priv->ops);
+      gsk_gpu_ops_splice (&priv->ops,
+                          pos,
+                          0, FALSE,
+                          gsk_gpu_ops_get_data (&recording->ops),
+                          gsk_gpu_ops_get_size (&recording->ops));
+      priv->last_op = (GskGpuOp *) gsk_gpu_ops_index (&priv->ops,
+                                                     pos + ((guchar *) recording->last_op - gsk_gpu_ops_get_data (&recording->ops)));
+    }
+
+  /* The ops now belong to the frame, so don't finish them */
+  gsk_gpu_ops_clear (&recording->ops);
+  g_free (recording->vertex_data);
+  g_free (recording);
+}
+
 static void
 gsk_gpu_frame_ensure_storage_buffer (GskGpuFrame *self)
 {
@@ -13,6 +13,7 @@ G_BEGIN_DECLS
 #define GSK_GPU_FRAME_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), GSK_TYPE_GPU_FRAME, GskGpuFrameClass))
 
 typedef struct _GskGpuFrameClass GskGpuFrameClass;
+typedef struct _GskGpuFrameRecording GskGpuFrameRecording;
 
 struct _GskGpuFrame
 {
@@ -92,6 +93,12 @@ void                    gsk_gpu_frame_write_texture_vertex_data         (GskGpuF
                                                                          GskGpuImage           **images,
                                                                          GskGpuSampler          *samplers,
                                                                          gsize                   n_images);
+GskGpuFrameRecording *  gsk_gpu_frame_start_recording                   (GskGpuFrame            *self);
+void                    gsk_gpu_frame_stop_recording                    (GskGpuFrame            *self,
+                                                                         GskGpuFrameRecording   *recording);
+gboolean                gsk_gpu_frame_is_recording                      (GskGpuFrame            *self);
+void                    gsk_gpu_frame_append_recording                  (GskGpuFrame            *self,
+                                                                         GskGpuFrameRecording   *recording);
 GskGpuBuffer *          gsk_gpu_frame_write_storage_buffer              (GskGpuFrame            *self,
                                                                          const guchar           *data,
                                                                          gsize                   size,
@@ -29,7 +29,7 @@ gsk_gpu_mask_op_print_instance (GskGpuShaderOp *shader,
   gsk_gpu_print_image (string, shader->images[1]);
 }
 
-static const GskGpuShaderOpClass GSK_GPU_MASK_OP_CLASS = {
+const GskGpuShaderOpClass GSK_GPU_MASK_OP_CLASS = {
   {
     GSK_GPU_OP_SIZE (GskGpuMaskOp),
     GSK_GPU_STAGE_SHADER,
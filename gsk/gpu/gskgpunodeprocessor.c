@@ -45,6 +45,7 @@
 #include "gdk/gdkcolorstateprivate.h"
 #include "gdk/gdkcairoprivate.h"
 #include "gdk/gdkmemorytextureprivate.h"
+#include "gdk/gdkparalleltaskprivate.h"
 #include "gdk/gdkrgbaprivate.h"
 #include "gdk/gdksubsurfaceprivate.h"
 #include "gdk/gdktextureprivate.h"
@@ -2102,6 +2103,34 @@ gsk_gpu_node_processor_add_texture_node (GskGpuNodeProcessor *self,
   texture = gsk_texture_node_get_texture (node);
   should_mipmap = texture_node_should_mipmap (node, self->frame, &self->scale);
 
+  if (!should_mipmap &&
+      gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_TEXTURE_ATLAS))
+    {
+      graphene_rect_t area;
+
+      image = gsk_gpu_cache_lookup_atlas_texture (gsk_gpu_device_get_cache (gsk_gpu_frame_get_device (self->frame)),
+                                                  self->frame,
+                                                  texture,
+                                                  &area);
+      if (image)
+        {
+          float scale_x = node->bounds.size.width / area.size.width;
+          float scale_y = node->bounds.size.height / area.size.height;
+
+          gsk_gpu_node_processor_image_op (self,
+                                           image,
+                                           GDK_COLOR_STATE_SRGB,
+                                           GSK_GPU_SAMPLER_DEFAULT,
+                                           &node->bounds,
+                                           &GRAPHENE_RECT_INIT (node->bounds.origin.x - area.origin.x * scale_x,
+                                                                node->bounds.origin.y - area.origin.y * scale_y,
+                                                                gsk_gpu_image_get_width (image) * scale_x,
+                                                                gsk_gpu_image_get_height (image) * scale_y));
+          g_object_unref (image);
+          return;
+        }
+    }
+
   image = gsk_gpu_lookup_texture (self->frame, self->ccs, texture, should_mipmap, &image_cs);
 
   if (image == NULL)
@@ -3686,12 +3715,146 @@ gsk_gpu_get_subsurface_node_as_image (GskGpuFrame           *frame,
                                     out_bounds);
 }
 
+/* Runs of at least this many children of a container are recorded
+ * in parallel, in chunks of GSK_GPU_PARALLEL_CHUNK_SIZE
+ */
+#define GSK_GPU_PARALLEL_MIN_NODES 256
+#define GSK_GPU_PARALLEL_CHUNK_SIZE 64
+
+/* How deep to look into containers and transforms for nodes that
+ * can not be recorded in parallel
+ */
+#define GSK_GPU_PARALLEL_MAX_DEPTH 4
+
+/* Checks if @node turns only into shader ops without images, so that
+ * it can be recorded on any thread. Anything that needs the device,
+ * like uploads, offscreens or the glyph and texture caches, can not.
+ */
+static gboolean
+gsk_gpu_node_processor_can_record_in_parallel (GskGpuNodeProcessor *self,
+                                               GskRenderNode       *node,
+                                               guint                depth)
+{
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+      return TRUE;
+
+    /* more stops need an offscreen, see gsk_gpu_node_processor_add_gradient_node() */
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+      return gsk_linear_gradient_node_get_n_color_stops (node) < 8;
+
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+      return gsk_radial_gradient_node_get_n_color_stops (node) < 8;
+
+    case GSK_CONIC_GRADIENT_NODE:
+      return gsk_conic_gradient_node_get_n_color_stops (node) < 8;
+
+    case GSK_TRANSFORM_NODE:
+      if (depth == 0 ||
+          gsk_transform_get_fine_category (gsk_transform_node_get_transform (node)) < GSK_FINE_TRANSFORM_CATEGORY_2D_TRANSLATE)
+        return FALSE;
+      return gsk_gpu_node_processor_can_record_in_parallel (self, gsk_transform_node_get_child (node), depth - 1);
+
+    case GSK_CONTAINER_NODE:
+      {
+        GskRenderNode **children;
+        guint i, n_children;
+
+        if (depth == 0 ||
+            (self->opacity < 1.0 && !gsk_container_node_is_disjoint (node)))
+          return FALSE;
+
+        children = gsk_container_node_get_children (node, &n_children);
+        for (i = 0; i < n_children; i++)
+          {
+            if (!gsk_gpu_node_processor_can_record_in_parallel (self, children[i], depth - 1))
+              return FALSE;
+          }
+      }
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+typedef struct _GskGpuParallelNodes GskGpuParallelNodes;
+
+struct _GskGpuParallelNodes
+{
+  const GskGpuNodeProcessor *processor;
+  GskRenderNode **nodes;
+  guint n_nodes;
+  GskGpuFrameRecording **recordings;
+  int n_chunks;
+  int next_chunk;
+};
+
+static void
+gsk_gpu_node_processor_add_nodes_func (gpointer data)
+{
+  GskGpuParallelNodes *pn = data;
+  int chunk;
+
+  for (chunk = g_atomic_int_add (&pn->next_chunk, 1);
+       chunk < pn->n_chunks;
+       chunk = g_atomic_int_add (&pn->next_chunk, 1))
+    {
+      GskGpuNodeProcessor other = *pn->processor;
+      guint i, end;
+
+      pn->recordings[chunk] = gsk_gpu_frame_start_recording (other.frame);
+
+      end = MIN ((guint) (chunk + 1) * GSK_GPU_PARALLEL_CHUNK_SIZE, pn->n_nodes);
+      for (i = chunk * GSK_GPU_PARALLEL_CHUNK_SIZE; i < end; i++)
+        gsk_gpu_node_processor_add_node (&other, pn->nodes[i]);
+
+      gsk_gpu_frame_stop_recording (other.frame, pn->recordings[chunk]);
+    }
+}
+
+/* Records @nodes on multiple threads and appends the ops in order,
+ * so the result does not depend on the number of threads.
+ */
+static void
+gsk_gpu_node_processor_add_nodes_in_parallel (GskGpuNodeProcessor  *self,
+                                              GskRenderNode       **nodes,
+                                              guint                 n_nodes)
+{
+  GskGpuParallelNodes pn;
+  int i;
+
+  /* The nodes don't change globals, so make sure they are not emitted
+   * by every chunk */
+  gsk_gpu_node_processor_sync_globals (self, 0);
+
+  pn.processor = self;
+  pn.nodes = nodes;
+  pn.n_nodes = n_nodes;
+  pn.n_chunks = (n_nodes + GSK_GPU_PARALLEL_CHUNK_SIZE - 1) / GSK_GPU_PARALLEL_CHUNK_SIZE;
+  pn.next_chunk = 0;
+  pn.recordings = g_new (GskGpuFrameRecording *, pn.n_chunks);
+
+  gdk_parallel_task_run (gsk_gpu_node_processor_add_nodes_func, &pn);
+
+  for (i = 0; i < pn.n_chunks; i++)
+    gsk_gpu_frame_append_recording (self->frame, pn.recordings[i]);
+
+  g_free (pn.recordings);
+}
+
 static void
 gsk_gpu_node_processor_add_container_node (GskGpuNodeProcessor *self,
                                            GskRenderNode       *node)
 {
   GskRenderNode **children;
-  guint n_children;
+  guint i, end, n_children;
 
   if (self->opacity < 1.0 && !gsk_container_node_is_disjoint (node))
     {
@@ -3700,8 +3863,35 @@ gsk_gpu_node_processor_add_container_node (GskGpuNodeProcessor *self,
     }
 
   children = gsk_container_node_get_children (node, &n_children);
-  for (guint i = 0; i < n_children; i++)
-    gsk_gpu_node_processor_add_node (self, children[i]);
+
+  if (n_children < GSK_GPU_PARALLEL_MIN_NODES ||
+      !gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_THREADS) ||
+      gsk_gpu_frame_is_recording (self->frame))
+    {
+      for (i = 0; i < n_children; i++)
+        gsk_gpu_node_processor_add_node (self, children[i]);
+      return;
+    }
+
+  for (i = 0; i < n_children; )
+    {
+      for (end = i; end < n_children; end++)
+        {
+          if (!gsk_gpu_node_processor_can_record_in_parallel (self, children[end], GSK_GPU_PARALLEL_MAX_DEPTH))
+            break;
+        }
+
+      if (end - i >= GSK_GPU_PARALLEL_MIN_NODES)
+        {
+          gsk_gpu_node_processor_add_nodes_in_parallel (self, children + i, end - i);
+          i = end;
+        }
+      else
+        {
+          for (end = MAX (end, i + 1); i < end; i++)
+            gsk_gpu_node_processor_add_node (self, children[i]);
+        }
+    }
 }
 
 static gboolean
@@ -3773,7 +3963,9 @@ gsk_gpu_get_debug_node_as_image (GskGpuFrame           *frame,
 }
 
 typedef enum {
-  GSK_GPU_HANDLE_OPACITY = (1 << 0)
+  GSK_GPU_HANDLE_OPACITY = (1 << 0),
+  /* Expensive to render, so keep the result around for the next frame */
+  GSK_GPU_CACHE_OFFSCREEN = (1 << 1)
 } GskGpuNodeFeatures;
 
 static const struct
@@ -3900,7 +4092,7 @@ static const struct
   },
   [GSK_COLOR_MATRIX_NODE] = {
     0,
-    GSK_GPU_HANDLE_OPACITY,
+    GSK_GPU_HANDLE_OPACITY | GSK_GPU_CACHE_OFFSCREEN,
     gsk_gpu_node_processor_add_color_matrix_node,
     NULL,
     NULL,
@@ -3928,7 +4120,7 @@ static const struct
   },
   [GSK_SHADOW_NODE] = {
     0,
-    0,
+    GSK_GPU_CACHE_OFFSCREEN,
     gsk_gpu_node_processor_add_shadow_node,
     NULL,
     NULL,
@@ -3956,7 +4148,7 @@ static const struct
   },
   [GSK_BLUR_NODE] = {
     0,
-    0,
+    GSK_GPU_CACHE_OFFSCREEN,
     gsk_gpu_node_processor_add_blur_node,
     NULL,
     NULL,
@@ -3984,7 +4176,7 @@ static const struct
   },
   [GSK_MASK_NODE] = {
     0,
-    GSK_GPU_HANDLE_OPACITY,
+    GSK_GPU_HANDLE_OPACITY | GSK_GPU_CACHE_OFFSCREEN,
     gsk_gpu_node_processor_add_mask_node,
     NULL,
     NULL,
@@ -4012,6 +4204,74 @@ static const struct
   },
 };
 
+/* Draws @node from an offscreen that is kept in the cache, so that
+ * it can be reused in later frames. The whole node is rendered into
+ * it, so it can still be used when the clip changes.
+ *
+ * Returns FALSE if the node should be rendered the normal way.
+ */
+static gboolean
+gsk_gpu_node_processor_add_cached_node (GskGpuNodeProcessor *self,
+                                        GskRenderNode       *node)
+{
+  GskGpuNodeProcessor other;
+  GskGpuCache *cache;
+  GskGpuImage *image;
+  graphene_rect_t clip_bounds, rect, snapped;
+  gboolean should_cache;
+
+  if (!gsk_gpu_node_processor_clip_node_bounds (self, node, &clip_bounds))
+    return TRUE;
+  gsk_rect_snap_to_grid (&clip_bounds, &self->scale, &self->offset, &clip_bounds);
+
+  cache = gsk_gpu_device_get_cache (gsk_gpu_frame_get_device (self->frame));
+  image = gsk_gpu_cache_lookup_offscreen (cache, node, self->ccs, &self->scale, &rect, &should_cache);
+  if (image)
+    {
+      /* The node moved by a fraction of a pixel, so the image would get blurry */
+      gsk_rect_snap_to_grid (&rect, &self->scale, &self->offset, &snapped);
+      if (!gsk_rect_equal (&rect, &snapped))
+        {
+          g_clear_object (&image);
+          should_cache = TRUE;
+        }
+    }
+
+  if (image == NULL)
+    {
+      if (!should_cache)
+        return FALSE;
+
+      gsk_rect_snap_to_grid (&node->bounds, &self->scale, &self->offset, &rect);
+      image = gsk_gpu_node_processor_init_draw (&other,
+                                                self->frame,
+                                                self->ccs,
+                                                gdk_memory_depth_merge (gdk_color_state_get_depth (self->ccs),
+                                                                        gsk_render_node_get_preferred_depth (node)),
+                                                &self->scale,
+                                                &rect);
+      if (image == NULL)
+        return FALSE;
+
+      gsk_gpu_node_processor_sync_globals (&other, 0);
+      nodes_vtable[gsk_render_node_get_node_type (node)].process_node (&other, node);
+      gsk_gpu_node_processor_finish_draw (&other, image);
+
+      gsk_gpu_cache_cache_offscreen (cache, node, self->ccs, &self->scale, &rect, image);
+    }
+
+  gsk_gpu_node_processor_image_op (self,
+                                   image,
+                                   self->ccs,
+                                   GSK_GPU_SAMPLER_DEFAULT,
+                                   &clip_bounds,
+                                   &rect);
+
+  g_object_unref (image);
+
+  return TRUE;
+}
+
 static void
 gsk_gpu_node_processor_add_node (GskGpuNodeProcessor *self,
                                  GskRenderNode       *node)
@@ -4043,6 +4303,11 @@ gsk_gpu_node_processor_add_node (GskGpuNodeProcessor *self,
   gsk_gpu_node_processor_sync_globals (self, nodes_vtable[node_type].ignored_globals);
   g_assert ((self->pending_globals & ~nodes_vtable[node_type].ignored_globals) == 0);
 
+  if ((nodes_vtable[node_type].features & GSK_GPU_CACHE_OFFSCREEN) &&
+      gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_OFFSCREEN_CACHE) &&
+      gsk_gpu_node_processor_add_cached_node (self, node))
+    return;
+
   if (nodes_vtable[node_type].process_node)
     {
       nodes_vtable[node_type].process_node (self, node);
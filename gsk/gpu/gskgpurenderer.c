@@ -32,6 +32,9 @@ static const GdkDebugKey gsk_gpu_optimization_keys[] = {
   { "mipmap",    GSK_GPU_OPTIMIZE_MIPMAP,            "Avoid creating mipmaps" },
   { "to-image",  GSK_GPU_OPTIMIZE_TO_IMAGE,          "Don't fast-path creation of images for nodes" },
   { "occlusion", GSK_GPU_OPTIMIZE_OCCLUSION_CULLING, "Disable occlusion culling via opaque node tracking" },
+  { "threads",   GSK_GPU_OPTIMIZE_THREADS,           "Record all operations on the rendering thread" },
+  { "offscreens", GSK_GPU_OPTIMIZE_OFFSCREEN_CACHE,   "Don't reuse offscreens of effects between frames" },
+  { "atlas",     GSK_GPU_OPTIMIZE_TEXTURE_ATLAS,     "Give every texture its own image" },
 };
 
 typedef struct _GskGpuRendererPrivate GskGpuRendererPrivate;
@@ -21,6 +21,47 @@
  */
 #define MAX_MERGE_OPS (10 * 1000)
 
+static const GskGpuShaderOpClass *shader_op_classes[] = {
+  &GSK_GPU_BLEND_MODE_OP_CLASS,
+  &GSK_GPU_BLUR_OP_CLASS,
+  &GSK_GPU_BORDER_OP_CLASS,
+  &GSK_GPU_BOX_SHADOW_OP_CLASS,
+  &GSK_GPU_COLORIZE_OP_CLASS,
+  &GSK_GPU_COLOR_MATRIX_OP_CLASS,
+  &GSK_GPU_COLOR_OP_CLASS,
+  &GSK_GPU_CONIC_GRADIENT_OP_CLASS,
+  &GSK_GPU_CONVERT_CICP_OP_CLASS,
+  &GSK_GPU_CONVERT_OP_CLASS,
+  &GSK_GPU_CROSS_FADE_OP_CLASS,
+  &GSK_GPU_LINEAR_GRADIENT_OP_CLASS,
+  &GSK_GPU_MASK_OP_CLASS,
+  &GSK_GPU_RADIAL_GRADIENT_OP_CLASS,
+  &GSK_GPU_ROUNDED_COLOR_OP_CLASS,
+  &GSK_GPU_TEXTURE_OP_CLASS,
+};
+
+/*
+ * gsk_gpu_shader_op_class_lookup:
+ * @shader_name: the name of a shader
+ *
+ * Finds the op class using the given shader.
+ *
+ * Returns: (nullable): the op class
+ */
+const GskGpuShaderOpClass *
+gsk_gpu_shader_op_class_lookup (const char *shader_name)
+{
+  gsize i;
+
+  for (i = 0; i < G_N_ELEMENTS (shader_op_classes); i++)
+    {
+      if (g_str_equal (shader_op_classes[i]->shader_name, shader_name))
+        return shader_op_classes[i];
+    }
+
+  return NULL;
+}
+
 void
 gsk_gpu_shader_op_finish (GskGpuOp *op)
 {
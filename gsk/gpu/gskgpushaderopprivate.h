@@ -48,6 +48,27 @@ struct _GskGpuShaderOpClass
   void                  (* setup_vao)                                   (gsize                   offset);
 };
 
+/* All the shader op classes, so their shaders can be found by name */
+extern const GskGpuShaderOpClass GSK_GPU_BLEND_MODE_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_BLUR_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_BORDER_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_BOX_SHADOW_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_COLORIZE_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_COLOR_MATRIX_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_COLOR_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_CONIC_GRADIENT_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_CONVERT_CICP_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_CONVERT_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_CROSS_FADE_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_LINEAR_GRADIENT_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_MASK_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_RADIAL_GRADIENT_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_ROUNDED_COLOR_OP_CLASS;
+extern const GskGpuShaderOpClass GSK_GPU_TEXTURE_OP_CLASS;
+
+const GskGpuShaderOpClass *
+                        gsk_gpu_shader_op_class_lookup                  (const char             *shader_name);
+
 void                    gsk_gpu_shader_op_alloc                         (GskGpuFrame            *frame,
                                                                          const GskGpuShaderOpClass *op_class,
                                                                          GskGpuColorStates       color_states,
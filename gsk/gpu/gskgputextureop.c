@@ -27,7 +27,7 @@ gsk_gpu_texture_op_print_instance (GskGpuShaderOp *shader,
   gsk_gpu_print_rect (string, instance->tex_rect);
 }
 
-static const GskGpuShaderOpClass GSK_GPU_TEXTURE_OP_CLASS = {
+const GskGpuShaderOpClass GSK_GPU_TEXTURE_OP_CLASS = {
   {
     GSK_GPU_OP_SIZE (GskGpuTextureOp),
     GSK_GPU_STAGE_SHADER,
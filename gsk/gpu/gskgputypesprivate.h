@@ -138,5 +138,8 @@ typedef enum {
   GSK_GPU_OPTIMIZE_MIPMAP               = 1 <<  4,
   GSK_GPU_OPTIMIZE_TO_IMAGE             = 1 <<  5,
   GSK_GPU_OPTIMIZE_OCCLUSION_CULLING    = 1 <<  6,
+  GSK_GPU_OPTIMIZE_THREADS              = 1 <<  7,
+  GSK_GPU_OPTIMIZE_OFFSCREEN_CACHE      = 1 <<  8,
+  GSK_GPU_OPTIMIZE_TEXTURE_ATLAS        = 1 <<  9,
 } GskGpuOptimizations;
 
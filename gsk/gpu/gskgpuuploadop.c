@@ -16,6 +16,8 @@
 #include "gdk/gdkglcontextprivate.h"
 #include "gsk/gskdebugprivate.h"
 
+#include <string.h>
+
 static GskGpuOp *
 gsk_gpu_upload_op_gl_command_with_area (GskGpuOp                    *op,
                                         GskGpuFrame                 *frame,
@@ -679,3 +681,147 @@ gsk_gpu_upload_glyph_op (GskGpuFrame                 *frame,
   self->glyph = glyph;
   self->origin = *origin;
 }
+
+typedef struct _GskGpuUploadAtlasTextureOp GskGpuUploadAtlasTextureOp;
+
+struct _GskGpuUploadAtlasTextureOp
+{
+  GskGpuOp op;
+
+  GskGpuImage *image;
+  cairo_rectangle_int_t area;
+  GdkTexture *texture;
+
+  GskGpuBuffer *buffer;
+};
+
+static void
+gsk_gpu_upload_atlas_texture_op_finish (GskGpuOp *op)
+{
+  GskGpuUploadAtlasTextureOp *self = (GskGpuUploadAtlasTextureOp *) op;
+
+  g_object_unref (self->image);
+  g_object_unref (self->texture);
+
+  g_clear_object (&self->buffer);
+}
+
+static void
+gsk_gpu_upload_atlas_texture_op_print (GskGpuOp    *op,
+                                       GskGpuFrame *frame,
+                                       GString     *string,
+                                       guint        indent)
+{
+  GskGpuUploadAtlasTextureOp *self = (GskGpuUploadAtlasTextureOp *) op;
+
+  gsk_gpu_print_op (string, indent, "upload-atlas-texture");
+  gsk_gpu_print_int_rect (string, &self->area);
+  gsk_gpu_print_image (string, self->image);
+  gsk_gpu_print_newline (string);
+}
+
+static void
+gsk_gpu_upload_atlas_texture_op_draw (GskGpuOp *op,
+                                      guchar   *data,
+                                      gsize     stride)
+{
+  GskGpuUploadAtlasTextureOp *self = (GskGpuUploadAtlasTextureOp *) op;
+  GdkTextureDownloader *downloader;
+  gsize bpp, width, height, y;
+
+  bpp = gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (self->image));
+  width = self->area.width - 2;
+  height = self->area.height - 2;
+
+  downloader = gdk_texture_downloader_new (self->texture);
+  gdk_texture_downloader_set_format (downloader, gsk_gpu_image_get_format (self->image));
+  gdk_texture_downloader_set_color_state (downloader, gdk_texture_get_color_state (self->texture));
+  gdk_texture_downloader_download_into (downloader, data + stride + bpp, stride);
+  gdk_texture_downloader_free (downloader);
+
+  /* Repeat the edges into the padding, so linear filtering
+   * doesn't pick up the neighbours in the atlas
+   */
+  for (y = 1; y <= height; y++)
+    {
+      guchar *row = data + y * stride;
+
+      memcpy (row, row + bpp, bpp);
+      memcpy (row + (width + 1) * bpp, row + width * bpp, bpp);
+    }
+  memcpy (data, data + stride, stride);
+  memcpy (data + (height + 1) * stride, data + height * stride, stride);
+}
+
+#ifdef GDK_RENDERING_VULKAN
+static GskGpuOp *
+gsk_gpu_upload_atlas_texture_op_vk_command (GskGpuOp              *op,
+                                            GskGpuFrame           *frame,
+                                            GskVulkanCommandState *state)
+{
+  GskGpuUploadAtlasTextureOp *self = (GskGpuUploadAtlasTextureOp *) op;
+
+  return gsk_gpu_upload_op_vk_command_with_area (op,
+                                                 frame,
+                                                 state,
+                                                 GSK_VULKAN_IMAGE (self->image),
+                                                 &self->area,
+                                                 gsk_gpu_upload_atlas_texture_op_draw,
+                                                 &self->buffer);
+}
+#endif
+
+static GskGpuOp *
+gsk_gpu_upload_atlas_texture_op_gl_command (GskGpuOp          *op,
+                                            GskGpuFrame       *frame,
+                                            GskGLCommandState *state)
+{
+  GskGpuUploadAtlasTextureOp *self = (GskGpuUploadAtlasTextureOp *) op;
+
+  return gsk_gpu_upload_op_gl_command_with_area (op,
+                                                 frame,
+                                                 self->image,
+                                                 &self->area,
+                                                 gsk_gpu_upload_atlas_texture_op_draw);
+}
+
+static const GskGpuOpClass GSK_GPU_UPLOAD_ATLAS_TEXTURE_OP_CLASS = {
+  GSK_GPU_OP_SIZE (GskGpuUploadAtlasTextureOp),
+  GSK_GPU_STAGE_UPLOAD,
+  gsk_gpu_upload_atlas_texture_op_finish,
+  gsk_gpu_upload_atlas_texture_op_print,
+#ifdef GDK_RENDERING_VULKAN
+  gsk_gpu_upload_atlas_texture_op_vk_command,
+#endif
+  gsk_gpu_upload_atlas_texture_op_gl_command,
+};
+
+/*
+ * gsk_gpu_upload_atlas_texture_op:
+ * @frame: the frame
+ * @image: the atlas image
+ * @area: the area of @image to upload to, including 1 pixel of
+ *   padding on each side
+ * @texture: the texture to upload, its size must match @area
+ *   without the padding
+ *
+ * Uploads @texture into a region of an atlas image, and fills the
+ * padding with the texture's edge pixels.
+ */
+void
+gsk_gpu_upload_atlas_texture_op (GskGpuFrame                 *frame,
+                                 GskGpuImage                 *image,
+                                 const cairo_rectangle_int_t *area,
+                                 GdkTexture                  *texture)
+{
+  GskGpuUploadAtlasTextureOp *self;
+
+  g_assert (area->width == gdk_texture_get_width (texture) + 2);
+  g_assert (area->height == gdk_texture_get_height (texture) + 2);
+
+  self = (GskGpuUploadAtlasTextureOp *) gsk_gpu_op_alloc (frame, &GSK_GPU_UPLOAD_ATLAS_TEXTURE_OP_CLASS);
+
+  self->image = g_object_ref (image);
+  self->area = *area;
+  self->texture = g_object_ref (texture);
+}
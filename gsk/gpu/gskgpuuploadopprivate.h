@@ -29,5 +29,10 @@ void                    gsk_gpu_upload_glyph_op                         (GskGpuF
                                                                          const cairo_rectangle_int_t    *area,
                                                                          const graphene_point_t         *origin);
 
+void                    gsk_gpu_upload_atlas_texture_op                 (GskGpuFrame                    *frame,
+                                                                         GskGpuImage                    *image,
+                                                                         const cairo_rectangle_int_t    *area,
+                                                                         GdkTexture                     *texture);
+
 G_END_DECLS
 
@@ -72,7 +72,8 @@ static const GskGpuCachedClass GSK_VULKAN_YCBCR_CLASS =
   sizeof (GskVulkanYcbcr),
   "Vulkan Ycbcr",
   gsk_vulkan_ycbcr_free,
-  gsk_vulkan_ycbcr_should_collect
+  gsk_vulkan_ycbcr_should_collect,
+  0.0f
 };
 
 GskVulkanYcbcr *
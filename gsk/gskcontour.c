@@ -94,6 +94,11 @@ struct _GskContourClass
                                                  gpointer                measure_data,
                                                  float                   distance,
                                                  GskPathPoint           *result);
+  void                  (* get_points)          (const GskContour       *contour,
+                                                 gpointer                measure_data,
+                                                 const float            *distances,
+                                                 gsize                   n_distances,
+                                                 GskPathPoint           *results);
   float                 (* get_distance)        (const GskContour       *contour,
                                                  const GskPathPoint     *point,
                                                  gpointer                measure_data);
@@ -518,6 +523,17 @@ gsk_contour_print_default (const GskContour *contour,
   gsk_contour_foreach (contour, foreach_print, string);
 }
 
+static void
+gsk_contour_get_points_default (const GskContour *contour,
+                                gpointer          measure_data,
+                                const float      *distances,
+                                gsize             n_distances,
+                                GskPathPoint     *results)
+{
+  for (gsize i = 0; i < n_distances; i++)
+    contour->klass->get_point (contour, measure_data, distances[i], &results[i]);
+}
+
 /* }}} */
 /* {{{ Standard */
 
@@ -696,6 +712,23 @@ gsk_standard_contour_get_stroke_bounds (const GskContour *contour,
   return TRUE;
 }
 
+/* Filling implicitly closes the contour */
+static int
+gsk_standard_contour_get_closing_crossing (const GskStandardContour *self,
+                                           const graphene_point_t   *point)
+{
+  GskCurve c;
+
+  if (self->flags & GSK_PATH_CLOSED)
+    return 0;
+
+  gsk_curve_init (&c, gsk_pathop_encode (GSK_PATH_CLOSE,
+                                         (const GskAlignedPoint[]) { self->points[self->n_points - 1],
+                                                                     self->points[0] }));
+
+  return gsk_curve_get_crossing (&c, point);
+}
+
 static int
 gsk_standard_contour_get_winding (const GskContour       *contour,
                                   const graphene_point_t *point)
@@ -717,16 +750,7 @@ gsk_standard_contour_get_winding (const GskContour       *contour,
       winding += gsk_curve_get_crossing (&c, point);
     }
 
-  if ((self->flags & GSK_PATH_CLOSED) == 0)
-    {
-      GskCurve c;
-
-      gsk_curve_init (&c, gsk_pathop_encode (GSK_PATH_CLOSE,
-                                             (const GskAlignedPoint[]) { self->points[self->n_points - 1],
-                                                                         self->points[0] }));
-
-      winding += gsk_curve_get_crossing (&c, point);
-    }
+  winding += gsk_standard_contour_get_closing_crossing (self, point);
 
   return winding;
 }
@@ -1146,30 +1170,15 @@ find_curve (gconstpointer a,
 }
 
 static void
-gsk_standard_contour_get_point (const GskContour *contour,
-                                gpointer          measure_data,
-                                float             distance,
-                                GskPathPoint     *result)
+get_point_on_curve (const GskStandardContour  *self,
+                    GskStandardContourMeasure *measure,
+                    CurveMeasure              *curve_measure,
+                    float                      distance,
+                    GskPathPoint              *result)
 {
-  const GskStandardContour *self = (const GskStandardContour *) contour;
-  GskStandardContourMeasure *measure = measure_data;
-  CurveMeasure *curve_measure;
-  gboolean found G_GNUC_UNUSED;
-  guint idx;
   gsize i0, i1;
   CurvePoint *p0, *p1;
 
-  if (self->n_ops == 1)
-    {
-      result->idx = 0;
-      result->t = 1;
-      return;
-    }
-
-  found = g_array_binary_search (measure->curves, &distance, find_curve, &idx);
-  g_assert (found);
-
-  curve_measure = &g_array_index (measure->curves, CurveMeasure, idx);
   ensure_samples (self, measure, curve_measure);
 
   i0 = curve_measure->first;
@@ -1221,6 +1230,84 @@ gsk_standard_contour_get_point (const GskContour *contour,
     }
 }
 
+static void
+gsk_standard_contour_get_point (const GskContour *contour,
+                                gpointer          measure_data,
+                                float             distance,
+                                GskPathPoint     *result)
+{
+  const GskStandardContour *self = (const GskStandardContour *) contour;
+  GskStandardContourMeasure *measure = measure_data;
+  gboolean found G_GNUC_UNUSED;
+  guint idx;
+
+  if (self->n_ops == 1)
+    {
+      result->idx = 0;
+      result->t = 1;
+      return;
+    }
+
+  found = g_array_binary_search (measure->curves, &distance, find_curve, &idx);
+  g_assert (found);
+
+  get_point_on_curve (self, measure,
+                      &g_array_index (measure->curves, CurveMeasure, idx),
+                      distance, result);
+}
+
+/* Animations and text on a path usually ask for increasing
+ * distances, so we look at the curve of the previous distance
+ * and the one after it before doing a binary search.
+ */
+static void
+gsk_standard_contour_get_points (const GskContour *contour,
+                                 gpointer          measure_data,
+                                 const float      *distances,
+                                 gsize             n_distances,
+                                 GskPathPoint     *results)
+{
+  const GskStandardContour *self = (const GskStandardContour *) contour;
+  GskStandardContourMeasure *measure = measure_data;
+  CurveMeasure *curve_measure;
+  guint idx;
+
+  if (self->n_ops == 1)
+    {
+      for (gsize i = 0; i < n_distances; i++)
+        {
+          results[i].idx = 0;
+          results[i].t = 1;
+        }
+      return;
+    }
+
+  idx = 1;
+
+  for (gsize i = 0; i < n_distances; i++)
+    {
+      float distance = distances[i];
+
+      curve_measure = &g_array_index (measure->curves, CurveMeasure, idx);
+      if (distance > curve_measure->length1 && idx + 1 < measure->curves->len)
+        {
+          idx++;
+          curve_measure++;
+        }
+
+      if (distance < curve_measure->length0 || distance > curve_measure->length1)
+        {
+          gboolean found G_GNUC_UNUSED;
+
+          found = g_array_binary_search (measure->curves, &distance, find_curve, &idx);
+          g_assert (found);
+          curve_measure = &g_array_index (measure->curves, CurveMeasure, idx);
+        }
+
+      get_point_on_curve (self, measure, curve_measure, distance, &results[i]);
+    }
+}
+
 static float
 gsk_standard_contour_get_distance (const GskContour   *contour,
                                    const GskPathPoint *point,
@@ -1287,6 +1374,7 @@ static const GskContourClass GSK_STANDARD_CONTOUR_CLASS =
   gsk_standard_contour_init_measure,
   gsk_standard_contour_free_measure,
   gsk_standard_contour_get_point,
+  gsk_standard_contour_get_points,
   gsk_standard_contour_get_distance,
 };
 
@@ -1347,6 +1435,374 @@ gsk_standard_contour_new (GskPathFlags            flags,
   return contour;
 }
 
+/* }}} */
+/* {{{ Index */
+
+/* An index for standard contours with many operations.
+ *
+ * It is a bounding volume hierarchy over the curves of the
+ * contour, so that hit testing only needs to look at the curves
+ * near the point instead of all of them.
+ */
+
+#define GSK_CONTOUR_INDEX_MIN_OPS 32
+#define GSK_CONTOUR_INDEX_LEAF_SIZE 4
+#define GSK_CONTOUR_INDEX_MAX_DEPTH 48
+
+typedef struct _GskContourIndexNode GskContourIndexNode;
+typedef struct _GskContourIndexItem GskContourIndexItem;
+
+struct _GskContourIndexNode
+{
+  GskBoundingBox bounds;
+  /* For leaves, the first entry in the ops array,
+   * for other nodes, the first of the two children
+   */
+  guint first;
+  guint n_ops; /* 0 if not a leaf */
+};
+
+struct _GskContourIndex
+{
+  const GskStandardContour *contour;
+
+  guint *ops;
+  GskContourIndexNode *nodes;
+  guint n_nodes;
+};
+
+struct _GskContourIndexItem
+{
+  guint idx;
+  GskBoundingBox bounds;
+  graphene_point_t center;
+};
+
+static inline float
+index_item_get_center (const GskContourIndexItem *item,
+                       guint                      axis)
+{
+  return axis == 0 ? item->center.x : item->center.y;
+}
+
+/* Partially sorts the items by their center, so that the
+ * item at position k is in the right place
+ */
+static void
+index_items_select (GskContourIndexItem *items,
+                    gssize               n_items,
+                    gssize               k,
+                    guint                axis)
+{
+  gssize lo = 0;
+  gssize hi = n_items - 1;
+
+  while (lo < hi)
+    {
+      float pivot = index_item_get_center (&items[lo + (hi - lo) / 2], axis);
+      gssize i = lo;
+      gssize j = hi;
+
+      while (i <= j)
+        {
+          while (i < hi && index_item_get_center (&items[i], axis) < pivot)
+            i++;
+          while (j > lo && index_item_get_center (&items[j], axis) > pivot)
+            j--;
+
+          if (i <= j)
+            {
+              GskContourIndexItem tmp = items[i];
+              items[i] = items[j];
+              items[j] = tmp;
+              i++;
+              j--;
+            }
+        }
+
+      if (k <= j)
+        hi = j;
+      else if (k >= i)
+        lo = i;
+      else
+        break;
+    }
+}
+
+static void
+gsk_contour_index_build (GskContourIndex     *self,
+                         GskContourIndexItem *items,
+                         guint                n_items,
+                         guint                start,
+                         guint                node_idx,
+                         guint                depth)
+{
+  GskContourIndexNode *node = &self->nodes[node_idx];
+  GskBoundingBox centers;
+  guint i, first, half, axis;
+
+  node->bounds = items[0].bounds;
+  gsk_bounding_box_init (&centers, &items[0].center, &items[0].center);
+  for (i = 1; i < n_items; i++)
+    {
+      gsk_bounding_box_union (&node->bounds, &items[i].bounds, &node->bounds);
+      gsk_bounding_box_expand (&centers, &items[i].center);
+    }
+
+  if (n_items <= GSK_CONTOUR_INDEX_LEAF_SIZE || depth + 1 >= GSK_CONTOUR_INDEX_MAX_DEPTH)
+    {
+      node->first = start;
+      node->n_ops = n_items;
+      for (i = 0; i < n_items; i++)
+        self->ops[start + i] = items[i].idx;
+      return;
+    }
+
+  /* Split at the median of the longer side */
+  if (centers.max.x - centers.min.x >= centers.max.y - centers.min.y)
+    axis = 0;
+  else
+    axis = 1;
+
+  half = n_items / 2;
+  index_items_select (items, n_items, half, axis);
+
+  first = self->n_nodes;
+  self->n_nodes += 2;
+  node->first = first;
+  node->n_ops = 0;
+
+  gsk_contour_index_build (self, items, half, start, first, depth + 1);
+  gsk_contour_index_build (self, items + half, n_items - half, start + half, first + 1, depth + 1);
+}
+
+/*
+ * gsk_contour_index_new:
+ * @contour: a contour
+ *
+ * Creates an index for the given contour, if that is
+ * worth it.
+ *
+ * The contour must stay alive while the index is in use.
+ *
+ * Returns: (nullable): the index
+ */
+GskContourIndex *
+gsk_contour_index_new (const GskContour *contour)
+{
+  const GskStandardContour *standard = (const GskStandardContour *) contour;
+  GskContourIndexItem *items;
+  GskContourIndex *self;
+  guint n_items;
+
+  if (contour->klass != &GSK_STANDARD_CONTOUR_CLASS ||
+      standard->n_ops < GSK_CONTOUR_INDEX_MIN_OPS)
+    return NULL;
+
+  items = g_new (GskContourIndexItem, standard->n_ops);
+  n_items = 0;
+  for (gsize i = 0; i < standard->n_ops; i++)
+    {
+      GskContourIndexItem *item;
+      GskCurve c;
+
+      if (gsk_pathop_op (standard->ops[i]) == GSK_PATH_MOVE)
+        continue;
+
+      item = &items[n_items++];
+      gsk_curve_init (&c, standard->ops[i]);
+      gsk_curve_get_bounds (&c, &item->bounds);
+      item->idx = i;
+      item->center.x = (item->bounds.min.x + item->bounds.max.x) / 2;
+      item->center.y = (item->bounds.min.y + item->bounds.max.y) / 2;
+    }
+
+  self = g_new0 (GskContourIndex, 1);
+  self->contour = standard;
+  self->ops = g_new (guint, n_items);
+  self->nodes = g_new (GskContourIndexNode, 2 * n_items);
+  self->n_nodes = 1;
+
+  gsk_contour_index_build (self, items, n_items, 0, 0, 0);
+
+  g_free (items);
+
+  return self;
+}
+
+void
+gsk_contour_index_free (GskContourIndex *self)
+{
+  g_free (self->nodes);
+  g_free (self->ops);
+  g_free (self);
+}
+
+/*
+ * gsk_contour_index_get_winding:
+ * @self: an index
+ * @point: the point
+ *
+ * Returns the same value as gsk_contour_get_winding()
+ * for the contour of the index.
+ */
+int
+gsk_contour_index_get_winding (const GskContourIndex  *self,
+                               const graphene_point_t *point)
+{
+  const GskStandardContour *contour = self->contour;
+  guint stack[GSK_CONTOUR_INDEX_MAX_DEPTH + 1];
+  guint n_stack;
+  int winding;
+
+  if (!gsk_bounding_box_contains_point (&contour->bounds, point))
+    return 0;
+
+  winding = 0;
+  n_stack = 0;
+  stack[n_stack++] = 0;
+
+  while (n_stack > 0)
+    {
+      const GskContourIndexNode *node = &self->nodes[stack[--n_stack]];
+
+      /* Only curves to the right of the point can cross the ray */
+      if (node->bounds.min.y > point->y ||
+          node->bounds.max.y < point->y ||
+          node->bounds.max.x < point->x)
+        continue;
+
+      if (node->n_ops == 0)
+        {
+          stack[n_stack++] = node->first;
+          stack[n_stack++] = node->first + 1;
+          continue;
+        }
+
+      for (guint i = node->first; i < node->first + node->n_ops; i++)
+        {
+          GskCurve c;
+
+          gsk_curve_init (&c, contour->ops[self->ops[i]]);
+          winding += gsk_curve_get_crossing (&c, point);
+        }
+    }
+
+  winding += gsk_standard_contour_get_closing_crossing (contour, point);
+
+  return winding;
+}
+
+static inline float
+bounding_box_distance (const GskBoundingBox   *bounds,
+                       const graphene_point_t *point)
+{
+  float dx, dy;
+
+  dx = MAX (MAX (bounds->min.x - point->x, point->x - bounds->max.x), 0);
+  dy = MAX (MAX (bounds->min.y - point->y, point->y - bounds->max.y), 0);
+
+  return sqrtf (dx * dx + dy * dy);
+}
+
+/*
+ * gsk_contour_index_get_closest_point:
+ * @self: an index
+ * @point: the point
+ * @threshold: the maximum distance
+ * @result: (out caller-allocates): return location for the closest point
+ * @out_dist: (out): return location for the distance
+ *
+ * Does the same as gsk_contour_get_closest_point() for
+ * the contour of the index.
+ *
+ * Returns: `TRUE` if a point closer than @threshold was found
+ */
+gboolean
+gsk_contour_index_get_closest_point (const GskContourIndex  *self,
+                                     const graphene_point_t *point,
+                                     float                   threshold,
+                                     GskPathPoint           *result,
+                                     float                  *out_dist)
+{
+  const GskStandardContour *contour = self->contour;
+  struct {
+    guint node;
+    float dist;
+  } stack[GSK_CONTOUR_INDEX_MAX_DEPTH + 1];
+  guint n_stack;
+  guint best_idx = G_MAXUINT;
+  float best_t = 0;
+
+  n_stack = 0;
+  stack[n_stack].node = 0;
+  stack[n_stack].dist = bounding_box_distance (&self->nodes[0].bounds, point);
+  n_stack++;
+
+  while (n_stack > 0)
+    {
+      const GskContourIndexNode *node;
+
+      n_stack--;
+      if (stack[n_stack].dist > threshold)
+        continue;
+
+      node = &self->nodes[stack[n_stack].node];
+
+      if (node->n_ops == 0)
+        {
+          float dist0, dist1;
+          guint closer;
+
+          dist0 = bounding_box_distance (&self->nodes[node->first].bounds, point);
+          dist1 = bounding_box_distance (&self->nodes[node->first + 1].bounds, point);
+
+          /* Look at the closer child first, to lower the
+           * threshold quickly
+           */
+          closer = dist0 <= dist1 ? 0 : 1;
+
+          stack[n_stack].node = node->first + 1 - closer;
+          stack[n_stack].dist = closer ? dist0 : dist1;
+          n_stack++;
+          stack[n_stack].node = node->first + closer;
+          stack[n_stack].dist = closer ? dist1 : dist0;
+          n_stack++;
+          continue;
+        }
+
+      for (guint i = node->first; i < node->first + node->n_ops; i++)
+        {
+          guint idx = self->ops[i];
+          GskCurve c;
+          float distance, t;
+
+          gsk_curve_init (&c, contour->ops[idx]);
+          if (!gsk_curve_get_closest_point (&c, point, threshold, &distance, &t))
+            continue;
+
+          /* On ties, prefer the earlier curve, like a linear search */
+          if (distance < threshold ||
+              (distance == threshold && best_idx != G_MAXUINT && idx < best_idx))
+            {
+              best_idx = idx;
+              best_t = t;
+              threshold = distance;
+            }
+        }
+    }
+
+  if (best_idx != G_MAXUINT)
+    {
+      *out_dist = threshold;
+      result->idx = best_idx;
+      result->t = best_t;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
 /* }}} */
 /* {{{ Circle */
 
@@ -1744,6 +2200,7 @@ static const GskContourClass GSK_CIRCLE_CONTOUR_CLASS =
   gsk_circle_contour_init_measure,
   gsk_circle_contour_free_measure,
   gsk_circle_contour_get_point,
+  gsk_contour_get_points_default,
   gsk_circle_contour_get_distance,
 };
 
@@ -2077,6 +2534,7 @@ static const GskContourClass GSK_RECT_CONTOUR_CLASS =
   gsk_rect_contour_init_measure,
   gsk_rect_contour_free_measure,
   gsk_rect_contour_get_point,
+  gsk_contour_get_points_default,
   gsk_rect_contour_get_distance,
 };
 
@@ -2411,6 +2869,7 @@ static const GskContourClass GSK_ROUNDED_RECT_CONTOUR_CLASS =
   gsk_rounded_rect_contour_init_measure,
   gsk_rounded_rect_contour_free_measure,
   gsk_rounded_rect_contour_get_point,
+  gsk_contour_get_points_default,
   gsk_rounded_rect_contour_get_distance,
 };
 
@@ -2641,6 +3100,16 @@ gsk_contour_get_point (const GskContour *self,
   self->klass->get_point (self, measure_data, distance, result);
 }
 
+void
+gsk_contour_get_points (const GskContour *self,
+                        gpointer          measure_data,
+                        const float      *distances,
+                        gsize             n_distances,
+                        GskPathPoint     *results)
+{
+  self->klass->get_points (self, measure_data, distances, n_distances, results);
+}
+
 float
 gsk_contour_get_distance (const GskContour   *self,
                           const GskPathPoint *point,
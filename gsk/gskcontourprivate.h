@@ -27,6 +27,8 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GskContourIndex GskContourIndex;
+
 GskContour *            gsk_standard_contour_new                (GskPathFlags            flags,
                                                                  const GskAlignedPoint  *points,
                                                                  gsize                   n_points,
@@ -91,8 +93,23 @@ void                    gsk_contour_get_point                   (const GskContou
                                                                  gpointer                measure_data,
                                                                  float                   distance,
                                                                  GskPathPoint           *result);
+void                    gsk_contour_get_points                  (const GskContour       *self,
+                                                                 gpointer                measure_data,
+                                                                 const float            *distances,
+                                                                 gsize                   n_distances,
+                                                                 GskPathPoint           *results);
 float                   gsk_contour_get_distance                (const GskContour       *self,
                                                                  const GskPathPoint     *point,
                                                                  gpointer                measure_data);
 
+GskContourIndex *       gsk_contour_index_new                   (const GskContour       *contour);
+void                    gsk_contour_index_free                  (GskContourIndex        *self);
+int                     gsk_contour_index_get_winding           (const GskContourIndex  *self,
+                                                                 const graphene_point_t *point);
+gboolean                gsk_contour_index_get_closest_point     (const GskContourIndex  *self,
+                                                                 const graphene_point_t *point,
+                                                                 float                   threshold,
+                                                                 GskPathPoint           *result,
+                                                                 float                  *out_dist);
+
 G_END_DECLS
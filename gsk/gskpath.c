@@ -59,6 +59,10 @@ struct _GskPath
 
   GskPathFlags flags;
 
+  /* see gsk_path_get_indexes() */
+  guint n_queries;
+  GskContourIndex **indexes;
+
   gsize n_contours;
   GskContour *contours[];
   /* followed by the contours data */
@@ -66,6 +70,11 @@ struct _GskPath
 
 G_DEFINE_BOXED_TYPE (GskPath, gsk_path, gsk_path_ref, gsk_path_unref)
 
+/* Building an index only pays off if a path is hit tested
+ * repeatedly, so we only do it after a few queries
+ */
+#define GSK_PATH_INDEX_MIN_QUERIES 8
+
 /* {{{ Private API */
 
 GskPath *
@@ -122,6 +131,38 @@ gsk_path_get_contour (const GskPath *self,
     return NULL;
 }
 
+/* Returns the indexes for the contours, or NULL if there
+ * are none. Contours that don't need one have a NULL index.
+ */
+static GskContourIndex **
+gsk_path_get_indexes (GskPath *self)
+{
+  if (self->n_queries < GSK_PATH_INDEX_MIN_QUERIES)
+    {
+      self->n_queries++;
+      return NULL;
+    }
+
+  if (self->n_queries == GSK_PATH_INDEX_MIN_QUERIES)
+    {
+      gboolean has_index = FALSE;
+
+      self->n_queries++;
+
+      self->indexes = g_new (GskContourIndex *, self->n_contours);
+      for (gsize i = 0; i < self->n_contours; i++)
+        {
+          self->indexes[i] = gsk_contour_index_new (self->contours[i]);
+          has_index |= self->indexes[i] != NULL;
+        }
+
+      if (!has_index)
+        g_clear_pointer (&self->indexes, g_free);
+    }
+
+  return self->indexes;
+}
+
 GskPathFlags
 gsk_path_get_flags (const GskPath *self)
 {
@@ -177,6 +218,13 @@ gsk_path_unref (GskPath *self)
   if (self->ref_count > 0)
     return;
 
+  if (self->indexes)
+    {
+      for (gsize i = 0; i < self->n_contours; i++)
+        g_clear_pointer (&self->indexes[i], gsk_contour_index_free);
+      g_free (self->indexes);
+    }
+
   g_free (self);
 }
 
@@ -474,10 +522,18 @@ gsk_path_in_fill (GskPath                *self,
                   const graphene_point_t *point,
                   GskFillRule             fill_rule)
 {
+  GskContourIndex **indexes;
   int winding = 0;
 
+  indexes = gsk_path_get_indexes (self);
+
   for (int i = 0; i < self->n_contours; i++)
-    winding += gsk_contour_get_winding (self->contours[i], point);
+    {
+      if (indexes && indexes[i])
+        winding += gsk_contour_index_get_winding (indexes[i], point);
+      else
+        winding += gsk_contour_get_winding (self->contours[i], point);
+    }
 
   switch (fill_rule)
     {
@@ -582,6 +638,7 @@ gsk_path_get_closest_point (GskPath                *self,
                             GskPathPoint           *result,
                             float                  *distance)
 {
+  GskContourIndex **indexes;
   gboolean found;
 
   g_return_val_if_fail (self != NULL, FALSE);
@@ -590,12 +647,19 @@ gsk_path_get_closest_point (GskPath                *self,
   g_return_val_if_fail (result != NULL, FALSE);
 
   found = FALSE;
+  indexes = gsk_path_get_indexes (self);
 
   for (int i = 0; i < self->n_contours; i++)
     {
+      gboolean found_here;
       float dist;
 
-      if (gsk_contour_get_closest_point (self->contours[i], point, threshold, result, &dist))
+      if (indexes && indexes[i])
+        found_here = gsk_contour_index_get_closest_point (indexes[i], point, threshold, result, &dist);
+      else
+        found_here = gsk_contour_get_closest_point (self->contours[i], point, threshold, result, &dist);
+
+      if (found_here)
         {
           found = TRUE;
           g_assert (0 <= result->t && result->t <= 1);
@@ -293,6 +293,156 @@ gsk_path_measure_get_point (GskPathMeasure *self,
   return TRUE;
 }
 
+/**
+ * gsk_path_measure_get_points:
+ * @self: a `GskPathMeasure`
+ * @distances: (array length=n_distances): the distances
+ * @n_distances: the number of distances
+ * @results: (out caller-allocates) (array length=n_distances): return
+ *   location for the results
+ *
+ * Sets @results to the points at the given distances into the path.
+ *
+ * This is the same as calling [method@Gsk.PathMeasure.get_point]
+ * for each of the distances, but faster, in particular if the
+ * distances are in increasing order.
+ *
+ * An empty path has no points, so `FALSE` is returned in that case.
+ *
+ * Returns: `TRUE` if @results were set
+ *
+ * Since: 4.18
+ */
+gboolean
+gsk_path_measure_get_points (GskPathMeasure *self,
+                             const float    *distances,
+                             gsize           n_distances,
+                             GskPathPoint   *results)
+{
+  float local[64];
+  gsize i, j, n, contour;
+  float offset;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (distances != NULL || n_distances == 0, FALSE);
+  g_return_val_if_fail (results != NULL || n_distances == 0, FALSE);
+
+  if (self->n_contours == 0)
+    return FALSE;
+
+  contour = 0;
+  offset = 0;
+
+  for (i = 0; i < n_distances; i += n)
+    {
+      float distance, length;
+
+      distance = gsk_path_measure_clamp_distance (self, distances[i]);
+
+      if (distance < offset)
+        {
+          contour = 0;
+          offset = 0;
+        }
+
+      while (contour < self->n_contours - 1 &&
+             distance >= offset + self->measures[contour].length)
+        {
+          offset += self->measures[contour].length;
+          contour++;
+        }
+
+      length = self->measures[contour].length;
+      local[0] = CLAMP (distance - offset, 0, length);
+
+      /* Collect the following distances on the same contour */
+      for (n = 1; n < G_N_ELEMENTS (local) && i + n < n_distances; n++)
+        {
+          distance = gsk_path_measure_clamp_distance (self, distances[i + n]) - offset;
+          if (distance < 0 ||
+              (contour < self->n_contours - 1 && distance >= length))
+            break;
+
+          local[n] = MIN (distance, length);
+        }
+
+      gsk_contour_get_points (gsk_path_get_contour (self->path, contour),
+                              self->measures[contour].contour_data,
+                              local, n,
+                              &results[i]);
+
+      for (j = 0; j < n; j++)
+        {
+          g_assert (0 <= results[i + j].t && results[i + j].t <= 1);
+          results[i + j].contour = contour;
+        }
+    }
+
+  return TRUE;
+}
+
+/**
+ * gsk_path_measure_get_positions:
+ * @self: a `GskPathMeasure`
+ * @distances: (array length=n_distances): the distances
+ * @n_distances: the number of distances
+ * @positions: (out caller-allocates) (array length=n_distances): return
+ *   location for the positions
+ * @tangents: (out caller-allocates) (array length=n_distances) (optional):
+ *   return location for the tangents
+ *
+ * Computes the positions of the points at the given distances
+ * into the path, and optionally the tangents at these points
+ * in the direction of the path.
+ *
+ * This is meant for placing many things along a path, such as
+ * the glyphs of text. It is the same as getting the points with
+ * [method@Gsk.PathMeasure.get_points] and calling
+ * [method@Gsk.PathPoint.get_position] and
+ * [method@Gsk.PathPoint.get_tangent] for each of them, but faster.
+ *
+ * An empty path has no points, so `FALSE` is returned in that case.
+ *
+ * Returns: `TRUE` if @positions were set
+ *
+ * Since: 4.18
+ */
+gboolean
+gsk_path_measure_get_positions (GskPathMeasure   *self,
+                                const float      *distances,
+                                gsize             n_distances,
+                                graphene_point_t *positions,
+                                graphene_vec2_t  *tangents)
+{
+  GskPathPoint points[64];
+  gsize i, j, n;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (distances != NULL || n_distances == 0, FALSE);
+  g_return_val_if_fail (positions != NULL || n_distances == 0, FALSE);
+
+  if (self->n_contours == 0)
+    return FALSE;
+
+  for (i = 0; i < n_distances; i += n)
+    {
+      n = MIN (n_distances - i, G_N_ELEMENTS (points));
+
+      gsk_path_measure_get_points (self, &distances[i], n, points);
+
+      for (j = 0; j < n; j++)
+        {
+          const GskContour *contour = gsk_path_get_contour (self->path, points[j].contour);
+
+          gsk_contour_get_position (contour, &points[j], &positions[i + j]);
+          if (tangents)
+            gsk_contour_get_tangent (contour, &points[j], GSK_PATH_TO_END, &tangents[i + j]);
+        }
+    }
+
+  return TRUE;
+}
+
 /**
  * gsk_path_point_get_distance:
  * @point: a `GskPathPoint on the path
@@ -56,6 +56,17 @@ GDK_AVAILABLE_IN_4_14
 gboolean                gsk_path_measure_get_point              (GskPathMeasure         *self,
                                                                  float                   distance,
                                                                  GskPathPoint           *result);
+GDK_AVAILABLE_IN_4_18
+gboolean                gsk_path_measure_get_points             (GskPathMeasure         *self,
+                                                                 const float            *distances,
+                                                                 gsize                   n_distances,
+                                                                 GskPathPoint           *results);
+GDK_AVAILABLE_IN_4_18
+gboolean                gsk_path_measure_get_positions          (GskPathMeasure         *self,
+                                                                 const float            *distances,
+                                                                 gsize                   n_distances,
+                                                                 graphene_point_t       *positions,
+                                                                 graphene_vec2_t        *tangents);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GskPathMeasure, gsk_path_measure_unref)
 
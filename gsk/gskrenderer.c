@@ -85,6 +85,7 @@ typedef struct
   GskDebugFlags debug_flags;
 
   unsigned int is_realized : 1;
+  unsigned int accurate_damage : 1;
 } GskRendererPrivate;
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GskRenderer, gsk_renderer, G_TYPE_OBJECT)
@@ -218,6 +219,7 @@ gsk_renderer_init (GskRenderer *self)
 
   priv->profiler = gsk_profiler_new ();
   priv->debug_flags = gsk_get_debug_flags ();
+  priv->accurate_damage = g_strcmp0 (g_getenv ("GSK_ACCURATE_DAMAGE"), "1") == 0;
 }
 
 /**
@@ -489,7 +491,7 @@ gsk_renderer_render (GskRenderer          *renderer,
     }
   else
     {
-      gsk_render_node_diff (priv->prev_node, root, &(GskDiffData) { clip, priv->surface });
+      gsk_render_node_diff (priv->prev_node, root, &(GskDiffData) { clip, priv->surface, priv->accurate_damage });
     }
 
   renderer_class->render (renderer, root, clip);
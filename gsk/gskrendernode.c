@@ -585,6 +585,11 @@ gsk_render_node_diff (GskRenderNode  *node1,
   if (node1 == node2)
     return;
 
+  /* The hash covers node type and bounds, so this catches
+   * identical subtrees without looking at them */
+  if (node1->hash != 0 && node1->hash == node2->hash)
+    return;
+
   if (gsk_render_node_get_node_type (node1) == gsk_render_node_get_node_type (node2))
     {
       GSK_RENDER_NODE_GET_CLASS (node1)->diff (node1, node2, data);
@@ -56,7 +56,8 @@
 #define MAX_CAIRO_IMAGE_HEIGHT 16384
 
 /* maximal number of rectangles we keep in a diff region before we throw
- * the towel and just use the bounding box of the parent node.
+ * the towel and just use the bounding box of the parent node, or the
+ * bounding box of the damage when accurate damage was requested.
  * Meant to avoid performance corner cases.
  */
 #define MAX_RECTS_IN_DIFF 30
@@ -164,6 +165,97 @@ region_union_region_affine (cairo_region_t       *region,
     }
 }
 
+/* {{{ Structural hashing */
+
+/* Widgets snapshot again when anything about them changes, so large
+ * parts of a new node tree are often identical to the previous one
+ * without being the same objects. To let the diff skip those without
+ * recursing, nodes compute a hash of everything that influences their
+ * rendering when they are created.
+ *
+ * A hash of 0 means no hash is known, either because the node type
+ * doesn't compute one or because one of its descendants doesn't.
+ * Objects the node holds a reference to, like textures and fonts, are
+ * hashed by pointer. Both nodes are alive while diffing, so equal
+ * pointers mean equal objects.
+ */
+
+#define GSK_HASH_INIT  G_GUINT64_CONSTANT (0xcbf29ce484222325)
+#define GSK_HASH_PRIME G_GUINT64_CONSTANT (0x100000001b3)
+
+/* FNV-1a, with 0 sticking */
+static guint64
+gsk_hash_bytes (guint64       hash,
+                gconstpointer data,
+                gsize         size)
+{
+  const guchar *bytes = data;
+  gsize i;
+
+  if (hash == 0)
+    return 0;
+
+  for (i = 0; i < size; i++)
+    {
+      hash ^= bytes[i];
+      hash *= GSK_HASH_PRIME;
+    }
+
+  return hash;
+}
+
+static inline guint64
+gsk_hash_pointer (guint64       hash,
+                  gconstpointer pointer)
+{
+  return gsk_hash_bytes (hash, &pointer, sizeof (gconstpointer));
+}
+
+static inline guint64
+gsk_hash_float (guint64 hash,
+                float   value)
+{
+  return gsk_hash_bytes (hash, &value, sizeof (float));
+}
+
+static inline guint64
+gsk_hash_color (guint64         hash,
+                const GdkColor *color)
+{
+  hash = gsk_hash_pointer (hash, color->color_state);
+  return gsk_hash_bytes (hash, color->values, sizeof (color->values));
+}
+
+static inline guint64
+gsk_hash_rounded_rect (guint64               hash,
+                       const GskRoundedRect *rect)
+{
+  hash = gsk_hash_bytes (hash, &rect->bounds, sizeof (graphene_rect_t));
+  return gsk_hash_bytes (hash, rect->corner, sizeof (rect->corner));
+}
+
+static inline guint64
+gsk_hash_child (guint64              hash,
+                const GskRenderNode *child)
+{
+  if (child->hash == 0)
+    return 0;
+
+  return gsk_hash_bytes (hash, &child->hash, sizeof (guint64));
+}
+
+/* Starts the hash of a node, its bounds must be set already */
+static guint64
+gsk_render_node_hash_init (const GskRenderNode *node)
+{
+  GskRenderNodeType node_type = gsk_render_node_get_node_type (node);
+  guint64 hash;
+
+  hash = gsk_hash_bytes (GSK_HASH_INIT, &node_type, sizeof (GskRenderNodeType));
+  return gsk_hash_bytes (hash, &node->bounds, sizeof (graphene_rect_t));
+}
+
+/* }}} */
 /* {{{ GSK_COLOR_NODE */
 
 /**
@@ -324,6 +416,8 @@ gsk_color_node_new2 (const GdkColor        *color,
   gsk_rect_init_from_rect (&node->bounds, bounds);
   gsk_rect_normalize (&node->bounds);
 
+  node->hash = gsk_hash_color (gsk_render_node_hash_init (node), &self->color);
+
   return node;
 }
 
@@ -1773,6 +1867,7 @@ gsk_border_node_new2 (const GskRoundedRect *outline,
 {
   GskBorderNode *self;
   GskRenderNode *node;
+  guint64 hash;
 
   g_return_val_if_fail (outline != NULL, NULL);
   g_return_val_if_fail (border_width != NULL, NULL);
@@ -1805,6 +1900,13 @@ gsk_border_node_new2 (const GskRoundedRect *outline,
 
   gsk_rect_init_from_rect (&node->bounds, &self->outline.bounds);
 
+  hash = gsk_render_node_hash_init (node);
+  hash = gsk_hash_rounded_rect (hash, &self->outline);
+  hash = gsk_hash_bytes (hash, self->border_width, sizeof (self->border_width));
+  for (int i = 0; i < 4; i++)
+    hash = gsk_hash_color (hash, &self->border_color[i]);
+  node->hash = hash;
+
   return node;
 }
 
@@ -2064,6 +2166,8 @@ gsk_texture_node_new (GdkTexture            *texture,
 
   node->preferred_depth = gdk_texture_get_depth (texture);
 
+  node->hash = gsk_hash_pointer (gsk_render_node_hash_init (node), self->texture);
+
   return node;
 }
 
@@ -2269,6 +2373,7 @@ gsk_texture_scale_node_new (GdkTexture            *texture,
 {
   GskTextureScaleNode *self;
   GskRenderNode *node;
+  guint64 hash;
 
   g_return_val_if_fail (GDK_IS_TEXTURE (texture), NULL);
   g_return_val_if_fail (bounds != NULL, NULL);
@@ -2288,6 +2393,9 @@ gsk_texture_scale_node_new (GdkTexture            *texture,
 
   node->preferred_depth = gdk_texture_get_depth (texture);
 
+  hash = gsk_hash_pointer (gsk_render_node_hash_init (node), self->texture);
+  node->hash = gsk_hash_bytes (hash, &self->filter, sizeof (GskScalingFilter));
+
   return node;
 }
 
@@ -2790,6 +2898,7 @@ gsk_inset_shadow_node_new2 (const GskRoundedRect   *outline,
 {
   GskInsetShadowNode *self;
   GskRenderNode *node;
+  guint64 hash;
 
   g_return_val_if_fail (outline != NULL, NULL);
   g_return_val_if_fail (color != NULL, NULL);
@@ -2809,6 +2918,13 @@ gsk_inset_shadow_node_new2 (const GskRoundedRect   *outline,
 
   gsk_rect_init_from_rect (&node->bounds, &self->outline.bounds);
 
+  hash = gsk_render_node_hash_init (node);
+  hash = gsk_hash_rounded_rect (hash, &self->outline);
+  hash = gsk_hash_color (hash, &self->color);
+  hash = gsk_hash_bytes (hash, &self->offset, sizeof (graphene_point_t));
+  hash = gsk_hash_float (hash, self->spread);
+  node->hash = gsk_hash_float (hash, self->blur_radius);
+
   return node;
 }
 
@@ -3187,6 +3303,7 @@ gsk_outset_shadow_node_new2 (const GskRoundedRect   *outline,
   GskOutsetShadowNode *self;
   GskRenderNode *node;
   float top, right, bottom, left;
+  guint64 hash;
 
   g_return_val_if_fail (outline != NULL, NULL);
   g_return_val_if_fail (color != NULL, NULL);
@@ -3211,6 +3328,13 @@ gsk_outset_shadow_node_new2 (const GskRoundedRect   *outline,
   node->bounds.size.width += left + right;
   node->bounds.size.height += top + bottom;
 
+  hash = gsk_render_node_hash_init (node);
+  hash = gsk_hash_rounded_rect (hash, &self->outline);
+  hash = gsk_hash_color (hash, &self->color);
+  hash = gsk_hash_bytes (hash, &self->offset, sizeof (graphene_point_t));
+  hash = gsk_hash_float (hash, self->spread);
+  node->hash = gsk_hash_float (hash, self->blur_radius);
+
   return node;
 }
 
@@ -3571,15 +3695,34 @@ gsk_container_node_compare_func (gconstpointer elem1, gconstpointer elem2, gpoin
   return gsk_render_node_can_diff ((const GskRenderNode *) elem1, (const GskRenderNode *) elem2) ? 0 : 1;
 }
 
+static GskDiffResult
+gsk_container_node_check_region (GskDiffData *data)
+{
+  cairo_rectangle_int_t extents;
+
+  if (cairo_region_num_rectangles (data->region) <= MAX_RECTS_IN_DIFF)
+    return GSK_DIFF_OK;
+
+  if (!data->accurate)
+    return GSK_DIFF_ABORTED;
+
+  /* The region only holds the damage of this container's children,
+   * see gsk_render_node_diff_multiple(), so its extents stay within
+   * the bounds we'd fall back to when aborting.
+   */
+  cairo_region_get_extents (data->region, &extents);
+  cairo_region_union_rectangle (data->region, &extents);
+
+  return GSK_DIFF_OK;
+}
+
 static GskDiffResult
 gsk_container_node_keep_func (gconstpointer elem1, gconstpointer elem2, gpointer user_data)
 {
   GskDiffData *data = user_data;
   gsk_render_node_diff ((GskRenderNode *) elem1, (GskRenderNode *) elem2, data);
-  if (cairo_region_num_rectangles (data->region) > MAX_RECTS_IN_DIFF)
-    return GSK_DIFF_ABORTED;
 
-  return GSK_DIFF_OK;
+  return gsk_container_node_check_region (data);
 }
 
 static GskDiffResult
@@ -3591,27 +3734,28 @@ gsk_container_node_change_func (gconstpointer elem, gsize idx, gpointer user_dat
 
   gsk_rect_to_cairo_grow (&node->bounds, &rect);
   cairo_region_union_rectangle (data->region, &rect);
-  if (cairo_region_num_rectangles (data->region) > MAX_RECTS_IN_DIFF)
-    return GSK_DIFF_ABORTED;
 
-  return GSK_DIFF_OK;
+  return gsk_container_node_check_region (data);
 }
 
 static GskDiffSettings *
-gsk_container_node_get_diff_settings (void)
+gsk_container_node_get_diff_settings (gboolean accurate)
 {
-  static GskDiffSettings *settings = NULL;
+  static GskDiffSettings *settings[2] = { NULL, NULL };
+  guint i = accurate ? 1 : 0;
 
-  if (G_LIKELY (settings))
-    return settings;
+  if (G_LIKELY (settings[i]))
+    return settings[i];
 
-  settings = gsk_diff_settings_new (gsk_container_node_compare_func,
-                                    gsk_container_node_keep_func,
-                                    gsk_container_node_change_func,
-                                    gsk_container_node_change_func);
-  gsk_diff_settings_set_allow_abort (settings, TRUE);
+  settings[i] = gsk_diff_settings_new (gsk_container_node_compare_func,
+                                       gsk_container_node_keep_func,
+                                       gsk_container_node_change_func,
+                                       gsk_container_node_change_func);
+  /* With accurate damage, an expensive diff falls back to a
+   * suboptimal match of the children instead of giving up */
+  gsk_diff_settings_set_allow_abort (settings[i], !accurate);
 
-  return settings;
+  return settings[i];
 }
 
 static gboolean
@@ -3621,10 +3765,26 @@ gsk_render_node_diff_multiple (GskRenderNode **nodes1,
                                gsize           n_nodes2,
                                GskDiffData    *data)
 {
-  return gsk_diff ((gconstpointer *) nodes1, n_nodes1,
-                   (gconstpointer *) nodes2, n_nodes2,
-                   gsk_container_node_get_diff_settings (),
-                   data) == GSK_DIFF_OK;
+  cairo_region_t *sub;
+  GskDiffResult result;
+
+  if (!data->accurate)
+    return gsk_diff ((gconstpointer *) nodes1, n_nodes1,
+                     (gconstpointer *) nodes2, n_nodes2,
+                     gsk_container_node_get_diff_settings (FALSE),
+                     data) == GSK_DIFF_OK;
+
+  /* Collect the damage separately, so that coarsening it
+   * doesn't merge it with damage from elsewhere */
+  sub = cairo_region_create ();
+  result = gsk_diff ((gconstpointer *) nodes1, n_nodes1,
+                     (gconstpointer *) nodes2, n_nodes2,
+                     gsk_container_node_get_diff_settings (TRUE),
+                     &(GskDiffData) { sub, data->surface, TRUE });
+  cairo_region_union (data->region, sub);
+  cairo_region_destroy (sub);
+
+  return result == GSK_DIFF_OK;
 }
 
 void
@@ -3717,12 +3877,14 @@ gsk_container_node_new (GskRenderNode **children,
     {
       gsk_rect_init_from_rect (&node->bounds, graphene_rect_zero ());
       node->preferred_depth = GDK_MEMORY_NONE;
+      node->hash = gsk_render_node_hash_init (node);
     }
   else
     {
       graphene_rect_t child_opaque;
       gboolean have_opaque;
       gboolean is_hdr;
+      guint64 hash;
 
       self->children = g_malloc_n (n_children, sizeof (GskRenderNode *));
 
@@ -3756,6 +3918,11 @@ gsk_container_node_new (GskRenderNode **children,
 
       node->offscreen_for_opacity = node->offscreen_for_opacity || !self->disjoint;
       node->is_hdr = is_hdr;
+
+      hash = gsk_render_node_hash_init (node);
+      for (guint i = 0; i < n_children; i++)
+        hash = gsk_hash_child (hash, self->children[i]);
+      node->hash = hash;
    }
 
   return node;
@@ -3933,7 +4100,7 @@ gsk_transform_node_diff (GskRenderNode *node1,
         float dx, dy;
         gsk_transform_to_translate (self1->transform, &dx, &dy);
         sub = cairo_region_create ();
-        gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+        gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
         cairo_region_translate (sub, floorf (dx), floorf (dy));
         if (floorf (dx) != dx)
           {
@@ -3960,7 +4127,7 @@ gsk_transform_node_diff (GskRenderNode *node1,
         float scale_x, scale_y, dx, dy;
         gsk_transform_to_affine (self1->transform, &scale_x, &scale_y, &dx, &dy);
         sub = cairo_region_create ();
-        gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+        gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
         region_union_region_affine (data->region, sub, scale_x, scale_y, dx, dy);
         cairo_region_destroy (sub);
       }
@@ -4027,6 +4194,7 @@ gsk_transform_node_new (GskRenderNode *child,
   GskTransformNode *self;
   GskRenderNode *node;
   GskTransformCategory category;
+  guint64 hash;
 
   g_return_val_if_fail (GSK_IS_RENDER_NODE (child), NULL);
   g_return_val_if_fail (transform != NULL, NULL);
@@ -4053,6 +4221,23 @@ gsk_transform_node_new (GskRenderNode *child,
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
 
+  hash = gsk_hash_child (gsk_render_node_hash_init (node), child);
+  hash = gsk_hash_bytes (hash, &category, sizeof (GskTransformCategory));
+  if (category >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+    {
+      hash = gsk_hash_float (hash, self->dx);
+      node->hash = gsk_hash_float (hash, self->dy);
+    }
+  else if (hash != 0)
+    {
+      graphene_matrix_t matrix;
+      float values[16];
+
+      gsk_transform_to_matrix (transform, &matrix);
+      graphene_matrix_to_float (&matrix, values);
+      node->hash = gsk_hash_bytes (hash, values, sizeof (values));
+    }
+
   return node;
 }
 
@@ -4206,6 +4391,8 @@ gsk_opacity_node_new (GskRenderNode *child,
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
 
+  node->hash = gsk_hash_float (gsk_hash_child (gsk_render_node_hash_init (node), child), self->opacity);
+
   return node;
 }
 
@@ -4678,7 +4865,7 @@ gsk_repeat_node_diff (GskRenderNode *node1,
       cairo_region_t *sub;
 
       sub = cairo_region_create();
-      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
       if (cairo_region_is_empty (sub))
         {
           cairo_region_destroy (sub);
@@ -4844,7 +5031,7 @@ gsk_clip_node_diff (GskRenderNode *node1,
       cairo_rectangle_int_t clip_rect;
 
       sub = cairo_region_create();
-      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
       gsk_rect_to_cairo_grow (&self1->clip, &clip_rect);
       cairo_region_intersect_rectangle (sub, &clip_rect);
       cairo_region_union (data->region, sub);
@@ -4899,6 +5086,7 @@ gsk_clip_node_new (GskRenderNode         *child,
 {
   GskClipNode *self;
   GskRenderNode *node;
+  guint64 hash;
 
   g_return_val_if_fail (GSK_IS_RENDER_NODE (child), NULL);
   g_return_val_if_fail (clip != NULL, NULL);
@@ -4918,6 +5106,9 @@ gsk_clip_node_new (GskRenderNode         *child,
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
 
+  hash = gsk_hash_child (gsk_render_node_hash_init (node), child);
+  node->hash = gsk_hash_bytes (hash, &self->clip, sizeof (graphene_rect_t));
+
   return node;
 }
 
@@ -5011,7 +5202,7 @@ gsk_rounded_clip_node_diff (GskRenderNode *node1,
       cairo_rectangle_int_t clip_rect;
 
       sub = cairo_region_create();
-      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
       gsk_rect_to_cairo_grow (&self1->clip.bounds, &clip_rect);
       cairo_region_intersect_rectangle (sub, &clip_rect);
       cairo_region_union (data->region, sub);
@@ -5102,6 +5293,8 @@ gsk_rounded_clip_node_new (GskRenderNode         *child,
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
 
+  node->hash = gsk_hash_rounded_rect (gsk_hash_child (gsk_render_node_hash_init (node), child), &self->clip);
+
   return node;
 }
 
@@ -5217,7 +5410,7 @@ gsk_fill_node_diff (GskRenderNode *node1,
       cairo_rectangle_int_t clip_rect;
 
       sub = cairo_region_create();
-      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
       gsk_rect_to_cairo_grow (&node1->bounds, &clip_rect);
       cairo_region_intersect_rectangle (sub, &clip_rect);
       cairo_region_union (data->region, sub);
@@ -5425,7 +5618,7 @@ gsk_stroke_node_diff (GskRenderNode *node1,
       cairo_rectangle_int_t clip_rect;
 
       sub = cairo_region_create();
-      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
       gsk_rect_to_cairo_grow (&node1->bounds, &clip_rect);
       cairo_region_intersect_rectangle (sub, &clip_rect);
       cairo_region_union (data->region, sub);
@@ -5678,7 +5871,7 @@ gsk_shadow_node_diff (GskRenderNode *node1,
     }
 
   sub = cairo_region_create ();
-  gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+  gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
 
   n = cairo_region_num_rectangles (sub);
   for (i = 0; i < n; i++)
@@ -6495,6 +6688,7 @@ gsk_text_node_new2 (PangoFont              *font,
   GskRenderNode *node;
   PangoRectangle ink_rect;
   PangoGlyphInfo *glyph_infos;
+  guint64 hash;
   int n;
 
   pango_glyph_string_extents (glyphs, font, &ink_rect, NULL);
@@ -6542,6 +6736,24 @@ gsk_text_node_new2 (PangoFont              *font,
                  pango_units_to_float (ink_rect.width),
                  pango_units_to_float (ink_rect.height));
 
+  hash = gsk_hash_pointer (gsk_render_node_hash_init (node), self->font);
+  hash = gsk_hash_color (hash, &self->color);
+  hash = gsk_hash_bytes (hash, &self->offset, sizeof (graphene_point_t));
+  for (guint i = 0; i < self->num_glyphs; i++)
+    {
+      const PangoGlyphInfo *gi = &self->glyphs[i];
+      gint32 values[5] = {
+        gi->glyph,
+        gi->geometry.width,
+        gi->geometry.x_offset,
+        gi->geometry.y_offset,
+        gi->attr.is_color,
+      };
+
+      hash = gsk_hash_bytes (hash, values, sizeof (values));
+    }
+  node->hash = hash;
+
   return node;
 }
 
@@ -6914,7 +7126,7 @@ gsk_blur_node_diff (GskRenderNode *node1,
 
       clip_radius = ceil (gsk_cairo_blur_compute_pixels (self1->radius / 2.0));
       sub = cairo_region_create ();
-      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface });
+      gsk_render_node_diff (self1->child, self2->child, &(GskDiffData) { sub, data->surface, data->accurate });
 
       n = cairo_region_num_rectangles (sub);
       for (i = 0; i < n; i++)
@@ -7399,6 +7611,9 @@ gsk_debug_node_new (GskRenderNode *child,
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   self->render_node.is_hdr = gsk_render_node_is_hdr (child);
 
+  /* the message doesn't influence rendering */
+  node->hash = gsk_hash_child (gsk_render_node_hash_init (node), child);
+
   return node;
 }
 
@@ -7497,7 +7712,7 @@ gsk_gl_shader_node_diff (GskRenderNode *node1,
     {
       cairo_region_t *child_region = cairo_region_create();
       for (guint i = 0; i < self1->n_children; i++)
-        gsk_render_node_diff (self1->children[i], self2->children[i], &(GskDiffData) { child_region, data->surface });
+        gsk_render_node_diff (self1->children[i], self2->children[i], &(GskDiffData) { child_region, data->surface, data->accurate });
       if (!cairo_region_is_empty (child_region))
         gsk_render_node_diff_impossible (node1, node2, data);
       cairo_region_destroy (child_region);
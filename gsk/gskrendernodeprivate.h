@@ -33,6 +33,10 @@ struct _GskRenderNode
 
   graphene_rect_t bounds;
 
+  /* structural hash of the node and its children, or 0 if unknown.
+   * Nodes with the same nonzero hash draw the same */
+  guint64 hash;
+
   guint preferred_depth : GDK_MEMORY_DEPTH_BITS;
   guint offscreen_for_opacity : 1;
   guint fully_opaque : 1;
@@ -43,6 +47,9 @@ typedef struct
 {
   cairo_region_t *region;
   GdkSurface *surface;
+  /* coarsen the damage when it gets too complex instead of
+   * falling back to the bounds of the parent */
+  gboolean accurate;
 } GskDiffData;
 
 struct _GskRenderNodeClass
@@ -814,7 +814,7 @@ on_loader_size_prepared (GdkPixbufLoader *loader,
                               height * loader_data->scale);
 }
 
-static GdkPaintable *
+GdkPaintable *
 gdk_paintable_new_from_bytes_scaled (GBytes *bytes,
                                      double  scale)
 {
@@ -74,6 +74,8 @@ GdkTexture *gdk_texture_new_from_resource_symbolic  (const char    *path,
 GdkTexture *gtk_load_symbolic_texture_from_file     (GFile         *file);
 GdkTexture *gtk_load_symbolic_texture_from_resource (const char    *path);
 
+GdkPaintable *gdk_paintable_new_from_bytes_scaled    (GBytes        *bytes,
+                                                      double         scale);
 GdkPaintable *gdk_paintable_new_from_filename_scaled (const char    *filename,
                                                       double         scale);
 GdkPaintable *gdk_paintable_new_from_resource_scaled (const char    *path,
@@ -636,6 +636,28 @@ gtk_bitset_difference (GtkBitset       *self,
   roaring_bitmap_xor_inplace (&self->roaring, &other->roaring);
 }
 
+typedef struct {
+  roaring_bitmap_t *target;
+  guint amount;
+} ShiftData;
+
+static bool
+shift_left_run (uint32_t  start,
+                uint32_t  end,
+                void     *data)
+{
+  ShiftData *shift = data;
+
+  if (end < shift->amount)
+    return true;
+
+  roaring_bitmap_add_range_closed (shift->target,
+                                   MAX (start, shift->amount) - shift->amount,
+                                   end - shift->amount);
+
+  return true;
+}
+
 /**
  * gtk_bitset_shift_left:
  * @self: a `GtkBitset`
@@ -650,9 +672,7 @@ gtk_bitset_shift_left (GtkBitset *self,
                        guint      amount)
 {
   GtkBitset *original;
-  GtkBitsetIter iter;
-  guint value;
-  gboolean loop;
+  ShiftData shift;
 
   g_return_if_fail (self != NULL);
 
@@ -662,16 +682,31 @@ gtk_bitset_shift_left (GtkBitset *self,
   original = gtk_bitset_copy (self);
   gtk_bitset_remove_all (self);
 
-  for (loop = gtk_bitset_iter_init_at (&iter, original, amount, &value);
-       loop;
-       loop = gtk_bitset_iter_next (&iter, &value))
-    {
-      gtk_bitset_add (self, value - amount);
-    }
+  /* Shift whole runs, so that large selections stay cheap */
+  shift.target = &self->roaring;
+  shift.amount = amount;
+  roaring_iterate_runs (&original->roaring, shift_left_run, &shift);
 
   gtk_bitset_unref (original);
 }
 
+static bool
+shift_right_run (uint32_t  start,
+                 uint32_t  end,
+                 void     *data)
+{
+  ShiftData *shift = data;
+
+  if (start > G_MAXUINT - shift->amount)
+    return false;
+
+  roaring_bitmap_add_range_closed (shift->target,
+                                   start + shift->amount,
+                                   MIN (end, G_MAXUINT - shift->amount) + shift->amount);
+
+  return true;
+}
+
 /**
  * gtk_bitset_shift_right:
  * @self: a `GtkBitset`
@@ -686,9 +721,7 @@ gtk_bitset_shift_right (GtkBitset *self,
                         guint      amount)
 {
   GtkBitset *original;
-  GtkBitsetIter iter;
-  guint value;
-  gboolean loop;
+  ShiftData shift;
 
   g_return_if_fail (self != NULL);
 
@@ -698,12 +731,9 @@ gtk_bitset_shift_right (GtkBitset *self,
   original = gtk_bitset_copy (self);
   gtk_bitset_remove_all (self);
 
-  for (loop = gtk_bitset_iter_init_first (&iter, original, &value);
-       loop && value <= G_MAXUINT - amount;
-       loop = gtk_bitset_iter_next (&iter, &value))
-    {
-      gtk_bitset_add (self, value + amount);
-    }
+  shift.target = &self->roaring;
+  shift.amount = amount;
+  roaring_iterate_runs (&original->roaring, shift_right_run, &shift);
 
   gtk_bitset_unref (original);
 }
@@ -40,8 +40,182 @@
 #include "gtkstyleproviderprivate.h"
 #include "gtkcsscustompropertypoolprivate.h"
 
+#include "gdk/gdkprofilerprivate.h"
+
 G_DEFINE_TYPE (GtkCssAnimatedStyle, gtk_css_animated_style, GTK_TYPE_CSS_STYLE)
 
+/* Animated styles only depend on the styles they are created from and
+ * the time. When many nodes run the same animation, like rows in a list
+ * that share their static style, they would all compute the same values.
+ * So while sharing is enabled, we remember the styles we created and
+ * hand out the same style again for the same inputs.
+ */
+typedef struct _GtkCssAnimatedStyleSample GtkCssAnimatedStyleSample;
+struct _GtkCssAnimatedStyleSample
+{
+  GtkCssStyle      *source;        /* previous style or style we advance, may be NULL */
+  GtkCssStyle      *base_style;
+  GtkCssStyle      *parent_style;
+  GtkStyleProvider *provider;
+  gint64            timestamp;
+  gboolean          advance;
+
+  GtkCssStyle      *result;
+};
+
+static GHashTable *samples;
+static guint sharing_depth;
+static int sample_hits;
+static int sample_misses;
+static guint sample_hits_counter;
+static guint sample_misses_counter;
+
+static guint
+gtk_css_animated_style_sample_hash (gconstpointer data)
+{
+  const GtkCssAnimatedStyleSample *sample = data;
+  guint hash;
+
+  hash = g_direct_hash (sample->source);
+  hash = hash * 31 + g_direct_hash (sample->base_style);
+  hash = hash * 31 + g_direct_hash (sample->parent_style);
+  hash = hash * 31 + g_direct_hash (sample->provider);
+  hash = hash * 31 + g_int64_hash (&sample->timestamp);
+
+  return hash ^ sample->advance;
+}
+
+static gboolean
+gtk_css_animated_style_sample_equal (gconstpointer a,
+                                     gconstpointer b)
+{
+  const GtkCssAnimatedStyleSample *sample1 = a;
+  const GtkCssAnimatedStyleSample *sample2 = b;
+
+  return sample1->source == sample2->source &&
+         sample1->base_style == sample2->base_style &&
+         sample1->parent_style == sample2->parent_style &&
+         sample1->provider == sample2->provider &&
+         sample1->timestamp == sample2->timestamp &&
+         sample1->advance == sample2->advance;
+}
+
+static void
+gtk_css_animated_style_sample_free (gpointer data)
+{
+  GtkCssAnimatedStyleSample *sample = data;
+
+  g_clear_object (&sample->source);
+  g_object_unref (sample->base_style);
+  g_clear_object (&sample->parent_style);
+  g_object_unref (sample->provider);
+  g_object_unref (sample->result);
+
+  g_free (sample);
+}
+
+/* Returns a new reference to a previously created style or NULL */
+static GtkCssStyle *
+gtk_css_animated_style_lookup_sample (GtkCssStyle      *source,
+                                      GtkCssStyle      *base_style,
+                                      GtkCssStyle      *parent_style,
+                                      GtkStyleProvider *provider,
+                                      gint64            timestamp,
+                                      gboolean          advance)
+{
+  GtkCssAnimatedStyleSample key = { source, base_style, parent_style, provider, timestamp, advance, NULL };
+  GtkCssAnimatedStyleSample *sample;
+
+  if (samples == NULL)
+    return NULL;
+
+  sample = g_hash_table_lookup (samples, &key);
+  if (sample == NULL)
+    {
+      sample_misses++;
+      return NULL;
+    }
+
+  sample_hits++;
+
+  return g_object_ref (sample->result);
+}
+
+static void
+gtk_css_animated_style_add_sample (GtkCssStyle      *source,
+                                   GtkCssStyle      *base_style,
+                                   GtkCssStyle      *parent_style,
+                                   GtkStyleProvider *provider,
+                                   gint64            timestamp,
+                                   gboolean          advance,
+                                   GtkCssStyle      *result)
+{
+  GtkCssAnimatedStyleSample *sample;
+
+  if (samples == NULL)
+    return;
+
+  sample = g_new (GtkCssAnimatedStyleSample, 1);
+  sample->source = source ? g_object_ref (source) : NULL;
+  sample->base_style = g_object_ref (base_style);
+  sample->parent_style = parent_style ? g_object_ref (parent_style) : NULL;
+  sample->provider = g_object_ref (provider);
+  sample->timestamp = timestamp;
+  sample->advance = advance;
+  sample->result = g_object_ref (result);
+
+  g_hash_table_add (samples, sample);
+}
+
+/*
+ * gtk_css_animated_style_begin_sharing:
+ *
+ * Starts sharing animated styles. Until the matching call to
+ * gtk_css_animated_style_end_sharing(), creating or advancing an
+ * animated style with the same arguments as before returns the
+ * same style.
+ *
+ * Calls can be nested.
+ */
+void
+gtk_css_animated_style_begin_sharing (void)
+{
+  sharing_depth++;
+
+  if (samples == NULL)
+    samples = g_hash_table_new_full (gtk_css_animated_style_sample_hash,
+                                     gtk_css_animated_style_sample_equal,
+                                     gtk_css_animated_style_sample_free,
+                                     NULL);
+}
+
+void
+gtk_css_animated_style_end_sharing (void)
+{
+  g_return_if_fail (sharing_depth > 0);
+
+  sharing_depth--;
+  if (sharing_depth > 0)
+    return;
+
+  g_clear_pointer (&samples, g_hash_table_unref);
+
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      if (sample_hits_counter == 0)
+        {
+          sample_hits_counter = gdk_profiler_define_int_counter ("animated-style-hits", "Shared animated styles");
+          sample_misses_counter = gdk_profiler_define_int_counter ("animated-style-misses", "Computed animated styles");
+        }
+
+      gdk_profiler_set_int_counter (sample_hits_counter, sample_hits);
+      gdk_profiler_set_int_counter (sample_misses_counter, sample_misses);
+    }
+
+  sample_hits = 0;
+  sample_misses = 0;
+}
+
 
 #define DEFINE_VALUES(ENUM, TYPE, NAME) \
 static inline void \
@@ -1001,25 +1175,17 @@ gtk_css_animated_style_apply_animations (GtkCssAnimatedStyle *style)
   gtk_css_style_resolve_used_values ((GtkCssStyle *) style, &context);
 }
 
-GtkCssStyle *
-gtk_css_animated_style_new (GtkCssStyle      *base_style,
-                            GtkCssStyle      *parent_style,
-                            gint64            timestamp,
-                            GtkStyleProvider *provider,
-                            GtkCssStyle      *previous_style)
+static GtkCssStyle *
+gtk_css_animated_style_create (GtkCssStyle      *base_style,
+                               GtkCssStyle      *parent_style,
+                               gint64            timestamp,
+                               GtkStyleProvider *provider,
+                               GtkCssStyle      *previous_style)
 {
   GtkCssAnimatedStyle *result;
   GtkCssStyle *style;
   GPtrArray *animations = NULL;
 
-  gtk_internal_return_val_if_fail (GTK_IS_CSS_STYLE (base_style), NULL);
-  gtk_internal_return_val_if_fail (parent_style == NULL || GTK_IS_CSS_STYLE (parent_style), NULL);
-  gtk_internal_return_val_if_fail (GTK_IS_STYLE_PROVIDER (provider), NULL);
-  gtk_internal_return_val_if_fail (previous_style == NULL || GTK_IS_CSS_STYLE (previous_style), NULL);
-
-  if (timestamp == 0)
-    return g_object_ref (base_style);
-
   if (previous_style != NULL)
     animations = gtk_css_animated_style_create_css_transitions (animations, base_style, timestamp, previous_style);
 
@@ -1061,29 +1227,44 @@ gtk_css_animated_style_new (GtkCssStyle      *base_style,
 }
 
 GtkCssStyle *
-gtk_css_animated_style_new_advance (GtkCssAnimatedStyle *source,
-                                    GtkCssStyle         *base_style,
-                                    GtkCssStyle         *parent_style,
-                                    gint64               timestamp,
-                                    GtkStyleProvider    *provider)
+gtk_css_animated_style_new (GtkCssStyle      *base_style,
+                            GtkCssStyle      *parent_style,
+                            gint64            timestamp,
+                            GtkStyleProvider *provider,
+                            GtkCssStyle      *previous_style)
 {
-  GtkCssAnimatedStyle *result;
-  GtkCssStyle *style;
-  GPtrArray *animations;
-  guint i;
+  GtkCssStyle *result;
 
-  gtk_internal_return_val_if_fail (GTK_IS_CSS_ANIMATED_STYLE (source), NULL);
   gtk_internal_return_val_if_fail (GTK_IS_CSS_STYLE (base_style), NULL);
   gtk_internal_return_val_if_fail (parent_style == NULL || GTK_IS_CSS_STYLE (parent_style), NULL);
   gtk_internal_return_val_if_fail (GTK_IS_STYLE_PROVIDER (provider), NULL);
+  gtk_internal_return_val_if_fail (previous_style == NULL || GTK_IS_CSS_STYLE (previous_style), NULL);
 
   if (timestamp == 0)
-    return g_object_ref (source->style);
+    return g_object_ref (base_style);
 
-  if (timestamp == source->current_time)
-    return g_object_ref (GTK_CSS_STYLE (source));
+  result = gtk_css_animated_style_lookup_sample (previous_style, base_style, parent_style, provider, timestamp, FALSE);
+  if (result)
+    return result;
 
-  gtk_internal_return_val_if_fail (timestamp > source->current_time, NULL);
+  result = gtk_css_animated_style_create (base_style, parent_style, timestamp, provider, previous_style);
+
+  gtk_css_animated_style_add_sample (previous_style, base_style, parent_style, provider, timestamp, FALSE, result);
+
+  return result;
+}
+
+static GtkCssStyle *
+gtk_css_animated_style_create_advance (GtkCssAnimatedStyle *source,
+                                       GtkCssStyle         *base_style,
+                                       GtkCssStyle         *parent_style,
+                                       gint64               timestamp,
+                                       GtkStyleProvider    *provider)
+{
+  GtkCssAnimatedStyle *result;
+  GtkCssStyle *style;
+  GPtrArray *animations;
+  guint i;
 
   animations = NULL;
   for (i = 0; i < source->n_animations; i ++)
@@ -1134,6 +1315,39 @@ gtk_css_animated_style_new_advance (GtkCssAnimatedStyle *source,
   return GTK_CSS_STYLE (result);
 }
 
+GtkCssStyle *
+gtk_css_animated_style_new_advance (GtkCssAnimatedStyle *source,
+                                    GtkCssStyle         *base_style,
+                                    GtkCssStyle         *parent_style,
+                                    gint64               timestamp,
+                                    GtkStyleProvider    *provider)
+{
+  GtkCssStyle *result;
+
+  gtk_internal_return_val_if_fail (GTK_IS_CSS_ANIMATED_STYLE (source), NULL);
+  gtk_internal_return_val_if_fail (GTK_IS_CSS_STYLE (base_style), NULL);
+  gtk_internal_return_val_if_fail (parent_style == NULL || GTK_IS_CSS_STYLE (parent_style), NULL);
+  gtk_internal_return_val_if_fail (GTK_IS_STYLE_PROVIDER (provider), NULL);
+
+  if (timestamp == 0)
+    return g_object_ref (source->style);
+
+  if (timestamp == source->current_time)
+    return g_object_ref (GTK_CSS_STYLE (source));
+
+  gtk_internal_return_val_if_fail (timestamp > source->current_time, NULL);
+
+  result = gtk_css_animated_style_lookup_sample (GTK_CSS_STYLE (source), base_style, parent_style, provider, timestamp, TRUE);
+  if (result)
+    return result;
+
+  result = gtk_css_animated_style_create_advance (source, base_style, parent_style, timestamp, provider);
+
+  gtk_css_animated_style_add_sample (GTK_CSS_STYLE (source), base_style, parent_style, provider, timestamp, TRUE, result);
+
+  return result;
+}
+
 GtkCssStyle *
 gtk_css_animated_style_get_base_style (GtkCssAnimatedStyle *style)
 {
@@ -82,5 +82,8 @@ GtkCssStyle *           gtk_css_animated_style_get_base_style   (GtkCssAnimatedS
 GtkCssStyle *           gtk_css_animated_style_get_parent_style (GtkCssAnimatedStyle    *style);
 GtkStyleProvider *      gtk_css_animated_style_get_provider     (GtkCssAnimatedStyle    *style);
 
+void                    gtk_css_animated_style_begin_sharing    (void);
+void                    gtk_css_animated_style_end_sharing      (void);
+
 G_END_DECLS
 
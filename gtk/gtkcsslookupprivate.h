@@ -29,8 +29,6 @@
 
 G_BEGIN_DECLS
 
-typedef struct _GtkCssLookup GtkCssLookup;
-
 typedef struct {
   GtkCssSection     *section;
   GtkCssValue       *value;
@@ -21,13 +21,17 @@
 
 #include "gtkcssstaticstyleprivate.h"
 #include "gtkcssanimatedstyleprivate.h"
+#include "gtkcsslookupprivate.h"
 #include "gtkcssstylepropertyprivate.h"
 #include "gtkmarshalers.h"
 #include "gtksettingsprivate.h"
+#include "gtkstyleproviderprivate.h"
 #include "gtktypebuiltins.h"
 #include "gtkprivate.h"
 #include "gdkprofilerprivate.h"
 
+#include "gdk/gdkparalleltaskprivate.h"
+
 /*
  * CSS nodes are the backbone of the GtkStyleContext implementation and
  * replace the role that GtkWidgetPath played in the past. A CSS node has
@@ -126,6 +130,51 @@ static int created_styles;
 static guint invalidated_nodes_counter;
 static guint created_styles_counter;
 
+/* Minimum number of styles that need to be recomputed before we match
+ * selectors ahead of time in parallel, and the number of nodes we match
+ * in one go and per thread.
+ */
+#define GTK_CSS_MATCH_PARALLEL_MIN_NODES (256)
+#define GTK_CSS_MATCH_BATCH_SIZE (1024)
+#define GTK_CSS_MATCH_CHUNK_SIZE (32)
+
+typedef struct _GtkCssNodeMatch GtkCssNodeMatch;
+typedef struct _GtkCssNodeMatches GtkCssNodeMatches;
+
+struct _GtkCssNodeMatch
+{
+  GtkCssLookup lookup;
+  GtkCssChange change;
+};
+
+/* Selector matching does not depend on the styles of other nodes,
+ * only on the node tree. So when a lot of styles need to be recomputed
+ * we can match the nodes that will need it in parallel before
+ * computing the styles in the main thread.
+ */
+struct _GtkCssNodeMatches
+{
+  guint serial;
+  GPtrArray *nodes;             /* nodes in validation order */
+  GPtrArray *providers;         /* the style provider of each node */
+  GHashTable *positions;        /* node => position in nodes + 1 */
+
+  guint batch_start;
+  guint batch_size;
+  GtkCssNodeMatch *batch;       /* GTK_CSS_MATCH_BATCH_SIZE matches, starting at batch_start */
+
+  int n_chunks;
+  int next_chunk;
+};
+
+/* Only set during gtk_css_node_validate() */
+static GtkCssNodeMatches *node_matches;
+
+/* Increased whenever something changes that affects selector matching,
+ * so that node_matches can't be used anymore.
+ */
+static guint match_serial;
+
 static void
 gtk_css_node_set_invalid (GtkCssNode *node,
                           gboolean    invalid)
@@ -355,12 +404,111 @@ store_in_global_parent_cache (GtkCssNode                  *node,
                                                  style);
 }
 
+static void
+gtk_css_node_match_func (gpointer data)
+{
+  GtkCssNodeMatches *matches = data;
+  GtkCountingBloomFilter filter = GTK_COUNTING_BLOOM_FILTER_INIT;
+  int chunk;
+
+  for (chunk = g_atomic_int_add (&matches->next_chunk, 1);
+       chunk < matches->n_chunks;
+       chunk = g_atomic_int_add (&matches->next_chunk, 1))
+    {
+      guint i, end;
+
+      end = MIN ((guint) (chunk + 1) * GTK_CSS_MATCH_CHUNK_SIZE, matches->batch_size);
+      for (i = chunk * GTK_CSS_MATCH_CHUNK_SIZE; i < end; i++)
+        {
+          GtkCssNode *node = g_ptr_array_index (matches->nodes, matches->batch_start + i);
+          GtkStyleProvider *provider = g_ptr_array_index (matches->providers, matches->batch_start + i);
+          GtkCssNodeMatch *match = &matches->batch[i];
+          GtkCssNode *parent;
+
+          for (parent = node->parent; parent; parent = parent->parent)
+            gtk_css_node_declaration_add_bloom_hashes (parent->decl, &filter);
+
+          _gtk_css_lookup_init (&match->lookup);
+          gtk_style_provider_lookup (provider, &filter, node, &match->lookup, &match->change);
+
+          for (parent = node->parent; parent; parent = parent->parent)
+            gtk_css_node_declaration_remove_bloom_hashes (parent->decl, &filter);
+        }
+    }
+}
+
+static void
+gtk_css_node_matches_clear_batch (GtkCssNodeMatches *matches)
+{
+  guint i;
+
+  for (i = 0; i < matches->batch_size; i++)
+    _gtk_css_lookup_destroy (&matches->batch[i].lookup);
+
+  matches->batch_size = 0;
+}
+
+/* Matches the next batch of nodes, starting at @start */
+static void
+gtk_css_node_matches_fill_batch (GtkCssNodeMatches *matches,
+                                 guint              start)
+{
+  gtk_css_node_matches_clear_batch (matches);
+
+  matches->batch_start = start;
+  matches->batch_size = MIN (GTK_CSS_MATCH_BATCH_SIZE, matches->nodes->len - start);
+  matches->n_chunks = (matches->batch_size + GTK_CSS_MATCH_CHUNK_SIZE - 1) / GTK_CSS_MATCH_CHUNK_SIZE;
+  matches->next_chunk = 0;
+
+  gdk_parallel_task_run (gtk_css_node_match_func, matches);
+}
+
+static void
+gtk_css_node_matches_free (GtkCssNodeMatches *matches)
+{
+  gtk_css_node_matches_clear_batch (matches);
+  g_free (matches->batch);
+  g_ptr_array_unref (matches->nodes);
+  g_ptr_array_unref (matches->providers);
+  g_hash_table_unref (matches->positions);
+  g_free (matches);
+}
+
+/* Returns the selector matches for @cssnode if they were
+ * computed ahead of time and are still valid.
+ */
+static GtkCssNodeMatch *
+gtk_css_node_get_match (GtkCssNode       *cssnode,
+                        GtkStyleProvider *provider)
+{
+  guint pos;
+
+  if (node_matches == NULL || node_matches->serial != match_serial)
+    return NULL;
+
+  pos = GPOINTER_TO_UINT (g_hash_table_lookup (node_matches->positions, cssnode));
+  if (pos == 0)
+    return NULL;
+  pos--;
+
+  if (g_ptr_array_index (node_matches->providers, pos) != provider)
+    return NULL;
+
+  if (pos < node_matches->batch_start ||
+      pos >= node_matches->batch_start + node_matches->batch_size)
+    gtk_css_node_matches_fill_batch (node_matches, pos);
+
+  return &node_matches->batch[pos - node_matches->batch_start];
+}
+
 static GtkCssStyle *
 gtk_css_node_create_style (GtkCssNode                   *cssnode,
                            const GtkCountingBloomFilter *filter,
                            GtkCssChange                  change)
 {
   const GtkCssNodeDeclaration *decl;
+  GtkStyleProvider *provider;
+  GtkCssNodeMatch *match;
   GtkCssStyle *style;
   GtkCssChange style_change;
 
@@ -382,10 +530,19 @@ gtk_css_node_create_style (GtkCssNode                   *cssnode,
       style_change = gtk_css_static_style_get_change (gtk_css_style_get_static_style (cssnode->style));
     }
 
-  style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
-                                            filter,
-                                            cssnode,
-                                            style_change);
+  provider = gtk_css_node_get_style_provider (cssnode);
+  match = gtk_css_node_get_match (cssnode, provider);
+
+  if (match)
+    style = gtk_css_static_style_new_compute_for_lookup (provider,
+                                                         cssnode,
+                                                         &match->lookup,
+                                                         style_change ? style_change : match->change);
+  else
+    style = gtk_css_static_style_new_compute (provider,
+                                              filter,
+                                              cssnode,
+                                              style_change);
 
   store_in_global_parent_cache (cssnode, decl, style);
 
@@ -698,6 +855,8 @@ gtk_css_node_reposition (GtkCssNode *node,
   old_parent = node->parent;
   old_previous = node->previous_sibling;
 
+  match_serial++;
+
   /* Take a reference here so the whole function has a reference */
   g_object_ref (node);
 
@@ -1024,6 +1183,7 @@ gtk_css_node_set_visible (GtkCssNode *cssnode,
     return;
 
   cssnode->visible = visible;
+  match_serial++;
   g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_VISIBLE]);
 
   if (cssnode->invalid)
@@ -1087,6 +1247,7 @@ gtk_css_node_set_name (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_set_name (&cssnode->decl, name))
     {
+      match_serial++;
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_NAME);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_NAME]);
     }
@@ -1104,6 +1265,7 @@ gtk_css_node_set_id (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_set_id (&cssnode->decl, id))
     {
+      match_serial++;
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_ID);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_ID]);
     }
@@ -1142,6 +1304,7 @@ gtk_css_node_set_state (GtkCssNode    *cssnode,
                      GTK_STATE_FLAG_SELECTED))
         change |= GTK_CSS_CHANGE_STATE;
 
+      match_serial++;
       gtk_css_node_invalidate (cssnode, change);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_STATE]);
     }
@@ -1158,6 +1321,7 @@ gtk_css_node_clear_classes (GtkCssNode *cssnode)
 {
   if (gtk_css_node_declaration_clear_classes (&cssnode->decl))
     {
+      match_serial++;
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1209,6 +1373,7 @@ gtk_css_node_add_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_add_class (&cssnode->decl, style_class))
     {
+      match_serial++;
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1220,6 +1385,7 @@ gtk_css_node_remove_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_remove_class (&cssnode->decl, style_class))
     {
+      match_serial++;
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1250,6 +1416,7 @@ gtk_css_node_invalidate_style_provider (GtkCssNode *cssnode)
 {
   GtkCssNode *child;
 
+  match_serial++;
   gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
 
   for (child = cssnode->first_child;
@@ -1349,10 +1516,100 @@ gtk_css_node_validate_internal (GtkCssNode             *cssnode,
     gtk_css_node_declaration_remove_bloom_hashes (cssnode->decl, filter);
 }
 
+/* Collects the nodes that will likely need a new static style when
+ * validating, using the same rules as gtk_css_node_real_update_style()
+ * and gtk_css_node_propagate_pending_changes(). It's only a guess,
+ * nodes that are missed are matched when their style is created.
+ *
+ * Returns: %TRUE if @cssnode will need a new style
+ */
+static gboolean
+gtk_css_node_collect_matches (GtkCssNode                  *cssnode,
+                              GtkCssChange                 parent_change,
+                              const GtkCssNodeDeclaration *sibling_decl,
+                              GtkCssNodeMatches           *matches)
+{
+  const GtkCssNodeDeclaration *child_decl;
+  GtkCssChange change, child_change, sibling_change;
+  GtkCssNode *child;
+  gboolean restyle;
+
+  if (!cssnode->invalid && parent_change == 0)
+    return FALSE;
+
+  change = cssnode->pending_changes | parent_change;
+  restyle = (cssnode->style_is_invalid || parent_change) &&
+            gtk_css_style_needs_recreation (GTK_CSS_STYLE (gtk_css_style_get_static_style (cssnode->style)), change);
+
+  if (restyle)
+    {
+      /* Siblings with the same declaration will likely find
+       * their style in the parent's cache, don't match them.
+       */
+      if (sibling_decl == NULL ||
+          !gtk_css_node_declaration_equal (sibling_decl, cssnode->decl))
+        {
+          g_ptr_array_add (matches->nodes, cssnode);
+          g_ptr_array_add (matches->providers, gtk_css_node_get_style_provider (cssnode));
+          g_hash_table_insert (matches->positions, cssnode, GUINT_TO_POINTER (matches->nodes->len));
+        }
+
+      child_change = _gtk_css_change_for_child (change) | GTK_CSS_CHANGE_PARENT_STYLE;
+    }
+  else
+    {
+      child_change = _gtk_css_change_for_child (change);
+    }
+
+  sibling_change = 0;
+  child_decl = NULL;
+  for (child = gtk_css_node_get_first_child (cssnode);
+       child;
+       child = gtk_css_node_get_next_sibling (child))
+    {
+      if (!child->visible)
+        continue;
+
+      if (gtk_css_node_collect_matches (child, child_change | sibling_change, child_decl, matches))
+        child_decl = child->decl;
+      else
+        child_decl = NULL;
+
+      sibling_change |= _gtk_css_change_for_sibling (child->pending_changes);
+    }
+
+  return restyle;
+}
+
+static GtkCssNodeMatches *
+gtk_css_node_matches_new (GtkCssNode *cssnode)
+{
+  GtkCssNodeMatches *matches;
+
+  matches = g_new0 (GtkCssNodeMatches, 1);
+  matches->serial = match_serial;
+  matches->nodes = g_ptr_array_new ();
+  matches->providers = g_ptr_array_new ();
+  matches->positions = g_hash_table_new (NULL, NULL);
+
+  gtk_css_node_collect_matches (cssnode, 0, NULL, matches);
+
+  if (matches->nodes->len < GTK_CSS_MATCH_PARALLEL_MIN_NODES)
+    {
+      gtk_css_node_matches_free (matches);
+      return NULL;
+    }
+
+  matches->batch = g_new (GtkCssNodeMatch, GTK_CSS_MATCH_BATCH_SIZE);
+
+  return matches;
+}
+
 void
 gtk_css_node_validate (GtkCssNode *cssnode)
 {
   GtkCountingBloomFilter filter = GTK_COUNTING_BLOOM_FILTER_INIT;
+  GtkCssNodeMatches *matches = NULL;
   gint64 timestamp;
   gint64 before G_GNUC_UNUSED;
 
@@ -1362,7 +1619,18 @@ gtk_css_node_validate (GtkCssNode *cssnode)
 
   timestamp = gtk_css_node_get_timestamp (cssnode);
 
+  if (node_matches == NULL && cssnode->invalid)
+    node_matches = matches = gtk_css_node_matches_new (cssnode);
+
+  gtk_css_animated_style_begin_sharing ();
   gtk_css_node_validate_internal (cssnode, &filter, timestamp);
+  gtk_css_animated_style_end_sharing ();
+
+  if (matches)
+    {
+      gtk_css_node_matches_free (matches);
+      node_matches = NULL;
+    }
 
   if (GDK_PROFILER_IS_RUNNING)
     {
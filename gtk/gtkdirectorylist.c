@@ -19,7 +19,7 @@
 
 #include "config.h"
 
-#include "gtkdirectorylist.h"
+#include "gtkdirectorylistprivate.h"
 
 #include "gtkprivate.h"
 
@@ -42,6 +42,9 @@
  * If loading fails at any point, the [property@Gtk.DirectoryList:error]
  * property will be set to give more indication about the failure.
  *
+ * To keep the overhead low for big directories, files are not added as
+ * soon as they are loaded, but collected and added in bigger batches.
+ *
  * The `GFileInfo`s returned from a `GtkDirectoryList` have the "standard::file"
  * attribute set to the `GFile` they refer to. This way you can get at the file
  * that is referred to in the same way you would via g_file_enumerator_get_child().
@@ -52,6 +55,10 @@
 
 /* random number that everyone else seems to use, too */
 #define FILES_PER_QUERY 100
+/* We double the query size every time a query comes back full */
+#define MAX_FILES_PER_QUERY (128 * FILES_PER_QUERY)
+/* Loaded files are collected and added in one go at this interval */
+#define PUBLISH_INTERVAL_MS 100
 
 enum {
   PROP_0,
@@ -100,6 +107,14 @@ struct _GtkDirectoryList
   GError *error; /* Error while loading */
   GSequence *items; /* Use GPtrArray or GListStore here? */
   GQueue events;
+
+  guint query_size; /* files in the first query, or 0 for the default */
+  guint files_per_query;
+  guint n_queries;
+  GPtrArray *pending; /* loaded, but not yet in items */
+  guint publish_interval; /* in ms */
+  guint publish_source;
+  gint64 last_publish;
 };
 
 struct _GtkDirectoryListClass
@@ -253,6 +268,14 @@ gtk_directory_list_stop_monitoring (GtkDirectoryList *self)
   g_clear_object (&self->monitor);
 }
 
+static void
+gtk_directory_list_clear_pending (GtkDirectoryList *self)
+{
+  g_clear_handle_id (&self->publish_source, g_source_remove);
+  if (self->pending)
+    g_ptr_array_set_size (self->pending, 0);
+}
+
 static void
 gtk_directory_list_dispose (GObject *object)
 {
@@ -265,7 +288,9 @@ gtk_directory_list_dispose (GObject *object)
   g_clear_pointer (&self->attributes, g_free);
 
   g_clear_error (&self->error);
+  gtk_directory_list_clear_pending (self);
   g_clear_pointer (&self->items, g_sequence_free);
+  g_clear_pointer (&self->pending, g_ptr_array_unref);
 
   g_queue_foreach (&self->events, (GFunc) free_queued_event, NULL);
   g_queue_clear (&self->events);
@@ -373,6 +398,8 @@ static void
 gtk_directory_list_init (GtkDirectoryList *self)
 {
   self->items = g_sequence_new (g_object_unref);
+  self->pending = g_ptr_array_new_with_free_func (g_object_unref);
+  self->publish_interval = PUBLISH_INTERVAL_MS;
   self->io_priority = G_PRIORITY_DEFAULT;
   self->monitored = TRUE;
   g_queue_init (&self->events);
@@ -402,11 +429,72 @@ gtk_directory_list_new (const char *attributes,
                        NULL);
 }
 
+static void
+gtk_directory_list_publish (GtkDirectoryList *self)
+{
+  guint i, position;
+
+  g_clear_handle_id (&self->publish_source, g_source_remove);
+  self->last_publish = g_get_monotonic_time ();
+
+  if (self->pending->len == 0)
+    return;
+
+  position = g_sequence_get_length (self->items);
+  for (i = 0; i < self->pending->len; i++)
+    g_sequence_append (self->items, g_object_ref (g_ptr_array_index (self->pending, i)));
+
+  g_list_model_items_changed (G_LIST_MODEL (self), position, 0, self->pending->len);
+  g_ptr_array_set_size (self->pending, 0);
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
+}
+
+static gboolean
+gtk_directory_list_publish_cb (gpointer data)
+{
+  GtkDirectoryList *self = data;
+
+  self->publish_source = 0;
+  gtk_directory_list_publish (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Emitting items-changed for every query is expensive for big
+ * directories, as everybody downstream (sorting, filtering, the
+ * views) has to process every one of those. So we collect files
+ * and only publish them every publish_interval ms.
+ */
+static void
+gtk_directory_list_queue_publish (GtkDirectoryList *self)
+{
+  gint64 elapsed;
+
+  if (self->publish_source != 0)
+    return;
+
+  elapsed = (g_get_monotonic_time () - self->last_publish) / 1000;
+  if (self->last_publish == 0 || elapsed >= self->publish_interval)
+    {
+      gtk_directory_list_publish (self);
+      return;
+    }
+
+  self->publish_source = g_timeout_add_full (self->io_priority,
+                                             self->publish_interval - elapsed,
+                                             gtk_directory_list_publish_cb,
+                                             self,
+                                             NULL);
+  gdk_source_set_static_name_by_id (self->publish_source, "[gtk] gtk_directory_list_publish_cb");
+}
+
 static void
 gtk_directory_list_clear_items (GtkDirectoryList *self)
 {
   guint n_items;
 
+  gtk_directory_list_clear_pending (self);
+
   n_items = g_sequence_get_length (self->items);
   if (n_items > 0)
     {
@@ -461,6 +549,8 @@ gtk_directory_list_got_files_cb (GObject      *source,
 
       g_object_freeze_notify (G_OBJECT (self));
 
+      gtk_directory_list_publish (self);
+
       g_clear_object (&self->cancellable);
       g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_LOADING]);
 
@@ -484,23 +574,24 @@ gtk_directory_list_got_files_cb (GObject      *source,
       file = g_file_enumerator_get_child (enumerator, info);
       g_file_info_set_attribute_object (info, "standard::file", G_OBJECT (file));
       g_object_unref (file);
-      g_sequence_append (self->items, info);
+      g_ptr_array_add (self->pending, info);
       n++;
     }
   g_list_free (files);
 
+  /* Fewer, bigger queries are a lot faster for big directories */
+  if (n >= self->files_per_query)
+    self->files_per_query = MIN (2 * self->files_per_query, MAX_FILES_PER_QUERY);
+
+  self->n_queries++;
   g_file_enumerator_next_files_async (enumerator,
-                                      g_file_is_native (self->file) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY,
+                                      self->files_per_query,
                                       self->io_priority,
                                       self->cancellable,
                                       gtk_directory_list_got_files_cb,
                                       self);
 
-  if (n > 0)
-    {
-      g_list_model_items_changed (G_LIST_MODEL (self), g_sequence_get_length (self->items) - n, 0, n);
-      g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
-    }
+  gtk_directory_list_queue_publish (self);
 }
 
 static void
@@ -531,8 +622,9 @@ gtk_directory_list_got_enumerator_cb (GObject      *source,
       return;
     }
 
+  self->n_queries++;
   g_file_enumerator_next_files_async (enumerator,
-                                      g_file_is_native (file) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY,
+                                      self->files_per_query,
                                       self->io_priority,
                                       self->cancellable,
                                       gtk_directory_list_got_files_cb,
@@ -558,6 +650,12 @@ gtk_directory_list_start_loading (GtkDirectoryList *self)
 
   glib_apis_suck = g_strconcat ("standard::name,", self->attributes, NULL);
   self->cancellable = g_cancellable_new ();
+  if (self->query_size > 0)
+    self->files_per_query = self->query_size;
+  else
+    self->files_per_query = g_file_is_native (self->file) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY;
+  self->n_queries = 0;
+  self->last_publish = 0;
   g_file_enumerate_children_async (self->file,
                                    glib_apis_suck,
                                    G_FILE_QUERY_INFO_NONE,
@@ -664,6 +762,9 @@ handle_events (GtkDirectoryList *self)
 {
   QueuedEvent *event;
 
+  /* Make sure events see all files we know about */
+  gtk_directory_list_publish (self);
+
   do
     {
       event = g_queue_peek_tail (&self->events);
@@ -1046,3 +1147,57 @@ gtk_directory_list_get_monitored (GtkDirectoryList *self)
 
   return self->monitored;
 }
+
+/*<private>
+ * gtk_directory_list_set_query_size:
+ * @self: a `GtkDirectoryList`
+ * @query_size: the number of files to ask for in the first query,
+ *   or 0 for the default
+ *
+ * Sets the size of the first query when loading starts the next
+ * time. This is meant for tests, so they can load a directory in
+ * many small queries.
+ */
+void
+gtk_directory_list_set_query_size (GtkDirectoryList *self,
+                                   guint             query_size)
+{
+  g_return_if_fail (GTK_IS_DIRECTORY_LIST (self));
+
+  self->query_size = query_size;
+}
+
+/*<private>
+ * gtk_directory_list_set_publish_interval:
+ * @self: a `GtkDirectoryList`
+ * @interval: the minimum time between two additions of loaded
+ *   files, in milliseconds
+ *
+ * Sets how long loaded files are collected before they are added.
+ * The files of the first query are always added right away, and
+ * files that are still collected when loading is done are added
+ * then. This is meant for tests, so they don't depend on how fast
+ * the directory can be read.
+ */
+void
+gtk_directory_list_set_publish_interval (GtkDirectoryList *self,
+                                         guint             interval)
+{
+  g_return_if_fail (GTK_IS_DIRECTORY_LIST (self));
+
+  self->publish_interval = interval;
+}
+
+/*<private>
+ * gtk_directory_list_get_n_queries:
+ * @self: a `GtkDirectoryList`
+ *
+ * Returns: the number of queries made since loading last started
+ */
+guint
+gtk_directory_list_get_n_queries (GtkDirectoryList *self)
+{
+  g_return_val_if_fail (GTK_IS_DIRECTORY_LIST (self), 0);
+
+  return self->n_queries;
+}
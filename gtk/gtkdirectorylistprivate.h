@@ -0,0 +1,30 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "gtkdirectorylist.h"
+
+G_BEGIN_DECLS
+
+void                    gtk_directory_list_set_query_size       (GtkDirectoryList       *self,
+                                                                 guint                   query_size);
+void                    gtk_directory_list_set_publish_interval (GtkDirectoryList       *self,
+                                                                 guint                   interval);
+guint                   gtk_directory_list_get_n_queries        (GtkDirectoryList       *self);
+
+G_END_DECLS
@@ -490,3 +490,28 @@ _gtk_file_info_get_file (GFileInfo *info)
 
   return G_FILE (g_file_info_get_attribute_object (info, "standard::file"));
 }
+
+/* The collation key of the display name, for sorting by name.
+ *
+ * GtkFileSystemModel computes it in the thread that enumerates the
+ * directory, for everything else we compute it on first use.
+ */
+const char *
+_gtk_file_info_get_collate_key (GFileInfo *info)
+{
+  const char *key;
+  char *new_key;
+
+  key = g_file_info_get_attribute_string (info, "filechooser::collate-key");
+  if (key)
+    return key;
+
+  if (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME))
+    return NULL;
+
+  new_key = g_utf8_collate_key_for_filename (g_file_info_get_display_name (info), -1);
+  g_file_info_set_attribute_string (info, "filechooser::collate-key", new_key);
+  g_free (new_key);
+
+  return g_file_info_get_attribute_string (info, "filechooser::collate-key");
+}
@@ -58,6 +58,7 @@ GIcon *         _gtk_file_info_get_icon    (GFileInfo    *info,
                                             GtkIconTheme *icon_theme);
 
 GFile *         _gtk_file_info_get_file (GFileInfo *info);
+const char *    _gtk_file_info_get_collate_key (GFileInfo *info);
 
 G_END_DECLS
 
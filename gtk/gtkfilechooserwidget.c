@@ -6985,19 +6985,9 @@ name_sort_func (gconstpointer a,
                 gconstpointer b,
                 gpointer      user_data)
 {
-  char *key_a, *key_b;
-  GtkOrdering result;
-
-  /* FIXME: use sortkeys for these */
-  key_a = g_utf8_collate_key_for_filename (g_file_info_get_display_name ((GFileInfo *)a), -1);
-  key_b = g_utf8_collate_key_for_filename (g_file_info_get_display_name ((GFileInfo *)b), -1);
-
-  result = g_strcmp0 (key_a, key_b);
-
-  g_free (key_a);
-  g_free (key_b);
-
-  return result;
+  /* The keys are usually computed while loading the directory */
+  return gtk_ordering_from_cmpfunc (g_strcmp0 (_gtk_file_info_get_collate_key ((GFileInfo *)a),
+                                               _gtk_file_info_get_collate_key ((GFileInfo *)b)));
 }
 
 static GtkOrdering
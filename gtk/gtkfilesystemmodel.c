@@ -36,6 +36,13 @@
 
 /* random number that everyone else seems to use, too */
 #define FILES_PER_QUERY 100
+#define MAX_FILES_PER_QUERY (128 * FILES_PER_QUERY)
+
+/* While loading, updates are collected for this long. This grows
+ * while loading, so huge directories get fewer, bigger updates.
+ */
+#define MIN_THAW_INTERVAL_MS 50
+#define MAX_THAW_INTERVAL_MS 400
 
 typedef struct _FileModelNode           FileModelNode;
 
@@ -74,6 +81,9 @@ struct _GtkFileSystemModel
   GtkFileFilter *       filter;         /* filter to use for deciding which nodes are visible */
 
   guint                 frozen;         /* number of times we're frozen */
+  guint                 first_frozen_add; /* index of the first node with frozen_add set, or G_MAXUINT */
+  guint                 files_per_query; /* number of files to ask for in the next query */
+  guint                 thaw_interval;  /* ms to wait before unfreezing the model while loading */
 
   unsigned int          filter_on_thaw   : 1; /* set when filtering needs to happen upon thawing */
   unsigned int          show_hidden      : 1; /* whether to show hidden files */
@@ -410,7 +420,8 @@ thaw_updates (GtkFileSystemModel *model)
       guint i;
       guint changed_idx = G_MAXUINT;
 
-      for (i = 0; i < model->files->len; i++)
+      /* Files are only ever appended, so no need to look at older ones */
+      for (i = MIN (model->first_frozen_add, model->files->len); i < model->files->len; i++)
         {
           FileModelNode *node = get_node (model, i);
 
@@ -423,6 +434,8 @@ thaw_updates (GtkFileSystemModel *model)
             changed_idx = i;
         }
 
+      model->first_frozen_add = G_MAXUINT;
+
       if (changed_idx != G_MAXUINT)
         g_list_model_items_changed (G_LIST_MODEL (model), changed_idx,
                                     model->files->len - changed_idx,
@@ -456,6 +469,9 @@ add_file (GtkFileSystemModel *model,
 
   position = model->files->len - 1;
 
+  if (model->frozen && model->first_frozen_add == G_MAXUINT)
+    model->first_frozen_add = position;
+
   if (!model->frozen)
     {
       node_compute_visibility_and_filters (model, position);
@@ -506,6 +522,9 @@ remove_file (GtkFileSystemModel *model,
   g_clear_object (&node->file);
   adjust_file_lookup (model, id, -1);
 
+  if (model->first_frozen_add != G_MAXUINT && id < model->first_frozen_add)
+    model->first_frozen_add--;
+
   g_clear_object (&node->info);
 
   g_array_remove_index (model->files, id);
@@ -580,6 +599,9 @@ gtk_file_system_model_init (GtkFileSystemModel *model)
 
   model->file_lookup = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
   model->cancellable = g_cancellable_new ();
+  model->first_frozen_add = G_MAXUINT;
+  model->files_per_query = FILES_PER_QUERY;
+  model->thaw_interval = MIN_THAW_INTERVAL_MS;
 }
 
 /*** API ***/
@@ -599,10 +621,90 @@ thaw_func (gpointer data)
 
   thaw_updates (model);
   model->dir_thaw_source = 0;
+  model->thaw_interval = MIN (2 * model->thaw_interval, MAX_THAW_INTERVAL_MS);
 
   return FALSE;
 }
 
+static void
+free_file_infos (gpointer data)
+{
+  g_list_free_full (data, g_object_unref);
+}
+
+/* Like g_file_enumerator_next_files_async(), but we also compute
+ * the collation keys while we're in the thread, so sorting by name
+ * does not have to do it on the main thread.
+ *
+ * Like it, an error after the first file is kept on the enumerator
+ * and returned by the next call, so the files we read aren't lost.
+ */
+static void
+next_files_thread (GTask        *task,
+                   gpointer      source_object,
+                   gpointer      task_data,
+                   GCancellable *cancellable)
+{
+  GFileEnumerator *enumerator = source_object;
+  guint i, n_files = GPOINTER_TO_UINT (task_data);
+  GList *files = NULL;
+  GError *error = NULL;
+
+  error = g_object_steal_data (G_OBJECT (enumerator), "gtk-pending-error");
+  if (error)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  for (i = 0; i < n_files; i++)
+    {
+      GFileInfo *info;
+
+      info = g_file_enumerator_next_file (enumerator, cancellable, &error);
+      if (info == NULL)
+        break;
+
+      _gtk_file_info_get_collate_key (info);
+      files = g_list_prepend (files, info);
+    }
+
+  if (error)
+    {
+      if (files == NULL)
+        {
+          g_task_return_error (task, error);
+          return;
+        }
+
+      /* Never keep cancellation around for the next call */
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_error_free (error);
+      else
+        g_object_set_data_full (G_OBJECT (enumerator), "gtk-pending-error",
+                                error, (GDestroyNotify) g_error_free);
+    }
+
+  g_task_return_pointer (task, g_list_reverse (files), free_file_infos);
+}
+
+static void
+next_files_async (GFileEnumerator     *enumerator,
+                  guint                n_files,
+                  GCancellable        *cancellable,
+                  GAsyncReadyCallback  callback,
+                  gpointer             user_data)
+{
+  GTask *task;
+
+  task = g_task_new (enumerator, cancellable, callback, user_data);
+  g_task_set_source_tag (task, next_files_async);
+  g_task_set_priority (task, IO_PRIORITY);
+  g_task_set_task_data (task, GUINT_TO_POINTER (n_files), NULL);
+  g_task_run_in_thread (task, next_files_thread);
+  g_object_unref (task);
+}
+
 static void
 gtk_file_system_model_got_files (GObject      *object,
                                  GAsyncResult *res,
@@ -613,20 +715,24 @@ gtk_file_system_model_got_files (GObject      *object,
   GList *walk, *files;
   GError *error = NULL;
 
-  files = g_file_enumerator_next_files_finish (enumerator, res, &error);
+  files = g_task_propagate_pointer (G_TASK (res), &error);
 
   if (files)
     {
       if (model->dir_thaw_source == 0)
         {
           freeze_updates (model);
-          model->dir_thaw_source = g_timeout_add_full (IO_PRIORITY + 1, 50,
+          model->dir_thaw_source = g_timeout_add_full (IO_PRIORITY + 1, model->thaw_interval,
                                                        thaw_func,
                                                        model,
                                                        NULL);
           gdk_source_set_static_name_by_id (model->dir_thaw_source, "[gtk] thaw_func");
         }
 
+      /* We got all we asked for, so ask for more next time */
+      if (g_list_length (files) >= model->files_per_query)
+        model->files_per_query = MIN (2 * model->files_per_query, MAX_FILES_PER_QUERY);
+
       for (walk = files; walk; walk = walk->next)
         {
           const char *name;
@@ -648,12 +754,11 @@ gtk_file_system_model_got_files (GObject      *object,
         }
       g_list_free (files);
 
-      g_file_enumerator_next_files_async (enumerator,
-                                          g_file_is_native (model->dir) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY,
-                                          IO_PRIORITY,
-                                          model->cancellable,
-                                          gtk_file_system_model_got_files,
-                                          model);
+      next_files_async (enumerator,
+                        model->files_per_query,
+                        model->cancellable,
+                        gtk_file_system_model_got_files,
+                        model);
     }
   else
     {
@@ -793,12 +898,14 @@ gtk_file_system_model_got_enumerator (GObject *dir, GAsyncResult *res, gpointer
     }
   else
     {
-      g_file_enumerator_next_files_async (enumerator,
-                                          g_file_is_native (model->dir) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY,
-                                          IO_PRIORITY,
-                                          model->cancellable,
-                                          gtk_file_system_model_got_files,
-                                          model);
+      if (g_file_is_native (model->dir))
+        model->files_per_query = 50 * FILES_PER_QUERY;
+
+      next_files_async (enumerator,
+                        model->files_per_query,
+                        model->cancellable,
+                        gtk_file_system_model_got_files,
+                        model);
       g_object_unref (enumerator);
       model->dir_monitor = g_file_monitor_directory (model->dir,
                                                      G_FILE_MONITOR_NONE,
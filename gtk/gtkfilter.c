@@ -19,7 +19,7 @@
 
 #include "config.h"
 
-#include "gtkfilter.h"
+#include "gtkfilterprivate.h"
 
 #include "gtktypebuiltins.h"
 #include "gtkprivate.h"
@@ -47,12 +47,19 @@
  * also possible to subclass `GtkFilter` and provide one's own filter.
  */
 
+typedef struct _GtkFilterPrivate GtkFilterPrivate;
+
+struct _GtkFilterPrivate
+{
+  GtkFilterKeys *keys;
+};
+
 enum {
   CHANGED,
   LAST_SIGNAL
 };
 
-G_DEFINE_TYPE (GtkFilter, gtk_filter, G_TYPE_OBJECT)
+G_DEFINE_TYPE_WITH_PRIVATE (GtkFilter, gtk_filter, G_TYPE_OBJECT)
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
@@ -71,11 +78,24 @@ gtk_filter_default_get_strictness (GtkFilter *self)
   return GTK_FILTER_MATCH_SOME;
 }
 
+static void
+gtk_filter_dispose (GObject *object)
+{
+  GtkFilter *self = GTK_FILTER (object);
+  GtkFilterPrivate *priv = gtk_filter_get_instance_private (self);
+
+  g_clear_pointer (&priv->keys, gtk_filter_keys_unref);
+
+  G_OBJECT_CLASS (gtk_filter_parent_class)->dispose (object);
+}
+
 static void
 gtk_filter_class_init (GtkFilterClass *class)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
+  gobject_class->dispose = gtk_filter_dispose;
+
   class->match = gtk_filter_default_match;
   class->get_strictness = gtk_filter_default_get_strictness;
 
@@ -185,3 +205,75 @@ gtk_filter_changed (GtkFilter       *self,
   g_signal_emit (self, signals[CHANGED], 0, change);
 }
 
+/*<private>
+ * gtk_filter_get_keys:
+ * @self: a `GtkFilter`
+ *
+ * Gets the `GtkFilterKeys` that can be used to cache the expensive
+ * part of matching items with @self.
+ *
+ * The filter keys can change every time [signal@Gtk.Filter::changed]
+ * is emitted. When gtk_filter_keys_is_compatible() returns %TRUE for
+ * the old and new keys, keys that were created previously can be
+ * reused.
+ *
+ * Returns: (transfer full) (nullable): the filter keys or %NULL if
+ *   the filter does not support them
+ */
+GtkFilterKeys *
+gtk_filter_get_keys (GtkFilter *self)
+{
+  GtkFilterPrivate *priv = gtk_filter_get_instance_private (self);
+
+  g_return_val_if_fail (GTK_IS_FILTER (self), NULL);
+
+  if (priv->keys == NULL)
+    return NULL;
+
+  return gtk_filter_keys_ref (priv->keys);
+}
+
+/*<private>
+ * gtk_filter_set_keys:
+ * @self: a `GtkFilter`
+ * @keys: (nullable) (transfer full): New keys to use
+ *
+ * Updates the filter's keys to @keys without emitting
+ * [signal@Gtk.Filter::changed].
+ *
+ * Use this when a change does not affect the filter's
+ * results, but does affect the keys.
+ */
+void
+gtk_filter_set_keys (GtkFilter     *self,
+                     GtkFilterKeys *keys)
+{
+  GtkFilterPrivate *priv = gtk_filter_get_instance_private (self);
+
+  g_return_if_fail (GTK_IS_FILTER (self));
+
+  g_clear_pointer (&priv->keys, gtk_filter_keys_unref);
+  priv->keys = keys;
+}
+
+/*<private>
+ * gtk_filter_changed_with_keys:
+ * @self: a `GtkFilter`
+ * @change: How the filter changed
+ * @keys: (nullable) (transfer full): New keys to use
+ *
+ * Updates the filter's keys to @keys and then calls gtk_filter_changed().
+ *
+ * If you do not want to update the keys, call that function instead.
+ */
+void
+gtk_filter_changed_with_keys (GtkFilter       *self,
+                              GtkFilterChange  change,
+                              GtkFilterKeys   *keys)
+{
+  g_return_if_fail (GTK_IS_FILTER (self));
+
+  gtk_filter_set_keys (self, keys);
+
+  gtk_filter_changed (self, change);
+}
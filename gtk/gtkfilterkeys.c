@@ -0,0 +1,118 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkfilterkeysprivate.h"
+
+/*<private>
+ * GtkFilterKeys:
+ *
+ * Filter keys are the filtering equivalent of `GtkSortKeys`.
+ *
+ * A filter can provide them to allow filter models to cache the
+ * expensive part of matching an item - like looking up properties
+ * and normalizing strings - in a key per item. When the filter
+ * changes in a way that keeps the keys compatible, only the cheap
+ * match_key() needs to be run again.
+ */
+
+GtkFilterKeys *
+gtk_filter_keys_alloc (const GtkFilterKeysClass *klass,
+                       gsize                     size,
+                       gsize                     key_size,
+                       gsize                     key_align)
+{
+  GtkFilterKeys *self;
+
+  g_return_val_if_fail (key_align > 0, NULL);
+
+  self = g_malloc0 (size);
+
+  self->klass = klass;
+  self->ref_count = 1;
+
+  self->key_size = key_size;
+  self->key_align = key_align;
+
+  return self;
+}
+
+GtkFilterKeys *
+gtk_filter_keys_ref (GtkFilterKeys *self)
+{
+  self->ref_count += 1;
+
+  return self;
+}
+
+void
+gtk_filter_keys_unref (GtkFilterKeys *self)
+{
+  self->ref_count -= 1;
+  if (self->ref_count > 0)
+    return;
+
+  self->klass->free (self);
+}
+
+gsize
+gtk_filter_keys_get_key_size (GtkFilterKeys *self)
+{
+  return self->key_size;
+}
+
+gsize
+gtk_filter_keys_get_key_align (GtkFilterKeys *self)
+{
+  return self->key_align;
+}
+
+gboolean
+gtk_filter_keys_is_compatible (GtkFilterKeys *self,
+                               GtkFilterKeys *other)
+{
+  if (self == other)
+    return TRUE;
+
+  return self->klass->is_compatible (self, other);
+}
+
+gboolean
+gtk_filter_keys_needs_clear_key (GtkFilterKeys *self)
+{
+  return self->klass->clear_key != NULL;
+}
+
+/*<private>
+ * gtk_filter_keys_is_threadsafe:
+ * @self: a `GtkFilterKeys`
+ *
+ * Checks if keys can be matched from other threads than the
+ * main thread. This is the case for filters that do not have
+ * any side effects and only look at the key.
+ *
+ * Creating keys with gtk_filter_keys_init_key() must always
+ * happen on the main thread.
+ *
+ * Returns: %TRUE if the keys are threadsafe
+ **/
+gboolean
+gtk_filter_keys_is_threadsafe (GtkFilterKeys *self)
+{
+  return self->threadsafe;
+}
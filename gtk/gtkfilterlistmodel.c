@@ -22,9 +22,28 @@
 #include "gtkfilterlistmodel.h"
 
 #include "gtkbitset.h"
+#include "gtkfilterprivate.h"
 #include "gtkprivate.h"
 #include "gtksectionmodelprivate.h"
 
+#include "gdk/gdkparalleltaskprivate.h"
+
+/* Number of items checked per step when filtering incrementally */
+#define GTK_FILTER_STEP_ITEMS (512)
+
+/* Number of items checked per step when the filter provides keys.
+ *
+ * Once the keys exist, matching them is cheap, so we can do a lot
+ * more work per step.
+ */
+#define GTK_FILTER_STEP_KEYS (8192)
+
+/* Minimum number of keys before we match them in parallel
+ * and the number of keys a thread matches at once.
+ */
+#define GTK_FILTER_PARALLEL_MIN_ITEMS (4096)
+#define GTK_FILTER_PARALLEL_CHUNK_SIZE (1024)
+
 /**
  * GtkFilterListModel:
  *
@@ -38,6 +57,12 @@
  * filtering long lists doesn't block the UI. See
  * [method@Gtk.FilterListModel.set_incremental] for details.
  *
+ * Some filters, like [class@Gtk.StringFilter], let the model cache the
+ * data they compute for every item, so that changing the search does not
+ * need to look at the items again. Like with [class@Gtk.SortListModel],
+ * changes to items that are not signaled with [signal@Gio.ListModel::items-changed]
+ * may then not be picked up until the filter changes in an incompatible way.
+ *
  * `GtkFilterListModel` passes through sections from the underlying model.
  */
 
@@ -64,6 +89,12 @@ struct _GtkFilterListModel
   GtkBitset *matches; /* NULL if strictness != GTK_FILTER_MATCH_SOME */
   GtkBitset *pending; /* not yet filtered items or NULL if all filtered */
   guint pending_cb; /* idle callback handle */
+
+  GtkFilterKeys *filter_keys; /* NULL if the filter doesn't provide keys */
+  gsize key_size;
+  gpointer keys; /* one key per item in model */
+  guint n_keys;
+  GtkBitset *missing_keys;
 };
 
 struct _GtkFilterListModelClass
@@ -233,6 +264,196 @@ G_DEFINE_TYPE_WITH_CODE (GtkFilterListModel, gtk_filter_list_model, G_TYPE_OBJEC
                          G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, gtk_filter_list_model_model_init)
                          G_IMPLEMENT_INTERFACE (GTK_TYPE_SECTION_MODEL, gtk_filter_list_model_section_model_init))
 
+static gpointer
+key_from_pos (GtkFilterListModel *self,
+              guint               pos)
+{
+  return (char *) self->keys + self->key_size * pos;
+}
+
+static void
+gtk_filter_list_model_clear_key_range (GtkFilterListModel *self,
+                                       guint               position,
+                                       guint               n_items)
+{
+  GtkBitsetIter iter;
+  GtkBitset *clear;
+  guint pos;
+
+  if (!gtk_filter_keys_needs_clear_key (self->filter_keys))
+    return;
+
+  clear = gtk_bitset_new_range (position, n_items);
+  gtk_bitset_subtract (clear, self->missing_keys);
+
+  for (gtk_bitset_iter_init_first (&iter, clear, &pos);
+       gtk_bitset_iter_is_valid (&iter);
+       gtk_bitset_iter_next (&iter, &pos))
+    {
+      gtk_filter_keys_clear_key (self->filter_keys, key_from_pos (self, pos));
+    }
+
+  gtk_bitset_unref (clear);
+}
+
+static void
+gtk_filter_list_model_clear_keys (GtkFilterListModel *self)
+{
+  if (self->filter_keys == NULL)
+    return;
+
+  gtk_filter_list_model_clear_key_range (self, 0, self->n_keys);
+
+  g_clear_pointer (&self->missing_keys, gtk_bitset_unref);
+  g_clear_pointer (&self->keys, g_free);
+  g_clear_pointer (&self->filter_keys, gtk_filter_keys_unref);
+  self->key_size = 0;
+  self->n_keys = 0;
+}
+
+/* Gets the current keys from the filter. If they are compatible
+ * with the keys we have, the existing keys are kept.
+ */
+static void
+gtk_filter_list_model_update_keys (GtkFilterListModel *self)
+{
+  GtkFilterKeys *keys;
+
+  if (self->filter == NULL || self->model == NULL)
+    keys = NULL;
+  else
+    keys = gtk_filter_get_keys (self->filter);
+
+  if (keys == NULL)
+    {
+      gtk_filter_list_model_clear_keys (self);
+      return;
+    }
+
+  if (self->filter_keys && gtk_filter_keys_is_compatible (keys, self->filter_keys))
+    {
+      gtk_filter_keys_unref (self->filter_keys);
+      self->filter_keys = keys;
+      return;
+    }
+
+  gtk_filter_list_model_clear_keys (self);
+
+  self->filter_keys = keys;
+  self->key_size = GTK_FILTER_KEYS_ALIGN (gtk_filter_keys_get_key_size (keys),
+                                          gtk_filter_keys_get_key_align (keys));
+  self->n_keys = g_list_model_get_n_items (self->model);
+  self->keys = g_malloc_n (self->n_keys, self->key_size);
+  self->missing_keys = gtk_bitset_new_range (0, self->n_keys);
+}
+
+static void
+gtk_filter_list_model_splice_keys (GtkFilterListModel *self,
+                                   guint               position,
+                                   guint               removed,
+                                   guint               added)
+{
+  if (self->filter_keys == NULL)
+    return;
+
+  gtk_filter_list_model_clear_key_range (self, position, removed);
+
+  if (removed > added)
+    {
+      memmove (key_from_pos (self, position + added),
+               key_from_pos (self, position + removed),
+               self->key_size * (self->n_keys - position - removed));
+      self->keys = g_realloc_n (self->keys, self->n_keys - removed + added, self->key_size);
+    }
+  else if (removed < added)
+    {
+      self->keys = g_realloc_n (self->keys, self->n_keys - removed + added, self->key_size);
+      memmove (key_from_pos (self, position + added),
+               key_from_pos (self, position + removed),
+               self->key_size * (self->n_keys - position - removed));
+    }
+
+  gtk_bitset_splice (self->missing_keys, position, removed, added);
+  gtk_bitset_add_range (self->missing_keys, position, added);
+
+  self->n_keys = self->n_keys - removed + added;
+}
+
+typedef struct _MatchKeysData MatchKeysData;
+struct _MatchKeysData
+{
+  GtkFilterListModel *self;
+  GArray *positions;
+  guint8 *results;
+  int n_chunks;
+  int next_chunk;
+};
+
+static void
+gtk_filter_list_model_match_keys_func (gpointer data)
+{
+  MatchKeysData *mk = data;
+  GtkFilterListModel *self = mk->self;
+  int chunk;
+
+  for (chunk = g_atomic_int_add (&mk->next_chunk, 1);
+       chunk < mk->n_chunks;
+       chunk = g_atomic_int_add (&mk->next_chunk, 1))
+    {
+      guint i, end;
+
+      end = MIN ((guint) (chunk + 1) * GTK_FILTER_PARALLEL_CHUNK_SIZE, mk->positions->len);
+      for (i = chunk * GTK_FILTER_PARALLEL_CHUNK_SIZE; i < end; i++)
+        {
+          guint pos = g_array_index (mk->positions, guint, i);
+
+          mk->results[i] = gtk_filter_keys_match_key (self->filter_keys, key_from_pos (self, pos));
+        }
+    }
+}
+
+/* Adds the items at @positions that match to self->matches.
+ * All keys must exist.
+ */
+static void
+gtk_filter_list_model_match_keys (GtkFilterListModel *self,
+                                  GArray             *positions)
+{
+  guint i;
+
+  if (gtk_filter_keys_is_threadsafe (self->filter_keys) &&
+      positions->len >= GTK_FILTER_PARALLEL_MIN_ITEMS)
+    {
+      MatchKeysData mk = {
+        .self = self,
+        .positions = positions,
+        .results = g_new (guint8, positions->len),
+        .n_chunks = (positions->len + GTK_FILTER_PARALLEL_CHUNK_SIZE - 1) / GTK_FILTER_PARALLEL_CHUNK_SIZE,
+        .next_chunk = 0,
+      };
+
+      gdk_parallel_task_run (gtk_filter_list_model_match_keys_func, &mk);
+
+      for (i = 0; i < positions->len; i++)
+        {
+          if (mk.results[i])
+            gtk_bitset_add (self->matches, g_array_index (positions, guint, i));
+        }
+
+      g_free (mk.results);
+    }
+  else
+    {
+      for (i = 0; i < positions->len; i++)
+        {
+          guint pos = g_array_index (positions, guint, i);
+
+          if (gtk_filter_keys_match_key (self->filter_keys, key_from_pos (self, pos)))
+            gtk_bitset_add (self->matches, pos);
+        }
+    }
+}
+
 static gboolean
 gtk_filter_list_model_run_filter_on_item (GtkFilterListModel *self,
                                           guint               position)
@@ -263,12 +484,39 @@ gtk_filter_list_model_run_filter (GtkFilterListModel *self,
   if (self->pending == NULL)
     return;
 
-  for (i = 0, more = gtk_bitset_iter_init_first (&iter, self->pending, &pos);
-       i < n_steps && more;
-       i++, more = gtk_bitset_iter_next (&iter, &pos))
+  if (self->filter_keys)
     {
-      if (gtk_filter_list_model_run_filter_on_item (self, pos))
-        gtk_bitset_add (self->matches, pos);
+      GArray *positions = g_array_new (FALSE, FALSE, sizeof (guint));
+
+      /* Create missing keys here, that needs the items, so it must
+       * happen in the main thread. Matching can happen in parallel.
+       */
+      for (i = 0, more = gtk_bitset_iter_init_first (&iter, self->pending, &pos);
+           i < n_steps && more;
+           i++, more = gtk_bitset_iter_next (&iter, &pos))
+        {
+          if (gtk_bitset_contains (self->missing_keys, pos))
+            {
+              gpointer item = g_list_model_get_item (self->model, pos);
+              gtk_filter_keys_init_key (self->filter_keys, item, key_from_pos (self, pos));
+              g_object_unref (item);
+              gtk_bitset_remove (self->missing_keys, pos);
+            }
+          g_array_append_val (positions, pos);
+        }
+
+      gtk_filter_list_model_match_keys (self, positions);
+      g_array_unref (positions);
+    }
+  else
+    {
+      for (i = 0, more = gtk_bitset_iter_init_first (&iter, self->pending, &pos);
+           i < n_steps && more;
+           i++, more = gtk_bitset_iter_next (&iter, &pos))
+        {
+          if (gtk_filter_list_model_run_filter_on_item (self, pos))
+            gtk_bitset_add (self->matches, pos);
+        }
     }
 
   if (more)
@@ -323,7 +571,7 @@ gtk_filter_list_model_run_filter_cb (gpointer data)
   GtkBitset *old;
 
   old = gtk_bitset_copy (self->matches);
-  gtk_filter_list_model_run_filter (self, 512);
+  gtk_filter_list_model_run_filter (self, self->filter_keys ? GTK_FILTER_STEP_KEYS : GTK_FILTER_STEP_ITEMS);
 
   if (self->pending == NULL)
     gtk_filter_list_model_stop_filtering (self);
@@ -377,6 +625,8 @@ gtk_filter_list_model_items_changed_cb (GListModel         *model,
 {
   guint filter_removed, filter_added;
 
+  gtk_filter_list_model_splice_keys (self, position, removed, added);
+
   switch (self->strictness)
     {
     case GTK_FILTER_MATCH_NONE:
@@ -495,6 +745,7 @@ gtk_filter_list_model_clear_model (GtkFilterListModel *self)
     return;
 
   gtk_filter_list_model_stop_filtering (self);
+  gtk_filter_list_model_clear_keys (self);
   g_signal_handlers_disconnect_by_func (self->model, gtk_filter_list_model_items_changed_cb, self);
   g_signal_handlers_disconnect_by_func (self->model, gtk_filter_list_model_sections_changed_cb, self);
   g_clear_object (&self->model);
@@ -508,6 +759,8 @@ gtk_filter_list_model_refilter (GtkFilterListModel *self,
 {
   GtkFilterMatch new_strictness;
 
+  gtk_filter_list_model_update_keys (self);
+
   if (self->model == NULL)
     new_strictness = GTK_FILTER_MATCH_NONE;
   else if (self->filter == NULL)
@@ -871,6 +1124,7 @@ gtk_filter_list_model_set_model (GtkFilterListModel *self,
         }
       else if (self->matches)
         {
+          gtk_filter_list_model_update_keys (self);
           gtk_filter_list_model_start_filtering (self, gtk_bitset_new_range (0, g_list_model_get_n_items (model)));
           added = gtk_bitset_get_size (self->matches);
         }
@@ -948,7 +1202,7 @@ gtk_filter_list_model_set_incremental (GtkFilterListModel *self,
       gtk_filter_list_model_run_filter (self, G_MAXUINT);
 
       old = gtk_bitset_copy (self->matches);
-      gtk_filter_list_model_run_filter (self, 512);
+      gtk_filter_list_model_run_filter (self, GTK_FILTER_STEP_ITEMS);
 
       gtk_filter_list_model_stop_filtering (self);
 
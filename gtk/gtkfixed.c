@@ -192,6 +192,7 @@ gtk_fixed_init (GtkFixed *self)
   GtkFixedPrivate *priv = gtk_fixed_get_instance_private (self);
 
   gtk_widget_set_overflow (GTK_WIDGET (self), GTK_OVERFLOW_HIDDEN);
+  gtk_widget_set_use_pick_index (GTK_WIDGET (self), TRUE);
 
   priv->layout = gtk_widget_get_layout_manager (GTK_WIDGET (self));
 }
@@ -284,6 +284,7 @@
 
 typedef struct _GtkLabelClass         GtkLabelClass;
 typedef struct _GtkLabelSelectionInfo GtkLabelSelectionInfo;
+typedef struct _GtkLabelMeasureCache  GtkLabelMeasureCache;
 
 struct _GtkLabel
 {
@@ -298,6 +299,8 @@ struct _GtkLabel
   PangoLayout   *layout;
   PangoTabArray *tabs;
 
+  GtkLabelMeasureCache *measure_cache;
+
   GtkWidget *popup_menu;
   GMenuModel *extra_menu;
 
@@ -380,6 +383,46 @@ typedef struct
   int end;
 } GtkLabelLink;
 
+/* Width-for-height measuring needs a binary search over the width,
+ * and every probe rewraps the whole text. Wrapped labels get measured
+ * that way on every allocation, so we remember the probes (which are
+ * valid for any height) as well as the last few results.
+ *
+ * The cache is dropped whenever the layout is cleared or its attributes,
+ * wrap modes or font change.
+ */
+#define N_CACHED_WIDTHS_FOR_HEIGHT 4
+#define MAX_MEASURE_SAMPLES 128
+
+typedef struct
+{
+  int wrap;
+  int width;         /* in pixels */
+  int text_width;    /* in pixels */
+  int text_height;   /* in Pango units */
+} GtkLabelMeasureSample;
+
+typedef struct
+{
+  int height;
+  int minimum_default;
+  int minimum_width;
+  int natural_width;
+} GtkLabelWidthForHeight;
+
+struct _GtkLabelMeasureCache
+{
+  PangoLayout *layout;  /* unellipsized copy of the label's layout */
+  guint context_serial;
+  int unwrapped_width;
+
+  GArray *samples;      /* sorted by wrap, then width */
+
+  GtkLabelWidthForHeight widths[N_CACHED_WIDTHS_FOR_HEIGHT];
+  guint n_widths;
+  guint next_width;
+};
+
 struct _GtkLabelSelectionInfo
 {
   int selection_anchor;
@@ -456,6 +499,7 @@ static void gtk_label_ensure_select_info  (GtkLabel *self);
 static void gtk_label_clear_select_info   (GtkLabel *self);
 static void gtk_label_clear_provider_info (GtkLabel *self);
 static void gtk_label_clear_layout        (GtkLabel *self);
+static void gtk_label_clear_measure_cache (GtkLabel *self);
 static void gtk_label_ensure_layout       (GtkLabel *self);
 static void gtk_label_select_region_index (GtkLabel *self,
                                            int       anchor_index,
@@ -843,6 +887,8 @@ gtk_label_update_layout_attributes (GtkLabel      *self,
       return;
     }
 
+  gtk_label_clear_measure_cache (self);
+
   if (self->select_info && self->select_info->links)
     {
       guint i;
@@ -1233,11 +1279,118 @@ get_height_for_width (GtkLabel *self,
   g_object_unref (layout);
 }
 
+static void
+gtk_label_measure_cache_free (GtkLabelMeasureCache *cache)
+{
+  g_clear_object (&cache->layout);
+  g_array_unref (cache->samples);
+  g_free (cache);
+}
+
+static void
+gtk_label_clear_measure_cache (GtkLabel *self)
+{
+  g_clear_pointer (&self->measure_cache, gtk_label_measure_cache_free);
+}
+
+static GtkLabelMeasureCache *
+gtk_label_get_measure_cache (GtkLabel *self)
+{
+  GtkLabelMeasureCache *cache;
+  guint serial;
+
+  gtk_label_ensure_layout (self);
+
+  /* Font changes don't clear the layout, they change the context */
+  serial = pango_context_get_serial (pango_layout_get_context (self->layout));
+  if (self->measure_cache && self->measure_cache->context_serial != serial)
+    gtk_label_clear_measure_cache (self);
+
+  if (self->measure_cache)
+    return self->measure_cache;
+
+  cache = g_new0 (GtkLabelMeasureCache, 1);
+  cache->context_serial = serial;
+  cache->samples = g_array_new (FALSE, FALSE, sizeof (GtkLabelMeasureSample));
+
+  /* Can't use a measuring layout here, because we need to force
+   * ellipsizing mode */
+  cache->layout = pango_layout_copy (self->layout);
+  pango_layout_set_ellipsize (cache->layout, PANGO_ELLIPSIZE_NONE);
+  pango_layout_set_width (cache->layout, -1);
+  pango_layout_get_size (cache->layout, &cache->unwrapped_width, NULL);
+
+  self->measure_cache = cache;
+
+  return cache;
+}
+
 static int
-my_pango_layout_get_width_for_height (PangoLayout *layout,
-                                      int          for_height,
-                                      int          min,
-                                      int          max)
+compare_measure_samples (int                          wrap,
+                         int                          width,
+                         const GtkLabelMeasureSample *sample)
+{
+  if (wrap != sample->wrap)
+    return wrap < sample->wrap ? -1 : 1;
+  if (width != sample->width)
+    return width < sample->width ? -1 : 1;
+  return 0;
+}
+
+static void
+gtk_label_measure_cache_sample (GtkLabelMeasureCache *cache,
+                                PangoWrapMode         wrap,
+                                int                   width,
+                                int                  *text_width,
+                                int                  *text_height)
+{
+  GtkLabelMeasureSample *samples = (GtkLabelMeasureSample *) cache->samples->data;
+  GtkLabelMeasureSample sample;
+  guint lo, hi;
+
+  lo = 0;
+  hi = cache->samples->len;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+      int cmp = compare_measure_samples (wrap, width, &samples[mid]);
+
+      if (cmp == 0)
+        {
+          *text_width = samples[mid].text_width;
+          *text_height = samples[mid].text_height;
+          return;
+        }
+      else if (cmp < 0)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+
+  pango_layout_set_wrap (cache->layout, wrap);
+  pango_layout_set_width (cache->layout, width * PANGO_SCALE);
+  pango_layout_get_size (cache->layout, text_width, text_height);
+  *text_width = PANGO_PIXELS_CEIL (*text_width);
+
+  if (cache->samples->len >= MAX_MEASURE_SAMPLES)
+    {
+      g_array_set_size (cache->samples, 0);
+      lo = 0;
+    }
+
+  sample.wrap = wrap;
+  sample.width = width;
+  sample.text_width = *text_width;
+  sample.text_height = *text_height;
+  g_array_insert_val (cache->samples, lo, sample);
+}
+
+static int
+my_pango_layout_get_width_for_height (GtkLabelMeasureCache *cache,
+                                      PangoWrapMode         wrap,
+                                      int                   for_height,
+                                      int                   min,
+                                      int                   max)
 {
   int mid, text_width, text_height;
 
@@ -1247,9 +1400,7 @@ my_pango_layout_get_width_for_height (PangoLayout *layout,
   while (min < max)
     {
       mid = (min + max) / 2;
-      pango_layout_set_width (layout, mid * PANGO_SCALE);
-      pango_layout_get_size (layout, &text_width, &text_height);
-      text_width = PANGO_PIXELS_CEIL (text_width);
+      gtk_label_measure_cache_sample (cache, wrap, mid, &text_width, &text_height);
       if (text_width > mid)
         min = text_width;
       else if (text_height > for_height)
@@ -1283,23 +1434,34 @@ get_width_for_height (GtkLabel *self,
       layout = gtk_label_get_measuring_layout (self, layout, natural_default);
       pango_layout_get_size (layout, natural_width, NULL);
       *natural_width = MAX (*natural_width, *minimum_width);
+
+      g_object_unref (layout);
     }
   else
     {
+      GtkLabelMeasureCache *cache;
+      GtkLabelWidthForHeight *result;
       int min, max;
+      guint i;
 
-      /* Can't use a measuring layout here, because we need to force
-       * ellipsizing mode */
-      gtk_label_ensure_layout (self);
-      layout = pango_layout_copy (self->layout);
-      pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_NONE);
+      cache = gtk_label_get_measure_cache (self);
+
+      for (i = 0; i < cache->n_widths; i++)
+        {
+          result = &cache->widths[i];
+          if (result->height == height &&
+              result->minimum_default == minimum_default)
+            {
+              *minimum_width = result->minimum_width;
+              *natural_width = result->natural_width;
+              return;
+            }
+        }
 
       /* binary search for the smallest width where the height doesn't
        * eclipse the given height */
       min = MAX (minimum_default, 0);
-
-      pango_layout_set_width (layout, -1);
-      pango_layout_get_size (layout, &max, NULL);
+      max = cache->unwrapped_width;
 
       /* first, do natural width */
       if (self->natural_wrap_mode == GTK_NATURAL_WRAP_NONE)
@@ -1308,18 +1470,23 @@ get_width_for_height (GtkLabel *self,
         }
       else
         {
+          PangoWrapMode wrap;
+
           if (self->natural_wrap_mode == GTK_NATURAL_WRAP_WORD)
-            pango_layout_set_wrap (layout, PANGO_WRAP_WORD);
-          *natural_width = my_pango_layout_get_width_for_height (layout, height, min, max);
+            wrap = PANGO_WRAP_WORD;
+          else
+            wrap = self->wrap_mode;
+
+          *natural_width = my_pango_layout_get_width_for_height (cache, wrap, height, min, max);
         }
 
       /* then, do minimum width */
       if (self->ellipsize != PANGO_ELLIPSIZE_NONE)
         {
-          g_object_unref (layout);
           layout = gtk_label_get_measuring_layout (self, NULL, MAX (minimum_default, 0));
           pango_layout_get_size (layout, minimum_width, NULL);
           *minimum_width = MAX (*minimum_width, minimum_default);
+          g_object_unref (layout);
         }
       else if (self->natural_wrap_mode == GTK_NATURAL_WRAP_INHERIT)
         {
@@ -1327,12 +1494,18 @@ get_width_for_height (GtkLabel *self,
         }
       else
         {
-          pango_layout_set_wrap (layout, self->wrap_mode);
-          *minimum_width = my_pango_layout_get_width_for_height (layout, height, min, *natural_width);
+          *minimum_width = my_pango_layout_get_width_for_height (cache, self->wrap_mode, height, min, *natural_width);
         }
-    }
 
-  g_object_unref (layout);
+      result = &cache->widths[cache->next_width];
+      result->height = height;
+      result->minimum_default = minimum_default;
+      result->minimum_width = *minimum_width;
+      result->natural_width = *natural_width;
+
+      cache->next_width = (cache->next_width + 1) % N_CACHED_WIDTHS_FOR_HEIGHT;
+      cache->n_widths = MIN (cache->n_widths + 1, N_CACHED_WIDTHS_FOR_HEIGHT);
+    }
 }
 
 static void
@@ -1604,6 +1777,7 @@ gtk_label_finalize (GObject *object)
   g_free (self->text);
 
   g_clear_object (&self->layout);
+  gtk_label_clear_measure_cache (self);
   g_clear_pointer (&self->attrs, pango_attr_list_unref);
   g_clear_pointer (&self->markup_attrs, pango_attr_list_unref);
 
@@ -4267,6 +4441,7 @@ gtk_label_set_wrap_mode (GtkLabel *self,
       self->wrap_mode = wrap_mode;
       g_object_notify_by_pspec (G_OBJECT (self), label_props[PROP_WRAP_MODE]);
 
+      gtk_label_clear_measure_cache (self);
       gtk_widget_queue_resize (GTK_WIDGET (self));
     }
 }
@@ -4312,6 +4487,7 @@ gtk_label_set_natural_wrap_mode (GtkLabel           *self,
       self->natural_wrap_mode = wrap_mode;
       g_object_notify_by_pspec (G_OBJECT (self), label_props[PROP_NATURAL_WRAP_MODE]);
 
+      gtk_label_clear_measure_cache (self);
       gtk_widget_queue_resize (GTK_WIDGET (self));
     }
 }
@@ -4340,6 +4516,7 @@ static void
 gtk_label_clear_layout (GtkLabel *self)
 {
   g_clear_object (&self->layout);
+  gtk_label_clear_measure_cache (self);
 }
 
 static void
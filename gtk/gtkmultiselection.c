@@ -39,7 +39,12 @@ struct _GtkMultiSelection
   GListModel *model;
 
   GtkBitset *selected;
-  GHashTable *items; /* item => position */
+  /* The selected items, in the order of their positions, so the
+   * n-th item is at the n-th position in selected. We keep them
+   * so items stay selected when they are removed and added back,
+   * like when the model is sorted.
+   */
+  GPtrArray *items;
 };
 
 struct _GtkMultiSelectionClass
@@ -58,6 +63,11 @@ enum {
 
 static GParamSpec *properties[N_PROPS] = { NULL, };
 
+/* Up to this many changes are applied to the items one by one,
+ * more than that rebuild the array in one go
+ */
+#define MAX_SINGLE_CHANGES 16
+
 static GType
 gtk_multi_selection_get_item_type (GListModel *list)
 {
@@ -131,47 +141,86 @@ gtk_multi_selection_get_selection_in_range (GtkSelectionModel *model,
   return gtk_bitset_ref (self->selected);
 }
 
+/* The index in items of the first selected position >= @position */
+static guint
+gtk_multi_selection_get_index (GtkMultiSelection *self,
+                               guint              position)
+{
+  if (position == 0)
+    return 0;
+
+  return gtk_bitset_get_size_in_range (self->selected, 0, position - 1);
+}
+
 static void
 gtk_multi_selection_toggle_selection (GtkMultiSelection *self,
                                       GtkBitset         *changes)
 {
   GListModel *model = G_LIST_MODEL (self);
-  GtkBitsetIter change_iter, selected_iter;
+  GtkBitsetIter iter, old_iter;
   GtkBitset *selected;
-  guint change_pos, selected_pos;
-  gboolean more;
+  GPtrArray *items;
+  guint pos, old_pos, old_index;
+  gboolean more, old_more;
+
+  if (gtk_bitset_get_size (changes) <= MAX_SINGLE_CHANGES)
+    {
+      /* Go backwards, so the indexes of earlier positions stay the same */
+      for (more = gtk_bitset_iter_init_last (&iter, changes, &pos);
+           more;
+           more = gtk_bitset_iter_previous (&iter, &pos))
+        {
+          guint index = gtk_multi_selection_get_index (self, pos);
 
-  gtk_bitset_difference (self->selected, changes);
+          if (gtk_bitset_contains (self->selected, pos))
+            {
+              gtk_bitset_remove (self->selected, pos);
+              g_ptr_array_remove_index (self->items, index);
+            }
+          else
+            {
+              gtk_bitset_add (self->selected, pos);
+              g_ptr_array_insert (self->items, index, g_list_model_get_item (model, pos));
+            }
+        }
 
-  selected = gtk_bitset_copy (changes);
-  gtk_bitset_intersect (selected, self->selected);
+      return;
+    }
 
-  if (!gtk_bitset_iter_init_first (&selected_iter, selected, &selected_pos))
-    selected_pos = G_MAXUINT;
+  selected = gtk_bitset_copy (self->selected);
+  gtk_bitset_difference (selected, changes);
+  items = g_ptr_array_new_full (gtk_bitset_get_size (selected), g_object_unref);
 
-  for (more = gtk_bitset_iter_init_first (&change_iter, changes, &change_pos);
+  /* Walk the old and new selection together, and move
+   * over the items that stay selected
+   */
+  old_more = gtk_bitset_iter_init_first (&old_iter, self->selected, &old_pos);
+  old_index = 0;
+  for (more = gtk_bitset_iter_init_first (&iter, selected, &pos);
        more;
-       more = gtk_bitset_iter_next (&change_iter, &change_pos))
+       more = gtk_bitset_iter_next (&iter, &pos))
     {
-      gpointer item = g_list_model_get_item (model, change_pos);
-
-      if (change_pos < selected_pos)
+      while (old_more && old_pos < pos)
         {
-          g_hash_table_remove (self->items, item);
-          g_object_unref (item);
+          old_more = gtk_bitset_iter_next (&old_iter, &old_pos);
+          old_index++;
         }
-      else
-        {
-          g_assert (change_pos == selected_pos);
 
-          g_hash_table_insert (self->items, item, GUINT_TO_POINTER (change_pos));
-
-          if (!gtk_bitset_iter_next (&selected_iter, &selected_pos))
-            selected_pos = G_MAXUINT;
-        }
+      if (old_more && old_pos == pos)
+        g_ptr_array_add (items, g_steal_pointer (&g_ptr_array_index (self->items, old_index)));
+      else
+        g_ptr_array_add (items, g_list_model_get_item (model, pos));
     }
 
-  gtk_bitset_unref (selected);
+  /* Only the unselected ones are left */
+  g_ptr_array_set_free_func (self->items, NULL);
+  for (old_index = 0; old_index < self->items->len; old_index++)
+    g_clear_object (&g_ptr_array_index (self->items, old_index));
+  g_ptr_array_unref (self->items);
+  self->items = items;
+
+  gtk_bitset_unref (self->selected);
+  self->selected = selected;
 }
 
 static gboolean
@@ -235,57 +284,60 @@ gtk_multi_selection_items_changed_cb (GListModel        *model,
                                       guint              added,
                                       GtkMultiSelection *self)
 {
-  GHashTableIter iter;
-  gpointer item, pos_pointer;
-  GHashTable *pending = NULL;
-  guint i;
+  GHashTable *pending = NULL; /* item => how often it was removed */
+  guint first, n_removed, n_readded, i;
 
-  gtk_bitset_splice (self->selected, position, removed, added);
+  first = gtk_multi_selection_get_index (self, position);
+  if (removed > 0)
+    n_removed = gtk_bitset_get_size_in_range (self->selected, position, position + removed - 1);
+  else
+    n_removed = 0;
 
-  g_hash_table_iter_init (&iter, self->items);
-  while (g_hash_table_iter_next (&iter, &item, &pos_pointer))
+  if (n_removed > 0 && added > 0)
     {
-      guint pos = GPOINTER_TO_UINT (pos_pointer);
-
-      if (pos < position)
-        continue;
-      else if (pos >= position + removed)
-        g_hash_table_iter_replace (&iter, GUINT_TO_POINTER (pos - removed + added));
-      else /* if pos is in the removed range */
+      pending = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+      for (i = first; i < first + n_removed; i++)
         {
-          if (added == 0)
-            {
-              g_hash_table_iter_remove (&iter);
-            }
-          else
-            {
-              g_hash_table_iter_steal (&iter);
-              if (pending == NULL)
-                pending = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
-              g_hash_table_add (pending, item);
-            }
+          gpointer item = g_ptr_array_index (self->items, i);
+          guint count = GPOINTER_TO_UINT (g_hash_table_lookup (pending, item));
+
+          g_hash_table_insert (pending, g_object_ref (item), GUINT_TO_POINTER (count + 1));
         }
     }
 
+  gtk_bitset_splice (self->selected, position, removed, added);
+
+  /* Items that are added back go into the slots of the removed ones */
+  n_readded = 0;
   for (i = position; pending != NULL && i < position + added; i++)
     {
-      item = g_list_model_get_item (model, i);
-      if (g_hash_table_contains (pending, item))
-        {
-          gtk_bitset_add (self->selected, i);
-          g_hash_table_insert (self->items, item, GUINT_TO_POINTER (i));
-          g_hash_table_remove (pending, item);
-          if (g_hash_table_size (pending) == 0)
-            g_clear_pointer (&pending, g_hash_table_unref);
-        }
-      else
+      gpointer item = g_list_model_get_item (model, i);
+      guint count = GPOINTER_TO_UINT (g_hash_table_lookup (pending, item));
+
+      if (count == 0)
         {
           g_object_unref (item);
+          continue;
         }
+
+      gtk_bitset_add (self->selected, i);
+      g_object_unref (g_ptr_array_index (self->items, first + n_readded));
+      g_ptr_array_index (self->items, first + n_readded) = item;
+      n_readded++;
+
+      if (count > 1)
+        g_hash_table_insert (pending, g_object_ref (item), GUINT_TO_POINTER (count - 1));
+      else if (g_hash_table_size (pending) > 1)
+        g_hash_table_remove (pending, item);
+      else
+        g_clear_pointer (&pending, g_hash_table_unref);
     }
 
   g_clear_pointer (&pending, g_hash_table_unref);
 
+  if (n_readded < n_removed)
+    g_ptr_array_remove_range (self->items, first + n_readded, n_removed - n_readded);
+
   g_list_model_items_changed (G_LIST_MODEL (self), position, removed, added);
   if (removed != added)
     g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
@@ -374,7 +426,7 @@ gtk_multi_selection_dispose (GObject *object)
   gtk_multi_selection_clear_model (self);
 
   g_clear_pointer (&self->selected, gtk_bitset_unref);
-  g_clear_pointer (&self->items, g_hash_table_unref);
+  g_clear_pointer (&self->items, g_ptr_array_unref);
 
   G_OBJECT_CLASS (gtk_multi_selection_parent_class)->dispose (object);
 }
@@ -429,7 +481,7 @@ static void
 gtk_multi_selection_init (GtkMultiSelection *self)
 {
   self->selected = gtk_bitset_new_empty ();
-  self->items = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+  self->items = g_ptr_array_new_with_free_func (g_object_unref);
 }
 
 /**
@@ -516,7 +568,7 @@ gtk_multi_selection_set_model (GtkMultiSelection *self,
   else
     {
       gtk_bitset_remove_all (self->selected);
-      g_hash_table_remove_all (self->items);
+      g_ptr_array_set_size (self->items, 0);
       g_list_model_items_changed (G_LIST_MODEL (self), 0, n_items_before, 0);
       if (n_items_before)
         g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
@@ -143,6 +143,31 @@ gtk_multi_sort_keys_init_key (GtkSortKeys *keys,
     gtk_sort_keys_init_key (self->keys[i].keys, item, key + self->keys[i].offset);
 }
 
+static void
+gtk_multi_sort_keys_prepare_key (GtkSortKeys *keys,
+                                 gpointer     item,
+                                 gpointer     key_memory)
+{
+  GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
+  char *key = (char *) key_memory;
+  gsize i;
+
+  for (i = 0; i < self->n_keys; i++)
+    gtk_sort_keys_prepare_key (self->keys[i].keys, item, key + self->keys[i].offset);
+}
+
+static void
+gtk_multi_sort_keys_finish_key (GtkSortKeys *keys,
+                                gpointer     key_memory)
+{
+  GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
+  char *key = (char *) key_memory;
+  gsize i;
+
+  for (i = 0; i < self->n_keys; i++)
+    gtk_sort_keys_finish_key (self->keys[i].keys, key + self->keys[i].offset);
+}
+
 static void
 gtk_multi_sort_keys_clear_key (GtkSortKeys *keys,
                                gpointer     key_memory)
@@ -162,6 +187,8 @@ static const GtkSortKeysClass GTK_MULTI_SORT_KEYS_CLASS =
   gtk_multi_sort_keys_is_compatible,
   gtk_multi_sort_keys_init_key,
   gtk_multi_sort_keys_clear_key,
+  gtk_multi_sort_keys_prepare_key,
+  gtk_multi_sort_keys_finish_key,
 };
 
 static GtkSortKeys *
@@ -182,6 +209,7 @@ gtk_multi_sort_keys_new (GtkMultiSorter *self)
   result = (GtkMultiSortKeys *) keys;
 
   result->n_keys = gtk_sorters_get_size (&self->sorters);
+  keys->threadsafe = TRUE;
   for (i = 0; i < result->n_keys; i++)
     {
       result->keys[i].keys = gtk_sorter_get_keys (gtk_sorters_get (&self->sorters, i));
@@ -189,6 +217,7 @@ gtk_multi_sort_keys_new (GtkMultiSorter *self)
       keys->key_size = result->keys[i].offset + GTK_SORT_KEYS_ALIGN (gtk_sort_keys_get_key_size (result->keys[i].keys),
                                                                      gtk_sort_keys_get_key_align (result->keys[i].keys));
       keys->key_align = MAX (keys->key_align, gtk_sort_keys_get_key_align (result->keys[i].keys));
+      keys->threadsafe &= gtk_sort_keys_is_threadsafe (result->keys[i].keys);
     }
 
   return keys;
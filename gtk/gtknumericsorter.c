@@ -326,6 +326,7 @@ gtk_numeric_sort_keys_new (GtkNumericSorter *self)
     }
 
   result->expression = gtk_expression_ref (self->expression);
+  result->keys.threadsafe = TRUE;
 
   return (GtkSortKeys *) result;
 }
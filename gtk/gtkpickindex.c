@@ -0,0 +1,288 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkpickindexprivate.h"
+
+#include <math.h>
+
+/* A uniform grid over the bounds of a list of items, used to find
+ * the children of a widget that may contain a point without looking
+ * at all of them.
+ *
+ * Items are numbered in the order they are added. Every cell stores
+ * the numbers of the items overlapping it in ascending order, and
+ * iteration walks them backwards, so items are returned in the
+ * reverse order of addition - the order gtk_widget_pick() needs.
+ *
+ * Items without bounds, and items that would cover too many cells,
+ * are kept in a separate list that is merged into every query.
+ */
+
+#define MAX_GRID_SIZE 256
+#define MAX_CELLS_PER_ITEM 16
+
+struct _GtkPickIndex
+{
+  GPtrArray *items;
+  GArray *unbounded;            /* item numbers */
+
+  /* Only used while adding */
+  GArray *bounded;              /* item numbers */
+  GArray *bounds;               /* graphene_rect_t for each bounded item */
+
+  graphene_rect_t extent;
+  guint cols;
+  guint rows;
+  guint *cell_offsets;          /* cols * rows + 1 offsets into cell_items */
+  guint *cell_items;
+};
+
+GtkPickIndex *
+gtk_pick_index_new (void)
+{
+  GtkPickIndex *self;
+
+  self = g_new0 (GtkPickIndex, 1);
+  self->items = g_ptr_array_new ();
+  self->unbounded = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->bounded = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->bounds = g_array_new (FALSE, FALSE, sizeof (graphene_rect_t));
+
+  return self;
+}
+
+void
+gtk_pick_index_free (GtkPickIndex *self)
+{
+  g_ptr_array_unref (self->items);
+  g_array_unref (self->unbounded);
+  g_clear_pointer (&self->bounded, g_array_unref);
+  g_clear_pointer (&self->bounds, g_array_unref);
+  g_free (self->cell_offsets);
+  g_free (self->cell_items);
+  g_free (self);
+}
+
+/*<private>
+ * gtk_pick_index_add:
+ * @self: a `GtkPickIndex`
+ * @item: the item to add
+ * @bounds: (nullable): the area where @item may be picked or
+ *   %NULL if it may be picked anywhere
+ *
+ * Adds @item to the index. Items must be added before calling
+ * gtk_pick_index_build().
+ */
+void
+gtk_pick_index_add (GtkPickIndex          *self,
+                    gpointer               item,
+                    const graphene_rect_t *bounds)
+{
+  guint n = self->items->len;
+
+  g_assert (self->bounds != NULL);
+
+  g_ptr_array_add (self->items, item);
+
+  if (bounds)
+    {
+      g_array_append_val (self->bounded, n);
+      g_array_append_val (self->bounds, *bounds);
+    }
+  else
+    {
+      g_array_append_val (self->unbounded, n);
+    }
+}
+
+static guint
+gtk_pick_index_get_col (GtkPickIndex *self,
+                        double        x)
+{
+  double col;
+
+  if (self->extent.size.width <= 0)
+    return 0;
+
+  col = floor ((x - self->extent.origin.x) * self->cols / self->extent.size.width);
+
+  return CLAMP (col, 0, self->cols - 1);
+}
+
+static guint
+gtk_pick_index_get_row (GtkPickIndex *self,
+                        double        y)
+{
+  double row;
+
+  if (self->extent.size.height <= 0)
+    return 0;
+
+  row = floor ((y - self->extent.origin.y) * self->rows / self->extent.size.height);
+
+  return CLAMP (row, 0, self->rows - 1);
+}
+
+static int
+compare_item_numbers (gconstpointer a,
+                      gconstpointer b)
+{
+  guint na = *(const guint *) a;
+  guint nb = *(const guint *) b;
+
+  return (na > nb) - (na < nb);
+}
+
+void
+gtk_pick_index_build (GtkPickIndex *self)
+{
+  guint i, n, col, row, n_cells, n_unbounded;
+  guint *fill;
+
+  g_assert (self->bounds != NULL);
+
+  n = self->bounded->len;
+  n_unbounded = self->unbounded->len;
+
+  if (n > 0)
+    {
+      guint size;
+
+      self->extent = g_array_index (self->bounds, graphene_rect_t, 0);
+      for (i = 1; i < n; i++)
+        graphene_rect_union (&self->extent, &g_array_index (self->bounds, graphene_rect_t, i), &self->extent);
+
+      size = CLAMP ((guint) ceil (sqrt (n)), 1, MAX_GRID_SIZE);
+      self->cols = self->extent.size.width > 0 ? size : 1;
+      self->rows = self->extent.size.height > 0 ? size : 1;
+    }
+
+  n_cells = self->cols * self->rows;
+  self->cell_offsets = g_new0 (guint, n_cells + 1);
+
+  /* Count the items per cell, sending items that are too large
+   * to the unbounded list.
+   */
+  for (i = 0; i < n; i++)
+    {
+      const graphene_rect_t *r = &g_array_index (self->bounds, graphene_rect_t, i);
+      guint col0 = gtk_pick_index_get_col (self, r->origin.x);
+      guint col1 = gtk_pick_index_get_col (self, r->origin.x + r->size.width);
+      guint row0 = gtk_pick_index_get_row (self, r->origin.y);
+      guint row1 = gtk_pick_index_get_row (self, r->origin.y + r->size.height);
+
+      if ((col1 - col0 + 1) * (row1 - row0 + 1) > MAX_CELLS_PER_ITEM)
+        {
+          g_array_append_val (self->unbounded, g_array_index (self->bounded, guint, i));
+          g_array_index (self->bounded, guint, i) = G_MAXUINT;
+          continue;
+        }
+
+      for (row = row0; row <= row1; row++)
+        for (col = col0; col <= col1; col++)
+          self->cell_offsets[row * self->cols + col + 1]++;
+    }
+
+  for (i = 0; i < n_cells; i++)
+    self->cell_offsets[i + 1] += self->cell_offsets[i];
+
+  self->cell_items = g_new (guint, self->cell_offsets[n_cells]);
+  fill = g_memdup2 (self->cell_offsets, sizeof (guint) * n_cells);
+
+  for (i = 0; i < n; i++)
+    {
+      const graphene_rect_t *r = &g_array_index (self->bounds, graphene_rect_t, i);
+      guint item = g_array_index (self->bounded, guint, i);
+      guint col0, col1, row0, row1;
+
+      if (item == G_MAXUINT)
+        continue;
+
+      col0 = gtk_pick_index_get_col (self, r->origin.x);
+      col1 = gtk_pick_index_get_col (self, r->origin.x + r->size.width);
+      row0 = gtk_pick_index_get_row (self, r->origin.y);
+      row1 = gtk_pick_index_get_row (self, r->origin.y + r->size.height);
+
+      for (row = row0; row <= row1; row++)
+        for (col = col0; col <= col1; col++)
+          self->cell_items[fill[row * self->cols + col]++] = item;
+    }
+
+  g_free (fill);
+
+  if (self->unbounded->len != n_unbounded)
+    g_array_sort (self->unbounded, compare_item_numbers);
+
+  g_clear_pointer (&self->bounded, g_array_unref);
+  g_clear_pointer (&self->bounds, g_array_unref);
+}
+
+/*<private>
+ * gtk_pick_index_iter_init:
+ * @iter: an uninitialized iter
+ * @self: a built `GtkPickIndex`
+ * @x: the x coordinate
+ * @y: the y coordinate
+ *
+ * Initializes @iter to return all items that may be picked at
+ * (@x, @y), in reverse order of addition.
+ */
+void
+gtk_pick_index_iter_init (GtkPickIndexIter *iter,
+                          GtkPickIndex     *self,
+                          double            x,
+                          double            y)
+{
+  g_assert (self->bounds == NULL);
+
+  iter->index = self;
+  iter->unbounded = (const guint *) self->unbounded->data;
+  iter->n_unbounded = self->unbounded->len;
+
+  if (self->cols > 0 &&
+      graphene_rect_contains_point (&self->extent, &GRAPHENE_POINT_INIT (x, y)))
+    {
+      guint cell = gtk_pick_index_get_row (self, y) * self->cols + gtk_pick_index_get_col (self, x);
+
+      iter->cell = &self->cell_items[self->cell_offsets[cell]];
+      iter->n_cell = self->cell_offsets[cell + 1] - self->cell_offsets[cell];
+    }
+  else
+    {
+      iter->cell = NULL;
+      iter->n_cell = 0;
+    }
+}
+
+gpointer
+gtk_pick_index_iter_next (GtkPickIndexIter *iter)
+{
+  guint item;
+
+  if (iter->n_cell > 0 &&
+      (iter->n_unbounded == 0 ||
+       iter->cell[iter->n_cell - 1] > iter->unbounded[iter->n_unbounded - 1]))
+    item = iter->cell[--iter->n_cell];
+  else if (iter->n_unbounded > 0)
+    item = iter->unbounded[--iter->n_unbounded];
+  else
+    return NULL;
+
+  return g_ptr_array_index (iter->index->items, item);
+}
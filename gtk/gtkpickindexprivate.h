@@ -0,0 +1,52 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <graphene.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkPickIndex GtkPickIndex;
+typedef struct _GtkPickIndexIter GtkPickIndexIter;
+
+struct _GtkPickIndexIter
+{
+  /*< private >*/
+  GtkPickIndex *index;
+  const guint *cell;
+  guint n_cell;
+  const guint *unbounded;
+  guint n_unbounded;
+};
+
+GtkPickIndex *          gtk_pick_index_new                      (void);
+void                    gtk_pick_index_free                     (GtkPickIndex           *self);
+
+void                    gtk_pick_index_add                      (GtkPickIndex           *self,
+                                                                 gpointer                item,
+                                                                 const graphene_rect_t  *bounds);
+void                    gtk_pick_index_build                    (GtkPickIndex           *self);
+
+void                    gtk_pick_index_iter_init                (GtkPickIndexIter       *iter,
+                                                                 GtkPickIndex           *self,
+                                                                 double                  x,
+                                                                 double                  y);
+gpointer                gtk_pick_index_iter_next                (GtkPickIndexIter       *iter);
+
+G_END_DECLS
@@ -25,6 +25,7 @@
 #include "gtkcssnumbervalueprivate.h"
 #include "gtkcssstyleprivate.h"
 #include "gtkprivate.h"
+#include "gtkscalerprivate.h"
 #include "gtksnapshot.h"
 #include "gtktypebuiltins.h"
 #include "gtkwidgetprivate.h"
@@ -100,6 +101,17 @@ struct _GtkPicture
   GdkPaintable *paintable;
   GFile *file;
 
+  /* Large images loaded from a file are decoded at the
+   * allocated size, in a thread. We keep the encoded data
+   * around so we can decode again if we grow.
+   */
+  GBytes *bytes;
+  int image_width;
+  int image_height;
+  int decoded_width;
+  GCancellable *cancellable;
+  guint decoded : 1;
+
   char *alternative_text;
   guint can_shrink : 1;
   GtkContentFit content_fit;
@@ -114,6 +126,14 @@ static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
 
 G_DEFINE_TYPE (GtkPicture, gtk_picture, GTK_TYPE_WIDGET)
 
+/* Images with at least this many pixels are decoded
+ * at the size they are displayed at.
+ */
+#define SCALED_LOAD_MIN_PIXELS (1024 * 1024)
+
+static void gtk_picture_update_paintable (GtkPicture   *self,
+                                          GdkPaintable *paintable);
+
 static void
 gtk_picture_snapshot (GtkWidget   *widget,
                       GtkSnapshot *snapshot)
@@ -186,6 +206,159 @@ gtk_picture_snapshot (GtkWidget   *widget,
     }
 }
 
+typedef struct
+{
+  GBytes *bytes;
+  int width;
+  int height;
+} LoadData;
+
+static void
+load_data_free (gpointer data)
+{
+  LoadData *load = data;
+
+  g_bytes_unref (load->bytes);
+  g_free (load);
+}
+
+static void
+gtk_picture_load_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+  LoadData *load = task_data;
+  GdkTexture *texture;
+  GError *error = NULL;
+
+  texture = gdk_texture_new_from_bytes_at_size (load->bytes,
+                                                load->width,
+                                                load->height,
+                                                &error);
+  if (texture)
+    g_task_return_pointer (task, texture, g_object_unref);
+  else
+    g_task_return_error (task, error);
+}
+
+static void
+gtk_picture_load_done (GObject      *source,
+                       GAsyncResult *result,
+                       gpointer      data)
+{
+  GtkPicture *self = GTK_PICTURE (source);
+  GdkTexture *texture;
+  GdkPaintable *paintable;
+  GError *error = NULL;
+  int width;
+
+  texture = g_task_propagate_pointer (G_TASK (result), &error);
+  if (texture == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          /* Like small files that can't be loaded, this leaves
+           * us empty, unless a smaller version worked before.
+           */
+          g_clear_object (&self->cancellable);
+          g_clear_pointer (&self->bytes, g_bytes_unref);
+          if (!self->decoded)
+            gtk_picture_update_paintable (self, NULL);
+        }
+      g_error_free (error);
+      return;
+    }
+
+  g_clear_object (&self->cancellable);
+
+  width = gdk_texture_get_width (texture);
+  self->decoded_width = width;
+  self->decoded = TRUE;
+
+  if (width >= self->image_width)
+    {
+      /* Can't get any better than this */
+      g_clear_pointer (&self->bytes, g_bytes_unref);
+      paintable = GDK_PAINTABLE (texture);
+    }
+  else
+    {
+      paintable = gtk_scaler_new_for_size (GDK_PAINTABLE (texture),
+                                           (double) width / self->image_width,
+                                           self->image_width,
+                                           self->image_height);
+      g_object_unref (texture);
+    }
+
+  gtk_picture_update_paintable (self, paintable);
+  g_object_unref (paintable);
+}
+
+static void
+gtk_picture_cancel_load (GtkPicture *self)
+{
+  if (self->cancellable)
+    {
+      g_cancellable_cancel (self->cancellable);
+      g_clear_object (&self->cancellable);
+    }
+
+  g_clear_pointer (&self->bytes, g_bytes_unref);
+  self->image_width = 0;
+  self->image_height = 0;
+  self->decoded_width = 0;
+  self->decoded = FALSE;
+}
+
+static void
+gtk_picture_size_allocate (GtkWidget *widget,
+                           int        width,
+                           int        height,
+                           int        baseline)
+{
+  GtkPicture *self = GTK_PICTURE (widget);
+  LoadData *load;
+  GTask *task;
+  double scale;
+
+  if (self->bytes == NULL || width <= 0 || height <= 0)
+    return;
+
+  /* Enough pixels for any content-fit */
+  scale = MAX ((double) width / self->image_width,
+               (double) height / self->image_height);
+  scale *= gtk_widget_get_scale_factor (widget);
+  scale = MIN (scale, 1.0);
+
+  load = g_new (LoadData, 1);
+  load->width = MAX (1, ceil (self->image_width * scale));
+  load->height = MAX (1, ceil (self->image_height * scale));
+
+  if (load->width <= self->decoded_width)
+    {
+      g_free (load);
+      return;
+    }
+
+  if (self->cancellable)
+    {
+      g_cancellable_cancel (self->cancellable);
+      g_object_unref (self->cancellable);
+    }
+  self->cancellable = g_cancellable_new ();
+
+  /* Don't start a smaller load while this one runs */
+  self->decoded_width = load->width;
+  load->bytes = g_bytes_ref (self->bytes);
+
+  task = g_task_new (self, self->cancellable, gtk_picture_load_done, NULL);
+  g_task_set_source_tag (task, gtk_picture_size_allocate);
+  g_task_set_task_data (task, load, load_data_free);
+  g_task_run_in_thread (task, gtk_picture_load_thread);
+  g_object_unref (task);
+}
+
 static GtkSizeRequestMode
 gtk_picture_get_request_mode (GtkWidget *widget)
 {
@@ -377,6 +550,7 @@ gtk_picture_dispose (GObject *object)
 {
   GtkPicture *self = GTK_PICTURE (object);
 
+  gtk_picture_cancel_load (self);
   gtk_picture_clear_paintable (self);
 
   g_clear_object (&self->file);
@@ -398,11 +572,16 @@ gtk_picture_class_init (GtkPictureClass *class)
   widget_class->snapshot = gtk_picture_snapshot;
   widget_class->get_request_mode = gtk_picture_get_request_mode;
   widget_class->measure = gtk_picture_measure;
+  widget_class->size_allocate = gtk_picture_size_allocate;
 
   /**
    * GtkPicture:paintable:
    *
    * The `GdkPaintable` to be displayed by this `GtkPicture`.
+   *
+   * When displaying a large file, this changes without a call to
+   * [method@Gtk.Picture.set_paintable] once the image is loaded.
+   * See [ctor@Gtk.Picture.new_for_file].
    */
   properties[PROP_PAINTABLE] =
       g_param_spec_object ("paintable", NULL, NULL,
@@ -566,6 +745,14 @@ gtk_picture_new_for_pixbuf (GdkPixbuf *pixbuf)
  * [ctor@Gdk.Texture.new_from_file] to load the file yourself,
  * then create the `GtkPicture` from the texture.
  *
+ * Large images (1 megapixel or more) are loaded asynchronously, at
+ * the size they are displayed at. Until they are loaded, the
+ * [property@Gtk.Picture:paintable] is an empty placeholder of the
+ * image's size. It changes, with a notification, once the image is
+ * loaded, and again when the picture grows. If the image turns out
+ * to be broken, the picture becomes empty. If you need the full
+ * image, load it yourself as described above.
+ *
  * Returns: a new `GtkPicture`
  */
 GtkWidget*
@@ -657,7 +844,8 @@ gtk_picture_new_for_resource (const char *resource_path)
  *
  * Makes @self load and display @file.
  *
- * See [ctor@Gtk.Picture.new_for_file] for details.
+ * See [ctor@Gtk.Picture.new_for_file] for details, including
+ * how large images are loaded asynchronously.
  */
 void
 gtk_picture_set_file (GtkPicture *self,
@@ -676,12 +864,33 @@ gtk_picture_set_file (GtkPicture *self,
   g_set_object (&self->file, file);
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_FILE]);
 
+  gtk_picture_cancel_load (self);
+
+  paintable = NULL;
   if (file)
-    paintable = gdk_paintable_new_from_file_scaled (file, gtk_widget_get_scale_factor (GTK_WIDGET (self)));
-  else
-    paintable = NULL;
+    {
+      GBytes *bytes;
+      int width, height;
 
-  gtk_picture_set_paintable (self, paintable);
+      bytes = g_file_load_bytes (file, NULL, NULL, NULL);
+      if (bytes &&
+          gdk_texture_get_size_from_bytes (bytes, &width, &height) &&
+          (gsize) width * height >= SCALED_LOAD_MIN_PIXELS)
+        {
+          /* Decoded in size_allocate(), once we know how big we are */
+          self->bytes = bytes;
+          self->image_width = width;
+          self->image_height = height;
+          paintable = gdk_paintable_new_empty (width, height);
+        }
+      else if (bytes)
+        {
+          paintable = gdk_paintable_new_from_bytes_scaled (bytes, gtk_widget_get_scale_factor (GTK_WIDGET (self)));
+          g_bytes_unref (bytes);
+        }
+    }
+
+  gtk_picture_update_paintable (self, paintable);
   g_clear_object (&paintable);
 
   g_object_thaw_notify (G_OBJECT (self));
@@ -826,6 +1035,17 @@ gtk_picture_set_paintable (GtkPicture   *self,
   g_return_if_fail (GTK_IS_PICTURE (self));
   g_return_if_fail (paintable == NULL || GDK_IS_PAINTABLE (paintable));
 
+  if (self->paintable == paintable)
+    return;
+
+  gtk_picture_cancel_load (self);
+  gtk_picture_update_paintable (self, paintable);
+}
+
+static void
+gtk_picture_update_paintable (GtkPicture   *self,
+                              GdkPaintable *paintable)
+{
   if (self->paintable == paintable)
     return;
 
@@ -868,6 +1088,9 @@ gtk_picture_set_paintable (GtkPicture   *self,
  *
  * Gets the `GdkPaintable` being displayed by the `GtkPicture`.
  *
+ * For large files, this may be a placeholder or a downscaled
+ * version of the image, see [ctor@Gtk.Picture.new_for_file].
+ *
  * Returns: (nullable) (transfer none): the displayed paintable
  */
 GdkPaintable *
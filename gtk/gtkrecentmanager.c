@@ -31,6 +31,10 @@
  *
  * The recently used files list is per user.
  *
+ * Changes to the list made by other applications are loaded in the
+ * background, and [signal@Gtk.RecentManager::changed] is emitted once
+ * they are available. Until then, the previous contents are returned.
+ *
  * `GtkRecentManager` acts like a database of all the recently
  * used files. You can create new `GtkRecentManager` objects, but
  * it is more efficient to use the default manager created by GTK.
@@ -108,6 +112,9 @@
 /* limit the size of the list */
 #define MAX_LIST_SIZE 1000
 
+/* delay before reloading the list after the file changed on disk */
+#define RELOAD_TIMEOUT 250
+
 /* keep in sync with xdgmime */
 #define GTK_RECENT_DEFAULT_MIME "application/octet-stream"
 
@@ -166,6 +173,13 @@ struct _GtkRecentManagerPrivate
 
   guint changed_timeout;
   guint changed_age;
+
+  /* the etag of the file as of the last load or write */
+  char *etag;
+
+  guint reload_timeout;
+  guint reload_queued : 1;
+  GCancellable *load_cancellable;
 };
 
 enum
@@ -208,6 +222,8 @@ static void     gtk_recent_manager_enabled_changed     (GtkRecentManager  *manag
 
 
 static void     build_recent_items_list                (GtkRecentManager  *manager);
+static void     gtk_recent_manager_queue_reload        (GtkRecentManager  *manager);
+static void     gtk_recent_manager_cancel_reload       (GtkRecentManager  *manager);
 static void     purge_recent_items_list                (GtkRecentManager  *manager,
                                                         GError           **error);
 
@@ -377,6 +393,7 @@ gtk_recent_manager_finalize (GObject *object)
   GtkRecentManagerPrivate *priv = manager->priv;
 
   g_free (priv->filename);
+  g_free (priv->etag);
 
   if (priv->recent_items != NULL)
     g_bookmark_file_free (priv->recent_items);
@@ -406,6 +423,8 @@ gtk_recent_manager_dispose (GObject *gobject)
       priv->changed_age = 0;
     }
 
+  gtk_recent_manager_cancel_reload (manager);
+
   if (priv->is_dirty)
     {
       g_object_ref (manager);
@@ -423,6 +442,31 @@ gtk_recent_manager_enabled_changed (GtkRecentManager *manager)
   gtk_recent_manager_changed (manager);
 }
 
+static char *
+get_file_etag (const char   *filename,
+               GCancellable *cancellable)
+{
+  GFile *file;
+  GFileInfo *info;
+  char *etag = NULL;
+
+  file = g_file_new_for_path (filename);
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_ETAG_VALUE,
+                            G_FILE_QUERY_INFO_NONE,
+                            cancellable,
+                            NULL);
+  if (info)
+    {
+      etag = g_strdup (g_file_info_get_etag (info));
+      g_object_unref (info);
+    }
+
+  g_object_unref (file);
+
+  return etag;
+}
+
 static void
 gtk_recent_manager_real_changed (GtkRecentManager *manager)
 {
@@ -501,19 +545,26 @@ gtk_recent_manager_real_changed (GtkRecentManager *manager)
                          g_strerror (errno));
               g_free (utf8);
             }
+
+          /* the monitor will tell us about our own write, so
+           * remember what we wrote to avoid reloading it
+           */
+          g_free (priv->etag);
+          priv->etag = get_file_etag (priv->filename, NULL);
         }
 
+      /* any reload that is in flight predates our changes */
+      gtk_recent_manager_cancel_reload (manager);
+
       /* mark us as clean */
       priv->is_dirty = FALSE;
     }
-  else
-    {
-      /* we are not marked as dirty, so we have been called
-       * because the recently used resources file has been
-       * changed (and not from us).
-       */
-      build_recent_items_list (manager);
-    }
+
+  /* if we are not marked as dirty, we have been called because the
+   * recently used resources file has been changed (and not from us),
+   * and the new contents have already been loaded by
+   * load_recent_items_done().
+   */
 
   g_object_thaw_notify (G_OBJECT (manager));
 }
@@ -532,7 +583,7 @@ gtk_recent_manager_monitor_changed (GFileMonitor      *monitor,
     case G_FILE_MONITOR_EVENT_CHANGED:
     case G_FILE_MONITOR_EVENT_CREATED:
     case G_FILE_MONITOR_EVENT_DELETED:
-      gtk_recent_manager_changed (manager);
+      gtk_recent_manager_queue_reload (manager);
       break;
 
     case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
@@ -581,6 +632,9 @@ gtk_recent_manager_set_filename (GtkRecentManager *manager,
 
   priv = manager->priv;
 
+  gtk_recent_manager_cancel_reload (manager);
+  g_clear_pointer (&priv->etag, g_free);
+
   /* if a filename is already set and filename is not NULL, then copy
    * it and reset the monitor; otherwise, if it's NULL we're being
    * called from the finalization sequence, so we simply disconnect
@@ -666,6 +720,9 @@ build_recent_items_list (GtkRecentManager *manager)
        * object and hope for a better result when the next "changed" signal is
        * fired.
        */
+      g_free (priv->etag);
+      priv->etag = get_file_etag (priv->filename, NULL);
+
       read_error = NULL;
       g_bookmark_file_load_from_file (priv->recent_items, priv->filename, &read_error);
       if (read_error)
@@ -706,6 +763,212 @@ build_recent_items_list (GtkRecentManager *manager)
   priv->is_dirty = FALSE;
 }
 
+typedef struct
+{
+  char *filename;
+  char *etag;
+  GBookmarkFile *recent_items;
+} LoadData;
+
+static void
+load_data_free (gpointer data)
+{
+  LoadData *load = data;
+
+  g_free (load->filename);
+  g_free (load->etag);
+  g_clear_pointer (&load->recent_items, g_bookmark_file_free);
+  g_free (load);
+}
+
+/* runs in a thread; returns FALSE if the file is unchanged since
+ * it was last loaded or written, so that our own writes don't make
+ * us parse the whole file again.
+ */
+static void
+load_recent_items_thread (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+  LoadData *load = task_data;
+  GError *error = NULL;
+  char *etag;
+
+  /* query the etag before reading, so that a change happening
+   * while we read will cause another reload
+   */
+  etag = get_file_etag (load->filename, cancellable);
+  if (etag != NULL && g_strcmp0 (etag, load->etag) == 0)
+    {
+      g_free (etag);
+      g_task_return_boolean (task, FALSE);
+      return;
+    }
+
+  g_free (load->etag);
+  load->etag = etag;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  load->recent_items = g_bookmark_file_new ();
+  if (!g_bookmark_file_load_from_file (load->recent_items, load->filename, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+load_recent_items_done (GObject      *source_object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  GtkRecentManager *manager = GTK_RECENT_MANAGER (source_object);
+  GtkRecentManagerPrivate *priv = manager->priv;
+  LoadData *load = g_task_get_task_data (G_TASK (result));
+  GError *error = NULL;
+  gboolean changed;
+
+  changed = g_task_propagate_boolean (G_TASK (result), &error);
+
+  /* cancelled loads have been superseded by something else */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_error_free (error);
+      return;
+    }
+
+  g_clear_object (&priv->load_cancellable);
+
+  if (priv->is_dirty)
+    {
+      /* we have changes that haven't been written yet; they would be
+       * lost by replacing the list, and writing them will replace the
+       * file anyway
+       */
+      g_clear_error (&error);
+      changed = FALSE;
+    }
+  else if (error)
+    {
+      /* see build_recent_items_list() */
+      if (error->domain == G_FILE_ERROR &&
+          error->code != G_FILE_ERROR_NOENT)
+        {
+          char *utf8 = g_filename_to_utf8 (priv->filename, -1, NULL, NULL, NULL);
+          g_warning ("Attempting to read the recently used resources "
+                     "file at '%s', but the parser failed: %s.",
+                     utf8 ? utf8 : "(invalid filename)",
+                     error->message);
+          g_free (utf8);
+        }
+
+      g_clear_pointer (&priv->recent_items, g_bookmark_file_free);
+      g_free (priv->etag);
+      priv->etag = g_steal_pointer (&load->etag);
+
+      g_error_free (error);
+      changed = TRUE;
+    }
+  else if (changed)
+    {
+      int size;
+
+      g_clear_pointer (&priv->recent_items, g_bookmark_file_free);
+      priv->recent_items = g_steal_pointer (&load->recent_items);
+      g_free (priv->etag);
+      priv->etag = g_steal_pointer (&load->etag);
+
+      size = g_bookmark_file_get_size (priv->recent_items);
+      if (priv->size != size)
+        {
+          priv->size = size;
+
+          g_object_notify (G_OBJECT (manager), "size");
+        }
+    }
+
+  if (changed)
+    g_signal_emit (manager, signal_changed, 0);
+
+  if (priv->reload_queued)
+    {
+      priv->reload_queued = FALSE;
+      gtk_recent_manager_queue_reload (manager);
+    }
+}
+
+static gboolean
+reload_recent_items (gpointer data)
+{
+  GtkRecentManager *manager = data;
+  GtkRecentManagerPrivate *priv = manager->priv;
+  LoadData *load;
+  GTask *task;
+
+  priv->reload_timeout = 0;
+
+  if (priv->filename == NULL)
+    return G_SOURCE_REMOVE;
+
+  load = g_new0 (LoadData, 1);
+  load->filename = g_strdup (priv->filename);
+  load->etag = g_strdup (priv->etag);
+
+  priv->load_cancellable = g_cancellable_new ();
+
+  task = g_task_new (manager, priv->load_cancellable, load_recent_items_done, NULL);
+  g_task_set_source_tag (task, reload_recent_items);
+  g_task_set_static_name (task, "[gtk] reload_recent_items");
+  g_task_set_task_data (task, load, load_data_free);
+  g_task_run_in_thread (task, load_recent_items_thread);
+  g_object_unref (task);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* reloads the recently used resources file after it has been changed
+ * by another application. the file is parsed in a thread, so lookups
+ * keep using the current list until the new one is ready; bursts of
+ * monitor events are coalesced, and at most one load is in flight.
+ */
+static void
+gtk_recent_manager_queue_reload (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  if (priv->reload_timeout != 0)
+    return;
+
+  if (priv->load_cancellable != NULL)
+    {
+      priv->reload_queued = TRUE;
+      return;
+    }
+
+  priv->reload_timeout = g_timeout_add (RELOAD_TIMEOUT, reload_recent_items, manager);
+  gdk_source_set_static_name_by_id (priv->reload_timeout, "[gtk] reload_recent_items");
+}
+
+static void
+gtk_recent_manager_cancel_reload (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  g_clear_handle_id (&priv->reload_timeout, g_source_remove);
+  priv->reload_queued = FALSE;
+
+  if (priv->load_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->load_cancellable);
+      g_clear_object (&priv->load_cancellable);
+    }
+}
+
 
 /********************
  * GtkRecentManager *
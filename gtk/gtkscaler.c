@@ -29,6 +29,9 @@ struct _GtkScaler
 
   GdkPaintable *paintable;
   double scale;
+  /* intrinsic size, if it isn't the paintable's size / scale */
+  int width;
+  int height;
 };
 
 struct _GtkScalerClass
@@ -63,7 +66,10 @@ gtk_scaler_paintable_get_current_image (GdkPaintable *paintable)
   GdkPaintable *current_paintable, *current_self;
 
   current_paintable = gdk_paintable_get_current_image (self->paintable);
-  current_self = gtk_scaler_new (current_paintable, self->scale);
+  if (self->width > 0)
+    current_self = gtk_scaler_new_for_size (current_paintable, self->scale, self->width, self->height);
+  else
+    current_self = gtk_scaler_new (current_paintable, self->scale);
   g_object_unref (current_paintable);
 
   return current_self;
@@ -82,6 +88,9 @@ gtk_scaler_paintable_get_intrinsic_width (GdkPaintable *paintable)
 {
   GtkScaler *self = GTK_SCALER (paintable);
 
+  if (self->width > 0)
+    return self->width;
+
   return gdk_paintable_get_intrinsic_width (self->paintable) / self->scale;
 }
 
@@ -90,6 +99,9 @@ gtk_scaler_paintable_get_intrinsic_height (GdkPaintable *paintable)
 {
   GtkScaler *self = GTK_SCALER (paintable);
 
+  if (self->height > 0)
+    return self->height;
+
   return gdk_paintable_get_intrinsic_height (self->paintable) / self->scale;
 }
 
@@ -175,3 +187,34 @@ gtk_scaler_new (GdkPaintable *paintable,
 
   return GDK_PAINTABLE (self);
 }
+
+/*
+ * gtk_scaler_new_for_size:
+ * @paintable: the paintable to scale
+ * @scale: the scale
+ * @width: the intrinsic width
+ * @height: the intrinsic height
+ *
+ * Like gtk_scaler_new(), but reports the given size as intrinsic size.
+ *
+ * This is for paintables that were created downscaled from an image
+ * of the given size, so that rounding doesn't change the size.
+ *
+ * Returns: a new paintable
+ */
+GdkPaintable *
+gtk_scaler_new_for_size (GdkPaintable *paintable,
+                         double        scale,
+                         int           width,
+                         int           height)
+{
+  GtkScaler *self;
+
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+
+  self = GTK_SCALER (gtk_scaler_new (paintable, scale));
+  self->width = width;
+  self->height = height;
+
+  return GDK_PAINTABLE (self);
+}
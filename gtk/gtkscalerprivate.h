@@ -29,6 +29,10 @@ G_DECLARE_FINAL_TYPE (GtkScaler, gtk_scaler, GTK, SCALER, GObject)
 
 GdkPaintable *  gtk_scaler_new                  (GdkPaintable   *paintable,
                                                  double          scale);
+GdkPaintable *  gtk_scaler_new_for_size         (GdkPaintable   *paintable,
+                                                 double          scale,
+                                                 int             width,
+                                                 int             height);
 
 G_END_DECLS
 
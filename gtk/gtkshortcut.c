@@ -19,7 +19,7 @@
 
 #include "config.h"
 
-#include "gtkshortcut.h"
+#include "gtkshortcutprivate.h"
 
 #include "gtkshortcutaction.h"
 #include "gtkshortcuttrigger.h"
@@ -52,8 +52,16 @@ struct _GtkShortcut
   GtkShortcutAction *action;
   GtkShortcutTrigger *trigger;
   GVariant *args;
+
+  guint indexed : 1;
 };
 
+/* Bumped whenever the trigger of a shortcut changes that has been
+ * put into a shortcut controller's keyval index, so the controller
+ * knows that its index is stale.
+ */
+static guint trigger_serial;
+
 enum
 {
   PROP_0,
@@ -344,6 +352,8 @@ gtk_shortcut_set_trigger (GtkShortcut *self,
 
   if (g_set_object (&self->trigger, trigger))
     {
+      if (self->indexed)
+        trigger_serial++;
       g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_TRIGGER]);
       g_object_unref (trigger);
     }
@@ -387,3 +397,15 @@ gtk_shortcut_set_arguments (GtkShortcut *self,
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_ARGUMENTS]);
 }
+
+void
+gtk_shortcut_set_indexed (GtkShortcut *self)
+{
+  self->indexed = TRUE;
+}
+
+guint
+gtk_shortcut_get_trigger_serial (void)
+{
+  return trigger_serial;
+}
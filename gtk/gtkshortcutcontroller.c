@@ -70,7 +70,7 @@
 #include "gtkflattenlistmodel.h"
 #include "gtkbuildable.h"
 #include "gtkeventcontrollerprivate.h"
-#include "gtkshortcut.h"
+#include "gtkshortcutprivate.h"
 #include "gtkshortcutmanager.h"
 #include "gtkshortcuttrigger.h"
 #include "gtktypebuiltins.h"
@@ -80,6 +80,19 @@
 #include "gtkmodelbuttonprivate.h"
 
 #include <gdk/gdk.h>
+#include "gdk/gdkeventsprivate.h"
+
+/* Controllers with fewer shortcuts than this just try all of them */
+#define SHORTCUT_INDEX_MIN_ITEMS 32
+
+typedef struct _ShortcutIndex ShortcutIndex;
+
+struct _ShortcutIndex
+{
+  GHashTable *keyvals;          /* keyval => GArray of positions */
+  GArray *unindexed;            /* positions that always need to be tried */
+  guint trigger_serial;
+};
 
 struct _GtkShortcutController
 {
@@ -93,6 +106,8 @@ struct _GtkShortcutController
   guint custom_shortcuts : 1;
 
   guint last_activated;
+
+  ShortcutIndex *index;
 };
 
 struct _GtkShortcutControllerClass
@@ -176,6 +191,199 @@ G_DEFINE_TYPE_WITH_CODE (GtkShortcutController, gtk_shortcut_controller,
                          G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, gtk_shortcut_controller_list_model_init)
                          G_IMPLEMENT_INTERFACE (GTK_TYPE_BUILDABLE, gtk_shortcut_controller_buildable_init))
 
+static guint
+shortcut_index_normalize_keyval (guint keyval)
+{
+  /* Keyval and mnemonic triggers store their keyval this way */
+  if (keyval == GDK_KEY_ISO_Left_Tab)
+    return GDK_KEY_Tab;
+
+  return gdk_keyval_to_lower (keyval);
+}
+
+static void
+shortcut_index_add_keyval (ShortcutIndex *index,
+                           guint          keyval,
+                           guint          position)
+{
+  GArray *positions;
+
+  keyval = shortcut_index_normalize_keyval (keyval);
+
+  positions = g_hash_table_lookup (index->keyvals, GUINT_TO_POINTER (keyval));
+  if (positions == NULL)
+    {
+      positions = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (index->keyvals, GUINT_TO_POINTER (keyval), positions);
+    }
+
+  g_array_append_val (positions, position);
+}
+
+static void
+shortcut_index_add_trigger (ShortcutIndex      *index,
+                            GtkShortcutTrigger *trigger,
+                            guint               position)
+{
+  if (GTK_IS_KEYVAL_TRIGGER (trigger))
+    {
+      shortcut_index_add_keyval (index,
+                                 gtk_keyval_trigger_get_keyval (GTK_KEYVAL_TRIGGER (trigger)),
+                                 position);
+    }
+  else if (GTK_IS_MNEMONIC_TRIGGER (trigger))
+    {
+      shortcut_index_add_keyval (index,
+                                 gtk_mnemonic_trigger_get_keyval (GTK_MNEMONIC_TRIGGER (trigger)),
+                                 position);
+    }
+  else if (GTK_IS_ALTERNATIVE_TRIGGER (trigger))
+    {
+      GtkAlternativeTrigger *alternative = GTK_ALTERNATIVE_TRIGGER (trigger);
+
+      shortcut_index_add_trigger (index, gtk_alternative_trigger_get_first (alternative), position);
+      shortcut_index_add_trigger (index, gtk_alternative_trigger_get_second (alternative), position);
+    }
+  else if (GTK_IS_NEVER_TRIGGER (trigger))
+    {
+      /* never matches, nothing to do */
+    }
+  else
+    {
+      g_array_append_val (index->unindexed, position);
+    }
+}
+
+static void
+shortcut_index_free (ShortcutIndex *index)
+{
+  g_hash_table_unref (index->keyvals);
+  g_array_unref (index->unindexed);
+  g_free (index);
+}
+
+static ShortcutIndex *
+shortcut_index_new (GListModel *shortcuts)
+{
+  ShortcutIndex *index;
+  guint i, n;
+
+  index = g_new (ShortcutIndex, 1);
+  index->keyvals = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_array_unref);
+  index->unindexed = g_array_new (FALSE, FALSE, sizeof (guint));
+  index->trigger_serial = gtk_shortcut_get_trigger_serial ();
+
+  for (i = 0, n = g_list_model_get_n_items (shortcuts); i < n; i++)
+    {
+      gpointer item = g_list_model_get_item (shortcuts, i);
+
+      if (GTK_IS_SHORTCUT (item))
+        {
+          gtk_shortcut_set_indexed (item);
+          shortcut_index_add_trigger (index, gtk_shortcut_get_trigger (item), i);
+        }
+
+      g_object_unref (item);
+    }
+
+  return index;
+}
+
+static void
+shortcut_index_lookup (ShortcutIndex *index,
+                       guint          keyval,
+                       GArray        *result)
+{
+  GArray *positions;
+
+  positions = g_hash_table_lookup (index->keyvals,
+                                   GUINT_TO_POINTER (shortcut_index_normalize_keyval (keyval)));
+  if (positions)
+    g_array_append_vals (result, positions->data, positions->len);
+}
+
+static int
+compare_positions (gconstpointer a,
+                   gconstpointer b)
+{
+  guint pa = *(const guint *) a;
+  guint pb = *(const guint *) b;
+
+  return (pa > pb) - (pa < pb);
+}
+
+static void
+gtk_shortcut_controller_clear_index (GtkShortcutController *self)
+{
+  g_clear_pointer (&self->index, shortcut_index_free);
+}
+
+/*<private>
+ * gtk_shortcut_controller_get_candidates:
+ * @self: a `GtkShortcutController`
+ * @event: a key event
+ *
+ * Looks up the positions of all shortcuts whose trigger may
+ * match @event. A keyval trigger can match any keyval that the
+ * hardware keycode of the event produces in any layout or level,
+ * so all of those are looked up.
+ *
+ * Returns: (nullable) (transfer full): a sorted array of positions
+ *   or %NULL if all shortcuts need to be tried
+ */
+static GArray *
+gtk_shortcut_controller_get_candidates (GtkShortcutController *self,
+                                        GdkEvent              *event)
+{
+  GArray *candidates;
+  guint *keyvals;
+  int i, n_keyvals;
+  guint j, k;
+
+  if (g_list_model_get_n_items (self->shortcuts) < SHORTCUT_INDEX_MIN_ITEMS)
+    return NULL;
+
+  if (self->index &&
+      self->index->trigger_serial != gtk_shortcut_get_trigger_serial ())
+    gtk_shortcut_controller_clear_index (self);
+
+  if (self->index == NULL)
+    self->index = shortcut_index_new (self->shortcuts);
+
+  candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_array_append_vals (candidates, self->index->unindexed->data, self->index->unindexed->len);
+
+  shortcut_index_lookup (self->index, gdk_key_event_get_translated_key (event, FALSE)->keyval, candidates);
+  shortcut_index_lookup (self->index, gdk_key_event_get_translated_key (event, TRUE)->keyval, candidates);
+
+  if (gdk_display_map_keycode (gdk_event_get_display (event),
+                               gdk_key_event_get_keycode (event),
+                               NULL,
+                               &keyvals,
+                               &n_keyvals))
+    {
+      for (i = 0; i < n_keyvals; i++)
+        shortcut_index_lookup (self->index, keyvals[i], candidates);
+
+      g_free (keyvals);
+    }
+
+  if (candidates->len < 2)
+    return candidates;
+
+  g_array_sort (candidates, compare_positions);
+
+  /* Shortcuts show up once per matching keyval, drop the duplicates */
+  for (j = 1, k = 1; k < candidates->len; k++)
+    {
+      if (g_array_index (candidates, guint, k) != g_array_index (candidates, guint, j - 1))
+        g_array_index (candidates, guint, j++) = g_array_index (candidates, guint, k);
+    }
+  g_array_set_size (candidates, j);
+
+  return candidates;
+}
+
 static gboolean
 gtk_shortcut_controller_is_rooted (GtkShortcutController *self)
 {
@@ -194,6 +402,8 @@ gtk_shortcut_controller_items_changed_cb (GListModel            *model,
                                           guint                  added,
                                           GtkShortcutController *self)
 {
+  gtk_shortcut_controller_clear_index (self);
+
   g_list_model_items_changed (G_LIST_MODEL (self), position, removed, added);
   if (removed != added)
     g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
@@ -292,6 +502,7 @@ gtk_shortcut_controller_finalize (GObject *object)
 
   g_clear_signal_handler (&self->shortcuts_changed_id, self->shortcuts);
   g_clear_object (&self->shortcuts);
+  gtk_shortcut_controller_clear_index (self);
 
   G_OBJECT_CLASS (gtk_shortcut_controller_parent_class)->finalize (object);
 }
@@ -320,10 +531,31 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
   GtkShortcutController *self = GTK_SHORTCUT_CONTROLLER (controller);
   int i, p;
   GArray *shortcuts = NULL;
+  GArray *candidates;
+  guint n_items, start;
   gboolean has_exact = FALSE;
   gboolean retval = FALSE;
 
-  for (i = 0, p = g_list_model_get_n_items (self->shortcuts); i < p; i++)
+  n_items = g_list_model_get_n_items (self->shortcuts);
+  candidates = gtk_shortcut_controller_get_candidates (self, event);
+  start = 0;
+  if (candidates)
+    {
+      p = candidates->len;
+      /* Continue the round-robin after the last activated shortcut */
+      if (enable_mnemonics)
+        {
+          while (start < candidates->len &&
+                 g_array_index (candidates, guint, start) <= self->last_activated)
+            start++;
+        }
+    }
+  else
+    {
+      p = n_items;
+    }
+
+  for (i = 0; i < p; i++)
     {
       GtkShortcut *shortcut;
       ShortcutData *data;
@@ -334,8 +566,10 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
       /* This is not entirely right, but we only want to do round-robin cycling
        * for mnemonics.
        */
-      if (enable_mnemonics)
-        index = (self->last_activated + 1 + i) % g_list_model_get_n_items (self->shortcuts);
+      if (candidates)
+        index = g_array_index (candidates, guint, (start + i) % candidates->len);
+      else if (enable_mnemonics)
+        index = (self->last_activated + 1 + i) % n_items;
       else
         index = i;
 
@@ -417,6 +651,8 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
                  gdk_event_get_modifier_state (event));
     }
 
+  g_clear_pointer (&candidates, g_array_unref);
+
   if (!shortcuts)
     return retval;
 
@@ -95,6 +95,31 @@ gtk_sort_keys_needs_clear_key (GtkSortKeys *self)
   return self->klass->clear_key != NULL;
 }
 
+/*<private>
+ * gtk_sort_keys_is_threadsafe:
+ * @self: a `GtkSortKeys`
+ *
+ * Checks if keys can be compared and finished from other threads
+ * than the main thread.
+ *
+ * Only gtk_sort_keys_prepare_key() needs to access the item and must
+ * be called on the main thread. Once all keys are prepared, they can
+ * be finished with gtk_sort_keys_finish_key() and sorted in parallel.
+ *
+ * Returns: %TRUE if the keys are threadsafe
+ **/
+gboolean
+gtk_sort_keys_is_threadsafe (GtkSortKeys *self)
+{
+  return self->threadsafe;
+}
+
+gboolean
+gtk_sort_keys_needs_finish_key (GtkSortKeys *self)
+{
+  return self->klass->finish_key != NULL;
+}
+
 static void
 gtk_equal_sort_keys_free (GtkSortKeys *keys)
 {
@@ -143,8 +168,13 @@ static const GtkSortKeysClass GTK_EQUAL_SORT_KEYS_CLASS =
 GtkSortKeys *
 gtk_sort_keys_new_equal (void)
 {
-  return gtk_sort_keys_new (GtkSortKeys,
-                            &GTK_EQUAL_SORT_KEYS_CLASS,
-                            0, 1);
+  GtkSortKeys *result;
+
+  result = gtk_sort_keys_new (GtkSortKeys,
+                              &GTK_EQUAL_SORT_KEYS_CLASS,
+                              0, 1);
+  result->threadsafe = TRUE;
+
+  return result;
 }
 
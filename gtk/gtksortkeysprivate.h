@@ -31,6 +31,9 @@ struct _GtkSortKeys
 
   gsize key_size;
   gsize key_align; /* must be power of 2 */
+
+  /* key_compare() and finish_key() may be called from any thread */
+  gboolean threadsafe;
 };
 
 struct _GtkSortKeysClass
@@ -47,6 +50,14 @@ struct _GtkSortKeysClass
                                                                  gpointer                key_memory);
   void                  (* clear_key)                           (GtkSortKeys            *self,
                                                                  gpointer                key_memory);
+
+  /* optional: init_key() split into a part that needs the item and
+   * a part that does the expensive work on the intermediate result */
+  void                  (* prepare_key)                         (GtkSortKeys            *self,
+                                                                 gpointer                item,
+                                                                 gpointer                key_memory);
+  void                  (* finish_key)                          (GtkSortKeys            *self,
+                                                                 gpointer                key_memory);
 };
 
 GtkSortKeys *           gtk_sort_keys_alloc                     (const GtkSortKeysClass *klass,
@@ -66,6 +77,8 @@ GCompareDataFunc        gtk_sort_keys_get_key_compare_func      (GtkSortKeys
 gboolean                gtk_sort_keys_is_compatible             (GtkSortKeys            *self,
                                                                  GtkSortKeys            *other);
 gboolean                gtk_sort_keys_needs_clear_key           (GtkSortKeys            *self);
+gboolean                gtk_sort_keys_is_threadsafe             (GtkSortKeys            *self);
+gboolean                gtk_sort_keys_needs_finish_key          (GtkSortKeys            *self);
 
 #define GTK_SORT_KEYS_ALIGN(_size,_align) (((_size) + (_align) - 1) & ~((_align) - 1))
 static inline int
@@ -84,6 +97,25 @@ gtk_sort_keys_init_key (GtkSortKeys *self,
   self->klass->init_key (self, item, key_memory);
 }
 
+static inline void
+gtk_sort_keys_prepare_key (GtkSortKeys *self,
+                           gpointer     item,
+                           gpointer     key_memory)
+{
+  if (self->klass->prepare_key)
+    self->klass->prepare_key (self, item, key_memory);
+  else
+    self->klass->init_key (self, item, key_memory);
+}
+
+static inline void
+gtk_sort_keys_finish_key (GtkSortKeys *self,
+                          gpointer     key_memory)
+{
+  if (self->klass->finish_key)
+    self->klass->finish_key (self, key_memory);
+}
+
 static inline void
 gtk_sort_keys_clear_key (GtkSortKeys *self,
                          gpointer       key_memory)
@@ -28,6 +28,8 @@
 #include "gtksorterprivate.h"
 #include "timsort/gtktimsortprivate.h"
 
+#include "gdk/gdkparalleltaskprivate.h"
+
 /* The maximum amount of items to merge for a single merge step
  *
  * Making this smaller will result in more steps, which has more overhead and slows
@@ -53,6 +55,19 @@
  */
 #define GTK_SORT_STEP_TIME_US (1000) /* 1 millisecond */
 
+/* Minimum number of items before we sort in parallel
+ *
+ * Below that, the overhead of waking up the threads is larger than
+ * the time it takes to just sort the items.
+ */
+#define GTK_SORT_PARALLEL_MIN_ITEMS (16384)
+
+/* The number of items a thread handles at once when creating keys
+ * or sorting in parallel.
+ * When sorting, chunks are sorted independently and then merged pairwise.
+ */
+#define GTK_SORT_PARALLEL_CHUNK_SIZE (1024)
+
 /**
  * GtkSortListModel:
  *
@@ -70,6 +85,12 @@
  * sorting long lists doesn't block the UI. See
  * [method@Gtk.SortListModel.set_incremental] for details.
  *
+ * When sorting a large number of items with sorters that support it,
+ * like [class@Gtk.StringSorter] and [class@Gtk.NumericSorter], the
+ * work is spread over multiple threads. Only the evaluation of the
+ * expressions is done on the main thread, the sort keys are computed
+ * and sorted in parallel and the result is published at once.
+ *
  * `GtkSortListModel` is a generic model and because of that it
  * cannot take advantage of any external knowledge when sorting.
  * If you run into performance issues with `GtkSortListModel`,
@@ -108,6 +129,7 @@ struct _GtkSortListModel
 
   GtkTimSort sort; /* ongoing sort operation */
   guint sort_cb; /* 0 or current ongoing sort callback */
+  gboolean sort_parallel; /* ongoing sort operation is done in parallel */
 
   guint n_items;
   GtkSortKeys *sort_keys;
@@ -351,6 +373,8 @@ static void
 gtk_sort_list_model_stop_sorting (GtkSortListModel *self,
                                   gsize            *runs)
 {
+  self->sort_parallel = FALSE;
+
   if (self->sort_cb == 0)
     {
       if (runs)
@@ -369,6 +393,201 @@ gtk_sort_list_model_stop_sorting (GtkSortListModel *self,
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
 }
 
+static int
+sort_func (gconstpointer a,
+           gconstpointer b,
+           gpointer      data)
+{
+  gpointer *sa = (gpointer *) a;
+  gpointer *sb = (gpointer *) b;
+  int result;
+
+  result = gtk_sort_keys_compare (data, *sa, *sb);
+  if (result)
+    return result;
+
+  return *sa < *sb ? -1 : 1;
+}
+
+typedef struct _FinishKeysData FinishKeysData;
+struct _FinishKeysData
+{
+  GtkSortListModel *self;
+  GArray *positions;
+  int n_chunks;
+  int next_chunk;
+};
+
+static void
+gtk_sort_list_model_finish_keys_func (gpointer data)
+{
+  FinishKeysData *fk = data;
+  GtkSortListModel *self = fk->self;
+  int chunk;
+
+  for (chunk = g_atomic_int_add (&fk->next_chunk, 1);
+       chunk < fk->n_chunks;
+       chunk = g_atomic_int_add (&fk->next_chunk, 1))
+    {
+      guint i, end;
+
+      end = MIN ((guint) (chunk + 1) * GTK_SORT_PARALLEL_CHUNK_SIZE, fk->positions->len);
+      for (i = chunk * GTK_SORT_PARALLEL_CHUNK_SIZE; i < end; i++)
+        {
+          guint pos = g_array_index (fk->positions, guint, i);
+
+          gtk_sort_keys_finish_key (self->sort_keys, key_from_pos (self, pos));
+        }
+    }
+}
+
+/* Turns the prepared keys at @positions into real keys */
+static void
+gtk_sort_list_model_finish_keys (GtkSortListModel *self,
+                                 GArray           *positions)
+{
+  FinishKeysData fk = {
+    .self = self,
+    .positions = positions,
+    .n_chunks = (positions->len + GTK_SORT_PARALLEL_CHUNK_SIZE - 1) / GTK_SORT_PARALLEL_CHUNK_SIZE,
+    .next_chunk = 0,
+  };
+
+  if (gtk_sort_keys_needs_finish_key (self->sort_keys) && positions->len > 0)
+    {
+      if (fk.n_chunks > 1)
+        gdk_parallel_task_run (gtk_sort_list_model_finish_keys_func, &fk);
+      else
+        gtk_sort_list_model_finish_keys_func (&fk);
+    }
+
+  g_array_unref (positions);
+}
+
+typedef struct _SortData SortData;
+struct _SortData
+{
+  GtkSortKeys *sort_keys;
+  gsize n_items;
+  gpointer *src;
+  gpointer *dest;
+  gsize run_size; /* size of the sorted runs in src */
+  int n_tasks;
+  int next_task;
+};
+
+static void
+gtk_sort_list_model_sort_chunks_func (gpointer data)
+{
+  SortData *sd = data;
+  int task;
+
+  for (task = g_atomic_int_add (&sd->next_task, 1);
+       task < sd->n_tasks;
+       task = g_atomic_int_add (&sd->next_task, 1))
+    {
+      gsize start = (gsize) task * sd->run_size;
+
+      gtk_tim_sort (sd->src + start,
+                    MIN (sd->run_size, sd->n_items - start),
+                    sizeof (gpointer),
+                    sort_func,
+                    sd->sort_keys);
+    }
+}
+
+static void
+gtk_sort_list_model_merge_runs_func (gpointer data)
+{
+  SortData *sd = data;
+  int task;
+
+  for (task = g_atomic_int_add (&sd->next_task, 1);
+       task < sd->n_tasks;
+       task = g_atomic_int_add (&sd->next_task, 1))
+    {
+      gsize start, mid, end;
+      gpointer *a, *b, *dest;
+
+      start = (gsize) task * 2 * sd->run_size;
+      mid = MIN (start + sd->run_size, sd->n_items);
+      end = MIN (mid + sd->run_size, sd->n_items);
+
+      a = sd->src + start;
+      b = sd->src + mid;
+      dest = sd->dest + start;
+
+      /* sort_func() never considers 2 items equal, so this is stable */
+      while (a < sd->src + mid && b < sd->src + end)
+        {
+          if (sort_func (a, b, sd->sort_keys) < 0)
+            *dest++ = *a++;
+          else
+            *dest++ = *b++;
+        }
+
+      memcpy (dest, a, (sd->src + mid - a) * sizeof (gpointer));
+      dest += sd->src + mid - a;
+      memcpy (dest, b, (sd->src + end - b) * sizeof (gpointer));
+    }
+}
+
+/* Sorts all items at once, using all cores.
+ *
+ * The items are split into chunks that are sorted in parallel and
+ * then merged pairwise in parallel until a single sorted run is left.
+ * All keys must exist when calling this.
+ */
+static void
+gtk_sort_list_model_sort_parallel (GtkSortListModel *self)
+{
+  SortData sd = {
+    .sort_keys = self->sort_keys,
+    .n_items = self->n_items,
+    .src = self->positions,
+    .run_size = GTK_SORT_PARALLEL_CHUNK_SIZE,
+  };
+  gpointer *tmp;
+
+  sd.n_tasks = (self->n_items + sd.run_size - 1) / sd.run_size;
+  sd.next_task = 0;
+  gdk_parallel_task_run (gtk_sort_list_model_sort_chunks_func, &sd);
+
+  tmp = g_new (gpointer, self->n_items);
+  sd.dest = tmp;
+
+  for (; sd.run_size < self->n_items; sd.run_size *= 2)
+    {
+      gpointer *swap;
+
+      sd.n_tasks = (self->n_items + 2 * sd.run_size - 1) / (2 * sd.run_size);
+      sd.next_task = 0;
+      if (sd.n_tasks > 1)
+        gdk_parallel_task_run (gtk_sort_list_model_merge_runs_func, &sd);
+      else
+        gtk_sort_list_model_merge_runs_func (&sd);
+
+      swap = sd.src;
+      sd.src = sd.dest;
+      sd.dest = swap;
+    }
+
+  if (sd.src != self->positions)
+    memcpy (self->positions, sd.src, self->n_items * sizeof (gpointer));
+
+  g_free (tmp);
+
+  /* Let the ongoing sort know that everything is sorted now */
+  gtk_tim_sort_finish (&self->sort);
+  gtk_tim_sort_init (&self->sort,
+                     self->positions,
+                     self->n_items,
+                     sizeof (gpointer),
+                     sort_func,
+                     self->sort_keys);
+  gtk_tim_sort_set_runs (&self->sort, (gsize[2]) { self->n_items, 0 });
+}
+
 static gboolean
 gtk_sort_list_model_sort_step (GtkSortListModel *self,
                                gboolean          finish,
@@ -385,28 +604,54 @@ gtk_sort_list_model_sort_step (GtkSortListModel *self,
   if (!gtk_bitset_is_empty (self->missing_keys))
     {
       GtkBitsetIter iter;
+      GArray *prepared = NULL;
       guint pos;
 
+      /* When sorting in parallel, we only prepare the keys here and
+       * finish them in threads */
+      if (self->sort_parallel)
+        prepared = g_array_new (FALSE, FALSE, sizeof (guint));
+
       for (gtk_bitset_iter_init_first (&iter, self->missing_keys, &pos);
            gtk_bitset_iter_is_valid (&iter);
            gtk_bitset_iter_next (&iter, &pos))
         {
           gpointer item = g_list_model_get_item (self->model, pos);
-          gtk_sort_keys_init_key (self->sort_keys, item, key_from_pos (self, pos));
+          if (prepared)
+            {
+              gtk_sort_keys_prepare_key (self->sort_keys, item, key_from_pos (self, pos));
+              g_array_append_val (prepared, pos);
+            }
+          else
+            gtk_sort_keys_init_key (self->sort_keys, item, key_from_pos (self, pos));
           g_object_unref (item);
 
           if (g_get_monotonic_time () >= end_time && !finish)
             {
+              if (prepared)
+                gtk_sort_list_model_finish_keys (self, prepared);
               gtk_bitset_remove_range_closed (self->missing_keys, 0, pos);
               *out_position = 0;
               *out_n_items = 0;
               return TRUE;
             }
         }
+      if (prepared)
+        gtk_sort_list_model_finish_keys (self, prepared);
       result = TRUE;
       gtk_bitset_remove_all (self->missing_keys);
     }
 
+  if (self->sort_parallel)
+    {
+      gtk_sort_list_model_sort_parallel (self);
+      self->sort_parallel = FALSE;
+
+      *out_position = 0;
+      *out_n_items = self->n_items;
+      return TRUE;
+    }
+
   end_change = self->positions;
   start_change = self->positions + self->n_items;
 
@@ -455,28 +700,18 @@ gtk_sort_list_model_sort_cb (gpointer data)
   return G_SOURCE_REMOVE;
 }
 
-static int
-sort_func (gconstpointer a,
-           gconstpointer b,
-           gpointer      data)
-{
-  gpointer *sa = (gpointer *) a;
-  gpointer *sb = (gpointer *) b;
-  int result;
-
-  result = gtk_sort_keys_compare (data, *sa, *sb);
-  if (result)
-    return result;
-
-  return *sa < *sb ? -1 : 1;
-}
-
 static gboolean
 gtk_sort_list_model_start_sorting (GtkSortListModel *self,
                                    gsize            *runs)
 {
   g_assert (self->sort_cb == 0);
 
+  /* Only sort in parallel when sorting from scratch, otherwise
+   * resuming the sort with the existing runs is faster */
+  self->sort_parallel = runs == NULL &&
+                        self->n_items >= GTK_SORT_PARALLEL_MIN_ITEMS &&
+                        gtk_sort_keys_is_threadsafe (self->sort_keys);
+
   gtk_tim_sort_init (&self->sort,
                      self->positions,
                      self->n_items,
@@ -21,6 +21,7 @@
 
 #include "gtkstringfilter.h"
 
+#include "gtkfilterprivate.h"
 #include "gtktypebuiltins.h"
 
 /**
@@ -68,8 +69,8 @@ G_DEFINE_TYPE (GtkStringFilter, gtk_string_filter, GTK_TYPE_FILTER)
 static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
 
 static char *
-gtk_string_filter_prepare (GtkStringFilter *self,
-                           const char      *s)
+gtk_string_filter_prepare (const char *s,
+                           gboolean    ignore_case)
 {
   char *tmp;
   char *result;
@@ -79,7 +80,7 @@ gtk_string_filter_prepare (GtkStringFilter *self,
 
   tmp = g_utf8_normalize (s, -1, G_NORMALIZE_ALL);
 
-  if (!self->ignore_case)
+  if (!ignore_case)
     return tmp;
 
   result = g_utf8_casefold (tmp, -1);
@@ -97,6 +98,25 @@ gtk_string_filter_has_search (GtkStringFilter *self)
   return self->search_prepared != NULL;
 }
 
+static gboolean
+gtk_string_filter_match_prepared (const char               *prepared,
+                                  const char               *search_prepared,
+                                  GtkStringFilterMatchMode  match_mode)
+{
+  switch (match_mode)
+    {
+    case GTK_STRING_FILTER_MATCH_MODE_EXACT:
+      return strcmp (prepared, search_prepared) == 0;
+    case GTK_STRING_FILTER_MATCH_MODE_SUBSTRING:
+      return strstr (prepared, search_prepared) != NULL;
+    case GTK_STRING_FILTER_MATCH_MODE_PREFIX:
+      return g_str_has_prefix (prepared, search_prepared);
+    default:
+      g_assert_not_reached ();
+      return FALSE;
+    }
+}
+
 static gboolean
 gtk_string_filter_match (GtkFilter *filter,
                          gpointer   item)
@@ -114,25 +134,15 @@ gtk_string_filter_match (GtkFilter *filter,
       !gtk_expression_evaluate (self->expression, item, &value))
     return FALSE;
   s = g_value_get_string (&value);
-  prepared = gtk_string_filter_prepare (self, s);
+  prepared = gtk_string_filter_prepare (s, self->ignore_case);
   if (prepared == NULL)
-    return FALSE;
-
-  switch (self->match_mode)
     {
-    case GTK_STRING_FILTER_MATCH_MODE_EXACT:
-      result = strcmp (prepared, self->search_prepared) == 0;
-      break;
-    case GTK_STRING_FILTER_MATCH_MODE_SUBSTRING:
-      result = strstr (prepared, self->search_prepared) != NULL;
-      break;
-    case GTK_STRING_FILTER_MATCH_MODE_PREFIX:
-      result = g_str_has_prefix (prepared, self->search_prepared);
-      break;
-    default:
-      g_assert_not_reached ();
+      g_value_unset (&value);
+      return FALSE;
     }
 
+  result = gtk_string_filter_match_prepared (prepared, self->search_prepared, self->match_mode);
+
 #if 0
   g_print ("%s (%s) %s %s (%s)\n", s, prepared, result ? "==" : "!=", self->search, self->search_prepared);
 #endif
@@ -143,6 +153,121 @@ gtk_string_filter_match (GtkFilter *filter,
   return result;
 }
 
+/* The keys cache the prepared string of every item, so when the
+ * search changes, only the cheap matching needs to be redone.
+ */
+typedef struct _GtkStringFilterKeys GtkStringFilterKeys;
+struct _GtkStringFilterKeys
+{
+  GtkFilterKeys keys;
+
+  GtkExpression *expression;
+  gboolean ignore_case;
+
+  char *search_prepared;
+  GtkStringFilterMatchMode match_mode;
+};
+
+static void
+gtk_string_filter_keys_free (GtkFilterKeys *keys)
+{
+  GtkStringFilterKeys *self = (GtkStringFilterKeys *) keys;
+
+  gtk_expression_unref (self->expression);
+  g_free (self->search_prepared);
+  g_free (self);
+}
+
+static gboolean
+gtk_string_filter_keys_is_compatible (GtkFilterKeys *keys,
+                                      GtkFilterKeys *other)
+{
+  GtkStringFilterKeys *self = (GtkStringFilterKeys *) keys;
+  GtkStringFilterKeys *compare = (GtkStringFilterKeys *) other;
+
+  if (keys->klass != other->klass)
+    return FALSE;
+
+  return self->expression == compare->expression &&
+         self->ignore_case == compare->ignore_case;
+}
+
+static void
+gtk_string_filter_keys_init_key (GtkFilterKeys *keys,
+                                 gpointer       item,
+                                 gpointer       key_memory)
+{
+  GtkStringFilterKeys *self = (GtkStringFilterKeys *) keys;
+  char **key = (char **) key_memory;
+  GValue value = G_VALUE_INIT;
+
+  if (!gtk_expression_evaluate (self->expression, item, &value))
+    {
+      *key = NULL;
+      return;
+    }
+
+  *key = gtk_string_filter_prepare (g_value_get_string (&value), self->ignore_case);
+
+  g_value_unset (&value);
+}
+
+static void
+gtk_string_filter_keys_clear_key (GtkFilterKeys *keys,
+                                  gpointer       key_memory)
+{
+  char **key = (char **) key_memory;
+
+  g_free (*key);
+}
+
+static gboolean
+gtk_string_filter_keys_match_key (GtkFilterKeys *keys,
+                                  gconstpointer  key_memory)
+{
+  GtkStringFilterKeys *self = (GtkStringFilterKeys *) keys;
+  const char *key = *(const char **) key_memory;
+
+  if (self->search_prepared == NULL)
+    return TRUE;
+
+  if (key == NULL)
+    return FALSE;
+
+  return gtk_string_filter_match_prepared (key, self->search_prepared, self->match_mode);
+}
+
+static const GtkFilterKeysClass GTK_STRING_FILTER_KEYS_CLASS =
+{
+  gtk_string_filter_keys_free,
+  gtk_string_filter_keys_is_compatible,
+  gtk_string_filter_keys_init_key,
+  gtk_string_filter_keys_clear_key,
+  gtk_string_filter_keys_match_key,
+};
+
+static GtkFilterKeys *
+gtk_string_filter_keys_new (GtkStringFilter *self)
+{
+  GtkStringFilterKeys *result;
+
+  if (self->expression == NULL)
+    return NULL;
+
+  result = gtk_filter_keys_new (GtkStringFilterKeys,
+                                &GTK_STRING_FILTER_KEYS_CLASS,
+                                sizeof (char *),
+                                G_ALIGNOF (char *));
+
+  result->expression = gtk_expression_ref (self->expression);
+  result->ignore_case = self->ignore_case;
+  result->search_prepared = g_strdup (self->search_prepared);
+  result->match_mode = self->match_mode;
+  result->keys.threadsafe = TRUE;
+
+  return (GtkFilterKeys *) result;
+}
+
 static GtkFilterMatch
 gtk_string_filter_get_strictness (GtkFilter *filter)
 {
@@ -372,9 +497,9 @@ gtk_string_filter_set_search (GtkStringFilter *self,
   g_free (self->search_prepared);
 
   self->search = g_strdup (search);
-  self->search_prepared = gtk_string_filter_prepare (self, search);
+  self->search_prepared = gtk_string_filter_prepare (search, self->ignore_case);
 
-  gtk_filter_changed (GTK_FILTER (self), change);
+  gtk_filter_changed_with_keys (GTK_FILTER (self), change, gtk_string_filter_keys_new (self));
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_SEARCH]);
 }
@@ -420,7 +545,9 @@ gtk_string_filter_set_expression (GtkStringFilter *self,
   self->expression = gtk_expression_ref (expression);
 
   if (gtk_string_filter_has_search (self))
-    gtk_filter_changed (GTK_FILTER (self), GTK_FILTER_CHANGE_DIFFERENT);
+    gtk_filter_changed_with_keys (GTK_FILTER (self), GTK_FILTER_CHANGE_DIFFERENT, gtk_string_filter_keys_new (self));
+  else
+    gtk_filter_set_keys (GTK_FILTER (self), gtk_string_filter_keys_new (self));
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_EXPRESSION]);
 }
@@ -462,9 +589,13 @@ gtk_string_filter_set_ignore_case (GtkStringFilter *self,
   if (self->search)
     {
       g_free (self->search_prepared);
-      self->search_prepared = gtk_string_filter_prepare (self, self->search);
-      gtk_filter_changed (GTK_FILTER (self), ignore_case ? GTK_FILTER_CHANGE_LESS_STRICT : GTK_FILTER_CHANGE_MORE_STRICT);
+      self->search_prepared = gtk_string_filter_prepare (self->search, self->ignore_case);
+      gtk_filter_changed_with_keys (GTK_FILTER (self),
+                                    ignore_case ? GTK_FILTER_CHANGE_LESS_STRICT : GTK_FILTER_CHANGE_MORE_STRICT,
+                                    gtk_string_filter_keys_new (self));
     }
+  else
+    gtk_filter_set_keys (GTK_FILTER (self), gtk_string_filter_keys_new (self));
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_IGNORE_CASE]);
 }
@@ -511,18 +642,18 @@ gtk_string_filter_set_match_mode (GtkStringFilter *self,
       switch (old_mode)
         {
         case GTK_STRING_FILTER_MATCH_MODE_EXACT:
-          gtk_filter_changed (GTK_FILTER (self), GTK_FILTER_CHANGE_LESS_STRICT);
+          gtk_filter_changed_with_keys (GTK_FILTER (self), GTK_FILTER_CHANGE_LESS_STRICT, gtk_string_filter_keys_new (self));
           break;
 
         case GTK_STRING_FILTER_MATCH_MODE_SUBSTRING:
-          gtk_filter_changed (GTK_FILTER (self), GTK_FILTER_CHANGE_MORE_STRICT);
+          gtk_filter_changed_with_keys (GTK_FILTER (self), GTK_FILTER_CHANGE_MORE_STRICT, gtk_string_filter_keys_new (self));
           break;
 
         case GTK_STRING_FILTER_MATCH_MODE_PREFIX:
           if (mode == GTK_STRING_FILTER_MATCH_MODE_SUBSTRING)
-            gtk_filter_changed (GTK_FILTER (self), GTK_FILTER_CHANGE_LESS_STRICT);
+            gtk_filter_changed_with_keys (GTK_FILTER (self), GTK_FILTER_CHANGE_LESS_STRICT, gtk_string_filter_keys_new (self));
           else
-            gtk_filter_changed (GTK_FILTER (self), GTK_FILTER_CHANGE_MORE_STRICT);
+            gtk_filter_changed_with_keys (GTK_FILTER (self), GTK_FILTER_CHANGE_MORE_STRICT, gtk_string_filter_keys_new (self));
           break;
 
         default:
@@ -530,6 +661,8 @@ gtk_string_filter_set_match_mode (GtkStringFilter *self,
           break;
         }
     }
+  else
+    gtk_filter_set_keys (GTK_FILTER (self), gtk_string_filter_keys_new (self));
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MATCH_MODE]);
 }
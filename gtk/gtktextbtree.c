@@ -66,6 +66,7 @@
 #include "gtkdebug.h"
 #include "gtktextmarkprivate.h"
 #include "gtktextsegmentprivate.h"
+#include "gtktextsearchprivate.h"
 #include "gtkpangoprivate.h"
 #include "gdkprivate.h"
 
@@ -209,6 +210,8 @@ struct _GtkTextBTree {
   guint end_iter_segment_stamp;
 
   GHashTable *child_anchor_table;
+
+  GtkTextSearchCache *search_cache;
 };
 
 
@@ -508,6 +511,8 @@ _gtk_text_btree_unref (GtkTextBTree *tree)
 	  tree->child_anchor_table = NULL;
 	}
 
+      g_clear_pointer (&tree->search_cache, gtk_text_search_cache_free);
+
       g_object_unref (tree->insert_mark);
       tree->insert_mark = NULL;
       g_object_unref (tree->selection_bound_mark);
@@ -530,6 +535,15 @@ _gtk_text_btree_get_chars_changed_stamp (GtkTextBTree *tree)
   return tree->chars_changed_stamp;
 }
 
+GtkTextSearchCache *
+_gtk_text_btree_get_search_cache (GtkTextBTree *tree)
+{
+  if (tree->search_cache == NULL)
+    tree->search_cache = gtk_text_search_cache_new ();
+
+  return tree->search_cache;
+}
+
 guint
 _gtk_text_btree_get_segments_changed_stamp (GtkTextBTree *tree)
 {
@@ -27,6 +27,7 @@
 #include "gtktextbtreeprivate.h"
 #include "gtktextbufferprivate.h"
 #include "gtktextiterprivate.h"
+#include "gtktextsearchprivate.h"
 #include "gtkdebug.h"
 
 #include <string.h>
@@ -4949,6 +4950,24 @@ strbreakup (const char *string,
   return str_array;
 }
 
+typedef struct {
+  int start;
+  int end;
+} SearchFirstData;
+
+static gboolean
+search_first_cb (int      match_start,
+                 int      match_end,
+                 gpointer user_data)
+{
+  SearchFirstData *data = user_data;
+
+  data->start = match_start;
+  data->end = match_end;
+
+  return FALSE;
+}
+
 /**
  * gtk_text_iter_forward_search:
  * @iter: start of search
@@ -5015,6 +5034,30 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
         return FALSE;
     }
 
+  if (gtk_text_search_is_supported (str, flags))
+    {
+      SearchFirstData data = { -1, -1 };
+
+      gtk_text_search_foreach (iter, limit, str, flags, search_first_cb, &data);
+
+      if (data.start < 0 ||
+          (limit && data.end > gtk_text_iter_get_offset (limit)))
+        return FALSE;
+
+      if (match_start)
+        {
+          *match_start = *iter;
+          gtk_text_iter_set_offset (match_start, data.start);
+        }
+      if (match_end)
+        {
+          *match_end = *iter;
+          gtk_text_iter_set_offset (match_end, data.end);
+        }
+
+      return TRUE;
+    }
+
   visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
   slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
   case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
@@ -5063,6 +5106,108 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
   return retval;
 }
 
+typedef struct {
+  GArray *offsets;
+  int limit;
+} SearchAllData;
+
+static gboolean
+search_all_cb (int      match_start,
+               int      match_end,
+               gpointer user_data)
+{
+  SearchAllData *data = user_data;
+
+  if (match_end > data->limit)
+    return FALSE;
+
+  g_array_append_val (data->offsets, match_start);
+  g_array_append_val (data->offsets, match_end);
+
+  return TRUE;
+}
+
+/**
+ * gtk_text_iter_search_all:
+ * @start: start of the range to search
+ * @end: (nullable): end of the range, or %NULL for the end of the buffer
+ * @str: a search string
+ * @flags: flags affecting how the search is done
+ * @n_offsets: (out): return location for the number of returned offsets
+ *
+ * Finds all non-overlapping occurrences of @str between @start and @end.
+ *
+ * This is meant for highlighting all matches in a buffer, and is
+ * a lot cheaper than calling [method@Gtk.TextIter.forward_search]
+ * repeatedly.
+ *
+ * The matches are returned as pairs of character offsets into
+ * the buffer: the start of the n-th match is at index `2 * n`
+ * and its end at index `2 * n + 1`. The number of matches is
+ * half of @n_offsets.
+ *
+ * Returns: (transfer full) (array length=n_offsets) (nullable): the
+ *   offsets of the matches, or %NULL if there are none
+ *
+ * Since: 4.18
+ */
+guint *
+gtk_text_iter_search_all (const GtkTextIter  *start,
+                          const GtkTextIter  *end,
+                          const char         *str,
+                          GtkTextSearchFlags  flags,
+                          gsize              *n_offsets)
+{
+  SearchAllData data;
+
+  g_return_val_if_fail (start != NULL, NULL);
+  g_return_val_if_fail (str != NULL, NULL);
+  g_return_val_if_fail (n_offsets != NULL, NULL);
+
+  *n_offsets = 0;
+
+  if (*str == '\0' ||
+      (end && gtk_text_iter_compare (start, end) >= 0))
+    return NULL;
+
+  data.offsets = g_array_new (FALSE, FALSE, sizeof (guint));
+  data.limit = end ? gtk_text_iter_get_offset (end) : G_MAXINT;
+
+  if (gtk_text_search_is_supported (str, flags))
+    {
+      gtk_text_search_foreach (start, end, str, flags, search_all_cb, &data);
+    }
+  else
+    {
+      GtkTextIter iter, match_start, match_end;
+
+      iter = *start;
+      while (gtk_text_iter_forward_search (&iter, str, flags,
+                                           &match_start, &match_end, end))
+        {
+          if (!search_all_cb (gtk_text_iter_get_offset (&match_start),
+                              gtk_text_iter_get_offset (&match_end),
+                              &data))
+            break;
+
+          if (gtk_text_iter_equal (&iter, &match_end))
+            break;
+
+          iter = match_end;
+        }
+    }
+
+  *n_offsets = data.offsets->len;
+
+  if (data.offsets->len == 0)
+    {
+      g_array_unref (data.offsets);
+      return NULL;
+    }
+
+  return (guint *) g_array_free (data.offsets, FALSE);
+}
+
 static gboolean
 vectors_equal_ignoring_trailing (char     **vec1,
                                  char     **vec2,
@@ -394,6 +394,13 @@ gboolean gtk_text_iter_backward_search (const GtkTextIter *iter,
                                         GtkTextIter       *match_end,
                                         const GtkTextIter *limit);
 
+GDK_AVAILABLE_IN_4_18
+guint *  gtk_text_iter_search_all      (const GtkTextIter *start,
+                                        const GtkTextIter *end,
+                                        const char        *str,
+                                        GtkTextSearchFlags flags,
+                                        gsize             *n_offsets);
+
 /*
  * Comparisons
  */
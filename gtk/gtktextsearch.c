@@ -0,0 +1,575 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtktextsearchprivate.h"
+
+#include "gtktextiterprivate.h"
+#include "gtktextsegmentprivate.h"
+#include "gtktexttypesprivate.h"
+
+#include <string.h>
+
+/* The search engine in this file scans the segments of the btree
+ * directly instead of copying each line with gtk_text_iter_get_slice().
+ *
+ * A line that consists of a single character segment (the common case)
+ * is searched in place, lines made up of several segments are gathered
+ * into a scratch buffer that is reused for the whole search. Substring
+ * matching is done with memmem(), which is a vectorized two-way matcher
+ * in any decent libc.
+ *
+ * For case-insensitive searches, lines are casefolded and normalized
+ * one character at a time, so that we can keep a map from the folded
+ * text back to character offsets in the buffer. Folded lines are cached
+ * per buffer and dropped whenever the text of the buffer changes.
+ *
+ * Only single-line needles without GTK_TEXT_SEARCH_VISIBLE_ONLY are
+ * handled here, everything else goes through lines_match() in
+ * gtktextiter.c.
+ */
+
+/* Don't let the casefold cache grow without bounds */
+#define MAX_CACHE_SIZE (8 * 1024 * 1024)
+
+typedef struct _Gap Gap;
+typedef struct _FoldedLine FoldedLine;
+typedef struct _Searcher Searcher;
+
+/* Non-character segments that are skipped in text-only mode.
+ * Buffer offsets for text character n are n + skipped of the
+ * last gap with index <= n.
+ */
+struct _Gap
+{
+  int index;
+  int skipped;
+};
+
+struct _FoldedLine
+{
+  char *text;
+  gsize len;
+  guint *map;       /* folded char => line text char */
+  Gap *gaps;
+  guint n_gaps;
+  gboolean text_only;
+};
+
+struct _GtkTextSearchCache
+{
+  guint chars_changed_stamp;
+  GHashTable *lines;
+  gsize size;
+};
+
+struct _Searcher
+{
+  const char *needle;
+  gsize needle_len;
+  int needle_chars;
+  gboolean text_only;
+  gboolean case_insensitive;
+
+  GtkTextSearchCache *cache;
+
+  /* The current line */
+  const char *text;
+  gsize len;
+  guint n_pieces;
+  GString *scratch;
+  GArray *gaps;
+  int n_chars;
+};
+
+static void
+folded_line_free (gpointer data)
+{
+  FoldedLine *folded = data;
+
+  g_free (folded->text);
+  g_free (folded->map);
+  g_free (folded->gaps);
+  g_free (folded);
+}
+
+void
+gtk_text_search_cache_free (GtkTextSearchCache *cache)
+{
+  if (cache == NULL)
+    return;
+
+  g_hash_table_unref (cache->lines);
+  g_free (cache);
+}
+
+GtkTextSearchCache *
+gtk_text_search_cache_new (void)
+{
+  GtkTextSearchCache *cache;
+
+  cache = g_new0 (GtkTextSearchCache, 1);
+  cache->lines = g_hash_table_new_full (NULL, NULL, NULL, folded_line_free);
+
+  return cache;
+}
+
+/* Lines are only valid as long as the text doesn't change,
+ * so we keep it simple and drop everything on every change.
+ */
+static GtkTextSearchCache *
+get_cache (GtkTextBTree *tree)
+{
+  GtkTextSearchCache *cache;
+  guint stamp;
+
+  cache = _gtk_text_btree_get_search_cache (tree);
+  stamp = _gtk_text_btree_get_chars_changed_stamp (tree);
+
+  if (cache->chars_changed_stamp != stamp ||
+      cache->size > MAX_CACHE_SIZE)
+    {
+      g_hash_table_remove_all (cache->lines);
+      cache->size = 0;
+      cache->chars_changed_stamp = stamp;
+    }
+
+  return cache;
+}
+
+static inline const char *
+find_substring (const char *haystack,
+                gsize       haystack_len,
+                const char *needle,
+                gsize       needle_len)
+{
+#ifdef HAVE_MEMMEM
+  return memmem (haystack, haystack_len, needle, needle_len);
+#else
+  const char *p, *end;
+
+  if (needle_len > haystack_len)
+    return NULL;
+
+  end = haystack + haystack_len - needle_len + 1;
+  for (p = haystack; p < end; p++)
+    {
+      p = memchr (p, needle[0], end - p);
+      if (p == NULL)
+        return NULL;
+      if (memcmp (p, needle, needle_len) == 0)
+        return p;
+    }
+
+  return NULL;
+#endif
+}
+
+static void
+searcher_append (Searcher   *self,
+                 const char *data,
+                 gsize       len)
+{
+  if (self->n_pieces == 0)
+    {
+      /* Point right into the segment, no copy needed */
+      self->text = data;
+      self->len = len;
+    }
+  else
+    {
+      if (self->n_pieces == 1)
+        {
+          g_string_truncate (self->scratch, 0);
+          g_string_append_len (self->scratch, self->text, self->len);
+        }
+
+      g_string_append_len (self->scratch, data, len);
+      self->text = self->scratch->str;
+      self->len = self->scratch->len;
+    }
+
+  self->n_pieces++;
+}
+
+/* Collects the text of @line starting at @start_byte, and returns
+ * the number of buffer characters covered.
+ */
+static int
+searcher_collect_line (Searcher    *self,
+                       GtkTextLine *line,
+                       int          start_byte)
+{
+  GtkTextLineSegment *seg;
+  int skipped = 0;
+  int buffer_chars = 0;
+
+  self->text = "";
+  self->len = 0;
+  self->n_pieces = 0;
+  self->n_chars = 0;
+  g_array_set_size (self->gaps, 0);
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      int offset;
+
+      if (seg->byte_count == 0)
+        continue;
+
+      if (start_byte >= seg->byte_count)
+        {
+          start_byte -= seg->byte_count;
+          continue;
+        }
+
+      offset = start_byte;
+      start_byte = 0;
+
+      if (seg->type == &gtk_text_char_type)
+        {
+          int n_chars;
+
+          if (offset == 0)
+            n_chars = seg->char_count;
+          else
+            n_chars = g_utf8_strlen (seg->body.chars + offset, seg->byte_count - offset);
+
+          searcher_append (self, seg->body.chars + offset, seg->byte_count - offset);
+          self->n_chars += n_chars;
+          buffer_chars += n_chars;
+        }
+      else if (self->text_only)
+        {
+          Gap gap;
+
+          skipped += seg->char_count;
+          buffer_chars += seg->char_count;
+
+          gap.index = self->n_chars;
+          gap.skipped = skipped;
+          g_array_append_val (self->gaps, gap);
+        }
+      else
+        {
+          searcher_append (self, _gtk_text_unknown_char_utf8, GTK_TEXT_UNKNOWN_CHAR_UTF8_LEN);
+          self->n_chars += seg->char_count;
+          buffer_chars += seg->char_count;
+        }
+    }
+
+  return buffer_chars;
+}
+
+static FoldedLine *
+fold_line (Searcher *self)
+{
+  FoldedLine *folded;
+  GString *str;
+  GArray *map;
+  const char *p, *end;
+  guint n;
+
+  str = g_string_sized_new (self->len + 1);
+  map = g_array_sized_new (FALSE, FALSE, sizeof (guint), self->n_chars + 1);
+
+  end = self->text + self->len;
+  for (p = self->text, n = 0; p < end; p = g_utf8_next_char (p), n++)
+    {
+      if ((guchar) *p < 0x80)
+        {
+          g_string_append_c (str, g_ascii_tolower (*p));
+          g_array_append_val (map, n);
+        }
+      else
+        {
+          /* Same per-character folding as pointer_from_offset_skipping_decomp()
+           * in gtktextiter.c, so both agree on offsets.
+           */
+          char *casefold, *normal, *q;
+
+          casefold = g_utf8_casefold (p, g_utf8_next_char (p) - p);
+          normal = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
+
+          for (q = normal; *q; q = g_utf8_next_char (q))
+            g_array_append_val (map, n);
+          g_string_append (str, normal);
+
+          g_free (normal);
+          g_free (casefold);
+        }
+    }
+  g_array_append_val (map, n);
+
+  folded = g_new0 (FoldedLine, 1);
+  folded->len = str->len;
+  folded->text = g_string_free (str, FALSE);
+  folded->map = (guint *) g_array_free (map, FALSE);
+  folded->text_only = self->text_only;
+  folded->n_gaps = self->gaps->len;
+  if (self->gaps->len > 0)
+    folded->gaps = g_memdup2 (self->gaps->data, sizeof (Gap) * self->gaps->len);
+
+  return folded;
+}
+
+static inline int
+text_to_buffer_offset (const Gap *gaps,
+                       guint      n_gaps,
+                       int        index)
+{
+  int skipped = 0;
+  guint i;
+
+  for (i = 0; i < n_gaps && gaps[i].index <= index; i++)
+    skipped = gaps[i].skipped;
+
+  return index + skipped;
+}
+
+/* Same check as exact_prefix_cmp() in gtktextiter.c: a match must
+ * not end in the middle of a character and its combining marks.
+ */
+static inline gboolean
+is_followed_by_mark (const char *p,
+                     const char *end)
+{
+  GUnicodeType type;
+
+  if (p >= end)
+    return FALSE;
+
+  type = g_unichar_type (g_utf8_get_char (p));
+
+  return type == G_UNICODE_SPACING_MARK ||
+         type == G_UNICODE_ENCLOSING_MARK ||
+         type == G_UNICODE_NON_SPACING_MARK;
+}
+
+static gboolean
+searcher_search_line (Searcher          *self,
+                      GtkTextLine       *line,
+                      int                line_offset,
+                      int                start_byte,
+                      int               *n_buffer_chars,
+                      GtkTextSearchFunc  func,
+                      gpointer           user_data)
+{
+  FoldedLine *folded = NULL;
+  gboolean free_folded = FALSE;
+  const char *haystack, *end, *p, *last, *found;
+  const guint *map = NULL;
+  const Gap *gaps;
+  guint n_gaps;
+  int n_haystack_chars;
+
+  if (self->case_insensitive && start_byte == 0)
+    {
+      folded = g_hash_table_lookup (self->cache->lines, line);
+      if (folded && folded->text_only != self->text_only)
+        {
+          g_hash_table_remove (self->cache->lines, line);
+          folded = NULL;
+        }
+    }
+
+  if (folded != NULL)
+    {
+      *n_buffer_chars = _gtk_text_line_char_count (line);
+    }
+  else
+    {
+      *n_buffer_chars = searcher_collect_line (self, line, start_byte);
+
+      if (self->len < self->needle_len && !self->case_insensitive)
+        return TRUE;
+
+      if (self->case_insensitive)
+        {
+          folded = fold_line (self);
+          if (start_byte == 0)
+            {
+              g_hash_table_insert (self->cache->lines, line, folded);
+              self->cache->size += folded->len * (1 + sizeof (guint));
+            }
+          else
+            free_folded = TRUE;
+        }
+    }
+
+  if (folded)
+    {
+      haystack = folded->text;
+      end = haystack + folded->len;
+      map = folded->map;
+      gaps = folded->gaps;
+      n_gaps = folded->n_gaps;
+    }
+  else
+    {
+      haystack = self->text;
+      end = haystack + self->len;
+      gaps = (const Gap *) self->gaps->data;
+      n_gaps = self->gaps->len;
+    }
+
+  p = last = haystack;
+  n_haystack_chars = 0;
+
+  while ((found = find_substring (p, end - p, self->needle, self->needle_len)))
+    {
+      int first, last_char;
+      int match_start, match_end;
+
+      if (self->case_insensitive &&
+          is_followed_by_mark (found + self->needle_len, end))
+        {
+          p = g_utf8_next_char (found);
+          continue;
+        }
+
+      n_haystack_chars += g_utf8_strlen (last, found - last);
+      last = found;
+
+      if (map)
+        {
+          first = map[n_haystack_chars];
+          last_char = map[n_haystack_chars + self->needle_chars - 1];
+        }
+      else
+        {
+          first = n_haystack_chars;
+          last_char = n_haystack_chars + self->needle_chars - 1;
+        }
+
+      /* Like forward_chars_with_skipping(), the match starts right
+       * after the preceding text character.
+       */
+      if (first == 0)
+        match_start = 0;
+      else
+        match_start = text_to_buffer_offset (gaps, n_gaps, first - 1) + 1;
+      match_end = text_to_buffer_offset (gaps, n_gaps, last_char) + 1;
+
+      if (!func (line_offset + match_start, line_offset + match_end, user_data))
+        {
+          if (free_folded)
+            folded_line_free (folded);
+          return FALSE;
+        }
+
+      p = found + self->needle_len;
+    }
+
+  if (free_folded)
+    folded_line_free (folded);
+
+  return TRUE;
+}
+
+/*
+ * gtk_text_search_is_supported:
+ * @str: the search string
+ * @flags: the search flags
+ *
+ * Returns whether gtk_text_search_foreach() can handle a search
+ * for @str with @flags.
+ */
+gboolean
+gtk_text_search_is_supported (const char         *str,
+                              GtkTextSearchFlags  flags)
+{
+  return *str != '\0' &&
+         strchr (str, '\n') == NULL &&
+         (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) == 0;
+}
+
+/*
+ * gtk_text_search_foreach:
+ * @start: where to start searching
+ * @limit: (nullable): where to stop searching
+ * @str: the search string
+ * @flags: the search flags
+ * @func: function to call for each match
+ * @user_data: data for @func
+ *
+ * Calls @func for all non-overlapping matches of @str that start
+ * at or after @start, in order.
+ *
+ * Lines starting at or after @limit are not searched, but matches
+ * on earlier lines are reported even when they extend past @limit;
+ * it is up to @func to check that.
+ */
+void
+gtk_text_search_foreach (const GtkTextIter  *start,
+                         const GtkTextIter  *limit,
+                         const char         *str,
+                         GtkTextSearchFlags  flags,
+                         GtkTextSearchFunc   func,
+                         gpointer            user_data)
+{
+  Searcher self = { 0, };
+  GtkTextBTree *tree;
+  GtkTextLine *line;
+  char *needle = NULL;
+  int line_offset, start_byte, limit_offset;
+
+  g_return_if_fail (gtk_text_search_is_supported (str, flags));
+
+  tree = _gtk_text_iter_get_btree (start);
+  line = _gtk_text_iter_get_text_line (start);
+  line_offset = gtk_text_iter_get_offset (start);
+  start_byte = gtk_text_iter_get_line_index (start);
+  limit_offset = limit ? gtk_text_iter_get_offset (limit) : G_MAXINT;
+
+  self.text_only = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) != 0;
+  self.case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
+
+  if (self.case_insensitive)
+    {
+      char *casefold = g_utf8_casefold (str, -1);
+      needle = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
+      g_free (casefold);
+      self.needle = needle;
+      self.cache = get_cache (tree);
+    }
+  else
+    self.needle = str;
+
+  self.needle_len = strlen (self.needle);
+  self.needle_chars = g_utf8_strlen (self.needle, self.needle_len);
+  self.scratch = g_string_new (NULL);
+  self.gaps = g_array_new (FALSE, FALSE, sizeof (Gap));
+
+  while (line != NULL && line_offset < limit_offset)
+    {
+      int n_chars;
+
+      if (!searcher_search_line (&self, line, line_offset, start_byte,
+                                 &n_chars, func, user_data))
+        break;
+
+      line_offset += n_chars;
+      start_byte = 0;
+      line = _gtk_text_line_next_excluding_last (line);
+    }
+
+  g_array_unref (self.gaps);
+  g_string_free (self.scratch, TRUE);
+  g_free (needle);
+}
@@ -0,0 +1,53 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gtk/gtktextiter.h>
+#include <gtk/gtktextbtreeprivate.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkTextSearchCache GtkTextSearchCache;
+
+/* Called for every match, with character offsets into the buffer.
+ * Return FALSE to stop the search.
+ */
+typedef gboolean (* GtkTextSearchFunc) (int      match_start,
+                                        int      match_end,
+                                        gpointer user_data);
+
+GtkTextSearchCache *
+                gtk_text_search_cache_new       (void);
+void            gtk_text_search_cache_free      (GtkTextSearchCache     *cache);
+
+/* In gtktextbtree.c */
+GtkTextSearchCache *
+                _gtk_text_btree_get_search_cache (GtkTextBTree          *tree);
+
+gboolean        gtk_text_search_is_supported    (const char             *str,
+                                                 GtkTextSearchFlags      flags);
+
+void            gtk_text_search_foreach         (const GtkTextIter      *start,
+                                                 const GtkTextIter      *limit,
+                                                 const char             *str,
+                                                 GtkTextSearchFlags      flags,
+                                                 GtkTextSearchFunc       func,
+                                                 gpointer                user_data);
+
+G_END_DECLS
+
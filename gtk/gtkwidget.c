@@ -776,6 +776,34 @@ gtk_widget_real_contains (GtkWidget *widget,
                                           &GRAPHENE_POINT_INIT (x, y));
 }
 
+/* Marks the pick bounds of @widget and its ancestors as stale.
+ * A widget only has valid pick bounds if the children they were
+ * computed from are valid, so we can stop at the first invalid one.
+ */
+static void
+gtk_widget_invalidate_pick_bounds (GtkWidget *widget)
+{
+  for (; widget; widget = widget->priv->parent)
+    {
+      GtkWidgetPrivate *priv = widget->priv;
+
+      if (!priv->pick_bounds_valid)
+        break;
+
+      priv->pick_bounds_valid = FALSE;
+      g_clear_pointer (&priv->pick_index, gtk_pick_index_free);
+    }
+}
+
+static void
+gtk_widget_clear_pick_inverse (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+
+  g_clear_pointer (&priv->pick_inverse, g_free);
+  priv->pick_inverse_valid = FALSE;
+}
+
 static void
 gtk_widget_real_root (GtkWidget *widget)
 {
@@ -2587,6 +2615,8 @@ gtk_widget_unparent (GtkWidget *widget)
   priv->width = 0;
   priv->height = 0;
 
+  gtk_widget_invalidate_pick_bounds (priv->parent);
+
   if (_gtk_widget_get_realized (widget))
     gtk_widget_unrealize (widget);
 
@@ -2825,6 +2855,8 @@ gtk_widget_real_hide (GtkWidget *widget)
   priv->width = 0;
   priv->height = 0;
   priv->baseline = 0;
+  gtk_widget_clear_pick_inverse (widget);
+  gtk_widget_invalidate_pick_bounds (widget);
   gtk_widget_update_paintables (widget);
 }
 
@@ -4074,6 +4106,12 @@ gtk_widget_allocate (GtkWidget    *widget,
   if (adjusted.x || adjusted.y)
     transform = gsk_transform_translate (transform, &GRAPHENE_POINT_INIT (adjusted.x, adjusted.y));
 
+  if (!gsk_transform_equal (priv->transform, transform))
+    {
+      gtk_widget_clear_pick_inverse (widget);
+      gtk_widget_invalidate_pick_bounds (widget);
+    }
+
   gsk_transform_unref (priv->transform);
   priv->transform = transform;
 
@@ -4098,6 +4136,9 @@ gtk_widget_allocate (GtkWidget    *widget,
       priv->height = adjusted.height;
       priv->baseline = baseline;
 
+      /* CSS borders and padding may have changed, too */
+      gtk_widget_invalidate_pick_bounds (widget);
+
       priv->alloc_needed_on_child = FALSE;
 
       if (priv->layout_manager != NULL)
@@ -5758,6 +5799,8 @@ _gtk_widget_set_visible_flag (GtkWidget *widget,
       g_clear_pointer (&priv->transform, gsk_transform_unref);
       priv->width = 0;
       priv->height = 0;
+      gtk_widget_clear_pick_inverse (widget);
+      gtk_widget_invalidate_pick_bounds (widget);
       gtk_widget_update_paintables (widget);
     }
 }
@@ -6022,6 +6065,7 @@ gtk_widget_reposition_after (GtkWidget *widget,
   gtk_widget_push_verify_invariants (widget);
 
   priv->parent = parent;
+  gtk_widget_invalidate_pick_bounds (parent);
 
   if (previous_sibling)
     {
@@ -7691,6 +7735,8 @@ gtk_widget_finalize (GObject *object)
 
   g_clear_pointer (&priv->transform, gsk_transform_unref);
   g_clear_pointer (&priv->allocated_transform, gsk_transform_unref);
+  g_clear_pointer (&priv->pick_inverse, g_free);
+  g_clear_pointer (&priv->pick_index, gtk_pick_index_free);
 
   gtk_css_widget_node_widget_destroyed (GTK_CSS_WIDGET_NODE (priv->cssnode));
   g_object_unref (priv->cssnode);
@@ -10243,6 +10289,233 @@ gtk_widget_can_be_picked (GtkWidget    *widget,
   return TRUE;
 }
 
+/* Whether picking can only ever find @widget or its descendants
+ * inside of the rectangle returned in @bounds, in @widget's
+ * coordinates. This is cached until the allocation of @widget or
+ * one of its children changes.
+ */
+static gboolean gtk_widget_get_pick_bounds (GtkWidget       *widget,
+                                            graphene_rect_t *bounds);
+
+static gboolean
+gtk_widget_get_pick_bounds_in_parent (GtkWidget       *widget,
+                                      graphene_rect_t *bounds)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+  graphene_rect_t child_bounds;
+
+  if (!gtk_widget_get_pick_bounds (widget, &child_bounds))
+    return FALSE;
+
+  if (priv->transform == NULL)
+    {
+      *bounds = child_bounds;
+      return TRUE;
+    }
+
+  /* Projections can make the transformed bounds arbitrarily large */
+  if (gsk_transform_get_category (priv->transform) < GSK_TRANSFORM_CATEGORY_2D)
+    return FALSE;
+
+  gsk_transform_transform_bounds (priv->transform, &child_bounds, bounds);
+
+  return TRUE;
+}
+
+static void
+gtk_widget_compute_pick_bounds (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+  GtkWidget *child;
+  GtkCssBoxes boxes;
+
+  priv->pick_bounds_bounded = FALSE;
+
+  /* Custom contains() implementations may accept points anywhere */
+  if (GTK_WIDGET_GET_CLASS (widget)->contains != gtk_widget_real_contains)
+    return;
+
+  gtk_css_boxes_init (&boxes, widget);
+  priv->pick_bounds = *gtk_css_boxes_get_border_rect (&boxes);
+
+  /* With hidden overflow, children can only be picked inside the
+   * padding box, which is inside the border box.
+   */
+  if (priv->overflow != GTK_OVERFLOW_HIDDEN)
+    {
+      for (child = _gtk_widget_get_first_child (widget);
+           child != NULL;
+           child = _gtk_widget_get_next_sibling (child))
+        {
+          graphene_rect_t child_bounds;
+
+          if (GTK_IS_NATIVE (child))
+            continue;
+
+          if (!gtk_widget_get_pick_bounds_in_parent (child, &child_bounds))
+            return;
+
+          graphene_rect_union (&priv->pick_bounds, &child_bounds, &priv->pick_bounds);
+        }
+    }
+
+  priv->pick_bounds_bounded = TRUE;
+}
+
+static gboolean
+gtk_widget_get_pick_bounds (GtkWidget       *widget,
+                            graphene_rect_t *bounds)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+
+  if (!priv->pick_bounds_valid)
+    {
+      gtk_widget_compute_pick_bounds (widget);
+      priv->pick_bounds_valid = TRUE;
+    }
+
+  if (!priv->pick_bounds_bounded)
+    return FALSE;
+
+  *bounds = priv->pick_bounds;
+  return TRUE;
+}
+
+static const graphene_matrix_t *
+gtk_widget_get_pick_inverse (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+
+  if (!priv->pick_inverse_valid)
+    {
+      GskTransform *transform;
+
+      transform = gsk_transform_invert (gsk_transform_ref (priv->transform));
+      if (transform)
+        {
+          priv->pick_inverse = g_new (graphene_matrix_t, 1);
+          gsk_transform_to_matrix (transform, priv->pick_inverse);
+          gsk_transform_unref (transform);
+        }
+
+      priv->pick_inverse_valid = TRUE;
+    }
+
+  return priv->pick_inverse;
+}
+
+/* Containers with fewer children than this are not worth indexing */
+#define PICK_INDEX_MIN_CHILDREN 64
+
+static GtkPickIndex *
+gtk_widget_ensure_pick_index (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+  graphene_rect_t bounds;
+  GtkWidget *child;
+  guint n_children;
+
+  if (priv->pick_index)
+    return priv->pick_index;
+
+  n_children = 0;
+  for (child = _gtk_widget_get_first_child (widget);
+       child != NULL && n_children < PICK_INDEX_MIN_CHILDREN;
+       child = _gtk_widget_get_next_sibling (child))
+    n_children++;
+
+  if (n_children < PICK_INDEX_MIN_CHILDREN)
+    return NULL;
+
+  /* The index is dropped together with the pick bounds, so they
+   * must be valid while it exists.
+   */
+  gtk_widget_get_pick_bounds (widget, &bounds);
+
+  priv->pick_index = gtk_pick_index_new ();
+
+  for (child = _gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      if (GTK_IS_NATIVE (child))
+        continue;
+
+      if (gtk_widget_get_pick_bounds_in_parent (child, &bounds))
+        gtk_pick_index_add (priv->pick_index, child, &bounds);
+      else
+        gtk_pick_index_add (priv->pick_index, child, NULL);
+    }
+
+  gtk_pick_index_build (priv->pick_index);
+
+  return priv->pick_index;
+}
+
+static GtkWidget * gtk_widget_do_pick (GtkWidget    *widget,
+                                       double        x,
+                                       double        y,
+                                       GtkPickFlags  flags);
+
+static GtkWidget *
+gtk_widget_pick_child (GtkWidget    *child,
+                       double        x,
+                       double        y,
+                       GtkPickFlags  flags)
+{
+  GtkWidgetPrivate *child_priv = gtk_widget_get_instance_private (child);
+  graphene_point3d_t res;
+  graphene_rect_t bounds;
+
+  if (!gtk_widget_can_be_picked (child, flags))
+    return NULL;
+
+  if (GTK_IS_NATIVE (child))
+    return NULL;
+
+  if (child_priv->transform)
+    {
+      if (gsk_transform_get_category (child_priv->transform) >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+        {
+          graphene_point_t transformed_p;
+
+          gsk_transform_transform_point (child_priv->transform,
+                                         &(graphene_point_t) { 0, 0 },
+                                         &transformed_p);
+
+          graphene_point3d_init (&res, x - transformed_p.x, y - transformed_p.y, 0.);
+        }
+      else
+        {
+          const graphene_matrix_t *inv;
+          graphene_point3d_t p0, p1;
+
+          inv = gtk_widget_get_pick_inverse (child);
+          if (inv == NULL)
+            return NULL;
+
+          graphene_point3d_init (&p0, x, y, 0);
+          graphene_point3d_init (&p1, x, y, 1);
+          graphene_matrix_transform_point3d (inv, &p0, &p0);
+          graphene_matrix_transform_point3d (inv, &p1, &p1);
+          if (fabs (p0.z - p1.z) < 1.f / 4096)
+            return NULL;
+
+          graphene_point3d_interpolate (&p0, &p1, p0.z / (p0.z - p1.z), &res);
+        }
+    }
+  else
+    {
+      graphene_point3d_init (&res, x, y, 0);
+    }
+
+  if (gtk_widget_get_pick_bounds (child, &bounds) &&
+      !graphene_rect_contains_point (&bounds, &GRAPHENE_POINT_INIT (res.x, res.y)))
+    return NULL;
+
+  return gtk_widget_do_pick (child, res.x, res.y, flags);
+}
+
 static GtkWidget *
 gtk_widget_do_pick (GtkWidget    *widget,
                     double        x,
@@ -10250,7 +10523,8 @@ gtk_widget_do_pick (GtkWidget    *widget,
                     GtkPickFlags  flags)
 {
   GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
-  GtkWidget *child;
+  GtkPickIndex *index;
+  GtkWidget *child, *picked;
 
   if (priv->overflow == GTK_OVERFLOW_HIDDEN)
     {
@@ -10263,62 +10537,29 @@ gtk_widget_do_pick (GtkWidget    *widget,
         return NULL;
     }
 
-  for (child = _gtk_widget_get_last_child (widget);
-       child;
-       child = _gtk_widget_get_prev_sibling (child))
+  if (priv->use_pick_index &&
+      (index = gtk_widget_ensure_pick_index (widget)) != NULL)
     {
-      GtkWidgetPrivate *child_priv = gtk_widget_get_instance_private (child);
-      GtkWidget *picked;
-      graphene_point3d_t res;
+      GtkPickIndexIter iter;
 
-      if (!gtk_widget_can_be_picked (child, flags))
-        continue;
-
-      if (GTK_IS_NATIVE (child))
-        continue;
-
-      if (child_priv->transform)
+      gtk_pick_index_iter_init (&iter, index, x, y);
+      while ((child = gtk_pick_index_iter_next (&iter)))
         {
-          if (gsk_transform_get_category (child_priv->transform) >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
-            {
-              graphene_point_t transformed_p;
-
-              gsk_transform_transform_point (child_priv->transform,
-                                             &(graphene_point_t) { 0, 0 },
-                                             &transformed_p);
-
-              graphene_point3d_init (&res, x - transformed_p.x, y - transformed_p.y, 0.);
-            }
-          else
-            {
-              GskTransform *transform;
-              graphene_matrix_t inv;
-              graphene_point3d_t p0, p1;
-
-              transform = gsk_transform_invert (gsk_transform_ref (child_priv->transform));
-              if (transform == NULL)
-                continue;
-
-              gsk_transform_to_matrix (transform, &inv);
-              gsk_transform_unref (transform);
-              graphene_point3d_init (&p0, x, y, 0);
-              graphene_point3d_init (&p1, x, y, 1);
-              graphene_matrix_transform_point3d (&inv, &p0, &p0);
-              graphene_matrix_transform_point3d (&inv, &p1, &p1);
-              if (fabs (p0.z - p1.z) < 1.f / 4096)
-                continue;
-
-              graphene_point3d_interpolate (&p0, &p1, p0.z / (p0.z - p1.z), &res);
-            }
+          picked = gtk_widget_pick_child (child, x, y, flags);
+          if (picked)
+            return picked;
         }
-      else
+    }
+  else
+    {
+      for (child = _gtk_widget_get_last_child (widget);
+           child;
+           child = _gtk_widget_get_prev_sibling (child))
         {
-          graphene_point3d_init (&res, x, y, 0);
+          picked = gtk_widget_pick_child (child, x, y, flags);
+          if (picked)
+            return picked;
         }
-
-      picked = gtk_widget_do_pick (child, res.x, res.y, flags);
-      if (picked)
-        return picked;
     }
 
   if (!GTK_WIDGET_GET_CLASS (widget)->contains (widget, x, y))
@@ -10327,6 +10568,29 @@ gtk_widget_do_pick (GtkWidget    *widget,
   return widget;
 }
 
+/*<private>
+ * gtk_widget_set_use_pick_index:
+ * @widget: a `GtkWidget`
+ * @use_pick_index: whether to index the children for picking
+ *
+ * Makes gtk_widget_pick() look up the children of @widget in a
+ * spatial index instead of trying them one by one, once @widget
+ * has many children.
+ *
+ * This is meant for containers like `GtkFixed` that can have
+ * lots of children which are each only a small part of it.
+ */
+void
+gtk_widget_set_use_pick_index (GtkWidget *widget,
+                               gboolean   use_pick_index)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  priv->use_pick_index = use_pick_index;
+  if (!use_pick_index)
+    g_clear_pointer (&priv->pick_index, gtk_pick_index_free);
+}
+
 /**
  * gtk_widget_pick:
  * @widget: the widget to query
@@ -10711,6 +10975,7 @@ gtk_widget_set_overflow (GtkWidget   *widget,
 
   priv->overflow = overflow;
 
+  gtk_widget_invalidate_pick_bounds (widget);
   gtk_widget_queue_draw (widget);
 
   g_object_notify_by_pspec (G_OBJECT (widget), widget_props[PROP_OVERFLOW]);
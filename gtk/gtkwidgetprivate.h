@@ -32,6 +32,7 @@
 #include "gtkcsstypesprivate.h"
 #include "gtkeventcontrollerprivate.h"
 #include "gtklistlistmodelprivate.h"
+#include "gtkpickindexprivate.h"
 #include "gtkrootprivate.h"
 #include "gtksizerequestcacheprivate.h"
 #include "gtkwindowprivate.h"
@@ -102,6 +103,12 @@ struct _GtkWidgetPrivate
   /* SizeGroup related flags */
   guint have_size_groups      : 1;
 
+  /* Picking related flags */
+  guint pick_bounds_valid     : 1; /* pick_bounds is up to date */
+  guint pick_bounds_bounded   : 1; /* picking only happens inside pick_bounds */
+  guint pick_inverse_valid    : 1; /* pick_inverse is up to date */
+  guint use_pick_index        : 1; /* build a pick_index for many children */
+
   /* Alignment */
   guint   halign              : 4;
   guint   valign              : 4;
@@ -161,6 +168,11 @@ struct _GtkWidgetPrivate
   int baseline;
   GskTransform *transform;
 
+  /* Caches for gtk_widget_pick() */
+  graphene_rect_t pick_bounds;
+  graphene_matrix_t *pick_inverse;
+  GtkPickIndex *pick_index;
+
   /* The widget's requested sizes */
   SizeRequestCache requests;
 
@@ -341,6 +353,9 @@ void              gtk_widget_handle_crossing               (GtkWidget
                                                             double                 x,
                                                             double                 y);
 
+void              gtk_widget_set_use_pick_index            (GtkWidget             *widget,
+                                                            gboolean               use_pick_index);
+
 
 guint             gtk_widget_add_surface_transform_changed_callback (GtkWidget                          *widget,
                                                                      GtkSurfaceTransformChangedCallback  callback,
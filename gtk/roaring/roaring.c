@@ -8843,6 +8843,98 @@ bool roaring_iterate64(const roaring_bitmap_t *ra, roaring_iterator64 iterator,
     return true;
 }
 
+typedef struct run_accumulator_s {
+    roaring_run_iterator iterator;
+    void *ptr;
+    bool pending;
+    uint32_t start;
+    uint32_t end;
+} run_accumulator_t;
+
+// Merges [start, end] into the pending run or flushes the pending run.
+static inline bool run_accumulator_add(run_accumulator_t *acc, uint32_t start,
+                                       uint32_t end) {
+    if (acc->pending) {
+        if (start == acc->end + 1) {
+            acc->end = end;
+            return true;
+        }
+        if (!acc->iterator(acc->start, acc->end, acc->ptr)) return false;
+    }
+    acc->pending = true;
+    acc->start = start;
+    acc->end = end;
+    return true;
+}
+
+static bool container_iterate_runs(const void *container, uint8_t typecode,
+                                   uint32_t base, run_accumulator_t *acc) {
+    container = container_unwrap_shared(container, &typecode);
+    switch (typecode) {
+        case BITSET_CONTAINER_TYPE_CODE: {
+            const bitset_container_t *bc =
+                (const bitset_container_t *)container;
+            for (int32_t i = 0; i < BITSET_CONTAINER_SIZE_IN_WORDS; ++i) {
+                uint64_t w = bc->array[i];
+                while (w != 0) {
+                    int s = __builtin_ctzll(w);
+                    // set everything below s, the first zero above is the end
+                    uint64_t rest = ~(w | ((UINT64_C(1) << s) - 1));
+                    int e = rest ? __builtin_ctzll(rest) : 64;
+                    if (!run_accumulator_add(acc, base + 64 * i + s,
+                                             base + 64 * i + e - 1))
+                        return false;
+                    w = e == 64 ? 0 : w & ~((UINT64_C(1) << e) - 1);
+                }
+            }
+            return true;
+        }
+        case ARRAY_CONTAINER_TYPE_CODE: {
+            const array_container_t *ac = (const array_container_t *)container;
+            int32_t i = 0;
+            while (i < ac->cardinality) {
+                int32_t j = i;
+                while (j + 1 < ac->cardinality &&
+                       ac->array[j + 1] == ac->array[j] + 1)
+                    j++;
+                if (!run_accumulator_add(acc, base + ac->array[i],
+                                         base + ac->array[j]))
+                    return false;
+                i = j + 1;
+            }
+            return true;
+        }
+        case RUN_CONTAINER_TYPE_CODE: {
+            const run_container_t *rc = (const run_container_t *)container;
+            for (int32_t i = 0; i < rc->n_runs; ++i) {
+                uint32_t start = base + rc->runs[i].value;
+                if (!run_accumulator_add(acc, start,
+                                         start + rc->runs[i].length))
+                    return false;
+            }
+            return true;
+        }
+        default:
+            assert(false);
+            __builtin_unreachable();
+            return false;
+    }
+}
+
+bool roaring_iterate_runs(const roaring_bitmap_t *ra,
+                          roaring_run_iterator iterator, void *ptr) {
+    run_accumulator_t acc = {iterator, ptr, false, 0, 0};
+    for (int i = 0; i < ra->high_low_container.size; ++i)
+        if (!container_iterate_runs(
+                ra->high_low_container.containers[i],
+                ra->high_low_container.typecodes[i],
+                ((uint32_t)ra->high_low_container.keys[i]) << 16, &acc)) {
+            return false;
+        }
+    if (acc.pending) return iterator(acc.start, acc.end, ptr);
+    return true;
+}
+
 /****
 * begin roaring_uint32_iterator_t
 *****/
@@ -561,6 +561,8 @@ bool memequals(const void *s1, const void *s2, size_t n);
 
 typedef bool (*roaring_iterator)(uint32_t value, void *param);
 typedef bool (*roaring_iterator64)(uint64_t value, void *param);
+typedef bool (*roaring_run_iterator)(uint32_t start, uint32_t end,
+                                     void *param);
 
 /**
 *  (For advanced users.)
@@ -6838,6 +6840,20 @@ bool roaring_iterate(const roaring_bitmap_t *ra, roaring_iterator iterator,
 bool roaring_iterate64(const roaring_bitmap_t *ra, roaring_iterator64 iterator,
                        uint64_t high_bits, void *ptr);
 
+/**
+ * Iterate over the runs of consecutive values in the bitmap, in increasing
+ * order, calling the iterator with the first and the last (inclusive) value
+ * of each run. Runs are maximal: runs that touch across container
+ * boundaries are reported as one.
+ *
+ * The cost is proportional to the number of runs (plus the size of bitset
+ * containers), not to the cardinality.
+ *
+ * Returns true if the iterator returned true throughout.
+ */
+bool roaring_iterate_runs(const roaring_bitmap_t *ra,
+                          roaring_run_iterator iterator, void *ptr);
+
 /**
  * Return true if the two bitmaps contain the same elements.
  */
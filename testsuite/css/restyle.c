@@ -0,0 +1,258 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+#include <locale.h>
+
+#include "gtk/gtkcssanimatedstyleprivate.h"
+#include "gtk/gtkcssnodeprivate.h"
+#include "gtk/gtkcssstaticstyleprivate.h"
+#include "gtk/gtkcssvalueprivate.h"
+#include "gtk/gtkcsscolorvalueprivate.h"
+
+static const char css[] =
+  "box { color: rgb(1,2,3); }\n"
+  ".dark box { color: rgb(4,5,6); }\n"
+  ".dark box:nth-child(2n) { padding-left: 3px; }\n"
+  ".dark box > label.odd { margin-top: 2px; }\n"
+  "label:last-child { border-top: 1px solid; }\n"
+  "spinner { animation: pulse 1s linear infinite; }\n"
+  "@keyframes pulse { from { opacity: 1; } to { opacity: 0; } }\n";
+
+static GtkCssNode *
+node_new (GtkCssNode *parent,
+          const char *name)
+{
+  GtkCssNode *node;
+
+  node = gtk_css_node_new ();
+  gtk_css_node_set_name (node, g_quark_from_static_string (name));
+  if (parent)
+    {
+      gtk_css_node_set_parent (node, parent);
+      g_object_unref (node);
+    }
+
+  return node;
+}
+
+/* Creates a root with 100 boxes with 100 boxes each, and a label in each
+ * of those, so 20101 nodes in total
+ */
+static GtkCssNode *
+tree_new (void)
+{
+  GtkCssNode *root, *row, *cell, *label;
+  guint i, j;
+
+  root = node_new (NULL, "window");
+
+  for (i = 0; i < 100; i++)
+    {
+      row = node_new (root, "box");
+      for (j = 0; j < 100; j++)
+        {
+          cell = node_new (row, "box");
+          label = node_new (cell, "label");
+          if (j % 2)
+            gtk_css_node_add_class (label, g_quark_from_static_string ("odd"));
+        }
+    }
+
+  return root;
+}
+
+/* Compares the style of every node to a style computed from scratch */
+static void
+assert_styles_valid (GtkCssNode *node)
+{
+  GtkCssStyle *style, *reference;
+  GtkCssNode *child;
+  guint i;
+
+  style = GTK_CSS_STYLE (gtk_css_style_get_static_style (gtk_css_node_get_style (node)));
+  reference = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (node), NULL, node, 0);
+
+  for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+    g_assert_true (gtk_css_value_equal (gtk_css_style_get_value (style, i),
+                                        gtk_css_style_get_value (reference, i)));
+
+  g_object_unref (reference);
+
+  for (child = gtk_css_node_get_first_child (node);
+       child;
+       child = gtk_css_node_get_next_sibling (child))
+    assert_styles_valid (child);
+}
+
+static double
+get_red (GtkCssNode *node)
+{
+  return gtk_css_color_value_get_rgba (gtk_css_style_get_value (gtk_css_node_get_style (node),
+                                                                GTK_CSS_PROPERTY_COLOR))->red;
+}
+
+static void
+add_provider (void)
+{
+  GtkCssProvider *provider;
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_string (provider, css);
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+  gtk_style_context_add_provider_for_display (gdk_display_get_default (),
+                                              GTK_STYLE_PROVIDER (provider),
+                                              GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+G_GNUC_END_IGNORE_DEPRECATIONS
+  g_object_unref (provider);
+}
+
+static void
+test_restyle_tree (void)
+{
+  GQuark dark = g_quark_from_static_string ("dark");
+  GtkCssNode *root, *row, *cell;
+
+  root = tree_new ();
+  gtk_css_node_validate (root);
+  assert_styles_valid (root);
+
+  row = gtk_css_node_get_first_child (root);
+  cell = gtk_css_node_get_first_child (row);
+  g_assert_cmpfloat_with_epsilon (get_red (cell), 1 / 255., 0.0001);
+
+  /* Restyles the whole tree */
+  gtk_css_node_add_class (root, dark);
+  gtk_css_node_validate (root);
+  assert_styles_valid (root);
+  g_assert_cmpfloat_with_epsilon (get_red (cell), 4 / 255., 0.0001);
+
+  /* Changing the tree between validations must be picked up */
+  gtk_css_node_remove_class (root, dark);
+  gtk_css_node_set_parent (gtk_css_node_get_last_child (row), NULL);
+  gtk_css_node_set_visible (gtk_css_node_get_first_child (cell), FALSE);
+  gtk_css_node_validate (root);
+  assert_styles_valid (root);
+  g_assert_cmpfloat_with_epsilon (get_red (cell), 1 / 255., 0.0001);
+
+  /* Restyles a subtree */
+  gtk_css_node_add_class (row, dark);
+  gtk_css_node_validate (root);
+  assert_styles_valid (root);
+  g_assert_cmpfloat_with_epsilon (get_red (cell), 4 / 255., 0.0001);
+
+  g_object_unref (root);
+}
+
+static void
+test_shared_animation (void)
+{
+  GtkStyleProvider *provider;
+  GtkCssNode *node;
+  GtkCssStyle *base, *unshared, *unshared_advanced, *style1, *style2, *advanced1, *advanced2;
+
+  node = node_new (NULL, "spinner");
+  provider = gtk_css_node_get_style_provider (node);
+  base = gtk_css_static_style_new_compute (provider, NULL, node, 0);
+
+  unshared = gtk_css_animated_style_new (base, NULL, G_USEC_PER_SEC, provider, NULL);
+  g_assert_true (GTK_IS_CSS_ANIMATED_STYLE (unshared));
+  style1 = gtk_css_animated_style_new (base, NULL, G_USEC_PER_SEC, provider, NULL);
+  g_assert_true (style1 != unshared);
+  g_object_unref (style1);
+
+  gtk_css_animated_style_begin_sharing ();
+
+  style1 = gtk_css_animated_style_new (base, NULL, G_USEC_PER_SEC, provider, NULL);
+  style2 = gtk_css_animated_style_new (base, NULL, G_USEC_PER_SEC, provider, NULL);
+  g_assert_true (style1 == style2);
+
+  advanced1 = gtk_css_animated_style_new_advance (GTK_CSS_ANIMATED_STYLE (style1), base, NULL, G_USEC_PER_SEC * 5 / 4, provider);
+  advanced2 = gtk_css_animated_style_new_advance (GTK_CSS_ANIMATED_STYLE (style2), base, NULL, G_USEC_PER_SEC * 5 / 4, provider);
+  g_assert_true (advanced1 == advanced2);
+
+  gtk_css_animated_style_end_sharing ();
+
+  /* Sharing must not change the result */
+  unshared_advanced = gtk_css_animated_style_new_advance (GTK_CSS_ANIMATED_STYLE (unshared), base, NULL, G_USEC_PER_SEC * 5 / 4, provider);
+  g_assert_true (unshared_advanced != advanced1);
+  g_assert_true (gtk_css_value_equal (gtk_css_style_get_value (unshared_advanced, GTK_CSS_PROPERTY_OPACITY),
+                                      gtk_css_style_get_value (advanced1, GTK_CSS_PROPERTY_OPACITY)));
+  g_assert_false (gtk_css_value_equal (gtk_css_style_get_value (base, GTK_CSS_PROPERTY_OPACITY),
+                                       gtk_css_style_get_value (advanced1, GTK_CSS_PROPERTY_OPACITY)));
+
+  g_object_unref (unshared_advanced);
+  g_object_unref (advanced2);
+  g_object_unref (advanced1);
+  g_object_unref (style2);
+  g_object_unref (style1);
+  g_object_unref (unshared);
+  g_object_unref (base);
+  g_object_unref (node);
+}
+
+static void
+test_restyle_performance (void)
+{
+  GQuark dark = g_quark_from_static_string ("dark");
+  GtkCssNode *root;
+  gint64 start;
+  double elapsed;
+  guint i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Performance tests not enabled");
+      return;
+    }
+
+  root = tree_new ();
+  gtk_css_node_validate (root);
+
+  for (i = 0; i < 10; i++)
+    {
+      if (i % 2)
+        gtk_css_node_remove_class (root, dark);
+      else
+        gtk_css_node_add_class (root, dark);
+
+      start = g_get_monotonic_time ();
+      gtk_css_node_validate (root);
+      elapsed = (double) (g_get_monotonic_time () - start) / 1000;
+
+      g_test_minimized_result (elapsed, "20101 nodes, toggling class on root: %.2f ms", elapsed);
+    }
+
+  g_object_unref (root);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+  setlocale (LC_ALL, "C");
+
+  add_provider ();
+
+  g_test_add_func ("/css/restyle/tree", test_restyle_tree);
+  g_test_add_func ("/css/restyle/shared-animation", test_shared_animation);
+  g_test_add_func ("/css/restyle/performance", test_restyle_performance);
+
+  return g_test_run ();
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+
+#include "gdk/gdkdisplayprivate.h"
+#include "gdk/gdkeventsprivate.h"
+
+static GdkDevice *
+get_pointer (GdkDisplay *display)
+{
+  GdkSeat *seat;
+
+  seat = gdk_display_get_default_seat (display);
+  if (seat == NULL)
+    return NULL;
+
+  return gdk_seat_get_pointer (seat);
+}
+
+/* Queues a motion event and compresses, like the backends do */
+static void
+queue_motion (GdkSurface      *surface,
+              GdkDevice       *device,
+              guint32          time,
+              GdkModifierType  state,
+              double           x)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+
+  _gdk_event_queue_append (display,
+                           gdk_motion_event_new (surface, device, NULL, time, state, x, 0, NULL));
+  _gdk_event_queue_handle_motion_compression (display);
+}
+
+static void
+queue_scroll (GdkSurface *surface,
+              GdkDevice  *device,
+              guint32     time,
+              double      dy)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+
+  _gdk_event_queue_append (display,
+                           gdk_scroll_event_new (surface, device, NULL, time, 0,
+                                                 0, dy, FALSE, GDK_SCROLL_UNIT_SURFACE));
+  gdk_event_queue_handle_scroll_compression (display);
+}
+
+static void
+test_motion_compression (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkSurface *surface;
+  GdkDevice *device;
+  GdkEvent *event;
+  GdkTimeCoord *history;
+  guint i, n_coords, n_queued;
+  double x;
+
+  device = get_pointer (display);
+  if (device == NULL)
+    {
+      g_test_skip ("Display has no pointer");
+      return;
+    }
+
+  surface = gdk_surface_new_toplevel (display);
+  n_queued = g_queue_get_length (&display->queued_events);
+
+  /* Without buttons, only the last position is kept */
+  for (i = 0; i < 100; i++)
+    {
+      queue_motion (surface, device, i, 0, i);
+      g_assert_cmpuint (g_queue_get_length (&display->queued_events), ==, n_queued + 1);
+    }
+
+  event = g_queue_pop_tail (&display->queued_events);
+  gdk_event_get_position (event, &x, NULL);
+  g_assert_cmpfloat (x, ==, 99);
+  g_assert_null (gdk_event_get_history (event, &n_coords));
+  gdk_event_unref (event);
+
+  /* With a button held, all earlier positions go into the history */
+  for (i = 0; i < 1000; i++)
+    {
+      queue_motion (surface, device, i, GDK_BUTTON1_MASK, i);
+      g_assert_cmpuint (g_queue_get_length (&display->queued_events), ==, n_queued + 1);
+    }
+
+  event = g_queue_pop_tail (&display->queued_events);
+  gdk_event_get_position (event, &x, NULL);
+  g_assert_cmpfloat (x, ==, 999);
+
+  history = gdk_event_get_history (event, &n_coords);
+  g_assert_cmpuint (n_coords, ==, 999);
+  for (i = 0; i < n_coords; i++)
+    {
+      g_assert_cmpuint (history[i].time, ==, i);
+      g_assert_cmpfloat (history[i].axes[GDK_AXIS_X], ==, i);
+    }
+
+  g_free (history);
+  gdk_event_unref (event);
+
+  gdk_surface_destroy (surface);
+  g_object_unref (surface);
+}
+
+static void
+test_scroll_compression (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkSurface *surface;
+  GdkDevice *device;
+  GdkEvent *event;
+  GdkTimeCoord *history;
+  guint i, n_coords, n_queued;
+  double dx, dy;
+
+  device = get_pointer (display);
+  if (device == NULL)
+    {
+      g_test_skip ("Display has no pointer");
+      return;
+    }
+
+  surface = gdk_surface_new_toplevel (display);
+  n_queued = g_queue_get_length (&display->queued_events);
+
+  for (i = 0; i < 1000; i++)
+    {
+      queue_scroll (surface, device, i, i % 2 ? 1 : 2);
+      g_assert_cmpuint (g_queue_get_length (&display->queued_events), ==, n_queued + 1);
+    }
+
+  event = g_queue_pop_tail (&display->queued_events);
+  gdk_scroll_event_get_deltas (event, &dx, &dy);
+  g_assert_cmpfloat (dx, ==, 0);
+  g_assert_cmpfloat (dy, ==, 1500);
+
+  history = gdk_event_get_history (event, &n_coords);
+  g_assert_cmpuint (n_coords, ==, 1000);
+  for (i = 0; i < n_coords; i++)
+    {
+      g_assert_cmpuint (history[i].time, ==, i);
+      g_assert_cmpfloat (history[i].axes[GDK_AXIS_DELTA_Y], ==, i % 2 ? 1 : 2);
+    }
+
+  g_free (history);
+  gdk_event_unref (event);
+
+  gdk_surface_destroy (surface);
+  g_object_unref (surface);
+}
+
+/* Floods the queue with events, like a 1000 Hz mouse does when
+ * the application doesn't get to dispatch for a while
+ */
+static void
+test_flood_performance (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkSurface *surface;
+  GdkDevice *device;
+  GdkEvent *event;
+  guint n_events[] = { 1000, 10000, 100000 };
+  guint i, j;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Performance tests not enabled");
+      return;
+    }
+
+  device = get_pointer (display);
+  if (device == NULL)
+    {
+      g_test_skip ("Display has no pointer");
+      return;
+    }
+
+  surface = gdk_surface_new_toplevel (display);
+
+  for (i = 0; i < G_N_ELEMENTS (n_events); i++)
+    {
+      gint64 start;
+      double motion_time, scroll_time;
+
+      start = g_get_monotonic_time ();
+      for (j = 0; j < n_events[i]; j++)
+        queue_motion (surface, device, j, GDK_BUTTON1_MASK, j);
+      motion_time = (double) (g_get_monotonic_time () - start) / n_events[i];
+
+      event = g_queue_pop_tail (&display->queued_events);
+      gdk_event_unref (event);
+
+      start = g_get_monotonic_time ();
+      for (j = 0; j < n_events[i]; j++)
+        queue_scroll (surface, device, j, 1);
+      scroll_time = (double) (g_get_monotonic_time () - start) / n_events[i];
+
+      event = g_queue_pop_tail (&display->queued_events);
+      gdk_event_unref (event);
+
+      g_test_minimized_result (motion_time, "%u motion events: %.2f µs per event", n_events[i], motion_time);
+      g_test_minimized_result (scroll_time, "%u scroll events: %.2f µs per event", n_events[i], scroll_time);
+    }
+
+  gdk_surface_destroy (surface);
+  g_object_unref (surface);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/eventqueue/motion-compression", test_motion_compression);
+  g_test_add_func ("/eventqueue/scroll-compression", test_scroll_compression);
+  g_test_add_func ("/eventqueue/flood-performance", test_flood_performance);
+
+  return g_test_run ();
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <string.h>
+
+#include "gdk/gdkframeclockprivate.h"
+#include "gdk/gdkframeclockidleprivate.h"
+#include "gdk/gdkframestatsprivate.h"
+
+#define REFRESH_INTERVAL 16667
+
+/* Fills in the timings of a frame starting at @start,
+ * presented in the next refresh cycle after @cycle
+ */
+static void
+timings_fill (GdkFrameTimings *timings,
+              gint64           start,
+              gint64           cycle)
+{
+  timings->frame_time = start;
+  timings->events_duration = 300;
+  timings->layout_start_time = start + 1000;
+  timings->paint_start_time = start + 4000;
+  timings->frame_end_time = start + 8000;
+  timings->render_duration = 2500;
+  timings->refresh_interval = REFRESH_INTERVAL;
+  timings->presentation_time = (cycle + 1) * REFRESH_INTERVAL;
+  timings->complete = TRUE;
+}
+
+static GdkFrameTimings *
+timings_new (gint64 frame_counter,
+             gint64 start,
+             gint64 cycle)
+{
+  GdkFrameTimings *timings;
+
+  timings = _gdk_frame_timings_new (frame_counter);
+  timings_fill (timings, start, cycle);
+
+  return timings;
+}
+
+static void
+add_frame (GdkFrameStats *stats,
+           gint64         frame_counter,
+           gint64         cycle)
+{
+  GdkFrameTimings *timings;
+
+  timings = timings_new (frame_counter, cycle * REFRESH_INTERVAL, cycle);
+  gdk_frame_stats_add (stats, timings);
+  gdk_frame_timings_unref (timings);
+}
+
+static void
+test_phases (void)
+{
+  GdkFrameStats *stats;
+  GdkFrameTimings *timings;
+  const GdkFrameRecord *record;
+
+  stats = gdk_frame_stats_new ();
+
+  timings = timings_new (0, 1000, 0);
+  gdk_frame_stats_add (stats, timings);
+  gdk_frame_timings_unref (timings);
+
+  g_assert_cmpuint (gdk_frame_stats_get_n_records (stats), ==, 1);
+  record = gdk_frame_stats_get_record (stats, 0);
+  g_assert_cmpint (record->frame_counter, ==, 0);
+  g_assert_cmpint (record->frame_time, ==, 1000);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_EVENTS], ==, 300);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_UPDATE], ==, 1000);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_LAYOUT], ==, 3000);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_PAINT], ==, 4000);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_RENDER], ==, 2500);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_PRESENT], ==, REFRESH_INTERVAL - 9000);
+  g_assert_cmpuint (record->dropped, ==, 0);
+
+  /* A frame without layout, that was never presented */
+  timings = timings_new (1, 2 * REFRESH_INTERVAL, 2);
+  timings->layout_start_time = 0;
+  timings->presentation_time = 0;
+  gdk_frame_stats_add (stats, timings);
+  gdk_frame_timings_unref (timings);
+
+  record = gdk_frame_stats_get_record (stats, 1);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_UPDATE], ==, 4000);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_LAYOUT], ==, -1);
+  g_assert_cmpint (record->durations[GDK_FRAME_STATS_PHASE_PRESENT], ==, -1);
+
+  g_assert_cmpfloat (gdk_frame_stats_get_average (stats, GDK_FRAME_STATS_PHASE_UPDATE), ==, 2500);
+  g_assert_cmpfloat (gdk_frame_stats_get_average (stats, GDK_FRAME_STATS_PHASE_LAYOUT), ==, 3000);
+  g_assert_cmpint (stats->max[GDK_FRAME_STATS_PHASE_UPDATE], ==, 4000);
+
+  gdk_frame_stats_free (stats);
+}
+
+static void
+test_dropped (void)
+{
+  GdkFrameStats *stats;
+  GdkFrameTimings *timings;
+
+  stats = gdk_frame_stats_new ();
+
+  add_frame (stats, 0, 0);
+  add_frame (stats, 1, 1);
+  g_assert_cmpuint (gdk_frame_stats_get_record (stats, 1)->dropped, ==, 0);
+
+  /* Two refresh cycles missed */
+  add_frame (stats, 2, 4);
+  g_assert_cmpuint (gdk_frame_stats_get_record (stats, 2)->dropped, ==, 2);
+
+  /* The clock was idle, nothing was dropped */
+  timings = timings_new (3, 10 * REFRESH_INTERVAL, 10);
+  timings->slept_before = TRUE;
+  gdk_frame_stats_add (stats, timings);
+  gdk_frame_timings_unref (timings);
+  g_assert_cmpuint (gdk_frame_stats_get_record (stats, 3)->dropped, ==, 0);
+
+  /* Frames that are not consecutive don't count either */
+  add_frame (stats, 5, 20);
+  g_assert_cmpuint (gdk_frame_stats_get_record (stats, 4)->dropped, ==, 0);
+
+  g_assert_cmpuint (stats->n_frames, ==, 5);
+  g_assert_cmpuint (stats->n_dropped, ==, 2);
+
+  gdk_frame_stats_free (stats);
+}
+
+static void
+test_history (void)
+{
+  GdkFrameStats *stats;
+  GString *string;
+  guint i;
+
+  stats = gdk_frame_stats_new ();
+
+  for (i = 0; i < GDK_FRAME_STATS_HISTORY + 44; i++)
+    add_frame (stats, i, i);
+
+  g_assert_cmpuint (stats->n_frames, ==, GDK_FRAME_STATS_HISTORY + 44);
+  g_assert_cmpuint (gdk_frame_stats_get_n_records (stats), ==, GDK_FRAME_STATS_HISTORY);
+  for (i = 0; i < GDK_FRAME_STATS_HISTORY; i++)
+    g_assert_cmpint (gdk_frame_stats_get_record (stats, i)->frame_counter, ==, i + 44);
+
+  string = g_string_new (NULL);
+  gdk_frame_stats_print (stats, "test", string);
+  g_assert_true (g_str_has_prefix (string->str, "# test\n# frames: 300, dropped: 0\n"));
+  g_assert_nonnull (strstr (string->str, "\n299,4983433,300,1000,3000,4000,2500,8667,0\n"));
+  g_string_free (string, TRUE);
+
+  gdk_frame_stats_free (stats);
+}
+
+static void
+test_clock (void)
+{
+  GdkFrameClock *clock;
+  char *report;
+  gint64 cycle;
+  int i;
+
+  clock = _gdk_frame_clock_idle_new ();
+  gdk_frame_clock_set_label (clock, "test");
+
+  g_assert_cmpuint (gdk_frame_clock_get_n_frames (clock), ==, 0);
+  g_assert_cmpuint (gdk_frame_clock_get_n_dropped_frames (clock), ==, 0);
+  for (i = 0; i <= GDK_FRAME_STATS_PHASE_PRESENT; i++)
+    g_assert_cmpfloat (gdk_frame_clock_get_phase_time (clock, i), ==, 0);
+
+  report = gdk_frame_clock_print_stats (clock);
+  g_assert_true (g_str_has_prefix (report, "# test\n# frames: 0, dropped: 0\n"));
+  g_free (report);
+
+  /* Draw 10 frames, and skip a refresh cycle after the 5th one */
+  cycle = 1;
+  for (i = 0; i < 10; i++)
+    {
+      _gdk_frame_clock_begin_frame (clock, cycle * REFRESH_INTERVAL);
+      timings_fill (gdk_frame_clock_get_current_timings (clock), cycle * REFRESH_INTERVAL, cycle);
+      cycle += i == 4 ? 2 : 1;
+    }
+
+  /* Only frames that are done count, so start the next one */
+  _gdk_frame_clock_begin_frame (clock, cycle * REFRESH_INTERVAL);
+
+  g_assert_cmpuint (gdk_frame_clock_get_n_frames (clock), ==, 10);
+  g_assert_cmpuint (gdk_frame_clock_get_n_dropped_frames (clock), ==, 1);
+  g_assert_cmpfloat (gdk_frame_clock_get_phase_time (clock, GDK_FRAME_STATS_PHASE_EVENTS), ==, 300);
+  g_assert_cmpfloat (gdk_frame_clock_get_phase_time (clock, GDK_FRAME_STATS_PHASE_UPDATE), ==, 1000);
+  g_assert_cmpfloat (gdk_frame_clock_get_phase_time (clock, GDK_FRAME_STATS_PHASE_LAYOUT), ==, 3000);
+  g_assert_cmpfloat (gdk_frame_clock_get_phase_time (clock, GDK_FRAME_STATS_PHASE_PAINT), ==, 4000);
+  g_assert_cmpfloat (gdk_frame_clock_get_phase_time (clock, GDK_FRAME_STATS_PHASE_RENDER), ==, 2500);
+  g_assert_cmpfloat (gdk_frame_clock_get_phase_time (clock, GDK_FRAME_STATS_PHASE_PRESENT), ==, REFRESH_INTERVAL - 8000);
+
+  report = gdk_frame_clock_print_stats (clock);
+  g_assert_true (g_str_has_prefix (report, "# test\n# frames: 10, dropped: 1\n"));
+  g_free (report);
+
+  g_object_unref (clock);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/framestats/phases", test_phases);
+  g_test_add_func ("/framestats/dropped", test_dropped);
+  g_test_add_func ("/framestats/history", test_history);
+  g_test_add_func ("/framestats/clock", test_clock);
+
+  return g_test_run ();
+}
@@ -135,6 +135,286 @@ test_load_image_fail (gconstpointer data)
   g_free (path);
 }
 
+/* Something that looks roughly like a window: flat areas,
+ * a gradient and some small high-contrast detail.
+ */
+static GdkTexture *
+make_ui_texture (int width,
+                 int height)
+{
+  guchar *data;
+  GBytes *bytes;
+  GdkTexture *texture;
+  int x, y;
+
+  data = g_malloc (width * height * 4);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        guchar *p = data + (y * width + x) * 4;
+
+        if (y < 48)
+          p[0] = p[1] = p[2] = 0xe0 - y;
+        else if (x < width / 5)
+          p[0] = p[1] = p[2] = 0xf0;
+        else if ((x / 8 + y / 16) % 7 == 0 && (x + y) % 3)
+          p[0] = p[1] = p[2] = 0x20;
+        else
+          {
+            p[0] = 0xff;
+            p[1] = 0xff;
+            p[2] = 0xff;
+          }
+        p[3] = 0xff;
+      }
+
+  bytes = g_bytes_new_take (data, width * height * 4);
+  texture = gdk_memory_texture_new (width, height, GDK_MEMORY_R8G8B8A8, bytes, width * 4);
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
+static GdkTexture *
+load_png_bytes (GBytes *bytes)
+{
+  GdkTexture *texture;
+  GError *error = NULL;
+
+  texture = gdk_load_png (bytes, NULL, &error);
+  g_assert_no_error (error);
+
+  return texture;
+}
+
+static void
+test_save_png_options (void)
+{
+  struct {
+    int width, height;
+  } sizes[] = { { 1, 1 }, { 17, 3 }, { 800, 600 } };
+  GdkPngFilter filters[] = {
+    GDK_PNG_FILTER_NONE,
+    GDK_PNG_FILTER_SUB,
+    GDK_PNG_FILTER_UP,
+    GDK_PNG_FILTER_AVERAGE,
+    GDK_PNG_FILTER_PAETH,
+    GDK_PNG_FILTER_ADAPTIVE,
+  };
+  int levels[] = { -1, 0, 1, 9 };
+  gsize i, j, k;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      GdkTexture *texture = make_ui_texture (sizes[i].width, sizes[i].height);
+
+      for (j = 0; j < G_N_ELEMENTS (filters); j++)
+        for (k = 0; k < G_N_ELEMENTS (levels); k++)
+          {
+            GdkPngSaveOptions options = {
+              .compression_level = levels[k],
+              .filter = filters[j],
+              .parallel = TRUE,
+            };
+            GOutputStream *stream;
+            GBytes *bytes;
+            GdkTexture *texture2;
+            GError *error = NULL;
+
+            stream = g_memory_output_stream_new_resizable ();
+            g_assert_true (gdk_save_png_to_stream (texture, stream, &options, NULL, &error));
+            g_assert_no_error (error);
+            g_output_stream_close (stream, NULL, NULL);
+            bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (stream));
+
+            texture2 = load_png_bytes (bytes);
+            assert_texture_equal (texture, texture2);
+
+            g_object_unref (texture2);
+            g_bytes_unref (bytes);
+            g_object_unref (stream);
+          }
+
+      g_object_unref (texture);
+    }
+}
+
+static void
+test_save_png_16bit (void)
+{
+  GdkTexture *texture, *texture2;
+  GBytes *bytes;
+  char *path;
+  GError *error = NULL;
+
+  path = g_test_build_filename (G_TEST_DIST, "image-data", "image-float.tiff", NULL);
+  texture = gdk_texture_new_from_filename (path, &error);
+  g_assert_no_error (error);
+
+  bytes = gdk_save_png (texture);
+  texture2 = load_png_bytes (bytes);
+  g_bytes_unref (bytes);
+
+  /* Must match what libpng produces */
+  bytes = gdk_save_png_libpng (texture);
+  g_object_unref (texture);
+  texture = load_png_bytes (bytes);
+  assert_texture_equal (texture, texture2);
+
+  g_bytes_unref (bytes);
+  g_object_unref (texture);
+  g_object_unref (texture2);
+  g_free (path);
+}
+
+static void
+test_save_png_cancel (void)
+{
+  GdkTexture *texture;
+  GOutputStream *stream;
+  GCancellable *cancellable;
+  GError *error = NULL;
+
+  texture = make_ui_texture (1000, 1000);
+  stream = g_memory_output_stream_new_resizable ();
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+
+  g_assert_false (gdk_save_png_to_stream (texture, stream, NULL, cancellable, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+
+  g_error_free (error);
+  g_object_unref (cancellable);
+  g_object_unref (stream);
+  g_object_unref (texture);
+}
+
+static void
+serialize_done (GObject      *source,
+                GAsyncResult *result,
+                gpointer      data)
+{
+  gboolean *done = data;
+  GError *error = NULL;
+
+  g_assert_true (gdk_content_serialize_finish (result, &error));
+  g_assert_no_error (error);
+  *done = TRUE;
+}
+
+static void
+test_save_png_serializer (void)
+{
+  GdkTexture *texture, *texture2;
+  GOutputStream *stream;
+  GValue value = G_VALUE_INIT;
+  GBytes *bytes, *expected;
+  gboolean done = FALSE;
+
+  texture = make_ui_texture (1000, 1000);
+  g_value_init (&value, GDK_TYPE_TEXTURE);
+  g_value_set_object (&value, texture);
+
+  stream = g_memory_output_stream_new_resizable ();
+  gdk_content_serialize_async (stream, "image/png", &value,
+                               G_PRIORITY_DEFAULT, NULL,
+                               serialize_done, &done);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+  g_output_stream_close (stream, NULL, NULL);
+  bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (stream));
+  g_object_unref (stream);
+
+  /* The clipboard uses the fast options */
+  stream = g_memory_output_stream_new_resizable ();
+  g_assert_true (gdk_save_png_to_stream (texture, stream, &gdk_png_save_options_fast, NULL, NULL));
+  g_output_stream_close (stream, NULL, NULL);
+  expected = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (stream));
+  g_object_unref (stream);
+
+  g_assert_true (g_bytes_equal (bytes, expected));
+
+  texture2 = load_png_bytes (bytes);
+  assert_texture_equal (texture, texture2);
+
+  g_object_unref (texture2);
+  g_bytes_unref (expected);
+  g_bytes_unref (bytes);
+  g_value_unset (&value);
+  g_object_unref (texture);
+}
+
+static void
+test_save_png_performance (void)
+{
+  struct {
+    const char *name;
+    int width, height;
+  } sizes[] = {
+    { "icon", 48, 48 },
+    { "window", 1280, 800 },
+    { "screen", 3840, 2160 },
+  };
+  gsize i;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      GdkTexture *texture;
+      GOutputStream *stream;
+      GBytes *bytes;
+      GTimer *timer;
+      double libpng_time, time, fast_time;
+      gsize libpng_size = 0, size = 0, fast_size = 0;
+      int runs, j;
+
+      texture = make_ui_texture (sizes[i].width, sizes[i].height);
+      runs = MAX (1, 10000000 / (sizes[i].width * sizes[i].height));
+      timer = g_timer_new ();
+
+      g_timer_start (timer);
+      for (j = 0; j < runs; j++)
+        {
+          bytes = gdk_save_png_libpng (texture);
+          libpng_size = g_bytes_get_size (bytes);
+          g_bytes_unref (bytes);
+        }
+      libpng_time = g_timer_elapsed (timer, NULL) / runs;
+
+      g_timer_start (timer);
+      for (j = 0; j < runs; j++)
+        {
+          bytes = gdk_save_png (texture);
+          size = g_bytes_get_size (bytes);
+          g_bytes_unref (bytes);
+        }
+      time = g_timer_elapsed (timer, NULL) / runs;
+
+      g_timer_start (timer);
+      for (j = 0; j < runs; j++)
+        {
+          stream = g_memory_output_stream_new_resizable ();
+          gdk_save_png_to_stream (texture, stream, &gdk_png_save_options_fast, NULL, NULL);
+          fast_size = g_seekable_tell (G_SEEKABLE (stream));
+          g_object_unref (stream);
+        }
+      fast_time = g_timer_elapsed (timer, NULL) / runs;
+
+      g_test_message ("%s %dx%d: libpng %.2fms %" G_GSIZE_FORMAT " bytes, "
+                      "threaded %.2fms %" G_GSIZE_FORMAT " bytes, "
+                      "fast %.2fms %" G_GSIZE_FORMAT " bytes",
+                      sizes[i].name, sizes[i].width, sizes[i].height,
+                      libpng_time * 1000, libpng_size,
+                      time * 1000, size,
+                      fast_time * 1000, fast_size);
+
+      g_test_minimized_result (time, "%s: %.2fms", sizes[i].name, time * 1000);
+
+      g_timer_destroy (timer);
+      g_object_unref (texture);
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -172,6 +452,13 @@ main (int argc, char *argv[])
   g_test_add_data_func ("/image/save/image.png", "image.png", test_save_image);
   g_test_add_data_func ("/image/save/image.tiff", "image.tiff", test_save_image);
   g_test_add_data_func ("/image/save/image.jpeg", "image.jpeg", test_save_image);
+  g_test_add_func ("/image/save/png-options", test_save_png_options);
+  g_test_add_func ("/image/save/png-16bit", test_save_png_16bit);
+  g_test_add_func ("/image/save/png-cancel", test_save_png_cancel);
+  g_test_add_func ("/image/save/png-serializer", test_save_png_serializer);
+
+  if (g_test_perf ())
+    g_test_add_func ("/image/save/png-performance", test_save_png_performance);
 
   return g_test_run ();
 }
@@ -190,6 +190,38 @@ test_texture_save_to_png (void)
   g_assert_true (gdk_texture_save_to_png (texture, "test.png"));
 }
 
+static void
+test_texture_at_size (void)
+{
+  GdkTexture *texture;
+  GdkTexture *texture2;
+  GBytes *bytes;
+  GError *error = NULL;
+  int width, height;
+
+  texture = red_texture_new (64, 48);
+  bytes = gdk_texture_save_to_png_bytes (texture);
+
+  g_assert_true (gdk_texture_get_size_from_bytes (bytes, &width, &height));
+  g_assert_cmpint (width, ==, 64);
+  g_assert_cmpint (height, ==, 48);
+
+  texture2 = gdk_texture_new_from_bytes_at_size (bytes, 16, 12, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_texture_get_width (texture2), ==, 16);
+  g_assert_cmpint (gdk_texture_get_height (texture2), ==, 12);
+  g_object_unref (texture2);
+
+  /* Never upscale */
+  texture2 = gdk_texture_new_from_bytes_at_size (bytes, 128, 96, &error);
+  g_assert_no_error (error);
+  compare_textures (texture, texture2);
+  g_object_unref (texture2);
+
+  g_bytes_unref (bytes);
+  g_object_unref (texture);
+}
+
 static void
 test_texture_save_to_tiff (void)
 {
@@ -458,6 +490,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/texture/from-resource", test_texture_from_resource);
   g_test_add_func ("/texture/save-to-png", test_texture_save_to_png);
   g_test_add_func ("/texture/save-to-tiff", test_texture_save_to_tiff);
+  g_test_add_func ("/texture/at-size", test_texture_at_size);
   g_test_add_func ("/texture/subtexture", test_texture_subtexture);
   g_test_add_func ("/texture/icon/load", test_texture_icon);
   g_test_add_func ("/texture/icon/load-async", test_texture_icon_async);
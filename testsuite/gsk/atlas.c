@@ -0,0 +1,165 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "gsk/gskrendererprivate.h"
+#include "gsk/gskdebugprivate.h"
+#include "gsk/gpu/gsknglrendererprivate.h"
+
+#define N_TEXTURES 16
+#define TEXTURE_SIZE 16
+
+/* A grid of small textures, all different */
+static GskRenderNode *
+create_node (void)
+{
+  GskRenderNode *nodes[N_TEXTURES];
+  GskRenderNode *node;
+  guint i;
+
+  for (i = 0; i < N_TEXTURES; i++)
+    {
+      guchar data[TEXTURE_SIZE * TEXTURE_SIZE * 4];
+      GdkTexture *texture;
+      GBytes *bytes;
+      gsize j;
+
+      for (j = 0; j < sizeof (data); j += 4)
+        {
+          data[j] = i * 16;
+          data[j + 1] = 255 - i * 16;
+          data[j + 2] = j % 256;
+          data[j + 3] = 255;
+        }
+
+      bytes = g_bytes_new (data, sizeof (data));
+      texture = gdk_memory_texture_new (TEXTURE_SIZE, TEXTURE_SIZE,
+                                        GDK_MEMORY_R8G8B8A8_PREMULTIPLIED,
+                                        bytes,
+                                        TEXTURE_SIZE * 4);
+      nodes[i] = gsk_texture_node_new (texture,
+                                       &GRAPHENE_RECT_INIT ((i % 4) * TEXTURE_SIZE,
+                                                            (i / 4) * TEXTURE_SIZE,
+                                                            TEXTURE_SIZE, TEXTURE_SIZE));
+      g_object_unref (texture);
+      g_bytes_unref (bytes);
+    }
+
+  node = gsk_container_node_new (nodes, N_TEXTURES);
+
+  for (i = 0; i < N_TEXTURES; i++)
+    gsk_render_node_unref (nodes[i]);
+
+  return node;
+}
+
+static GskRenderer *
+create_renderer (void)
+{
+  GskRenderer *renderer;
+
+  renderer = gsk_ngl_renderer_new ();
+  if (!gsk_renderer_realize_for_display (renderer, gdk_display_get_default (), NULL))
+    {
+      g_object_unref (renderer);
+      return NULL;
+    }
+
+  return renderer;
+}
+
+/* Renders the node twice with the ops printed to stderr. In the
+ * first frame, the uploads keep the draws apart.
+ */
+static void
+render_verbose (void)
+{
+  GskRenderer *renderer;
+  GskRenderNode *node;
+  GdkTexture *texture;
+  guint i;
+
+  renderer = create_renderer ();
+  g_assert_nonnull (renderer);
+  gsk_renderer_set_debug_flags (renderer, GSK_DEBUG_VERBOSE);
+
+  node = create_node ();
+  for (i = 0; i < 2; i++)
+    {
+      texture = gsk_renderer_render_texture (renderer, node, NULL);
+      g_object_unref (texture);
+    }
+
+  gsk_render_node_unref (node);
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+}
+
+static void
+test_merge_atlas (void)
+{
+  render_verbose ();
+}
+
+static void
+test_merge_no_atlas (void)
+{
+  /* read when the renderer class is initialized */
+  g_setenv ("GSK_GPU_DISABLE", "atlas", TRUE);
+
+  render_verbose ();
+}
+
+/* Test that small textures are drawn from the atlas, so their
+ * draws are merged. Merged ops are printed with a "|".
+ */
+static void
+test_merge (void)
+{
+  GskRenderer *renderer;
+
+  renderer = create_renderer ();
+  if (renderer == NULL)
+    {
+      g_test_skip ("GL renderer not available");
+      return;
+    }
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+
+  g_test_trap_subprocess ("/atlas/merge/subprocess/atlas", 0, G_TEST_SUBPROCESS_DEFAULT);
+  g_test_trap_assert_passed ();
+  g_test_trap_assert_stderr ("*texture | *");
+
+  g_test_trap_subprocess ("/atlas/merge/subprocess/no-atlas", 0, G_TEST_SUBPROCESS_DEFAULT);
+  g_test_trap_assert_passed ();
+  g_test_trap_assert_stderr_unmatched ("*texture | *");
+}
+
+int
+main (int argc, char *argv[])
+{
+  (g_test_init) (&argc, &argv, NULL);
+  gtk_init ();
+
+  g_test_add_func ("/atlas/merge", test_merge);
+  g_test_add_func ("/atlas/merge/subprocess/atlas", test_merge_atlas);
+  g_test_add_func ("/atlas/merge/subprocess/no-atlas", test_merge_no_atlas);
+
+  return g_test_run ();
+}
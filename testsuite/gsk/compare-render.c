@@ -583,6 +583,27 @@ colorflip_create_reference (GskRenderer   *renderer,
   return result;
 }
 
+/* Render the node twice, so the offscreens of its effects are
+ * in the cache when the test draws it again
+ */
+static void
+rerender_prepare (GskRenderer   *renderer,
+                  GskRenderNode *node)
+{
+  int i;
+
+  for (i = 0; i < 2; i++)
+    g_object_unref (gsk_renderer_render_texture (renderer, node, NULL));
+}
+
+/* Like the next frame of a window that didn't change */
+static GskRenderNode *
+rerender_create_test (GskRenderNode *node,
+                      gconstpointer  unused)
+{
+  return gsk_container_node_new (&node, 1);
+}
+
 typedef struct _TestSetup TestSetup;
 struct _TestSetup
 {
@@ -590,6 +611,8 @@ struct _TestSetup
   const char *description;
   gpointer        (* setup)            (GskRenderNode *node);
   void            (* free)             (gpointer       data);
+  void            (* prepare)          (GskRenderer   *renderer,
+                                        GskRenderNode *node);
   GskRenderNode * (* create_test)      (GskRenderNode *node,
                                         gconstpointer  data);
   GdkTexture *    (* create_reference) (GskRenderer   *renderer,
@@ -648,6 +671,13 @@ static const TestSetup test_setups[] = {
     .create_test = colorflip_create_test,
     .create_reference = colorflip_create_reference,
   },
+  {
+    .name = "rerender",
+    .description = "Draw again from cached offscreens",
+    .prepare = rerender_prepare,
+    .create_test = rerender_create_test,
+    .create_reference = NULL,
+  },
 };
 
 static void
@@ -666,6 +696,9 @@ run_single_test (const TestSetup *setup,
   else
     test_data = NULL;
 
+  if (setup->prepare)
+    setup->prepare (renderer, org_test);
+
   if (setup->create_test)
     {
       test = setup->create_test (org_test, test_data);
@@ -785,6 +818,7 @@ main (int argc, char **argv)
     { test_setups[5].name, 0, 0, G_OPTION_ARG_NONE, &test_enabled[5], test_setups[5].description, NULL },
     { test_setups[6].name, 0, 0, G_OPTION_ARG_NONE, &test_enabled[6], test_setups[6].description, NULL },
     { test_setups[7].name, 0, 0, G_OPTION_ARG_NONE, &test_enabled[7], test_setups[7].description, NULL },
+    { test_setups[8].name, 0, 0, G_OPTION_ARG_NONE, &test_enabled[8], test_setups[8].description, NULL },
     { NULL }
   };
   GOptionContext *context;
@@ -95,6 +95,103 @@ test_can_diff_transform (void)
   gsk_transform_unref (t2);
 }
 
+static GskRenderNode *
+tree_new (guint n_changed)
+{
+  GskRenderNode *children[100];
+  GskRenderNode *container, *transform;
+  GskTransform *t;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (children); i++)
+    {
+      GdkRGBA color = { i < n_changed ? 1 : 0, 0, 0, 1 };
+
+      children[i] = gsk_color_node_new (&color, &GRAPHENE_RECT_INIT (0, i * 20, 10, 10));
+    }
+
+  container = gsk_container_node_new (children, G_N_ELEMENTS (children));
+  t = gsk_transform_translate (NULL, &GRAPHENE_POINT_INIT (10, 0));
+  transform = gsk_transform_node_new (container, t);
+
+  gsk_transform_unref (t);
+  gsk_render_node_unref (container);
+  for (i = 0; i < G_N_ELEMENTS (children); i++)
+    gsk_render_node_unref (children[i]);
+
+  return transform;
+}
+
+static void
+test_diff_hash (void)
+{
+  GskRenderNode *tree1, *tree2, *tree3, *cairo1, *cairo2;
+  cairo_region_t *region;
+  cairo_rectangle_int_t rect;
+
+  tree1 = tree_new (0);
+  tree2 = tree_new (0);
+  tree3 = tree_new (1);
+
+  /* Separately built but identical trees hash the same */
+  g_assert_true (tree1 != tree2);
+  g_assert_cmpuint (tree1->hash, !=, 0);
+  g_assert_cmpuint (tree1->hash, ==, tree2->hash);
+  g_assert_cmpuint (tree1->hash, !=, tree3->hash);
+
+  region = cairo_region_create ();
+  gsk_render_node_diff (tree1, tree2, &(GskDiffData) { region, NULL });
+  g_assert_true (cairo_region_is_empty (region));
+
+  gsk_render_node_diff (tree1, tree3, &(GskDiffData) { region, NULL });
+  cairo_region_get_extents (region, &rect);
+  g_assert_cmpint (rect.x, ==, 10);
+  g_assert_cmpint (rect.y, ==, 0);
+  g_assert_cmpint (rect.width, ==, 10);
+  g_assert_cmpint (rect.height, ==, 10);
+  cairo_region_destroy (region);
+
+  /* Nodes that can't be hashed don't claim to be equal */
+  cairo1 = gsk_cairo_node_new (&GRAPHENE_RECT_INIT (0, 0, 10, 10));
+  cairo2 = gsk_cairo_node_new (&GRAPHENE_RECT_INIT (0, 0, 10, 10));
+  g_assert_cmpuint (cairo1->hash, ==, 0);
+  g_assert_cmpuint (cairo2->hash, ==, 0);
+
+  gsk_render_node_unref (cairo1);
+  gsk_render_node_unref (cairo2);
+  gsk_render_node_unref (tree1);
+  gsk_render_node_unref (tree2);
+  gsk_render_node_unref (tree3);
+}
+
+static void
+test_diff_accurate (void)
+{
+  GskRenderNode *tree1, *tree2;
+  cairo_region_t *region;
+
+  tree1 = tree_new (0);
+  tree2 = tree_new (40);
+
+  /* Too many changes, the whole container is damaged */
+  region = cairo_region_create ();
+  gsk_render_node_diff (tree1, tree2, &(GskDiffData) { region, NULL, FALSE });
+  g_assert_true (cairo_region_contains_point (region, 15, 1985));
+  cairo_region_destroy (region);
+
+  /* With accurate damage, only the changed part is */
+  region = cairo_region_create ();
+  gsk_render_node_diff (tree1, tree2, &(GskDiffData) { region, NULL, TRUE });
+  g_assert_true (cairo_region_contains_point (region, 15, 5));
+  g_assert_true (cairo_region_contains_point (region, 15, 785));
+  g_assert_false (cairo_region_contains_point (region, 15, 805));
+  g_assert_false (cairo_region_contains_point (region, 15, 1985));
+  cairo_region_destroy (region);
+
+  gsk_render_node_unref (tree1);
+  gsk_render_node_unref (tree2);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -103,6 +200,8 @@ main (int   argc,
 
   g_test_add_func ("/node/can-diff/basic", test_can_diff_basic);
   g_test_add_func ("/node/can-diff/transform", test_can_diff_transform);
+  g_test_add_func ("/node/diff/hash", test_diff_hash);
+  g_test_add_func ("/node/diff/accurate", test_diff_accurate);
 
   return g_test_run ();
 }
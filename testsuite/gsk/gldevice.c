@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+
+#include "gsk/gpu/gskgldeviceprivate.h"
+
+static char *cache_dir;
+
+static void
+write_variants (const char *contents)
+{
+  GError *error = NULL;
+  char *dirname, *filename;
+
+  dirname = g_build_filename (cache_dir, "gtk-4.0", "gl-shader-variants", NULL);
+  g_assert_no_errno (g_mkdir_with_parents (dirname, 0755));
+
+  filename = g_build_filename (dirname, g_get_prgname (), NULL);
+  g_file_set_contents (filename, contents, -1, &error);
+  g_assert_no_error (error);
+
+  g_free (filename);
+  g_free (dirname);
+}
+
+/* Test that the warmup happens in the main loop, and doesn't
+ * change the current GL context
+ */
+static void
+test_warmup (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GError *error = NULL;
+  GskGpuDevice *device;
+
+  if (!gdk_display_prepare_gl (display, &error))
+    {
+      g_test_skip (error->message);
+      g_clear_error (&error);
+      return;
+    }
+
+  write_variants ("gskgpucolor-0-0-0\n"
+                  "not-a-variant\n"
+                  "gskgpunoshader-0-0-0\n");
+
+  device = gsk_gl_device_get_for_display (display, &error);
+  if (device == NULL)
+    {
+      g_test_skip (error->message);
+      g_clear_error (&error);
+      return;
+    }
+
+  /* getting the device doesn't compile anything */
+  g_assert_true (gsk_gl_device_is_warming_up (GSK_GL_DEVICE (device)));
+
+  gdk_gl_context_clear_current ();
+
+  while (gsk_gl_device_is_warming_up (GSK_GL_DEVICE (device)))
+    {
+      g_main_context_iteration (NULL, TRUE);
+      g_assert_null (gdk_gl_context_get_current ());
+    }
+
+  g_object_unref (device);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int result;
+
+  cache_dir = g_dir_make_tmp ("gldevice-XXXXXX", NULL);
+  g_assert_nonnull (cache_dir);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  (g_test_init) (&argc, &argv, NULL);
+  gtk_init ();
+
+  g_test_add_func ("/gldevice/warmup", test_warmup);
+
+  result = g_test_run ();
+
+  g_free (cache_dir);
+
+  return result;
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright © 2025 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "gsk/gl/gskglcommandqueueprivate.h"
+
+#define MB (1024 * 1024)
+
+/* Textures that are too big for the icon atlas, 512kB each */
+#define TEXTURE_WIDTH 256
+#define TEXTURE_HEIGHT 512
+
+static void
+push_region (GskGLUploadBuffer *buffer,
+             gsize              start)
+{
+  GskGLUploadRegion *region;
+
+  region = g_new0 (GskGLUploadRegion, 1);
+  region->start = start;
+  g_queue_push_tail (&buffer->regions, region);
+}
+
+/* Like the GPU being done with the oldest upload */
+static void
+retire_region (GskGLUploadBuffer *buffer)
+{
+  g_free (g_queue_pop_head (&buffer->regions));
+}
+
+static gboolean
+alloc_region (GskGLUploadBuffer *buffer,
+              gsize              size,
+              gsize             *out_start)
+{
+  if (!gsk_gl_upload_buffer_alloc (buffer, size, out_start))
+    return FALSE;
+
+  push_region (buffer, *out_start);
+  return TRUE;
+}
+
+/* More uploads than fit while the GPU is busy: the ones
+ * that don't fit must be refused, not overwrite others
+ */
+static void
+test_ring_full (void)
+{
+  GskGLUploadBuffer buffer = { .size = 4 * MB, };
+  gsize start, i;
+
+  for (i = 0; i < 4; i++)
+    {
+      g_assert_true (alloc_region (&buffer, MB, &start));
+      g_assert_cmpuint (start, ==, i * MB);
+    }
+
+  g_assert_false (alloc_region (&buffer, MB, &start));
+  g_assert_false (alloc_region (&buffer, 1, &start));
+
+  /* Too big for the buffer at all */
+  g_queue_clear_full (&buffer.regions, g_free);
+  g_assert_false (alloc_region (&buffer, 4 * MB + 1, &start));
+}
+
+static void
+test_ring_alignment (void)
+{
+  GskGLUploadBuffer buffer = { .size = 4 * MB, };
+  gsize start;
+
+  g_assert_true (alloc_region (&buffer, 100, &start));
+  g_assert_cmpuint (start, ==, 0);
+  g_assert_true (alloc_region (&buffer, 100, &start));
+  g_assert_cmpuint (start, ==, 128);
+
+  g_queue_clear_full (&buffer.regions, g_free);
+}
+
+/* Once the oldest regions are done, new ones go to the start
+ * of the buffer again, but never up to the oldest one in use
+ */
+static void
+test_ring_wrap (void)
+{
+  GskGLUploadBuffer buffer = { .size = 4 * MB, };
+  gsize start, i;
+
+  for (i = 0; i < 4; i++)
+    g_assert_true (alloc_region (&buffer, MB, &start));
+
+  /* Ending right at the oldest region would look like an empty buffer */
+  retire_region (&buffer);
+  g_assert_false (alloc_region (&buffer, MB, &start));
+
+  retire_region (&buffer);
+  g_assert_true (alloc_region (&buffer, MB, &start));
+  g_assert_cmpuint (start, ==, 0);
+
+  g_assert_false (alloc_region (&buffer, MB, &start));
+  g_assert_true (alloc_region (&buffer, MB / 2, &start));
+  g_assert_cmpuint (start, ==, MB);
+
+  retire_region (&buffer);
+  g_assert_true (alloc_region (&buffer, MB, &start));
+  g_assert_cmpuint (start, ==, MB + MB / 2);
+
+  /* With only the newest region in use, new ones fill up the
+   * rest of the buffer first, and then wrap around again
+   */
+  while (g_queue_get_length (&buffer.regions) > 1)
+    retire_region (&buffer);
+  g_assert_true (alloc_region (&buffer, MB, &start));
+  g_assert_cmpuint (start, ==, 2 * MB + MB / 2);
+  g_assert_true (alloc_region (&buffer, MB, &start));
+  g_assert_cmpuint (start, ==, 0);
+
+  g_queue_clear_full (&buffer.regions, g_free);
+}
+
+static guint32
+texture_color (guint i)
+{
+  return 0xFF000000 | ((i * 37) & 0xFF) << 16 | ((i * 91) & 0xFF) << 8 | ((255 - i * 13) & 0xFF);
+}
+
+static GdkTexture *
+create_texture (guint i)
+{
+  GdkTexture *texture;
+  GBytes *bytes;
+  guint32 *data;
+  gsize j;
+
+  data = g_new (guint32, TEXTURE_WIDTH * TEXTURE_HEIGHT);
+  for (j = 0; j < TEXTURE_WIDTH * TEXTURE_HEIGHT; j++)
+    data[j] = texture_color (i);
+
+  bytes = g_bytes_new_take (data, TEXTURE_WIDTH * TEXTURE_HEIGHT * 4);
+  texture = gdk_memory_texture_new (TEXTURE_WIDTH, TEXTURE_HEIGHT,
+                                    GDK_MEMORY_DEFAULT,
+                                    bytes,
+                                    TEXTURE_WIDTH * 4);
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
+/* Draws @n_textures new textures next to each other in one frame,
+ * and checks that each of them ends up where it belongs
+ */
+static void
+render_textures (GskRenderer *renderer,
+                 guint        first,
+                 guint        n_textures)
+{
+  GskRenderNode **nodes, *node;
+  GdkTexture *result;
+  guint32 *data;
+  guint i, x, y;
+
+  nodes = g_new (GskRenderNode *, n_textures);
+  for (i = 0; i < n_textures; i++)
+    {
+      GdkTexture *texture = create_texture (first + i);
+
+      nodes[i] = gsk_texture_node_new (texture,
+                                       &GRAPHENE_RECT_INIT (i * TEXTURE_WIDTH, 0,
+                                                            TEXTURE_WIDTH, TEXTURE_HEIGHT));
+      g_object_unref (texture);
+    }
+  node = gsk_container_node_new (nodes, n_textures);
+
+  result = gsk_renderer_render_texture (renderer, node, NULL);
+  g_assert_cmpint (gdk_texture_get_width (result), ==, n_textures * TEXTURE_WIDTH);
+  g_assert_cmpint (gdk_texture_get_height (result), ==, TEXTURE_HEIGHT);
+
+  data = g_new (guint32, n_textures * TEXTURE_WIDTH * TEXTURE_HEIGHT);
+  gdk_texture_download (result, (guchar *) data, n_textures * TEXTURE_WIDTH * 4);
+
+  for (i = 0; i < n_textures; i++)
+    for (y = 0; y < TEXTURE_HEIGHT; y += TEXTURE_HEIGHT / 8)
+      for (x = 0; x < TEXTURE_WIDTH; x += TEXTURE_WIDTH / 8)
+        g_assert_cmphex (data[y * n_textures * TEXTURE_WIDTH + i * TEXTURE_WIDTH + x], ==, texture_color (first + i));
+
+  g_free (data);
+  g_object_unref (result);
+  gsk_render_node_unref (node);
+  for (i = 0; i < n_textures; i++)
+    gsk_render_node_unref (nodes[i]);
+  g_free (nodes);
+}
+
+static GskRenderer *
+create_renderer (void)
+{
+  GskRenderer *renderer;
+  GError *error = NULL;
+
+  renderer = gsk_gl_renderer_new ();
+  if (!gsk_renderer_realize_for_display (renderer, gdk_display_get_default (), &error))
+    {
+      g_test_skip (error->message);
+      g_clear_error (&error);
+      g_object_unref (renderer);
+      return NULL;
+    }
+
+  return renderer;
+}
+
+/* 12MB of uploads in one frame, much more than the upload buffer holds */
+static void
+test_upload_many (void)
+{
+  GskRenderer *renderer;
+
+  renderer = create_renderer ();
+  if (renderer == NULL)
+    return;
+
+  render_textures (renderer, 0, 24);
+
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+}
+
+/* Uploads in frame after frame go around the upload buffer */
+static void
+test_upload_frames (void)
+{
+  GskRenderer *renderer;
+  guint i;
+
+  renderer = create_renderer ();
+  if (renderer == NULL)
+    return;
+
+  for (i = 0; i < 10; i++)
+    render_textures (renderer, i * 3, 3);
+
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+}
+
+int
+main (int argc, char *argv[])
+{
+  (g_test_init) (&argc, &argv, NULL);
+  gtk_init ();
+
+  g_test_add_func ("/glupload/ring/full", test_ring_full);
+  g_test_add_func ("/glupload/ring/alignment", test_ring_alignment);
+  g_test_add_func ("/glupload/ring/wrap", test_ring_wrap);
+  g_test_add_func ("/glupload/upload/many", test_upload_many);
+  g_test_add_func ("/glupload/upload/frames", test_upload_frames);
+
+  return g_test_run ();
+}
@@ -0,0 +1,443 @@
+/*
+ * Copyright © 2025 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <math.h>
+
+#include "gdk/gdkcolorstateprivate.h"
+#include "gsk/gskrendernodeprivate.h"
+#include "gsk/gpu/gskgldeviceprivate.h"
+#include "gsk/gpu/gskgpucacheprivate.h"
+
+#define MB (1024 * 1024)
+
+/* Images of cache items for the eviction tests, 256kB each */
+#define ITEM_SIZE 256
+#define ITEM_MEMORY (ITEM_SIZE * ITEM_SIZE * 4)
+
+static GskGpuDevice *
+get_device (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GError *error = NULL;
+  GskGpuDevice *device;
+
+  if (!gdk_display_prepare_gl (display, &error))
+    {
+      g_test_skip (error->message);
+      g_clear_error (&error);
+      return NULL;
+    }
+
+  device = gsk_gl_device_get_for_display (display, &error);
+  if (device == NULL)
+    {
+      g_test_skip (error->message);
+      g_clear_error (&error);
+      return NULL;
+    }
+
+  gsk_gpu_device_make_current (device);
+
+  return device;
+}
+
+static GskRenderNode *
+blur_node_new (const GdkRGBA *color)
+{
+  GskRenderNode *child, *node;
+
+  child = gsk_color_node_new (color, &GRAPHENE_RECT_INIT (0, 0, 20, 20));
+  node = gsk_blur_node_new (child, 2);
+  gsk_render_node_unref (child);
+
+  return node;
+}
+
+static GskGpuImage *
+lookup_offscreen (GskGpuCache   *cache,
+                  GskRenderNode *node,
+                  gboolean      *should_cache)
+{
+  graphene_rect_t rect;
+
+  return gsk_gpu_cache_lookup_offscreen (cache,
+                                         node,
+                                         GDK_COLOR_STATE_SRGB,
+                                         graphene_vec2_one (),
+                                         &rect,
+                                         should_cache);
+}
+
+static void
+cache_offscreen (GskGpuCache   *cache,
+                 GskRenderNode *node,
+                 GskGpuImage   *image)
+{
+  gsk_gpu_cache_cache_offscreen (cache,
+                                 node,
+                                 GDK_COLOR_STATE_SRGB,
+                                 graphene_vec2_one (),
+                                 &node->bounds,
+                                 image);
+}
+
+static GskGpuImage *
+create_image (GskGpuDevice  *device,
+              GskRenderNode *node)
+{
+  return gsk_gpu_device_create_offscreen_image (device,
+                                                FALSE,
+                                                GDK_MEMORY_U8,
+                                                ceil (node->bounds.size.width),
+                                                ceil (node->bounds.size.height));
+}
+
+/* The first time a node is seen, it only becomes a candidate,
+ * the second time it gets cached, the third time it is a hit.
+ * Recreated nodes that look the same are hits, too, but nodes
+ * of the same type and size that look different are not.
+ */
+static void
+test_offscreen_hit (void)
+{
+  GskGpuDevice *device;
+  GskGpuCache *cache;
+  GskRenderNode *node, *same, *different;
+  GskGpuImage *image, *result;
+  gboolean should_cache;
+
+  device = get_device ();
+  if (device == NULL)
+    return;
+  cache = gsk_gpu_device_get_cache (device);
+
+  node = blur_node_new (&(GdkRGBA) { 1, 0, 0, 1 });
+  same = blur_node_new (&(GdkRGBA) { 1, 0, 0, 1 });
+  different = blur_node_new (&(GdkRGBA) { 0, 0, 1, 1 });
+
+  g_assert_null (lookup_offscreen (cache, node, &should_cache));
+  g_assert_false (should_cache);
+
+  g_assert_null (lookup_offscreen (cache, node, &should_cache));
+  g_assert_true (should_cache);
+
+  image = create_image (device, node);
+  cache_offscreen (cache, node, image);
+
+  result = lookup_offscreen (cache, node, &should_cache);
+  g_assert_true (result == image);
+  g_assert_false (should_cache);
+  g_object_unref (result);
+
+  result = lookup_offscreen (cache, same, &should_cache);
+  g_assert_true (result == image);
+  g_object_unref (result);
+
+  g_assert_null (lookup_offscreen (cache, different, &should_cache));
+  g_assert_false (should_cache);
+
+  g_object_unref (image);
+  gsk_render_node_unref (different);
+  gsk_render_node_unref (same);
+  gsk_render_node_unref (node);
+  g_object_unref (device);
+}
+
+/* Caching a node again replaces the old image, and frees it right
+ * away, without counting its memory twice
+ */
+static void
+test_offscreen_replace (void)
+{
+  GskGpuDevice *device;
+  GskGpuCache *cache;
+  GskRenderNode *node, *same;
+  GskGpuImage *old_image, *image, *result;
+  gboolean should_cache;
+  gsize memory;
+
+  device = get_device ();
+  if (device == NULL)
+    return;
+  cache = gsk_gpu_device_get_cache (device);
+
+  node = blur_node_new (&(GdkRGBA) { 0, 1, 0, 1 });
+  same = blur_node_new (&(GdkRGBA) { 0, 1, 0, 1 });
+
+  g_assert_null (lookup_offscreen (cache, node, &should_cache));
+  g_assert_null (lookup_offscreen (cache, node, &should_cache));
+  g_assert_true (should_cache);
+
+  old_image = create_image (device, node);
+  g_object_add_weak_pointer (G_OBJECT (old_image), (gpointer *) &old_image);
+  cache_offscreen (cache, node, old_image);
+  memory = gsk_gpu_cache_get_memory (cache);
+
+  image = create_image (device, same);
+  cache_offscreen (cache, same, image);
+  g_assert_cmpuint (gsk_gpu_cache_get_memory (cache), ==, memory);
+
+  g_object_unref (old_image);
+  g_assert_null (old_image);
+
+  result = lookup_offscreen (cache, node, &should_cache);
+  g_assert_true (result == image);
+  g_object_unref (result);
+
+  g_object_unref (image);
+  gsk_render_node_unref (same);
+  gsk_render_node_unref (node);
+  g_object_unref (device);
+}
+
+static GskRenderNode *
+item_node_new (guint i)
+{
+  return gsk_color_node_new (&(GdkRGBA) { i / 255.f, 0, 0, 1 },
+                             &GRAPHENE_RECT_INIT (0, 0, ITEM_SIZE, ITEM_SIZE));
+}
+
+static GdkTexture *
+item_texture_new (void)
+{
+  static const guchar pixel[4] = { 0, };
+  GdkTexture *texture;
+  GBytes *bytes;
+
+  bytes = g_bytes_new_static (pixel, sizeof (pixel));
+  texture = gdk_memory_texture_new (1, 1, GDK_MEMORY_DEFAULT, bytes, 4);
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
+/* Caches an image for @texture at the cache's current time */
+static void
+cache_texture (GskGpuDevice *device,
+               GskGpuCache  *cache,
+               GdkTexture   *texture)
+{
+  GskGpuImage *image;
+
+  image = gsk_gpu_device_create_offscreen_image (device, FALSE, GDK_MEMORY_U8, ITEM_SIZE, ITEM_SIZE);
+  gsk_gpu_cache_cache_texture_image (cache, texture, image, NULL);
+  g_object_unref (image);
+}
+
+static void
+cache_item_offscreen (GskGpuDevice  *device,
+                      GskGpuCache   *cache,
+                      GskRenderNode *node)
+{
+  GskGpuImage *image;
+
+  image = create_image (device, node);
+  cache_offscreen (cache, node, image);
+  g_object_unref (image);
+}
+
+static gboolean
+has_texture (GskGpuCache *cache,
+             GdkTexture  *texture)
+{
+  GskGpuImage *image;
+
+  image = gsk_gpu_cache_lookup_texture_image (cache, texture, NULL);
+  g_clear_object (&image);
+
+  return image != NULL;
+}
+
+static gboolean
+has_offscreen (GskGpuCache   *cache,
+               GskRenderNode *node)
+{
+  GskGpuImage *image;
+  gboolean should_cache;
+
+  image = lookup_offscreen (cache, node, &should_cache);
+  if (image == NULL)
+    return FALSE;
+
+  g_object_unref (image);
+  return TRUE;
+}
+
+/* Items are evicted by age divided by their upload cost, and
+ * items that were used in the current frame are kept
+ */
+static void
+test_evict_order (void)
+{
+  GskGpuDevice *device;
+  GskGpuCache *cache;
+  GskRenderNode *old_offscreen, *young_offscreen;
+  GdkTexture *texture, *current_texture;
+  gint64 now;
+
+  device = get_device ();
+  if (device == NULL)
+    return;
+  cache = gsk_gpu_cache_new (device);
+  now = g_get_monotonic_time ();
+
+  old_offscreen = item_node_new (1);
+  young_offscreen = item_node_new (2);
+  texture = item_texture_new ();
+  current_texture = item_texture_new ();
+
+  /* Offscreens cost 8 times as much as textures to recreate */
+  gsk_gpu_cache_set_time (cache, now - 80 * G_TIME_SPAN_SECOND);
+  cache_item_offscreen (device, cache, old_offscreen);
+  gsk_gpu_cache_set_time (cache, now - 40 * G_TIME_SPAN_SECOND);
+  cache_item_offscreen (device, cache, young_offscreen);
+  gsk_gpu_cache_set_time (cache, now - 20 * G_TIME_SPAN_SECOND);
+  cache_texture (device, cache, texture);
+  gsk_gpu_cache_set_time (cache, now);
+  cache_texture (device, cache, current_texture);
+  g_assert_cmpuint (gsk_gpu_cache_get_memory (cache), ==, 4 * ITEM_MEMORY);
+
+  /* Evicting to 3/4 of the limit leaves room for 2 items */
+  gsk_gpu_cache_gc (cache, 3600 * G_TIME_SPAN_SECOND, 700000, now);
+  g_assert_cmpuint (gsk_gpu_cache_get_memory (cache), ==, 2 * ITEM_MEMORY);
+  g_assert_cmpuint (gsk_gpu_cache_get_unevictable_memory (cache), ==, 0);
+
+  g_assert_false (has_texture (cache, texture));
+  g_assert_true (has_texture (cache, current_texture));
+  g_assert_false (has_offscreen (cache, old_offscreen));
+  g_assert_true (has_offscreen (cache, young_offscreen));
+
+  /* Everything is in use now, so nothing can be evicted */
+  gsk_gpu_cache_gc (cache, 3600 * G_TIME_SPAN_SECOND, 0, now);
+  g_assert_cmpuint (gsk_gpu_cache_get_memory (cache), ==, 2 * ITEM_MEMORY);
+  g_assert_cmpuint (gsk_gpu_cache_get_unevictable_memory (cache), ==, 2 * ITEM_MEMORY);
+
+  g_object_unref (cache);
+  g_object_unref (current_texture);
+  g_object_unref (texture);
+  gsk_render_node_unref (young_offscreen);
+  gsk_render_node_unref (old_offscreen);
+  g_object_unref (device);
+}
+
+/* With GSK_CACHE_BUDGET=1, the cache is shrunk before
+ * the next frame once it grows beyond 1MB
+ */
+static void
+test_evict_budget (void)
+{
+  GskGpuDevice *device;
+  GskGpuCache *cache;
+  GdkTexture *textures[6], *current_texture;
+  gint64 now;
+  gsize i;
+
+  device = get_device ();
+  if (device == NULL)
+    return;
+  cache = gsk_gpu_device_get_cache (device);
+  now = g_get_monotonic_time ();
+
+  gsk_gpu_cache_set_time (cache, now - 10 * G_TIME_SPAN_SECOND);
+  for (i = 0; i < G_N_ELEMENTS (textures); i++)
+    {
+      textures[i] = item_texture_new ();
+      cache_texture (device, cache, textures[i]);
+    }
+  gsk_gpu_cache_set_time (cache, now);
+  current_texture = item_texture_new ();
+  cache_texture (device, cache, current_texture);
+  g_assert_cmpuint (gsk_gpu_cache_get_memory (cache), >, MB);
+
+  gsk_gpu_device_maybe_gc (device);
+
+  cache = gsk_gpu_device_get_cache (device);
+  g_assert_cmpuint (gsk_gpu_cache_get_memory (cache), <=, MB - MB / 4);
+  g_assert_true (has_texture (cache, current_texture));
+
+  g_object_unref (current_texture);
+  for (i = 0; i < G_N_ELEMENTS (textures); i++)
+    g_object_unref (textures[i]);
+  g_object_unref (device);
+}
+
+/* A low memory warning shrinks the cache to half of its size,
+ * but keeps the items of the current frame
+ */
+static void
+test_evict_low_memory (void)
+{
+  GskGpuDevice *device;
+  GskGpuCache *cache;
+  GMemoryMonitor *monitor;
+  GdkTexture *textures[3], *current_texture;
+  gsize i, memory;
+  gint64 now;
+
+  device = get_device ();
+  if (device == NULL)
+    return;
+  cache = gsk_gpu_device_get_cache (device);
+  now = g_get_monotonic_time ();
+
+  gsk_gpu_cache_set_time (cache, now - 10 * G_TIME_SPAN_SECOND);
+  for (i = 0; i < G_N_ELEMENTS (textures); i++)
+    {
+      textures[i] = item_texture_new ();
+      cache_texture (device, cache, textures[i]);
+    }
+  gsk_gpu_cache_set_time (cache, now);
+  current_texture = item_texture_new ();
+  cache_texture (device, cache, current_texture);
+
+  memory = gsk_gpu_cache_get_memory (cache);
+  g_assert_cmpuint (memory, >=, 4 * ITEM_MEMORY);
+
+  monitor = g_memory_monitor_dup_default ();
+  g_signal_emit_by_name (monitor, "low-memory-warning", G_MEMORY_MONITOR_WARNING_LEVEL_LOW);
+  g_object_unref (monitor);
+
+  cache = gsk_gpu_device_get_cache (device);
+  g_assert_cmpuint (gsk_gpu_cache_get_memory (cache), <=, memory / 2);
+  g_assert_true (has_texture (cache, current_texture));
+  for (i = 0; i < G_N_ELEMENTS (textures); i++)
+    g_assert_false (has_texture (cache, textures[i]));
+
+  g_object_unref (current_texture);
+  for (i = 0; i < G_N_ELEMENTS (textures); i++)
+    g_object_unref (textures[i]);
+  g_object_unref (device);
+}
+
+int
+main (int argc, char *argv[])
+{
+  /* Small enough for the eviction tests to exceed it */
+  g_setenv ("GSK_CACHE_BUDGET", "1", TRUE);
+
+  (g_test_init) (&argc, &argv, NULL);
+  gtk_init ();
+
+  g_test_add_func ("/gpucache/offscreen/hit", test_offscreen_hit);
+  g_test_add_func ("/gpucache/offscreen/replace", test_offscreen_replace);
+  g_test_add_func ("/gpucache/evict/order", test_evict_order);
+  g_test_add_func ("/gpucache/evict/budget", test_evict_budget);
+  g_test_add_func ("/gpucache/evict/low-memory", test_evict_low_memory);
+
+  return g_test_run ();
+}
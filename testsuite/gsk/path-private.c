@@ -263,6 +263,77 @@ test_rect_winding (void)
   gsk_path_unref (path1);
 }
 
+/* A star-shaped polygon with curved edges, so that the
+ * contour is big enough to get an index
+ */
+static GskPath *
+create_star_path (guint n_points)
+{
+  GskPathBuilder *builder;
+  guint i;
+
+  builder = gsk_path_builder_new ();
+
+  for (i = 0; i < n_points; i++)
+    {
+      float angle = 2 * G_PI * i / n_points;
+      float r = i % 2 ? 100 : 200;
+      float x = 250 + r * cosf (angle);
+      float y = 250 + r * sinf (angle);
+
+      if (i == 0)
+        gsk_path_builder_move_to (builder, x, y);
+      else if (i % 3 == 0)
+        gsk_path_builder_quad_to (builder, 250, 250, x, y);
+      else
+        gsk_path_builder_line_to (builder, x, y);
+    }
+
+  /* leave it open, so the implicit close is tested */
+
+  return gsk_path_builder_free_to_path (builder);
+}
+
+static void
+test_contour_index (void)
+{
+  GskPath *path;
+  const GskContour *contour;
+  GskContourIndex *index;
+  guint i;
+
+  path = create_star_path (500);
+  contour = gsk_path_get_contour (path, 0);
+  index = gsk_contour_index_new (contour);
+  g_assert_nonnull (index);
+
+  for (i = 0; i < 1000; i++)
+    {
+      graphene_point_t point = GRAPHENE_POINT_INIT (g_test_rand_double_range (0, 500),
+                                                    g_test_rand_double_range (0, 500));
+      GskPathPoint result1, result2;
+      float dist1, dist2;
+      gboolean found1, found2;
+
+      g_assert_cmpint (gsk_contour_get_winding (contour, &point), ==,
+                       gsk_contour_index_get_winding (index, &point));
+
+      found1 = gsk_contour_get_closest_point (contour, &point, 20, &result1, &dist1);
+      found2 = gsk_contour_index_get_closest_point (index, &point, 20, &result2, &dist2);
+      g_assert_true (found1 == found2);
+      if (found1)
+        g_assert_cmpfloat_with_epsilon (dist1, dist2, 0.01);
+    }
+
+  gsk_contour_index_free (index);
+  gsk_path_unref (path);
+
+  /* Small contours don't need an index */
+  path = create_star_path (10);
+  g_assert_null (gsk_contour_index_new (gsk_path_get_contour (path, 0)));
+  gsk_path_unref (path);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -274,6 +345,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/path/rounded-rect/winding", test_rounded_rect_winding);
   g_test_add_func ("/path/rect/roundtrip", test_rect_roundtrip);
   g_test_add_func ("/path/rect/winding", test_rect_winding);
+  g_test_add_func ("/path/contour/index", test_contour_index);
 
   return g_test_run ();
 }
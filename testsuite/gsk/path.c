@@ -762,6 +762,69 @@ test_segment (void)
     }
 }
 
+static void
+test_batch (void)
+{
+  GskPath *path;
+  GskPathMeasure *measure;
+  float distances[200];
+  GskPathPoint points[200];
+  graphene_point_t positions[200];
+  graphene_vec2_t tangents[200];
+  float length;
+
+  for (int i = 0; i < 100; i++)
+    {
+      if (g_test_verbose ())
+        g_test_message ("path %u", i);
+
+      path = create_random_path (G_MAXUINT);
+      measure = gsk_path_measure_new (path);
+      length = gsk_path_measure_get_length (measure);
+
+      /* increasing at first, then random, and a few out of range */
+      for (int j = 0; j < G_N_ELEMENTS (distances); j++)
+        {
+          if (j < 100)
+            distances[j] = length * j / 100;
+          else
+            distances[j] = g_test_rand_double_range (-10, length + 10);
+        }
+
+      if (!gsk_path_measure_get_points (measure, distances, G_N_ELEMENTS (distances), points))
+        {
+          g_assert_true (gsk_path_is_empty (path));
+          gsk_path_unref (path);
+          gsk_path_measure_unref (measure);
+          continue;
+        }
+
+      g_assert_true (gsk_path_measure_get_positions (measure, distances, G_N_ELEMENTS (distances), positions, tangents));
+
+      for (int j = 0; j < G_N_ELEMENTS (distances); j++)
+        {
+          GskPathPoint point;
+          graphene_point_t pos1, pos2;
+          graphene_vec2_t tangent;
+
+          g_assert_true (gsk_path_measure_get_point (measure, distances[j], &point));
+
+          gsk_path_point_get_position (&point, path, &pos1);
+          gsk_path_point_get_position (&points[j], path, &pos2);
+          g_assert_cmpfloat_with_epsilon (pos1.x, pos2.x, 0.01);
+          g_assert_cmpfloat_with_epsilon (pos1.y, pos2.y, 0.01);
+          g_assert_cmpfloat_with_epsilon (pos1.x, positions[j].x, 0.01);
+          g_assert_cmpfloat_with_epsilon (pos1.y, positions[j].y, 0.01);
+
+          gsk_path_point_get_tangent (&points[j], path, GSK_PATH_TO_END, &tangent);
+          g_assert_true (graphene_vec2_equal (&tangent, &tangents[j]));
+        }
+
+      gsk_path_unref (path);
+      gsk_path_measure_unref (measure);
+    }
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -775,6 +838,7 @@ main (int   argc,
   g_test_add_func ("/path/measure/split", test_split);
   g_test_add_func ("/path/measure/roundtrip", test_roundtrip);
   g_test_add_func ("/path/measure/segment", test_segment);
+  g_test_add_func ("/path/measure/batch", test_batch);
 
   return g_test_run ();
 }
@@ -414,6 +414,78 @@ test_shift_right (void)
     }
 }
 
+/* Shifts value by value, to compare against */
+static GtkBitset *
+shift_slowly (GtkBitset *set,
+              int        amount)
+{
+  GtkBitset *result;
+  GtkBitsetIter iter;
+  guint value;
+  gboolean loop;
+
+  result = gtk_bitset_new_empty ();
+
+  for (loop = gtk_bitset_iter_init_first (&iter, set, &value);
+       loop;
+       loop = gtk_bitset_iter_next (&iter, &value))
+    {
+      if (amount < 0 && value < (guint) -amount)
+        continue;
+      if (amount > 0 && value > G_MAXUINT - amount)
+        break;
+
+      gtk_bitset_add (result, value + amount);
+    }
+
+  return result;
+}
+
+static void
+test_shift_runs (void)
+{
+  GtkBitset *set, *shifted, *expected;
+  guint i, j;
+  int amounts[] = { 1, 63, 64, 65, 4096, 65535, 65536, 100000 };
+
+  set = gtk_bitset_new_empty ();
+
+  /* sparse values, turning into array containers */
+  for (i = 0; i < 1000; i++)
+    gtk_bitset_add (set, g_test_rand_int_range (0, 65536));
+
+  /* dense random values, turning into bitset containers */
+  for (i = 0; i < 30000; i++)
+    gtk_bitset_add (set, g_test_rand_int_range (65536, 2 * 65536));
+
+  /* runs touching word and container boundaries */
+  gtk_bitset_add_range_closed (set, 2 * 65536 + 60, 2 * 65536 + 130);
+  gtk_bitset_add_range_closed (set, 3 * 65536 - 10, 5 * 65536 + 10);
+  gtk_bitset_add_range_closed (set, G_MAXUINT - 100, G_MAXUINT);
+
+  for (i = 0; i < G_N_ELEMENTS (amounts); i++)
+    {
+      for (j = 0; j < 2; j++)
+        {
+          int amount = j ? amounts[i] : -amounts[i];
+
+          shifted = gtk_bitset_copy (set);
+          if (amount < 0)
+            gtk_bitset_shift_left (shifted, -amount);
+          else
+            gtk_bitset_shift_right (shifted, amount);
+
+          expected = shift_slowly (set, amount);
+          g_assert_true (gtk_bitset_equals (shifted, expected));
+
+          gtk_bitset_unref (expected);
+          gtk_bitset_unref (shifted);
+        }
+    }
+
+  gtk_bitset_unref (set);
+}
+
 static void
 test_slice (void)
 {
@@ -575,6 +647,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/bitset/subtract", test_subtract);
   g_test_add_func ("/bitset/shift-left", test_shift_left);
   g_test_add_func ("/bitset/shift-right", test_shift_right);
+  g_test_add_func ("/bitset/shift-runs", test_shift_runs);
   g_test_add_func ("/bitset/slice", test_slice);
   g_test_add_func ("/bitset/rectangle", test_rectangle);
   g_test_add_func ("/bitset/iter", test_iter);
@@ -0,0 +1,207 @@
+/* GtkDirectoryList tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <locale.h>
+#include <string.h>
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+
+#include "gtk/gtkdirectorylistprivate.h"
+
+typedef struct
+{
+  guint n_changes;
+  guint n_added;
+  guint min_added;
+  guint max_added;
+} Changes;
+
+static void
+items_changed (GListModel *model,
+               guint       position,
+               guint       removed,
+               guint       added,
+               Changes    *changes)
+{
+  g_assert_cmpuint (removed, ==, 0);
+
+  if (changes->n_changes == 0 || added < changes->min_added)
+    changes->min_added = added;
+  if (added > changes->max_added)
+    changes->max_added = added;
+
+  changes->n_changes++;
+  changes->n_added += added;
+}
+
+static char *
+make_directory (guint n_files)
+{
+  char *dir;
+  guint i;
+  GError *error = NULL;
+
+  dir = g_dir_make_tmp ("directorylistXXXXXX", &error);
+  g_assert_no_error (error);
+
+  for (i = 0; i < n_files; i++)
+    {
+      char *name = g_strdup_printf ("%s/file%u", dir, i);
+
+      g_file_set_contents (name, "", 0, &error);
+      g_assert_no_error (error);
+
+      g_free (name);
+    }
+
+  return dir;
+}
+
+static void
+remove_directory (const char *dir,
+                  guint       n_files)
+{
+  guint i;
+
+  for (i = 0; i < n_files; i++)
+    {
+      char *name = g_strdup_printf ("%s/file%u", dir, i);
+
+      g_remove (name);
+      g_free (name);
+    }
+
+  g_rmdir (dir);
+}
+
+static void
+load_directory (GtkDirectoryList *list)
+{
+  while (gtk_directory_list_is_loading (list))
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+load_in_small_queries (const char *dir,
+                       guint       n_files,
+                       guint       publish_interval,
+                       Changes    *changes)
+{
+  GtkDirectoryList *list;
+  GFile *file;
+
+  file = g_file_new_for_path (dir);
+
+  list = gtk_directory_list_new (G_FILE_ATTRIBUTE_STANDARD_NAME, NULL);
+  gtk_directory_list_set_monitored (list, FALSE);
+  /* Start with tiny queries, so loading takes many of them */
+  gtk_directory_list_set_query_size (list, 1);
+  gtk_directory_list_set_publish_interval (list, publish_interval);
+  g_signal_connect (list, "items-changed", G_CALLBACK (items_changed), changes);
+
+  gtk_directory_list_set_file (list, file);
+  load_directory (list);
+
+  g_assert_no_error (gtk_directory_list_get_error (list));
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, n_files);
+  g_assert_cmpuint (changes->n_added, ==, n_files);
+  /* The query size doubles: 1, 2, 4, ... 256, the rest, and the empty last one */
+  g_assert_cmpuint (gtk_directory_list_get_n_queries (list), ==, 11);
+
+  g_object_unref (list);
+  g_object_unref (file);
+}
+
+static void
+test_load (void)
+{
+  const guint n_files = 1000;
+  Changes changes = { 0, };
+  char *dir;
+
+  dir = make_directory (n_files);
+
+  /* Without batching, every query that returned files is added on its own */
+  load_in_small_queries (dir, n_files, 0, &changes);
+  g_assert_cmpuint (changes.n_changes, ==, 10);
+  g_assert_cmpuint (changes.min_added, ==, 1);
+
+  /* With batching, the first query is added right away and all the
+   * others are collected until loading is done.
+   */
+  memset (&changes, 0, sizeof (changes));
+  load_in_small_queries (dir, n_files, G_MAXUINT, &changes);
+  g_assert_cmpuint (changes.n_changes, ==, 2);
+  g_assert_cmpuint (changes.min_added, ==, 1);
+  g_assert_cmpuint (changes.max_added, ==, n_files - 1);
+
+  remove_directory (dir, n_files);
+  g_free (dir);
+}
+
+static void
+test_load_performance (void)
+{
+  const guint n_files = 200000;
+  GtkDirectoryList *list;
+  Changes changes = { 0, };
+  GFile *file;
+  GTimer *timer;
+  char *dir;
+
+  dir = make_directory (n_files);
+  file = g_file_new_for_path (dir);
+
+  list = gtk_directory_list_new (G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                 G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
+                                 G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                 G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                 NULL);
+  gtk_directory_list_set_monitored (list, FALSE);
+  g_signal_connect (list, "items-changed", G_CALLBACK (items_changed), &changes);
+
+  timer = g_timer_new ();
+  gtk_directory_list_set_file (list, file);
+  load_directory (list);
+  g_timer_stop (timer);
+
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, n_files);
+
+  g_test_message ("%u files in %u changes", n_files, changes.n_changes);
+  g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                           "load %u files: %.2fs", n_files, g_timer_elapsed (timer, NULL));
+
+  g_timer_destroy (timer);
+  g_object_unref (list);
+  g_object_unref (file);
+  remove_directory (dir, n_files);
+  g_free (dir);
+}
+
+int
+main (int argc, char *argv[])
+{
+  (g_test_init) (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  g_test_add_func ("/directorylist/load", test_load);
+
+  if (g_test_perf ())
+    g_test_add_func ("/directorylist/load-performance", test_load_performance);
+
+  return g_test_run ();
+}
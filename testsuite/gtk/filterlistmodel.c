@@ -561,6 +561,145 @@ test_sections (void)
   g_object_unref (sorted);
 }
 
+static void
+assert_filter_results (GtkFilterListModel *model)
+{
+  GListModel *unfiltered = gtk_filter_list_model_get_model (model);
+  GtkFilter *filter = gtk_filter_list_model_get_filter (model);
+  guint i, n;
+
+  while (gtk_filter_list_model_get_pending (model) != 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  n = 0;
+  for (i = 0; i < g_list_model_get_n_items (unfiltered); i++)
+    {
+      GObject *item = g_list_model_get_item (unfiltered, i);
+
+      if (gtk_filter_match (filter, item))
+        {
+          GObject *filtered = g_list_model_get_item (G_LIST_MODEL (model), n);
+          g_assert_true (filtered == item);
+          g_object_unref (filtered);
+          n++;
+        }
+
+      g_object_unref (item);
+    }
+
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, n);
+}
+
+static char *
+random_word (void)
+{
+  const char *syllables[] = { "ka", "LO", "mi", "Ne", "pu", "ri", "SA", "to", "\303\251" };
+  GString *s = g_string_new (NULL);
+  guint i, n;
+
+  n = g_test_rand_int_range (1, 6);
+  for (i = 0; i < n; i++)
+    g_string_append (s, syllables[g_test_rand_int_range (0, G_N_ELEMENTS (syllables))]);
+
+  return g_string_free (s, FALSE);
+}
+
+/* The string filter caches the prepared strings of the items,
+ * make sure the results match the uncached gtk_filter_match().
+ */
+static void
+test_string_filter_cache (gconstpointer data)
+{
+  gboolean incremental = GPOINTER_TO_UINT (data);
+  const char *searches[] = { "k", "ka", "kal", "kalo", "ka", "", "E\314\201", "\303\251", "to", "sa", "mine", "x", NULL };
+  GtkFilterListModel *model;
+  GtkStringFilter *filter;
+  GtkStringList *list;
+  guint i, j;
+
+  list = gtk_string_list_new (NULL);
+  for (i = 0; i < 20000; i++)
+    gtk_string_list_take (list, random_word ());
+
+  filter = gtk_string_filter_new (gtk_property_expression_new (GTK_TYPE_STRING_OBJECT, NULL, "string"));
+  model = gtk_filter_list_model_new (G_LIST_MODEL (list), GTK_FILTER (filter));
+  gtk_filter_list_model_set_incremental (model, incremental);
+
+  for (i = 0; searches[i]; i++)
+    {
+      gtk_string_filter_set_search (filter, searches[i]);
+      assert_filter_results (model);
+
+      /* Changing items must update the cached strings */
+      for (j = 0; j < 10; j++)
+        {
+          char *word = random_word ();
+          guint pos = g_test_rand_int_range (0, g_list_model_get_n_items (G_LIST_MODEL (list)));
+
+          gtk_string_list_splice (list, pos, 1, (const char *[]) { word, "kalo", NULL });
+          g_free (word);
+        }
+      assert_filter_results (model);
+    }
+
+  gtk_string_filter_set_search (filter, "ka");
+  gtk_string_filter_set_ignore_case (filter, FALSE);
+  assert_filter_results (model);
+  gtk_string_filter_set_match_mode (filter, GTK_STRING_FILTER_MATCH_MODE_PREFIX);
+  assert_filter_results (model);
+  gtk_string_filter_set_search (filter, NULL);
+  gtk_string_filter_set_ignore_case (filter, TRUE);
+  gtk_string_filter_set_search (filter, "ka");
+  assert_filter_results (model);
+
+  g_object_unref (model);
+}
+
+static void
+test_string_filter_performance (void)
+{
+  const char *search = "item 12345";
+  const guint n_items = 500000;
+  GtkFilterListModel *model;
+  GtkStringFilter *filter;
+  GtkStringList *list;
+  guint i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Performance tests not enabled");
+      return;
+    }
+
+  list = gtk_string_list_new (NULL);
+  for (i = 0; i < n_items; i++)
+    gtk_string_list_take (list, g_strdup_printf ("Item %u", g_test_rand_int_range (0, 1000000)));
+
+  filter = gtk_string_filter_new (gtk_property_expression_new (GTK_TYPE_STRING_OBJECT, NULL, "string"));
+  model = gtk_filter_list_model_new (G_LIST_MODEL (list), GTK_FILTER (filter));
+
+  /* Type the search, then delete it again */
+  for (i = 1; i <= 2 * strlen (search); i++)
+    {
+      guint len = i <= strlen (search) ? i : 2 * strlen (search) - i;
+      char *prefix = g_strndup (search, len);
+      gint64 start;
+      double elapsed;
+
+      start = g_get_monotonic_time ();
+      gtk_string_filter_set_search (filter, prefix);
+      elapsed = (double) (g_get_monotonic_time () - start) / 1000;
+
+      g_test_minimized_result (elapsed, "%u items, search \"%s\": %.2f ms, %u matches",
+                               n_items, prefix, elapsed,
+                               g_list_model_get_n_items (G_LIST_MODEL (model)));
+
+      g_free (prefix);
+    }
+
+  g_object_unref (model);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -577,6 +716,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/filterlistmodel/empty", test_empty);
   g_test_add_func ("/filterlistmodel/add_remove_item", test_add_remove_item);
   g_test_add_func ("/filterlistmodel/sections", test_sections);
+  g_test_add_data_func ("/filterlistmodel/string-filter/cache", GUINT_TO_POINTER (FALSE), test_string_filter_cache);
+  g_test_add_data_func ("/filterlistmodel/string-filter/cache-incremental", GUINT_TO_POINTER (TRUE), test_string_filter_cache);
+  g_test_add_func ("/filterlistmodel/string-filter/performance", test_string_filter_performance);
 
   return g_test_run ();
 }
@@ -228,6 +228,88 @@ test_label_parse_more (void)
   g_object_unref (label);
 }
 
+#define LOREM_IPSUM "Lorem ipsum dolor sit amet, consectetur adipiscing elit, " \
+                    "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua."
+
+static void
+test_label_width_for_height (void)
+{
+  GtkWidget *label;
+  int min1, nat1, min2, nat2;
+
+  label = gtk_label_new (LOREM_IPSUM);
+  g_object_ref_sink (label);
+  gtk_label_set_wrap (GTK_LABEL (label), TRUE);
+
+  gtk_widget_measure (label, GTK_ORIENTATION_HORIZONTAL, 60, &min1, &nat1, NULL, NULL);
+  gtk_widget_measure (label, GTK_ORIENTATION_HORIZONTAL, 60, &min2, &nat2, NULL, NULL);
+  g_assert_cmpint (min1, ==, min2);
+  g_assert_cmpint (nat1, ==, nat2);
+
+  /* more height means we can be narrower */
+  gtk_widget_measure (label, GTK_ORIENTATION_HORIZONTAL, 120, &min2, &nat2, NULL, NULL);
+  g_assert_cmpint (nat2, <=, nat1);
+
+  /* the cached values must be dropped when the text changes */
+  gtk_label_set_text (GTK_LABEL (label), LOREM_IPSUM " " LOREM_IPSUM);
+  gtk_widget_measure (label, GTK_ORIENTATION_HORIZONTAL, 60, &min2, &nat2, NULL, NULL);
+  g_assert_cmpint (nat2, >, nat1);
+
+  /* and when the wrap mode changes */
+  gtk_label_set_text (GTK_LABEL (label), LOREM_IPSUM);
+  gtk_widget_measure (label, GTK_ORIENTATION_HORIZONTAL, 60, &min2, &nat2, NULL, NULL);
+  g_assert_cmpint (nat2, ==, nat1);
+  gtk_label_set_natural_wrap_mode (GTK_LABEL (label), GTK_NATURAL_WRAP_NONE);
+  gtk_widget_measure (label, GTK_ORIENTATION_HORIZONTAL, 60, &min2, &nat2, NULL, NULL);
+  g_assert_cmpint (nat2, >=, nat1);
+
+  g_object_unref (label);
+}
+
+#define N_PERF_LABELS 1000
+#define N_PERF_PASSES 10
+
+static void
+test_label_width_for_height_perf (void)
+{
+  GtkWidget *labels[N_PERF_LABELS];
+  GTimer *timer;
+  int i, pass;
+
+  for (i = 0; i < N_PERF_LABELS; i++)
+    {
+      char *text = g_strdup_printf ("%d %s", i, LOREM_IPSUM);
+
+      labels[i] = gtk_label_new (text);
+      g_object_ref_sink (labels[i]);
+      gtk_label_set_wrap (GTK_LABEL (labels[i]), TRUE);
+      g_free (text);
+    }
+
+  timer = g_timer_new ();
+
+  /* Like a flowbox doing repeated allocation passes */
+  for (pass = 0; pass < N_PERF_PASSES; pass++)
+    {
+      for (i = 0; i < N_PERF_LABELS; i++)
+        {
+          int min, nat;
+
+          gtk_widget_measure (labels[i], GTK_ORIENTATION_HORIZONTAL, 40 + 20 * (pass % 3),
+                              &min, &nat, NULL, NULL);
+        }
+    }
+
+  g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                           "%d wrapped labels, %d width-for-height passes: %.3fs",
+                           N_PERF_LABELS, N_PERF_PASSES, g_timer_elapsed (timer, NULL));
+
+  g_timer_destroy (timer);
+
+  for (i = 0; i < N_PERF_LABELS; i++)
+    g_object_unref (labels[i]);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -236,6 +318,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/label/markup-parse", test_label_markup);
   g_test_add_func ("/label/underline-parse", test_label_underline);
   g_test_add_func ("/label/parse-more", test_label_parse_more);
+  g_test_add_func ("/label/width-for-height", test_label_width_for_height);
+  if (g_test_perf ())
+    g_test_add_func ("/label/width-for-height-perf", test_label_width_for_height_perf);
 
   return g_test_run ();
 }
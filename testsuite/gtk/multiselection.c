@@ -556,6 +556,111 @@ test_readd (void)
   g_object_unref (selection);
 }
 
+static guint
+get_selection_size (GtkSelectionModel *selection)
+{
+  GtkBitset *set;
+  guint size;
+
+  set = gtk_selection_model_get_selection (selection);
+  size = gtk_bitset_get_size (set);
+  gtk_bitset_unref (set);
+
+  return size;
+}
+
+/* Test that large ranges are handled as ranges,
+ * and survive changes to the model
+ */
+static void
+test_large_range (void)
+{
+  GtkSelectionModel *selection;
+  GListStore *store;
+  gboolean ret;
+
+  store = new_store (1, 100000, 1);
+  selection = new_model (G_LIST_MODEL (store));
+
+  ret = gtk_selection_model_select_all (selection);
+  g_assert_true (ret);
+  assert_selection_changes (selection, "0:100000");
+  g_assert_cmpuint (get_selection_size (selection), ==, 100000);
+
+  ret = gtk_selection_model_unselect_range (selection, 1000, 50000);
+  g_assert_true (ret);
+  assert_selection_changes (selection, "1000:50000");
+  g_assert_cmpuint (get_selection_size (selection), ==, 50000);
+
+  g_list_store_splice (store, 0, 10, NULL, 0);
+  assert_changes (selection, "0-10*");
+  g_assert_cmpuint (get_selection_size (selection), ==, 49990);
+  g_assert_true (gtk_selection_model_is_selected (selection, 989));
+  g_assert_false (gtk_selection_model_is_selected (selection, 990));
+  g_assert_false (gtk_selection_model_is_selected (selection, 50989));
+  g_assert_true (gtk_selection_model_is_selected (selection, 50990));
+  g_assert_true (gtk_selection_model_is_selected (selection, 99989));
+
+  insert (store, 0, 100001);
+  assert_changes (selection, "+0*");
+  add (store, 100002);
+  assert_changes (selection, "+99991*");
+  g_assert_cmpuint (get_selection_size (selection), ==, 49990);
+  g_assert_false (gtk_selection_model_is_selected (selection, 0));
+  g_assert_true (gtk_selection_model_is_selected (selection, 1));
+  g_assert_true (gtk_selection_model_is_selected (selection, 99990));
+  g_assert_false (gtk_selection_model_is_selected (selection, 99991));
+
+  /* selected items that are removed and readded stay selected */
+  g_list_model_items_changed (G_LIST_MODEL (store), 50000, 20000, 20000);
+  assert_changes (selection, "50000-20000+20000");
+  g_assert_cmpuint (get_selection_size (selection), ==, 49990);
+  assert_selection_changes (selection, "");
+
+  g_object_unref (store);
+  g_object_unref (selection);
+}
+
+static void
+test_large_range_performance (void)
+{
+  GtkSelectionModel *selection;
+  GListStore *store;
+  gint64 start;
+  double select_time, splice_time, append_time;
+  guint i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Performance tests not enabled");
+      return;
+    }
+
+  store = new_store (1, 1000000, 1);
+  selection = GTK_SELECTION_MODEL (gtk_multi_selection_new (g_object_ref (G_LIST_MODEL (store))));
+
+  start = g_get_monotonic_time ();
+  gtk_selection_model_select_all (selection);
+  select_time = (double) (g_get_monotonic_time () - start) / 1000;
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < 100; i++)
+    g_list_store_remove (store, 0);
+  splice_time = (double) (g_get_monotonic_time () - start) / 100;
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < 100; i++)
+    add (store, 1000001 + i);
+  append_time = (double) (g_get_monotonic_time () - start) / 100;
+
+  g_test_minimized_result (select_time, "selecting 1000000 items: %.2f ms", select_time);
+  g_test_minimized_result (splice_time, "removing at the top: %.2f µs per removal", splice_time);
+  g_test_minimized_result (append_time, "appending: %.2f µs per item", append_time);
+
+  g_object_unref (store);
+  g_object_unref (selection);
+}
+
 static void
 test_set_selection (void)
 {
@@ -880,6 +985,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/multiselection/selection", test_selection);
   g_test_add_func ("/multiselection/select-range", test_select_range);
   g_test_add_func ("/multiselection/readd", test_readd);
+  g_test_add_func ("/multiselection/large-range", test_large_range);
+  g_test_add_func ("/multiselection/large-range/performance", test_large_range_performance);
   g_test_add_func ("/multiselection/set_selection", test_set_selection);
   g_test_add_func ("/multiselection/selection-filter", test_selection_filter);
   g_test_add_func ("/multiselection/set-model", test_set_model);
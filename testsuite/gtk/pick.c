@@ -0,0 +1,328 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <locale.h>
+
+/* A widget that allocates its child outside of itself */
+#define OVERFLOW_TYPE_WIDGET (overflow_widget_get_type ())
+G_DECLARE_FINAL_TYPE (OverflowWidget, overflow_widget, OVERFLOW, WIDGET, GtkWidget)
+
+struct _OverflowWidget
+{
+  GtkWidget parent_instance;
+
+  GtkWidget *child;
+  int offset;
+};
+
+G_DEFINE_TYPE (OverflowWidget, overflow_widget, GTK_TYPE_WIDGET)
+
+static void
+overflow_widget_measure (GtkWidget      *widget,
+                         GtkOrientation  orientation,
+                         int             for_size,
+                         int            *minimum,
+                         int            *natural,
+                         int            *minimum_baseline,
+                         int            *natural_baseline)
+{
+  OverflowWidget *self = OVERFLOW_WIDGET (widget);
+
+  gtk_widget_measure (self->child, orientation, -1, NULL, NULL, NULL, NULL);
+
+  *minimum = *natural = 20;
+}
+
+static void
+overflow_widget_size_allocate (GtkWidget *widget,
+                               int        width,
+                               int        height,
+                               int        baseline)
+{
+  OverflowWidget *self = OVERFLOW_WIDGET (widget);
+
+  gtk_widget_size_allocate (self->child,
+                            &(GtkAllocation) { self->offset, self->offset, 20, 20 },
+                            -1);
+}
+
+static void
+overflow_widget_dispose (GObject *object)
+{
+  OverflowWidget *self = OVERFLOW_WIDGET (object);
+
+  g_clear_pointer (&self->child, gtk_widget_unparent);
+
+  G_OBJECT_CLASS (overflow_widget_parent_class)->dispose (object);
+}
+
+static void
+overflow_widget_class_init (OverflowWidgetClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->dispose = overflow_widget_dispose;
+
+  widget_class->measure = overflow_widget_measure;
+  widget_class->size_allocate = overflow_widget_size_allocate;
+}
+
+static void
+overflow_widget_init (OverflowWidget *self)
+{
+  self->child = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  gtk_widget_set_parent (self->child, GTK_WIDGET (self));
+  self->offset = 100;
+}
+
+static void
+after_paint (GdkFrameClock *clock,
+             gboolean      *painted)
+{
+  *painted = TRUE;
+}
+
+/* Waits for @window to be mapped and to have done a full frame,
+ * so that all pending allocations have happened
+ */
+static gboolean
+wait_for_frame (GtkWidget *window)
+{
+  gint64 end_time = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+  GdkFrameClock *clock;
+  gboolean painted = FALSE;
+  gulong handler;
+
+  while (!gtk_widget_get_mapped (window))
+    {
+      if (g_get_monotonic_time () > end_time)
+        return FALSE;
+
+      if (!g_main_context_iteration (NULL, FALSE))
+        g_usleep (1000);
+    }
+
+  clock = gtk_widget_get_frame_clock (window);
+  handler = g_signal_connect (clock, "after-paint", G_CALLBACK (after_paint), &painted);
+  gtk_widget_queue_draw (window);
+
+  while (!painted && g_get_monotonic_time () < end_time)
+    {
+      if (!g_main_context_iteration (NULL, FALSE))
+        g_usleep (1000);
+    }
+
+  g_signal_handler_disconnect (clock, handler);
+
+  return painted;
+}
+
+/* What gtk_widget_pick() does, for a container of leaf widgets */
+static GtkWidget *
+reference_pick (GtkWidget *widget,
+                double     x,
+                double     y)
+{
+  GtkWidget *child;
+
+  for (child = gtk_widget_get_last_child (widget);
+       child;
+       child = gtk_widget_get_prev_sibling (child))
+    {
+      graphene_point_t p;
+
+      if (!gtk_widget_compute_point (widget, child, &GRAPHENE_POINT_INIT (x, y), &p))
+        continue;
+
+      if (gtk_widget_contains (child, p.x, p.y))
+        return child;
+    }
+
+  if (gtk_widget_contains (widget, x, y))
+    return widget;
+
+  return NULL;
+}
+
+static GtkWidget *
+fixed_new (guint n_children)
+{
+  GtkWidget *fixed;
+  guint i;
+
+  fixed = gtk_fixed_new ();
+
+  for (i = 0; i < n_children; i++)
+    {
+      GtkWidget *child = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+
+      gtk_widget_set_size_request (child, 16, 16);
+      gtk_fixed_put (GTK_FIXED (fixed), child, (i % 50) * 12, (i / 50) * 12 % 600);
+
+      if (i % 7 == 0)
+        {
+          GskTransform *transform;
+
+          transform = gsk_transform_translate (NULL, &GRAPHENE_POINT_INIT ((i % 50) * 12 + 8, (i / 50) * 12 % 600 + 8));
+          transform = gsk_transform_rotate (transform, 30);
+          transform = gsk_transform_translate (transform, &GRAPHENE_POINT_INIT (-8, -8));
+          gtk_fixed_set_child_transform (GTK_FIXED (fixed), child, transform);
+          gsk_transform_unref (transform);
+        }
+    }
+
+  return fixed;
+}
+
+static void
+test_pick_fixed (void)
+{
+  GtkWidget *window, *fixed, *child;
+  guint i;
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 700, 700);
+  fixed = fixed_new (2000);
+  gtk_window_set_child (GTK_WINDOW (window), fixed);
+  gtk_window_present (GTK_WINDOW (window));
+
+  if (!wait_for_frame (window))
+    {
+      g_test_skip ("Could not map window");
+      gtk_window_destroy (GTK_WINDOW (window));
+      return;
+    }
+
+  for (i = 0; i < 2000; i++)
+    {
+      double x = g_test_rand_double_range (-10, gtk_widget_get_width (fixed) + 10);
+      double y = g_test_rand_double_range (-10, gtk_widget_get_height (fixed) + 10);
+
+      g_assert_true (gtk_widget_pick (fixed, x, y, GTK_PICK_DEFAULT) == reference_pick (fixed, x, y));
+    }
+
+  /* Moving a child must be picked up */
+  child = gtk_widget_get_first_child (fixed);
+  gtk_fixed_move (GTK_FIXED (fixed), child, 650, 650);
+  g_assert_true (wait_for_frame (window));
+  g_assert_true (gtk_widget_pick (fixed, 655, 655, GTK_PICK_DEFAULT) == child);
+
+  /* Untargetable children are skipped */
+  gtk_widget_set_can_target (child, FALSE);
+  g_assert_true (gtk_widget_pick (fixed, 655, 655, GTK_PICK_DEFAULT) == fixed);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_pick_overflow (void)
+{
+  GtkWidget *window, *fixed, *widget;
+  OverflowWidget *overflow;
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 400, 400);
+  fixed = gtk_fixed_new ();
+  gtk_window_set_child (GTK_WINDOW (window), fixed);
+  widget = g_object_new (OVERFLOW_TYPE_WIDGET, NULL);
+  overflow = OVERFLOW_WIDGET (widget);
+  gtk_fixed_put (GTK_FIXED (fixed), widget, 10, 10);
+  gtk_window_present (GTK_WINDOW (window));
+
+  if (!wait_for_frame (window))
+    {
+      g_test_skip ("Could not map window");
+      gtk_window_destroy (GTK_WINDOW (window));
+      return;
+    }
+
+  /* Children outside of their parent can be picked... */
+  g_assert_true (gtk_widget_pick (fixed, 115, 115, GTK_PICK_DEFAULT) == overflow->child);
+  g_assert_true (gtk_widget_pick (fixed, 15, 15, GTK_PICK_DEFAULT) == widget);
+  g_assert_true (gtk_widget_pick (fixed, 215, 215, GTK_PICK_DEFAULT) == fixed);
+
+  /* ...and keep being found when they move */
+  overflow->offset = 200;
+  gtk_widget_queue_allocate (widget);
+  g_assert_true (wait_for_frame (window));
+  g_assert_true (gtk_widget_pick (fixed, 215, 215, GTK_PICK_DEFAULT) == overflow->child);
+  g_assert_true (gtk_widget_pick (fixed, 115, 115, GTK_PICK_DEFAULT) == fixed);
+
+  /* Unless the parent clips them */
+  gtk_widget_set_overflow (widget, GTK_OVERFLOW_HIDDEN);
+  g_assert_true (gtk_widget_pick (fixed, 215, 215, GTK_PICK_DEFAULT) == fixed);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_pick_performance (void)
+{
+  GtkWidget *window, *fixed;
+  gint64 start;
+  double elapsed;
+  guint i, n;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Performance tests not enabled");
+      return;
+    }
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 700, 700);
+  fixed = fixed_new (10000);
+  gtk_window_set_child (GTK_WINDOW (window), fixed);
+  gtk_window_present (GTK_WINDOW (window));
+
+  if (!wait_for_frame (window))
+    {
+      g_test_skip ("Could not map window");
+      gtk_window_destroy (GTK_WINDOW (window));
+      return;
+    }
+
+  n = 100000;
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n; i++)
+    {
+      gtk_widget_pick (fixed,
+                       g_test_rand_double_range (0, gtk_widget_get_width (fixed)),
+                       g_test_rand_double_range (0, gtk_widget_get_height (fixed)),
+                       GTK_PICK_DEFAULT);
+    }
+  elapsed = (double) (g_get_monotonic_time () - start) / n;
+
+  g_test_minimized_result (elapsed, "10000 children: %.2f µs per pick", elapsed);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  g_test_add_func ("/pick/fixed", test_pick_fixed);
+  g_test_add_func ("/pick/overflow", test_pick_overflow);
+  g_test_add_func ("/pick/performance", test_pick_performance);
+
+  return g_test_run ();
+}
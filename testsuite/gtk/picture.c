@@ -0,0 +1,198 @@
+/* GtkPicture tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+
+/* Big enough to be loaded asynchronously */
+#define IMAGE_WIDTH 1200
+#define IMAGE_HEIGHT 900
+
+static GBytes *
+make_png (void)
+{
+  GdkTexture *texture;
+  GBytes *bytes;
+  guchar *data;
+  gsize x, y, stride;
+
+  stride = IMAGE_WIDTH * 4;
+  data = g_malloc (stride * IMAGE_HEIGHT);
+  for (y = 0; y < IMAGE_HEIGHT; y++)
+    for (x = 0; x < IMAGE_WIDTH; x++)
+      {
+        guchar *pixel = data + y * stride + x * 4;
+
+        pixel[0] = x * 255 / IMAGE_WIDTH;
+        pixel[1] = y * 255 / IMAGE_HEIGHT;
+        pixel[2] = 0;
+        pixel[3] = 255;
+      }
+
+  bytes = g_bytes_new_take (data, stride * IMAGE_HEIGHT);
+  texture = gdk_memory_texture_new (IMAGE_WIDTH, IMAGE_HEIGHT,
+                                    GDK_MEMORY_R8G8B8A8,
+                                    bytes,
+                                    stride);
+  g_bytes_unref (bytes);
+
+  bytes = gdk_texture_save_to_png_bytes (texture);
+  g_object_unref (texture);
+
+  return bytes;
+}
+
+static char *
+write_file (const guchar *data,
+            gsize         size)
+{
+  GError *error = NULL;
+  char *filename;
+  int fd;
+
+  fd = g_file_open_tmp ("pictureXXXXXX.png", &filename, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+
+  g_file_set_contents (filename, (const char *) data, size, &error);
+  g_assert_no_error (error);
+
+  return filename;
+}
+
+static void
+paintable_changed (GObject    *object,
+                   GParamSpec *pspec,
+                   gpointer    data)
+{
+  gboolean *changed = data;
+
+  *changed = TRUE;
+}
+
+static void
+allocate (GtkWidget *picture,
+          int        width,
+          int        height)
+{
+  gtk_widget_measure (picture, GTK_ORIENTATION_HORIZONTAL, -1, NULL, NULL, NULL, NULL);
+  gtk_widget_measure (picture, GTK_ORIENTATION_VERTICAL, width, NULL, NULL, NULL, NULL);
+  gtk_widget_allocate (picture, width, height, -1, NULL);
+}
+
+/* Allocates the picture and waits for the decode that triggers */
+static void
+allocate_and_wait (GtkWidget *picture,
+                   int        width,
+                   int        height)
+{
+  gboolean changed = FALSE;
+  gulong id;
+
+  id = g_signal_connect (picture, "notify::paintable", G_CALLBACK (paintable_changed), &changed);
+
+  allocate (picture, width, height);
+
+  while (!changed)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_signal_handler_disconnect (picture, id);
+}
+
+static void
+test_load_async (void)
+{
+  GtkWidget *picture;
+  GdkPaintable *placeholder, *paintable;
+  GBytes *bytes;
+  char *filename;
+
+  bytes = make_png ();
+  filename = write_file (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+
+  picture = g_object_ref_sink (gtk_picture_new_for_filename (filename));
+
+  /* Before we are allocated, there is a placeholder of the right size */
+  placeholder = gtk_picture_get_paintable (GTK_PICTURE (picture));
+  g_assert_nonnull (placeholder);
+  g_assert_false (GDK_IS_TEXTURE (placeholder));
+  g_assert_cmpint (gdk_paintable_get_intrinsic_width (placeholder), ==, IMAGE_WIDTH);
+  g_assert_cmpint (gdk_paintable_get_intrinsic_height (placeholder), ==, IMAGE_HEIGHT);
+
+  /* Once we are, the image is decoded at that size, but reports its own size */
+  allocate_and_wait (picture, IMAGE_WIDTH / 4, IMAGE_HEIGHT / 4);
+  paintable = gtk_picture_get_paintable (GTK_PICTURE (picture));
+  g_assert_nonnull (paintable);
+  g_assert_true (paintable != placeholder);
+  g_assert_cmpint (gdk_paintable_get_intrinsic_width (paintable), ==, IMAGE_WIDTH);
+  g_assert_cmpint (gdk_paintable_get_intrinsic_height (paintable), ==, IMAGE_HEIGHT);
+
+  /* Growing to the full size decodes the full image */
+  allocate_and_wait (picture, IMAGE_WIDTH, IMAGE_HEIGHT);
+  paintable = gtk_picture_get_paintable (GTK_PICTURE (picture));
+  g_assert_true (GDK_IS_TEXTURE (paintable));
+  g_assert_cmpint (gdk_texture_get_width (GDK_TEXTURE (paintable)), ==, IMAGE_WIDTH);
+  g_assert_cmpint (gdk_texture_get_height (GDK_TEXTURE (paintable)), ==, IMAGE_HEIGHT);
+
+  g_object_unref (picture);
+  g_remove (filename);
+  g_free (filename);
+  g_bytes_unref (bytes);
+}
+
+static void
+test_load_async_broken (void)
+{
+  GtkWidget *picture;
+  GdkPaintable *placeholder;
+  GBytes *bytes;
+  char *filename;
+
+  /* The header is fine, but the image data is cut off */
+  bytes = make_png ();
+  filename = write_file (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes) / 2);
+
+  picture = g_object_ref_sink (gtk_picture_new_for_filename (filename));
+
+  placeholder = gtk_picture_get_paintable (GTK_PICTURE (picture));
+  g_assert_nonnull (placeholder);
+  g_assert_cmpint (gdk_paintable_get_intrinsic_width (placeholder), ==, IMAGE_WIDTH);
+
+  /* Like a broken small image, this leaves the picture empty, without warnings */
+  allocate_and_wait (picture, IMAGE_WIDTH / 4, IMAGE_HEIGHT / 4);
+  g_assert_null (gtk_picture_get_paintable (GTK_PICTURE (picture)));
+
+  /* And we don't try again */
+  allocate (picture, IMAGE_WIDTH, IMAGE_HEIGHT);
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_null (gtk_picture_get_paintable (GTK_PICTURE (picture)));
+
+  g_object_unref (picture);
+  g_remove (filename);
+  g_free (filename);
+  g_bytes_unref (bytes);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/picture/load-async", test_load_async);
+  g_test_add_func ("/picture/load-async-broken", test_load_async_broken);
+
+  return g_test_run ();
+}
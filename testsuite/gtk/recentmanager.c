@@ -349,6 +349,71 @@ recent_manager_purge (void)
   g_assert_cmpint (n, ==, 1);
 }
 
+static void
+record_changed (GtkRecentManager *manager,
+                gpointer          data)
+{
+  gboolean *changed = data;
+
+  *changed = TRUE;
+}
+
+static void
+recent_manager_external_change (void)
+{
+  GtkRecentManager *writer, *reader;
+  GtkRecentData *recent_data;
+  char *dir, *filename;
+  gint64 end_time;
+  gboolean changed = FALSE;
+
+  dir = g_dir_make_tmp ("recentmanagerXXXXXX", NULL);
+  g_assert_nonnull (dir);
+  filename = g_build_filename (dir, "recently-used.xbel", NULL);
+
+  writer = g_object_new (GTK_TYPE_RECENT_MANAGER, "filename", filename, NULL);
+  reader = g_object_new (GTK_TYPE_RECENT_MANAGER, "filename", filename, NULL);
+  g_signal_connect (reader, "changed", G_CALLBACK (record_changed), &changed);
+
+  recent_data = g_new0 (GtkRecentData, 1);
+  recent_data->mime_type = (char *)"text/plain";
+  recent_data->app_name = (char *)"testrecentchooser";
+  recent_data->app_exec = (char *)"testrecentchooser %u";
+  g_assert_true (gtk_recent_manager_add_full (writer, uri, recent_data));
+  g_free (recent_data);
+
+  /* the reader only sees the change once it has loaded it */
+  g_assert_false (gtk_recent_manager_has_item (reader, uri));
+
+  end_time = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+  while (!changed && g_get_monotonic_time () < end_time)
+    {
+      if (!g_main_context_iteration (NULL, FALSE))
+        g_usleep (1000);
+    }
+
+  if (!changed)
+    g_test_skip ("File monitoring not available");
+  else
+    {
+      GList *items;
+
+      g_assert_true (gtk_recent_manager_has_item (reader, uri));
+
+      items = gtk_recent_manager_get_items (reader);
+      g_assert_cmpint (g_list_length (items), ==, 1);
+      g_list_free_full (items, (GDestroyNotify) gtk_recent_info_unref);
+    }
+
+  g_object_unref (reader);
+  g_object_unref (writer);
+
+  g_unlink (filename);
+  g_rmdir (dir);
+  g_free (filename);
+  g_free (dir);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -370,6 +435,7 @@ main (int    argc,
   g_test_add_func ("/recent-manager/lookup-item", recent_manager_lookup_item);
   g_test_add_func ("/recent-manager/remove-item", recent_manager_remove_item);
   g_test_add_func ("/recent-manager/purge", recent_manager_purge);
+  g_test_add_func ("/recent-manager/external-change", recent_manager_external_change);
 
   return g_test_run ();
 }
@@ -0,0 +1,322 @@
+/*
+ * Copyright © 2024 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <locale.h>
+
+#include "gdk/gdkeventsprivate.h"
+#include "gtk/gtkeventcontrollerprivate.h"
+
+static const GdkModifierType modifiers[] = {
+  GDK_CONTROL_MASK,
+  GDK_ALT_MASK,
+  GDK_CONTROL_MASK | GDK_ALT_MASK,
+  GDK_CONTROL_MASK | GDK_SUPER_MASK,
+};
+
+static gboolean
+present_window (GtkWidget *window)
+{
+  gint64 end_time = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+
+  gtk_window_present (GTK_WINDOW (window));
+
+  while (!gtk_widget_get_mapped (window) ||
+         !gdk_surface_get_mapped (gtk_native_get_surface (GTK_NATIVE (window))))
+    {
+      if (g_get_monotonic_time () > end_time)
+        return FALSE;
+
+      if (!g_main_context_iteration (NULL, FALSE))
+        g_usleep (1000);
+    }
+
+  return TRUE;
+}
+
+static GdkEvent *
+key_press_new (GtkWidget       *window,
+               guint            keyval,
+               GdkModifierType  state)
+{
+  GdkDisplay *display = gtk_widget_get_display (window);
+  GdkSeat *seat;
+  GdkKeymapKey *keys;
+  int n_keys;
+  GdkTranslatedKey translated;
+  GdkEvent *event;
+
+  seat = gdk_display_get_default_seat (display);
+  if (!seat || !gdk_display_map_keyval (display, keyval, &keys, &n_keys))
+    return NULL;
+
+  translated.keyval = keyval;
+  translated.consumed = 0;
+  translated.layout = keys[0].group;
+  translated.level = keys[0].level;
+
+  event = gdk_key_event_new (GDK_KEY_PRESS,
+                             gtk_native_get_surface (GTK_NATIVE (window)),
+                             gdk_seat_get_keyboard (seat),
+                             GDK_CURRENT_TIME,
+                             keys[0].keycode,
+                             state,
+                             FALSE,
+                             &translated,
+                             &translated,
+                             NULL);
+
+  g_free (keys);
+
+  return event;
+}
+
+static gboolean
+record_activation (GtkWidget *widget,
+                   GVariant  *args,
+                   gpointer   user_data)
+{
+  int *activated = g_object_get_data (G_OBJECT (widget), "activated");
+
+  *activated = GPOINTER_TO_INT (user_data);
+
+  return TRUE;
+}
+
+static GtkShortcut *
+recording_shortcut_new (GtkShortcutTrigger *trigger,
+                        int                 id)
+{
+  return gtk_shortcut_new (trigger,
+                           gtk_callback_action_new (record_activation, GINT_TO_POINTER (id), NULL));
+}
+
+/* Returns the id of the activated shortcut or -1 */
+static int
+dispatch (GtkWidget          *window,
+          GtkEventController *controller,
+          guint               keyval,
+          GdkModifierType     state)
+{
+  int *activated = g_object_get_data (G_OBJECT (window), "activated");
+  GdkEvent *event;
+  gboolean handled;
+
+  event = key_press_new (window, keyval, state);
+  g_assert_nonnull (event);
+
+  *activated = -1;
+  handled = gtk_event_controller_handle_event (controller, event, window, 0, 0);
+  g_assert_true (handled == (*activated != -1));
+
+  gdk_event_unref (event);
+
+  return *activated;
+}
+
+static GtkWidget *
+window_new (GtkEventController **controller)
+{
+  static int activated;
+  GtkWidget *window;
+
+  window = gtk_window_new ();
+  g_object_set_data (G_OBJECT (window), "activated", &activated);
+
+  *controller = gtk_shortcut_controller_new ();
+  gtk_widget_add_controller (window, *controller);
+
+  return window;
+}
+
+/* Adds 4 * 12 keyval shortcuts with ids 0..47, enough for the
+ * controller to use its index
+ */
+static void
+add_keyval_shortcuts (GtkShortcutController *controller)
+{
+  guint i, j;
+
+  for (i = 0; i < 12; i++)
+    for (j = 0; j < G_N_ELEMENTS (modifiers); j++)
+      gtk_shortcut_controller_add_shortcut (controller,
+                                            recording_shortcut_new (gtk_keyval_trigger_new (GDK_KEY_a + i, modifiers[j]),
+                                                                    i * G_N_ELEMENTS (modifiers) + j));
+}
+
+static void
+test_index_dispatch (void)
+{
+  GtkEventController *controller;
+  GtkWidget *window;
+  GtkShortcut *shortcut;
+  guint i, j;
+
+  window = window_new (&controller);
+  if (!present_window (window))
+    {
+      g_test_skip ("Could not map window");
+      gtk_window_destroy (GTK_WINDOW (window));
+      return;
+    }
+
+  add_keyval_shortcuts (GTK_SHORTCUT_CONTROLLER (controller));
+  gtk_shortcut_controller_add_shortcut (GTK_SHORTCUT_CONTROLLER (controller),
+                                        recording_shortcut_new (gtk_alternative_trigger_new (gtk_keyval_trigger_new (GDK_KEY_x, GDK_CONTROL_MASK),
+                                                                                             gtk_keyval_trigger_new (GDK_KEY_y, GDK_CONTROL_MASK)),
+                                                                100));
+
+  for (i = 0; i < 12; i++)
+    for (j = 0; j < G_N_ELEMENTS (modifiers); j++)
+      g_assert_cmpint (dispatch (window, controller, GDK_KEY_a + i, modifiers[j]), ==, i * G_N_ELEMENTS (modifiers) + j);
+
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_a, GDK_SHIFT_MASK), ==, -1);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_z, GDK_CONTROL_MASK), ==, -1);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_x, GDK_CONTROL_MASK), ==, 100);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_y, GDK_CONTROL_MASK), ==, 100);
+
+  /* Changing a trigger must be picked up */
+  shortcut = g_list_model_get_item (G_LIST_MODEL (controller), 0);
+  gtk_shortcut_set_trigger (shortcut, gtk_keyval_trigger_new (GDK_KEY_z, GDK_CONTROL_MASK));
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_z, GDK_CONTROL_MASK), ==, 0);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_a, GDK_CONTROL_MASK), ==, -1);
+
+  /* So must removing shortcuts, which shifts all positions */
+  gtk_shortcut_controller_remove_shortcut (GTK_SHORTCUT_CONTROLLER (controller), shortcut);
+  g_object_unref (shortcut);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_z, GDK_CONTROL_MASK), ==, -1);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_b, GDK_ALT_MASK), ==, 5);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_x, GDK_CONTROL_MASK), ==, 100);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_index_mnemonics (void)
+{
+  GtkEventController *controller;
+  GtkWidget *window;
+  guint i;
+
+  window = window_new (&controller);
+  if (!present_window (window))
+    {
+      g_test_skip ("Could not map window");
+      gtk_window_destroy (GTK_WINDOW (window));
+      return;
+    }
+
+  /* Spread the mnemonics out between the other shortcuts */
+  for (i = 0; i < 3; i++)
+    {
+      add_keyval_shortcuts (GTK_SHORTCUT_CONTROLLER (controller));
+      gtk_shortcut_controller_add_shortcut (GTK_SHORTCUT_CONTROLLER (controller),
+                                            recording_shortcut_new (gtk_mnemonic_trigger_new (GDK_KEY_m), 200 + i));
+    }
+
+  /* Mnemonics cycle round-robin through all matches */
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_m, GDK_ALT_MASK), ==, 200);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_m, GDK_ALT_MASK), ==, 201);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_m, GDK_ALT_MASK), ==, 202);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_m, GDK_ALT_MASK), ==, 200);
+
+  /* Alt+a is triggered 3 times, too, and continues after the last
+   * activation, moving the starting point past the first mnemonic
+   */
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_a, GDK_ALT_MASK), ==, 1);
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_m, GDK_ALT_MASK), ==, 201);
+
+  g_assert_cmpint (dispatch (window, controller, GDK_KEY_m, GDK_CONTROL_MASK), ==, -1);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_dispatch_performance (void)
+{
+  GtkEventController *controller;
+  GtkWidget *window;
+  guint n_shortcuts[] = { 20, 2000, 20000 };
+  guint i, j, k, n;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Performance tests not enabled");
+      return;
+    }
+
+  for (k = 0; k < G_N_ELEMENTS (n_shortcuts); k++)
+    {
+      GdkEvent *hit, *miss;
+      gint64 start;
+      double hit_time, miss_time;
+
+      window = window_new (&controller);
+      if (!present_window (window))
+        {
+          g_test_skip ("Could not map window");
+          gtk_window_destroy (GTK_WINDOW (window));
+          return;
+        }
+
+      for (i = 0; i < n_shortcuts[k]; i++)
+        {
+          gtk_shortcut_controller_add_shortcut (GTK_SHORTCUT_CONTROLLER (controller),
+                                                recording_shortcut_new (gtk_keyval_trigger_new (GDK_KEY_a + i % 26,
+                                                                                                modifiers[i / 26 % G_N_ELEMENTS (modifiers)]),
+                                                                        i));
+        }
+
+      hit = key_press_new (window, GDK_KEY_q, GDK_CONTROL_MASK);
+      miss = key_press_new (window, GDK_KEY_q, GDK_SHIFT_MASK);
+
+      /* Builds the index */
+      gtk_event_controller_handle_event (controller, hit, window, 0, 0);
+
+      n = 10000;
+      start = g_get_monotonic_time ();
+      for (j = 0; j < n; j++)
+        gtk_event_controller_handle_event (controller, hit, window, 0, 0);
+      hit_time = (double) (g_get_monotonic_time () - start) / n;
+
+      start = g_get_monotonic_time ();
+      for (j = 0; j < n; j++)
+        gtk_event_controller_handle_event (controller, miss, window, 0, 0);
+      miss_time = (double) (g_get_monotonic_time () - start) / n;
+
+      g_test_minimized_result (hit_time, "%u shortcuts, matching key: %.2f µs per event", n_shortcuts[k], hit_time);
+      g_test_minimized_result (miss_time, "%u shortcuts, unmatched key: %.2f µs per event", n_shortcuts[k], miss_time);
+
+      gdk_event_unref (hit);
+      gdk_event_unref (miss);
+
+      gtk_window_destroy (GTK_WINDOW (window));
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  g_test_add_func ("/shortcutcontroller/index/dispatch", test_index_dispatch);
+  g_test_add_func ("/shortcutcontroller/index/mnemonics", test_index_mnemonics);
+  g_test_add_func ("/shortcutcontroller/performance", test_dispatch_performance);
+
+  return g_test_run ();
+}
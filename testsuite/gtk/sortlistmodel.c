@@ -709,6 +709,217 @@ test_sections (void)
   g_object_unref (model);
 }
 
+static guint
+get_number_modulo (GObject  *object,
+                   gpointer  unused)
+{
+  return GPOINTER_TO_UINT (g_object_get_qdata (object, number_quark)) % 1000;
+}
+
+static char *
+get_string_key (GObject *object)
+{
+  char *folded, *key;
+
+  folded = g_utf8_casefold (gtk_string_object_get_string (GTK_STRING_OBJECT (object)), -1);
+  key = g_utf8_collate_key (folded, -1);
+  g_free (folded);
+
+  return key;
+}
+
+static void
+wait_for_sort (GtkSortListModel *model)
+{
+  while (gtk_sort_list_model_get_pending (model) != 0)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+/* Checks that items with equal keys are still in their original
+ * order, we store the original position as data on the items.
+ */
+static void
+assert_stable (GListModel *model,
+               guint       i,
+               int         cmp)
+{
+  GObject *a, *b;
+
+  g_assert_cmpint (cmp, <=, 0);
+  if (cmp < 0)
+    return;
+
+  a = g_list_model_get_item (model, i - 1);
+  b = g_list_model_get_item (model, i);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_object_get_data (a, "position")), <,
+                    GPOINTER_TO_UINT (g_object_get_data (b, "position")));
+  g_object_unref (a);
+  g_object_unref (b);
+}
+
+/* Large enough models are sorted in parallel for sorters that
+ * support it, make sure the result is the same.
+ */
+static void
+test_parallel_numeric (gconstpointer data)
+{
+  gboolean incremental = GPOINTER_TO_UINT (data);
+  const guint n_items = 100000;
+  GtkSortListModel *model;
+  GtkSorter *sorter;
+  GListStore *store;
+  guint i;
+
+  store = new_shuffled_store (n_items);
+  for (i = 0; i < n_items; i++)
+    {
+      GObject *item = g_list_model_get_item (G_LIST_MODEL (store), i);
+      g_object_set_data (item, "position", GUINT_TO_POINTER (i));
+      g_object_unref (item);
+    }
+
+  model = new_model (NULL);
+  gtk_sort_list_model_set_incremental (model, incremental);
+  gtk_sort_list_model_set_model (model, G_LIST_MODEL (store));
+
+  sorter = GTK_SORTER (gtk_numeric_sorter_new (gtk_cclosure_expression_new (G_TYPE_UINT,
+                                                                            NULL,
+                                                                            0, NULL,
+                                                                            G_CALLBACK (get_number_modulo),
+                                                                            NULL, NULL)));
+  gtk_sort_list_model_set_sorter (model, sorter);
+  wait_for_sort (model);
+
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, n_items);
+  for (i = 1; i < n_items; i++)
+    {
+      guint a = get (G_LIST_MODEL (model), i - 1) % 1000;
+      guint b = get (G_LIST_MODEL (model), i) % 1000;
+
+      assert_stable (G_LIST_MODEL (model), i, a < b ? -1 : a > b ? 1 : 0);
+    }
+
+  gtk_numeric_sorter_set_sort_order (GTK_NUMERIC_SORTER (sorter), GTK_SORT_DESCENDING);
+  wait_for_sort (model);
+
+  for (i = 1; i < n_items; i++)
+    {
+      guint a = get (G_LIST_MODEL (model), i - 1) % 1000;
+      guint b = get (G_LIST_MODEL (model), i) % 1000;
+
+      assert_stable (G_LIST_MODEL (model), i, a > b ? -1 : a < b ? 1 : 0);
+    }
+
+  ignore_changes (model);
+
+  g_object_unref (sorter);
+  g_object_unref (store);
+  g_object_unref (model);
+}
+
+static void
+test_parallel_string (gconstpointer data)
+{
+  gboolean incremental = GPOINTER_TO_UINT (data);
+  const guint n_items = 50000;
+  GtkSortListModel *model;
+  GtkStringList *list;
+  GtkSorter *sorter;
+  char *prev_key;
+  guint i;
+
+  list = gtk_string_list_new (NULL);
+  for (i = 0; i < n_items; i++)
+    {
+      char s[4];
+      GObject *item;
+      guint j;
+
+      for (j = 0; j < 3; j++)
+        s[j] = g_test_rand_int_range (0, 2) ? g_test_rand_int_range ('a', 'e') : g_test_rand_int_range ('A', 'E');
+      s[3] = 0;
+      gtk_string_list_append (list, s);
+
+      item = g_list_model_get_item (G_LIST_MODEL (list), i);
+      g_object_set_data (item, "position", GUINT_TO_POINTER (i));
+      g_object_unref (item);
+    }
+
+  model = new_model (NULL);
+  gtk_sort_list_model_set_incremental (model, incremental);
+  gtk_sort_list_model_set_model (model, G_LIST_MODEL (list));
+
+  sorter = GTK_SORTER (gtk_string_sorter_new (gtk_property_expression_new (GTK_TYPE_STRING_OBJECT, NULL, "string")));
+  gtk_sort_list_model_set_sorter (model, sorter);
+  g_object_unref (sorter);
+  wait_for_sort (model);
+
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, n_items);
+  prev_key = NULL;
+  for (i = 0; i < n_items; i++)
+    {
+      GObject *item = g_list_model_get_item (G_LIST_MODEL (model), i);
+      char *key = get_string_key (item);
+
+      if (prev_key)
+        assert_stable (G_LIST_MODEL (model), i, strcmp (prev_key, key));
+
+      g_free (prev_key);
+      prev_key = key;
+      g_object_unref (item);
+    }
+  g_free (prev_key);
+
+  ignore_changes (model);
+
+  g_object_unref (list);
+  g_object_unref (model);
+}
+
+static void
+test_parallel_performance (void)
+{
+  const guint n_items = 1000000;
+  GtkSortListModel *model;
+  GtkStringList *list;
+  GtkSorter *sorter;
+  gint64 start;
+  double elapsed;
+  guint i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Performance tests not enabled");
+      return;
+    }
+
+  list = gtk_string_list_new (NULL);
+  for (i = 0; i < n_items; i++)
+    {
+      char *s = g_strdup_printf ("Item %u", g_test_rand_int ());
+      gtk_string_list_take (list, s);
+    }
+
+  model = gtk_sort_list_model_new (G_LIST_MODEL (list), NULL);
+
+  sorter = GTK_SORTER (gtk_string_sorter_new (gtk_property_expression_new (GTK_TYPE_STRING_OBJECT, NULL, "string")));
+  start = g_get_monotonic_time ();
+  gtk_sort_list_model_set_sorter (model, sorter);
+  elapsed = (double) (g_get_monotonic_time () - start) / G_USEC_PER_SEC;
+  g_test_minimized_result (elapsed, "%u strings: %.3f s", n_items, elapsed);
+
+  gtk_string_sorter_set_ignore_case (GTK_STRING_SORTER (sorter), FALSE);
+  gtk_string_sorter_set_collation (GTK_STRING_SORTER (sorter), GTK_COLLATION_NONE);
+  start = g_get_monotonic_time ();
+  gtk_sort_list_model_set_sorter (model, NULL);
+  gtk_sort_list_model_set_sorter (model, sorter);
+  elapsed = (double) (g_get_monotonic_time () - start) / G_USEC_PER_SEC;
+  g_test_minimized_result (elapsed, "%u strings, no collation: %.3f s", n_items, elapsed);
+
+  g_object_unref (sorter);
+  g_object_unref (model);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -729,6 +940,11 @@ main (int argc, char *argv[])
   g_test_add_func ("/sortlistmodel/oob-access", test_out_of_bounds_access);
   g_test_add_func ("/sortlistmodel/add-remove-item", test_add_remove_item);
   g_test_add_func ("/sortlistmodel/sections", test_sections);
+  g_test_add_data_func ("/sortlistmodel/parallel/numeric", GUINT_TO_POINTER (FALSE), test_parallel_numeric);
+  g_test_add_data_func ("/sortlistmodel/parallel/numeric-incremental", GUINT_TO_POINTER (TRUE), test_parallel_numeric);
+  g_test_add_data_func ("/sortlistmodel/parallel/string", GUINT_TO_POINTER (FALSE), test_parallel_string);
+  g_test_add_data_func ("/sortlistmodel/parallel/string-incremental", GUINT_TO_POINTER (TRUE), test_parallel_string);
+  g_test_add_func ("/sortlistmodel/parallel/performance", test_parallel_performance);
 
   return g_test_run ();
 }
@@ -279,6 +279,84 @@ test_search_caseless (void)
   check_found_backward ("aa \303\200", "aa", flags, 0, 2, "aa");
 }
 
+static void
+check_search_all (GtkTextBuffer      *buffer,
+                  const char         *needle,
+                  GtkTextSearchFlags  flags,
+                  int                 limit,
+                  const guint        *expected,
+                  gsize               n_expected)
+{
+  GtkTextIter start, end;
+  guint *offsets;
+  gsize n_offsets, i;
+
+  gtk_text_buffer_get_start_iter (buffer, &start);
+  if (limit >= 0)
+    gtk_text_buffer_get_iter_at_offset (buffer, &end, limit);
+  else
+    gtk_text_buffer_get_end_iter (buffer, &end);
+
+  offsets = gtk_text_iter_search_all (&start, &end, needle, flags, &n_offsets);
+  g_assert_cmpuint (n_offsets, ==, n_expected);
+  for (i = 0; i < n_offsets; i++)
+    g_assert_cmpuint (offsets[i], ==, expected[i]);
+
+  g_free (offsets);
+}
+
+static void
+test_search_all (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  GdkPaintable *paintable;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, "foo bar Foo\nbaz foo", -1);
+
+  /* split the first line into several segments */
+  gtk_text_buffer_create_tag (buffer, "bold", "weight", PANGO_WEIGHT_BOLD, NULL);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 2);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 5);
+  gtk_text_buffer_apply_tag_by_name (buffer, "bold", &start, &end);
+
+  check_search_all (buffer, "foo", 0, -1,
+                    (guint[]) { 0, 3, 16, 19 }, 4);
+  check_search_all (buffer, "foo", GTK_TEXT_SEARCH_CASE_INSENSITIVE, -1,
+                    (guint[]) { 0, 3, 8, 11, 16, 19 }, 6);
+  check_search_all (buffer, "o b", 0, -1,
+                    (guint[]) { 2, 5 }, 2);
+  check_search_all (buffer, "foo", 0, 18,
+                    (guint[]) { 0, 3 }, 2);
+  check_search_all (buffer, "foo\nbaz", GTK_TEXT_SEARCH_CASE_INSENSITIVE, -1,
+                    (guint[]) { 8, 15 }, 2);
+  check_search_all (buffer, "qux", 0, -1, NULL, 0);
+
+  /* the cache must not return stale results */
+  gtk_text_buffer_get_start_iter (buffer, &start);
+  gtk_text_buffer_insert (buffer, &start, "FOO", -1);
+  check_search_all (buffer, "foo", GTK_TEXT_SEARCH_CASE_INSENSITIVE, -1,
+                    (guint[]) { 0, 3, 3, 6, 11, 14, 19, 22 }, 8);
+
+  /* paintables */
+  gtk_text_buffer_set_text (buffer, "foo bar", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 4);
+  paintable = gdk_paintable_new_empty (1, 1);
+  gtk_text_buffer_insert_paintable (buffer, &start, paintable);
+  g_object_unref (paintable);
+
+  check_search_all (buffer, "o \357\277\274b", 0, -1,
+                    (guint[]) { 2, 6 }, 2);
+  check_search_all (buffer, "o b", 0, -1, NULL, 0);
+  check_search_all (buffer, "o b", GTK_TEXT_SEARCH_TEXT_ONLY, -1,
+                    (guint[]) { 2, 6 }, 2);
+  check_search_all (buffer, "O B", GTK_TEXT_SEARCH_TEXT_ONLY | GTK_TEXT_SEARCH_CASE_INSENSITIVE, -1,
+                    (guint[]) { 2, 6 }, 2);
+
+  g_object_unref (buffer);
+}
+
 static void
 test_forward_to_tag_toggle (void)
 {
@@ -841,6 +919,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextIter/Search Full Buffer", test_search_full_buffer);
   g_test_add_func ("/TextIter/Search", test_search);
   g_test_add_func ("/TextIter/Search Caseless", test_search_caseless);
+  g_test_add_func ("/TextIter/Search All", test_search_all);
   g_test_add_func ("/TextIter/Forward To Tag Toggle", test_forward_to_tag_toggle);
   g_test_add_func ("/TextIter/Forward To Line End", test_forward_to_line_end);
   g_test_add_func ("/TextIter/Word Boundaries", test_word_boundaries);
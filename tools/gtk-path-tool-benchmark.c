@@ -0,0 +1,139 @@
+/*  Copyright 2024 the GTK team
+ *
+ * GTK+ is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * GLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GTK+; see the file COPYING.  If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+#include "gtk-path-tool.h"
+
+#include <glib/gi18n-lib.h>
+
+static void
+print_result (const char *name,
+              gint64      duration,
+              guint       queries)
+{
+  g_print ("%s\t%lld.%03ds\t%.3fµs/query\n",
+           name,
+           (long long) duration / G_USEC_PER_SEC,
+           (int) ((duration * 1000 / G_USEC_PER_SEC) % 1000),
+           (double) duration / queries);
+}
+
+static void
+benchmark_path (GskPath *path,
+                guint    runs,
+                guint    queries,
+                float    threshold)
+{
+  graphene_rect_t bounds;
+  graphene_point_t *points;
+  GRand *rand;
+  guint i, j;
+
+  if (!gsk_path_get_bounds (path, &bounds))
+    return;
+
+  /* Use the same points for every run, so the results are comparable */
+  rand = g_rand_new_with_seed (0);
+  points = g_new (graphene_point_t, queries);
+  for (i = 0; i < queries; i++)
+    {
+      points[i].x = g_rand_double_range (rand, bounds.origin.x, bounds.origin.x + bounds.size.width);
+      points[i].y = g_rand_double_range (rand, bounds.origin.y, bounds.origin.y + bounds.size.height);
+    }
+  g_rand_free (rand);
+
+  for (i = 0; i < runs; i++)
+    {
+      gint64 start_time;
+      guint inside = 0, found = 0;
+
+      start_time = g_get_monotonic_time ();
+      for (j = 0; j < queries; j++)
+        inside += gsk_path_in_fill (path, &points[j], GSK_FILL_RULE_WINDING);
+      print_result ("in-fill", g_get_monotonic_time () - start_time, queries);
+
+      start_time = g_get_monotonic_time ();
+      for (j = 0; j < queries; j++)
+        {
+          GskPathPoint point;
+
+          found += gsk_path_get_closest_point (path, &points[j], threshold, &point, NULL);
+        }
+      print_result ("closest-point", g_get_monotonic_time () - start_time, queries);
+
+      if (i == 0)
+        g_print ("%u/%u inside, %u/%u close\n", inside, queries, found, queries);
+    }
+
+  g_free (points);
+}
+
+void
+do_benchmark (int *argc, const char ***argv)
+{
+  GError *error = NULL;
+  char **args = NULL;
+  int runs = 3;
+  int queries = 10000;
+  double threshold = 10;
+  GOptionContext *context;
+  GOptionEntry entries[] = {
+    { "runs", 0, 0, G_OPTION_ARG_INT, &runs, N_("Number of runs"), N_("RUNS") },
+    { "queries", 0, 0, G_OPTION_ARG_INT, &queries, N_("Number of points to test in each run"), N_("COUNT") },
+    { "threshold", 0, 0, G_OPTION_ARG_DOUBLE, &threshold, N_("Maximum distance for closest points"), N_("VALUE") },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &args, NULL, N_("PATH") },
+    { NULL, },
+  };
+  GskPath *path;
+
+  g_set_prgname ("gtk4-path-tool benchmark");
+
+  context = g_option_context_new (NULL);
+  g_option_context_set_translation_domain (context, GETTEXT_PACKAGE);
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_set_summary (context, _("Benchmark hit testing of a path."));
+
+  if (!g_option_context_parse (context, argc, (char ***)argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      exit (1);
+    }
+
+  g_option_context_free (context);
+
+  if (args == NULL)
+    {
+      g_printerr ("%s\n", _("No paths given."));
+      exit (1);
+    }
+
+  if (runs < 1 || queries < 1 || threshold < 0)
+    {
+      g_printerr ("%s\n", _("Invalid benchmark parameters."));
+      exit (1);
+    }
+
+  path = get_path (args[0]);
+
+  benchmark_path (path, runs, queries, threshold);
+
+  gsk_path_unref (path);
+  g_strfreev (args);
+}
@@ -44,6 +44,7 @@ usage (void)
              "  show         Display the path in a window\n"
              "  render       Render the path as an image\n"
              "  info         Print information about the path\n"
+             "  benchmark    Benchmark hit testing of the path\n"
              "\n"));
   exit (1);
 }
@@ -108,7 +109,9 @@ main (int argc, const char *argv[])
   argv++;
   argc--;
 
-  if (strcmp (argv[0], "decompose") == 0)
+  if (strcmp (argv[0], "benchmark") == 0)
+    do_benchmark (&argc, &argv);
+  else if (strcmp (argv[0], "decompose") == 0)
     do_decompose (&argc, &argv);
   else if (strcmp (argv[0], "info") == 0)
     do_info (&argc, &argv);
@@ -8,6 +8,7 @@ void do_restrict  (int *argc, const char ***argv);
 void do_reverse   (int *argc, const char ***argv);
 void do_render    (int *argc, const char ***argv);
 void do_show      (int *argc, const char ***argv);
+void do_benchmark (int *argc, const char ***argv);
 
 GskPath *get_path       (const char *arg);
 int      get_enum_value (GType       type,